@@ -28,10 +28,24 @@
 #include "Sdk/C/LzmaDec.h"
 #include "Sdk/C/LzmaEnc.h"
 #include "Sdk/C/Bra.h"
+#include "Sdk/C/Threads.h"
 #include "CommonLib.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
 
+//
+// The chunked format starts with the uncompressed size, the uncompressed size
+// of each chunk (the last one may be smaller), the number of chunks and the
+// compressed size of each chunk, all UINT32 little endian. It is followed by
+// the chunks, each one a complete LZMA stream with its own LZMA_HEADER_SIZE header.
+//
+#define LZMA_CHUNKED_HEADER_SIZE        12
+#define LZMA_CHUNK_SIZE_MIN             (1 << 20)
+
 typedef enum {
   NoConverter, 
   X86Converter,
@@ -49,12 +63,31 @@ static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 
 static Bool mQuietMode = False;
 static CONVERTER_TYPE mConType = NoConverter;
+static UInt32 mDictSize = 0;
+static UInt32 mNumThreads = 1;
+static Bool mChunked = False;
+static UInt32 mChunkSize = 0;
+
+typedef struct {
+  const Byte *Input;
+  size_t InputSize;
+  Byte *Output;
+  size_t OutputSize;
+  SRes Result;
+} LZMA_CHUNK;
+
+typedef struct {
+  LZMA_CHUNK *Chunks;
+  UInt32 ChunkCount;
+  UInt32 NextChunk;
+  CCriticalSection Lock;
+} LZMA_CHUNK_QUEUE;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 2
+#define UTILITY_MINOR_VERSION 3
 #define INTEL_COPYRIGHT \
-  "Copyright (c) 2009-2012, Intel Corporation. All rights reserved."
+  "Copyright (c) 2009-2014, Intel Corporation. All rights reserved."
 void PrintHelp(char *buffer)
 {
   strcat(buffer,
@@ -65,6 +98,12 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --dict-size N: set the dictionary size to 2^N bytes, 12 <= N <= 30\n"
+             "  --threads N: use N threads, 0 means one per processor. In the\n"
+             "      standard format 2 or more enable the multithreaded match finder\n"
+             "  --chunked: encode or decode the chunked format, whose chunks are\n"
+             "      compressed independently, in parallel when --threads is given\n"
+             "  --chunk-size N: set the uncompressed size in bytes of each chunk\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
@@ -97,6 +136,186 @@ void PrintVersion(char *buffer)
   sprintf (buffer, "%s Version %d.%d %s ", UTILITY_NAME, UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION, __BUILD_VERSION);
 }
 
+static void SetEncodeProps(CLzmaEncProps *props, UInt32 numThreads, size_t inSize)
+{
+  LzmaEncProps_Init(props);
+  if (mDictSize != 0) {
+    props->dictSize = mDictSize;
+  }
+  props->numThreads = (numThreads > 1) ? 2 : 1;
+  LzmaEncProps_Normalize(props);
+
+  if (mChunked) {
+    //
+    // A dictionary larger than the chunk only costs memory, and every thread has one.
+    //
+    while ((props->dictSize > (1 << 12)) && ((size_t)(props->dictSize >> 1) >= inSize)) {
+      props->dictSize >>= 1;
+    }
+  }
+}
+
+static UInt32 GetProcessorCount(void)
+{
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return (UInt32)systemInfo.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return (count > 0) ? (UInt32)count : 1;
+#endif
+}
+
+static void WriteUInt32(Byte *buffer, UInt32 value)
+{
+  int i;
+  for (i = 0; i < 4; i++)
+    buffer[i] = (Byte)(value >> (8 * i));
+}
+
+static UInt32 ReadUInt32(const Byte *buffer)
+{
+  return (UInt32)buffer[0] | ((UInt32)buffer[1] << 8) | ((UInt32)buffer[2] << 16) | ((UInt32)buffer[3] << 24);
+}
+
+static void EncodeChunk(LZMA_CHUNK *chunk)
+{
+  CLzmaEncProps props;
+  size_t outSizeProcessed = chunk->OutputSize - LZMA_HEADER_SIZE;
+  size_t outPropsSize = LZMA_PROPS_SIZE;
+  int i;
+
+  SetEncodeProps(&props, 1, chunk->InputSize);
+  for (i = 0; i < 8; i++)
+    chunk->Output[i + LZMA_PROPS_SIZE] = (Byte)((UInt64)chunk->InputSize >> (8 * i));
+
+  chunk->Result = LzmaEncode(chunk->Output + LZMA_HEADER_SIZE, &outSizeProcessed,
+      chunk->Input, chunk->InputSize, &props, chunk->Output, &outPropsSize, 0,
+      NULL, &g_Alloc, &g_Alloc);
+  chunk->OutputSize = LZMA_HEADER_SIZE + outSizeProcessed;
+}
+
+static THREAD_FUNC_DECL EncodeChunkThread(void *p)
+{
+  LZMA_CHUNK_QUEUE *queue = (LZMA_CHUNK_QUEUE *)p;
+  UInt32 index;
+
+  for (;;) {
+    CriticalSection_Enter(&queue->Lock);
+    index = queue->NextChunk++;
+    CriticalSection_Leave(&queue->Lock);
+    if (index >= queue->ChunkCount)
+      break;
+    EncodeChunk(&queue->Chunks[index]);
+  }
+  return 0;
+}
+
+static SRes EncodeChunked(ISeqOutStream *outStream, const Byte *inBuffer, size_t inSize)
+{
+  SRes res = SZ_OK;
+  LZMA_CHUNK_QUEUE queue;
+  CThread *threads = 0;
+  Byte *header = 0;
+  size_t chunkSize;
+  size_t headerSize;
+  UInt32 numThreads;
+  UInt32 threadCount = 0;
+  UInt32 i;
+
+  if (inSize > 0xFFFFFFFF)
+    return SZ_ERROR_PARAM;
+
+  numThreads = (mNumThreads == 0) ? GetProcessorCount() : mNumThreads;
+  chunkSize = mChunkSize;
+  if (chunkSize == 0) {
+    chunkSize = (inSize + numThreads - 1) / numThreads;
+    if (chunkSize < LZMA_CHUNK_SIZE_MIN)
+      chunkSize = LZMA_CHUNK_SIZE_MIN;
+  }
+
+  memset(&queue, 0, sizeof(queue));
+  queue.ChunkCount = (UInt32)((inSize + chunkSize - 1) / chunkSize);
+  queue.Chunks = (LZMA_CHUNK *)MyAlloc(queue.ChunkCount * sizeof(LZMA_CHUNK));
+  headerSize = LZMA_CHUNKED_HEADER_SIZE + queue.ChunkCount * 4;
+  header = (Byte *)MyAlloc(headerSize);
+  if (queue.Chunks == 0 || header == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+  memset(queue.Chunks, 0, queue.ChunkCount * sizeof(LZMA_CHUNK));
+
+  for (i = 0; i < queue.ChunkCount; i++) {
+    LZMA_CHUNK *chunk = &queue.Chunks[i];
+    chunk->Input = inBuffer + i * chunkSize;
+    chunk->InputSize = (i + 1 < queue.ChunkCount) ? chunkSize : inSize - i * chunkSize;
+    chunk->OutputSize = LZMA_HEADER_SIZE + chunk->InputSize / 20 * 21 + (1 << 16);
+    chunk->Output = (Byte *)MyAlloc(chunk->OutputSize);
+    if (chunk->Output == 0) {
+      res = SZ_ERROR_MEM;
+      goto Done;
+    }
+  }
+
+  //
+  // This thread encodes chunks as well, so start one thread less.
+  //
+  if (numThreads > queue.ChunkCount)
+    numThreads = queue.ChunkCount;
+  if (CriticalSection_Init(&queue.Lock) != 0) {
+    res = SZ_ERROR_THREAD;
+    goto Done;
+  }
+  if (numThreads > 1) {
+    threads = (CThread *)MyAlloc((numThreads - 1) * sizeof(CThread));
+    for (threadCount = 0; threads != 0 && threadCount < numThreads - 1; threadCount++) {
+      Thread_Construct(&threads[threadCount]);
+      if (Thread_Create(&threads[threadCount], EncodeChunkThread, &queue) != 0)
+        break;
+    }
+  }
+  EncodeChunkThread(&queue);
+  for (i = 0; i < threadCount; i++) {
+    Thread_Wait(&threads[i]);
+    Thread_Close(&threads[i]);
+  }
+  CriticalSection_Delete(&queue.Lock);
+
+  WriteUInt32(header, (UInt32)inSize);
+  WriteUInt32(header + 4, (UInt32)chunkSize);
+  WriteUInt32(header + 8, queue.ChunkCount);
+  for (i = 0; i < queue.ChunkCount; i++) {
+    if (queue.Chunks[i].Result != SZ_OK) {
+      res = queue.Chunks[i].Result;
+      goto Done;
+    }
+    WriteUInt32(header + LZMA_CHUNKED_HEADER_SIZE + i * 4, (UInt32)queue.Chunks[i].OutputSize);
+  }
+
+  if (outStream->Write(outStream, header, headerSize) != headerSize) {
+    res = SZ_ERROR_WRITE;
+    goto Done;
+  }
+  for (i = 0; i < queue.ChunkCount; i++) {
+    if (outStream->Write(outStream, queue.Chunks[i].Output, queue.Chunks[i].OutputSize) != queue.Chunks[i].OutputSize) {
+      res = SZ_ERROR_WRITE;
+      goto Done;
+    }
+  }
+
+Done:
+  if (queue.Chunks != 0) {
+    for (i = 0; i < queue.ChunkCount; i++)
+      MyFree(queue.Chunks[i].Output);
+  }
+  MyFree(queue.Chunks);
+  MyFree(threads);
+  MyFree(header);
+
+  return res;
+}
+
 static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -107,8 +326,7 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
   size_t outSize;
   CLzmaEncProps props;
 
-  LzmaEncProps_Init(&props);
-  LzmaEncProps_Normalize(&props);
+  SetEncodeProps(&props, (mNumThreads == 0) ? GetProcessorCount() : mNumThreads, inSize);
 
   if (inSize != 0) {
     inBuffer = (Byte *)MyAlloc(inSize);
@@ -123,6 +341,11 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
     goto Done;
   }
 
+  if (mChunked) {
+    res = EncodeChunked(outStream, inBuffer, inSize);
+    goto Done;
+  }
+
   // we allocate 105% of original size + 64KB for output buffer
   outSize = (size_t)fileSize / 20 * 21 + (1 << 16);
   outBuffer = (Byte *)MyAlloc(outSize);
@@ -181,6 +404,67 @@ Done:
   return res;
 }
 
+static SRes DecodeChunked(ISeqOutStream *outStream, const Byte *inBuffer, size_t inSize)
+{
+  SRes res = SZ_OK;
+  Byte *outBuffer = 0;
+  size_t outSize;
+  size_t chunkSize;
+  size_t offset;
+  size_t outOffset = 0;
+  UInt32 chunkCount;
+  UInt32 i;
+
+  if (inSize < LZMA_CHUNKED_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  outSize = ReadUInt32(inBuffer);
+  chunkSize = ReadUInt32(inBuffer + 4);
+  chunkCount = ReadUInt32(inBuffer + 8);
+  if (chunkCount > (inSize - LZMA_CHUNKED_HEADER_SIZE) / 4)
+    return SZ_ERROR_INPUT_EOF;
+  if (outSize == 0)
+    return SZ_OK;
+
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  offset = LZMA_CHUNKED_HEADER_SIZE + chunkCount * 4;
+  for (i = 0; i < chunkCount; i++) {
+    size_t chunkInSize = ReadUInt32(inBuffer + LZMA_CHUNKED_HEADER_SIZE + i * 4);
+    size_t chunkOutSize = (i + 1 < chunkCount) ? chunkSize : outSize - outOffset;
+    size_t inSizePure;
+    ELzmaStatus status;
+
+    if (chunkInSize < LZMA_HEADER_SIZE || chunkInSize > inSize - offset ||
+        chunkOutSize > outSize - outOffset) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+    inSizePure = chunkInSize - LZMA_HEADER_SIZE;
+    res = LzmaDecode(outBuffer + outOffset, &chunkOutSize, inBuffer + offset + LZMA_HEADER_SIZE, &inSizePure,
+        inBuffer + offset, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    offset += chunkInSize;
+    outOffset += chunkOutSize;
+  }
+  if (outOffset != outSize) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+
+  return res;
+}
+
 static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -206,6 +490,11 @@ static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
     goto Done;
   }
 
+  if (mChunked) {
+    res = DecodeChunked(outStream, inBuffer, inSize);
+    goto Done;
+  }
+
   for (i = 0; i < 8; i++)
     outSize64 += ((UInt64)inBuffer[LZMA_PROPS_SIZE + i]) << (i * 8);
 
@@ -275,6 +564,31 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--dict-size") == 0) {
+      unsigned long dictLog;
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      dictLog = strtoul(args[++param], NULL, 0);
+      if (dictLog < 12 || dictLog > 30) {
+        return PrintError(rs, "Dictionary size must be 2^12 to 2^30 bytes");
+      }
+      mDictSize = (UInt32)1 << dictLog;
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mNumThreads = (UInt32)strtoul(args[++param], NULL, 0);
+    } else if (strcmp(args[param], "--chunked") == 0) {
+      mChunked = True;
+    } else if (strcmp(args[param], "--chunk-size") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mChunkSize = (UInt32)strtoul(args[++param], NULL, 0);
+      if (mChunkSize == 0) {
+        return PrintError(rs, "Chunk size must not be 0");
+      }
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -323,6 +637,10 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  if (mChunked && (mConType != NoConverter)) {
+    return PrintError(rs, "The x86 converter is not supported by the chunked format");
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
@@ -143,7 +143,9 @@ DEF_GetHeads2(2,  (p[0] | ((UInt32)p[1] << 8)), hashMask = hashMask; crc = crc;
 DEF_GetHeads(3,  (crc[p[0]] ^ p[1] ^ ((UInt32)p[2] << 8)) & hashMask)
 DEF_GetHeads(4,  (crc[p[0]] ^ p[1] ^ ((UInt32)p[2] << 8) ^ (crc[p[3]] << 5)) & hashMask)
 DEF_GetHeads(4b, (crc[p[0]] ^ p[1] ^ ((UInt32)p[2] << 8) ^ ((UInt32)p[3] << 16)) & hashMask)
+/* GetHeads5 is not used by MatchFinderMt_CreateVTable, so it is not defined to avoid the unused function warning.
 DEF_GetHeads(5,  (crc[p[0]] ^ p[1] ^ ((UInt32)p[2] << 8) ^ (crc[p[3]] << 5) ^ (crc[p[4]] << 3)) & hashMask)
+*/
 
 void HashThreadFunc(CMatchFinderMt *mt)
 {
@@ -458,6 +460,7 @@ static unsigned MY_STD_CALL BtThreadFunc2(void *p)
   int i = 0;
   for (i = 0; i < 16; i++)
     allocaDummy[i] = (Byte)i;
+  (void)allocaDummy;
   BtThreadFunc((CMatchFinderMt *)p);
   return 0;
 }
@@ -6,6 +6,8 @@
 
 #include "Types.h"
 
+#ifdef _WIN32
+
 typedef struct _CThread
 {
   HANDLE handle;
@@ -64,5 +66,80 @@ WRes CriticalSection_Init(CCriticalSection *p);
 #define CriticalSection_Enter(p) EnterCriticalSection(p)
 #define CriticalSection_Leave(p) LeaveCriticalSection(p)
 
+#else
+
+/* POSIX threads implementation of the same interface, used by the non-Windows builds */
+
+#include <pthread.h>
+
+typedef unsigned THREAD_FUNC_RET_TYPE;
+#define THREAD_FUNC_CALL_TYPE MY_STD_CALL
+#define THREAD_FUNC_DECL THREAD_FUNC_RET_TYPE THREAD_FUNC_CALL_TYPE
+
+typedef struct _CThread
+{
+  pthread_t thread;
+  int created;
+  THREAD_FUNC_RET_TYPE (THREAD_FUNC_CALL_TYPE *startAddress)(void *);
+  void *parameter;
+} CThread;
+
+#define Thread_Construct(p) (p)->created = 0
+#define Thread_WasCreated(p) ((p)->created != 0)
+
+WRes Thread_Create(CThread *thread, THREAD_FUNC_RET_TYPE (THREAD_FUNC_CALL_TYPE *startAddress)(void *), void *parameter);
+WRes Thread_Wait(CThread *thread);
+WRes Thread_Close(CThread *thread);
+
+typedef struct _CEvent
+{
+  int created;
+  int manualReset;
+  int state;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} CEvent;
+
+typedef CEvent CAutoResetEvent;
+typedef CEvent CManualResetEvent;
+
+#define Event_Construct(p) (p)->created = 0
+#define Event_IsCreated(p) ((p)->created != 0)
+
+WRes ManualResetEvent_Create(CManualResetEvent *p, int initialSignaled);
+WRes ManualResetEvent_CreateNotSignaled(CManualResetEvent *p);
+WRes AutoResetEvent_Create(CAutoResetEvent *p, int initialSignaled);
+WRes AutoResetEvent_CreateNotSignaled(CAutoResetEvent *p);
+WRes Event_Set(CEvent *p);
+WRes Event_Reset(CEvent *p);
+WRes Event_Wait(CEvent *p);
+WRes Event_Close(CEvent *p);
+
+typedef struct _CSemaphore
+{
+  int created;
+  UInt32 count;
+  UInt32 maxCount;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} CSemaphore;
+
+#define Semaphore_Construct(p) (p)->created = 0
+
+WRes Semaphore_Create(CSemaphore *p, UInt32 initiallyCount, UInt32 maxCount);
+WRes Semaphore_ReleaseN(CSemaphore *p, UInt32 num);
+WRes Semaphore_Release1(CSemaphore *p);
+WRes Semaphore_Wait(CSemaphore *p);
+WRes Semaphore_Close(CSemaphore *p);
+
+typedef pthread_mutex_t CCriticalSection;
+
+WRes CriticalSection_Init(CCriticalSection *p);
+#define CriticalSection_Delete(p) pthread_mutex_destroy(p)
+#define CriticalSection_Enter(p) pthread_mutex_lock(p)
+#define CriticalSection_Leave(p) pthread_mutex_unlock(p)
+
+#endif
+
 #endif
 
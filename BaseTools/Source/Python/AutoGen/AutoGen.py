@@ -2754,11 +2754,25 @@ class ModuleAutoGen(AutoGen):
                         self._IncludePathList.append(str(Inc))
         return self._IncludePathList
 
+    ## Check if the build result of the module can be reused
+    #
+    #   @retval     True    The module is unchanged since its outputs were built
+    #   @retval     False   The module must go through AutoGen and make
+    #
+    def CanSkipbyHash(self):
+        if GlobalData.gBuildCache == None:
+            return False
+        return GlobalData.gBuildCache.IsHit(self)
+
     ## Create AsBuilt INF file the module
     #
     def CreateAsBuiltInf(self):
         if self.IsAsBuiltInfCreated:
             return
+
+        # The AsBuilt INF of a module hit in build cache is still valid
+        if self.CanSkipbyHash():
+            return
             
         # Skip the following code for EDK I inf
         if self.AutoGenVersion < 0x00010005:
@@ -3020,6 +3034,10 @@ class ModuleAutoGen(AutoGen):
             for LibraryAutoGen in self.LibraryAutoGenList:
                 LibraryAutoGen.CreateMakeFile()
 
+        if self.CanSkipbyHash():
+            self.IsMakeFileCreated = True
+            return
+
         if len(self.CustomMakefile) == 0:
             Makefile = GenMake.ModuleMakefile(self)
         else:
@@ -3031,6 +3049,11 @@ class ModuleAutoGen(AutoGen):
             EdkLogger.debug(EdkLogger.DEBUG_9, "Skipped the generation of makefile for module %s [%s]" %
                             (self.Name, self.Arch))
 
+        # Record what the module depends on, to be saved once it's built
+        if GlobalData.gBuildCache != None and len(self.CustomMakefile) == 0 \
+           and not Makefile.UnknownDependency:
+            GlobalData.gBuildCache.Prepare(self, Makefile.DependencyFileSet)
+
         self.IsMakeFileCreated = True
 
     ## Create autogen code for the module and its dependent libraries
@@ -3051,6 +3074,10 @@ class ModuleAutoGen(AutoGen):
             for LibraryAutoGen in self.LibraryAutoGenList:
                 LibraryAutoGen.CreateCodeFile()
 
+        if self.CanSkipbyHash():
+            self.IsCodeFileCreated = True
+            return
+
         AutoGenList = []
         IgoredAutoGenList = []
 
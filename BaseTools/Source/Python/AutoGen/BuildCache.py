@@ -0,0 +1,248 @@
+## @file
+# Content hash based cache of module build results
+#
+# Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+# This program and the accompanying materials
+# are licensed and made available under the terms and conditions of the BSD License
+# which accompanies this distribution.  The full text of the license may be found at
+# http://opensource.org/licenses/bsd-license.php
+#
+# THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+# WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+
+## Import Modules
+#
+import os
+import hashlib
+
+import Common.EdkLogger as EdkLogger
+from Common.Misc import DataDump
+from Common.Misc import DataRestore
+from Common.DataType import TAB_PCDS_DYNAMIC
+from Common.BuildVersion import gBUILD_VERSION
+
+## Name of the file keeping the cache record, in the build directory of each module
+gBuildCacheFileName = "BuildCache.dat"
+
+## Version of the cache record format
+gBuildCacheVersion = 1
+
+## Build cache of modules
+#
+# A module (or library) is keyed by the MD5 digest of everything its build
+# result depends on: its INF and the DEC files it uses, the PCD settings
+# applied to it, the library instances linked into it, the tool flags and
+# build rules, and the contents of its source files and all the headers they
+# include. The key and the digests of the module outputs are recorded in its
+# build directory after a successful build. When a later build computes the
+# same key and finds the outputs untouched, AutoGen and make of the module
+# are skipped and the outputs are reused.
+#
+class BuildCache(object):
+    def __init__(self):
+        self._FileDigest = {}       # file path : digest of file content
+        self._Hit = {}              # module build directory : True/False
+        self._Key = {}              # module build directory : key of its build result
+        self._Pending = {}          # module build directory : record to be saved after build
+        self.HitCount = 0
+        self.MissCount = 0
+
+    ## Check if the outputs of the module from last build can be reused
+    #
+    #   @param      Ma      ModuleAutoGen object
+    #
+    #   @retval     True    The module doesn't need to be built
+    #   @retval     False   The module must be built
+    #
+    def IsHit(self, Ma):
+        Id = self._GetModuleId(Ma)
+        if Id not in self._Hit:
+            Hit = self._CheckHit(Ma)
+            if Hit:
+                self.HitCount += 1
+                EdkLogger.verbose("Build cache hit: %s [%s]" % (Ma.MetaFile, Ma.Arch))
+            else:
+                self.MissCount += 1
+            self._Hit[Id] = Hit
+        return self._Hit[Id]
+
+    ## Compute the key of a module which is going to be built
+    #
+    #   The record is kept in memory until Save() is called for the module.
+    #
+    #   @param      Ma                  ModuleAutoGen object
+    #   @param      DependencyFileSet   Paths of all files the build of the module reads
+    #
+    def Prepare(self, Ma, DependencyFileSet):
+        if not self._IsCacheable(Ma):
+            return
+
+        LibraryList = []
+        for La in Ma.LibraryAutoGenList:
+            # a module using a library not in the cache can't be cached either
+            LibraryId = self._GetModuleId(La)
+            if LibraryId not in self._Key:
+                return
+            LibraryList.append((str(La.MetaFile), self._Key[LibraryId]))
+
+        FileSet = set(DependencyFileSet)
+        FileSet.update([File.Path for File in Ma.SourceFileList])
+        FileSet.update([File.Path for File in Ma.UnicodeFileList])
+        DependencyList = []
+        for FilePath in sorted(FileSet):
+            # generated files are covered by the config digest
+            if self._IsInDirectory(FilePath, Ma.BuildDir):
+                continue
+            Digest = self._GetFileDigest(FilePath)
+            if Digest == None:
+                return
+            DependencyList.append((FilePath, Digest))
+
+        Config = self._GetConfigDigest(Ma)
+        Key = hashlib.md5(Config + repr(LibraryList) + repr(DependencyList)).hexdigest()
+        Id = self._GetModuleId(Ma)
+        self._Key[Id] = Key
+        self._Pending[Id] = {
+            "Version"       : gBuildCacheVersion,
+            "Key"           : Key,
+            "Config"        : Config,
+            "Library"       : LibraryList,
+            "Dependency"    : DependencyList,
+        }
+
+    ## Record the outputs of a module which has been built successfully
+    #
+    #   It's safe to call this method from build threads.
+    #
+    #   @param      Ma      ModuleAutoGen object
+    #
+    def Save(self, Ma):
+        Record = self._Pending.pop(self._GetModuleId(Ma), None)
+        if Record == None:
+            return
+        OutputList = []
+        for FilePath in self._GetOutputFileList(Ma):
+            OutputList.append((FilePath, self._HashFile(FilePath)))
+        Record["Output"] = OutputList
+        DataDump(Record, os.path.join(Ma.BuildDir, gBuildCacheFileName))
+
+    ## Check the record of last build against current module
+    def _CheckHit(self, Ma):
+        if not self._IsCacheable(Ma):
+            return False
+
+        Record = DataRestore(os.path.join(Ma.BuildDir, gBuildCacheFileName))
+        if Record == None or Record.get("Version") != gBuildCacheVersion:
+            return False
+
+        LibraryList = []
+        for La in Ma.LibraryAutoGenList:
+            if not self.IsHit(La):
+                return False
+            LibraryList.append((str(La.MetaFile), self._Key[self._GetModuleId(La)]))
+        if LibraryList != Record["Library"]:
+            return False
+
+        if Record["Config"] != self._GetConfigDigest(Ma):
+            return False
+
+        for FilePath, Digest in Record["Dependency"]:
+            if self._GetFileDigest(FilePath) != Digest:
+                return False
+
+        for FilePath, Digest in Record["Output"]:
+            if self._HashFile(FilePath) != Digest:
+                return False
+
+        self._Key[self._GetModuleId(Ma)] = Record["Key"]
+        return True
+
+    ## Identity of a module build
+    #
+    #   ModuleAutoGen objects compare equal by their INF only, while the same INF
+    #   is built for each arch, target and tool chain into its own build directory.
+    #
+    @staticmethod
+    def _GetModuleId(Ma):
+        return os.path.normcase(os.path.normpath(Ma.BuildDir))
+
+    ## Modules whose build can't be described by the key are always built
+    def _IsCacheable(self, Ma):
+        if Ma.AutoGenVersion < 0x00010005:
+            return False
+        if Ma.IsBinaryModule or Ma.PcdIsDriver != '':
+            return False
+        if len(Ma.CustomMakefile) != 0:
+            return False
+        return True
+
+    ## Digest of the build settings of a module
+    def _GetConfigDigest(self, Ma):
+        Pa = Ma.PlatformInfo
+        Md5 = hashlib.md5()
+        Md5.update(repr((gBUILD_VERSION, str(Ma.MetaFile), Ma.Arch, Ma.BuildTarget, Ma.ToolChain)))
+        Md5.update(repr(self._GetFileDigest(Ma.MetaFile.Path)))
+        for Package in Ma.DependentPackageList:
+            Md5.update(repr(self._GetFileDigest(Package.MetaFile.Path)))
+        Md5.update(''.join(Pa.BuildRule.RuleContent))
+        Md5.update(repr(self._Sorted(Pa.ToolDefinition)))
+        Md5.update(repr(self._Sorted(Ma.BuildOption)))
+        Md5.update(repr(Ma.IncludePathList))
+        Md5.update(repr([str(File) for File in Ma.SourceFileList]))
+        for Pcd in Ma.ModulePcdList + Ma.LibraryPcdList:
+            TokenNumber = None
+            if Pcd.Type and Pcd.Type.startswith(TAB_PCDS_DYNAMIC):
+                TokenNumber = Pa.PcdTokenNumber.get((Pcd.TokenCName, Pcd.TokenSpaceGuidCName))
+            SkuList = [self._Sorted(Sku.__dict__) for Sku in Pcd.SkuInfoList.values()]
+            Md5.update(repr((Pcd.TokenSpaceGuidCName, Pcd.TokenCName, Pcd.Type, Pcd.DatumType,
+                             Pcd.DefaultValue, Pcd.MaxDatumSize, Pcd.TokenValue, SkuList,
+                             TokenNumber)))
+        Md5.update(repr(self._Sorted(Ma.ConstPcd)))
+        Md5.update(repr((Pa.Platform.RFCLanguages, Pa.Platform.ISOLanguages)))
+        return Md5.hexdigest()
+
+    ## Files generated by make in the output directory of a module
+    def _GetOutputFileList(self, Ma):
+        FileList = []
+        if os.path.isdir(Ma.OutputDir):
+            for Name in sorted(os.listdir(Ma.OutputDir)):
+                FilePath = os.path.join(Ma.OutputDir, Name)
+                if os.path.isfile(FilePath):
+                    FileList.append(FilePath)
+        return FileList
+
+    ## Digest of a source file, which won't change during the build
+    def _GetFileDigest(self, FilePath):
+        if FilePath not in self._FileDigest:
+            self._FileDigest[FilePath] = self._HashFile(FilePath)
+        return self._FileDigest[FilePath]
+
+    ## Digest of file content, or None if the file can't be read
+    @staticmethod
+    def _HashFile(FilePath):
+        try:
+            Fd = open(FilePath, 'rb')
+        except:
+            return None
+        try:
+            return hashlib.md5(Fd.read()).hexdigest()
+        finally:
+            Fd.close()
+
+    ## Check if a path is in given directory
+    @staticmethod
+    def _IsInDirectory(FilePath, Directory):
+        Directory = os.path.normcase(os.path.normpath(Directory))
+        return os.path.normcase(os.path.normpath(FilePath)).startswith(Directory + os.sep)
+
+    ## Turn a dictionary, even nested, into an order independent representation
+    @staticmethod
+    def _Sorted(Value):
+        if isinstance(Value, dict):
+            return [(Key, BuildCache._Sorted(Value[Key])) for Key in sorted(Value)]
+        return Value
+
+# This acts like the main() function for the script, unless it is 'import'ed into another script.
+if __name__ == '__main__':
+    pass
@@ -425,6 +425,8 @@ cleanlib:
 
         self.FileCache = {}
         self.FileDependency = []
+        self.DependencyFileSet = set()      # {file path} for build cache
+        self.UnknownDependency = False
         self.LibraryBuildCommandList = []
         self.LibraryFileList = []
         self.LibraryMakefileList = []
@@ -619,6 +621,10 @@ cleanlib:
                                     ForceIncludedFile,
                                     self._AutoGenObject.IncludePathList + self._AutoGenObject.BuildOptionIncPathList
                                     )
+        self.DependencyFileSet = set([File.Path for File in SourceFileList])
+        for File in self.FileDependency:
+            self.DependencyFileSet.update([Dep.Path for Dep in self.FileDependency[File]])
+
         DepSet = None
         for File in self.FileDependency:
             if not self.FileDependency[File]:
@@ -773,6 +779,7 @@ cleanlib:
                             # not known macro used in #include, always build the file by
                             # returning a empty dependency
                             self.FileCache[File] = []
+                            self.UnknownDependency = True
                             return []
                     Inc = os.path.normpath(Inc)
                     CurrentFileDependencyList.append(Inc)
@@ -69,3 +69,8 @@ gIgnoreSource = False
 # FDF parser
 #
 gFdfParser = None
+
+#
+# Build cache of modules, None if disabled
+#
+gBuildCache = None
@@ -23,10 +23,16 @@ from struct import *
 
 import Ffs
 import AprioriSection
+import RuleComplexFile
+from FfsInfStatement import FfsInfStatement
+from FfsFileStatement import FileStatement
+from FvImageSection import FvImageSection
 from GenFdsGlobalVariable import GenFdsGlobalVariable
 from GenFds import GenFds
 from CommonDataClass.FdfClass import FvClassObject
 from Common.Misc import SaveFileOnChange
+from Common.Misc import PathClass
+from Common.String import NormPath
 
 T_CHAR_LF = '\n'
 
@@ -86,7 +92,7 @@ class FV (FvClassObject):
                                 GenFdsGlobalVariable.ErrorLogger("Capsule %s in FD region can't contain a FV %s in FD region." % (self.CapsuleName, self.UiFvName.upper()))
 
         GenFdsGlobalVariable.InfLogger( "\nGenerating %s FV" %self.UiFvName)
-        GenFdsGlobalVariable.LargeFileInFvFlags.append(False)
+        GenFdsGlobalVariable.GetLargeFileInFvFlags().append(False)
         FFSGuid = None
         
         if self.FvBaseAddress != None:
@@ -109,8 +115,14 @@ class FV (FvClassObject):
                                            T_CHAR_LF)
 
         # Process Modules in FfsList
+        JobList = []
         for FfsFile in self.FfsList :
-            FileName = FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress)
+            Job = lambda FfsFile=FfsFile: FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress)
+            Resources = None
+            if GenFdsGlobalVariable.ThreadNumber > 1:
+                Resources = FV.GetFfsResources(FfsFile)
+            JobList.append((Job, Resources))
+        for FileName in GenFdsGlobalVariable.RunJobs(JobList):
             FfsFileList.append(FileName)
             self.FvInfFile.writelines("EFI_FILE_NAME = " + \
                                        FileName          + \
@@ -132,7 +144,7 @@ class FV (FvClassObject):
         OrigFvInfo = None
         if os.path.exists (FvInfoFileName):
             OrigFvInfo = open(FvInfoFileName, 'r').read()
-        if GenFdsGlobalVariable.LargeFileInFvFlags[-1]:
+        if GenFdsGlobalVariable.GetLargeFileInFvFlags()[-1]:
             FFSGuid = GenFdsGlobalVariable.EFI_FIRMWARE_FILE_SYSTEM3_GUID;
         GenFdsGlobalVariable.GenerateFirmwareVolume(
                                 FvOutputFile,
@@ -164,7 +176,7 @@ class FV (FvClassObject):
                 for FfsFile in self.FfsList :
                     FileName = FfsFile.GenFfs(MacroDict, FvChildAddr, BaseAddress)
                 
-                if GenFdsGlobalVariable.LargeFileInFvFlags[-1]:
+                if GenFdsGlobalVariable.GetLargeFileInFvFlags()[-1]:
                     FFSGuid = GenFdsGlobalVariable.EFI_FIRMWARE_FILE_SYSTEM3_GUID;
                 #Update GenFv again
                 GenFdsGlobalVariable.GenerateFirmwareVolume(
@@ -202,9 +214,96 @@ class FV (FvClassObject):
             self.FvAlignment = str (FvAlignmentValue)
         FvFileObj.close()
         GenFds.ImageBinDict[self.UiFvName.upper() + 'fv'] = FvOutputFile
-        GenFdsGlobalVariable.LargeFileInFvFlags.pop()
+        GenFdsGlobalVariable.GetLargeFileInFvFlags().pop()
         return FvOutputFile
 
+    ## GetResources()
+    #
+    #   Get the resources generating this FV writes, for GenFdsGlobalVariable.RunJobs()
+    #
+    #   @param  self        The object pointer
+    #   @retval set         Resource names, None if the FV must be generated alone
+    #
+    def GetResources(self):
+        #
+        # Apriori sections and DEFINEs update the shared macro dictionary
+        #
+        if self.DefineVarDict or self.AprioriSectionList:
+            return None
+        Resources = set(['FV:' + self.UiFvName.upper()])
+        if self.CreateFileName != None:
+            Resources.add('FILE:' + os.path.normcase(os.path.normpath(self.CreateFileName)))
+        for FfsFile in self.FfsList:
+            FfsResources = FV.GetFfsResources(FfsFile)
+            if FfsResources == None:
+                return None
+            Resources |= FfsResources
+        return Resources
+
+    ## GetFfsResources()
+    #
+    #   Get the resources generating a FFS file writes, for GenFdsGlobalVariable.RunJobs()
+    #
+    #   @param  FfsFile     FfsInfStatement or FileStatement object
+    #   @retval set         Resource names, None if the FFS file must be generated alone
+    #                       (it contains a FV or FD, or it updates the macro dictionary)
+    #
+    @staticmethod
+    def GetFfsResources(FfsFile):
+        #
+        # The output directory of a FFS file is named after its GUID
+        #
+        if isinstance(FfsFile, FfsInfStatement):
+            if FV.__RulesContainFv():
+                return None
+            InfFileName = NormPath(FfsFile.InfFileName.replace('$(WORKSPACE)', '').lstrip('\\/'))
+            if InfFileName.find('$') != -1:
+                return None
+            PathClassObj = PathClass(InfFileName, GenFdsGlobalVariable.WorkSpaceDir)
+            ErrorCode, ErrorInfo = PathClassObj.Validate(".inf")
+            if ErrorCode != 0:
+                return None
+            Inf = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClassObj, 'COMMON', GenFdsGlobalVariable.TargetName, GenFdsGlobalVariable.ToolChainTag]
+            if not Inf.Guid:
+                return None
+            return set(['GUID:' + Inf.Guid.upper()])
+
+        if isinstance(FfsFile, FileStatement):
+            if FfsFile.DefineVarDict or FfsFile.FvName != None or FfsFile.FdName != None:
+                return None
+            if FfsFile.NameGuid == None or FfsFile.NameGuid.startswith('PCD('):
+                return None
+            if FV.__SectionsContainFv(FfsFile.SectionList):
+                return None
+            return set(['GUID:' + FfsFile.NameGuid.upper()])
+
+        return None
+
+    ## __SectionsContainFv()
+    #
+    #   @param  SectionList Sections to check, encapsulation sections are checked recursively
+    #   @retval bool        True if any of the sections generates a FV
+    #
+    @staticmethod
+    def __SectionsContainFv(SectionList):
+        for Section in SectionList:
+            if isinstance(Section, FvImageSection) and Section.FvName != None:
+                return True
+            if hasattr(Section, 'SectionList') and FV.__SectionsContainFv(Section.SectionList):
+                return True
+        return False
+
+    ## __RulesContainFv()
+    #
+    #   @retval bool        True if any rule in FDF generates a FV
+    #
+    @staticmethod
+    def __RulesContainFv():
+        for Rule in GenFdsGlobalVariable.FdfParser.Profile.RuleDict.values():
+            if isinstance(Rule, RuleComplexFile.RuleComplexFile) and FV.__SectionsContainFv(Rule.SectionList):
+                return True
+        return False
+
     ## __InitializeInf__()
     #
     #   Initilize the inf file to create FV
@@ -19,6 +19,7 @@ from optparse import OptionParser
 import sys
 import os
 import linecache
+import multiprocessing
 import FdfParser
 import Common.BuildToolError as BuildToolError
 from GenFdsGlobalVariable import GenFdsGlobalVariable
@@ -70,6 +71,16 @@ def main():
             
         if Options.FixedAddress != None:
             GenFdsGlobalVariable.FixedLoadAddress = True
+
+        if Options.ThreadNumber != None:
+            if Options.ThreadNumber < 0:
+                EdkLogger.error("GenFds", OPTION_VALUE_INVALID, "Thread number must not be negative")
+            if Options.ThreadNumber == 0:
+                try:
+                    Options.ThreadNumber = multiprocessing.cpu_count()
+                except NotImplementedError:
+                    Options.ThreadNumber = 1
+            GenFdsGlobalVariable.ThreadNumber = Options.ThreadNumber
             
         if Options.quiet != None:
             EdkLogger.SetLevel(EdkLogger.QUIET)
@@ -321,6 +332,7 @@ def myOptionParser():
                       action="callback", callback=SingleCheckCallback)
     Parser.add_option("-D", "--define", action="append", type="string", dest="Macros", help="Macro: \"Name [= Value]\".")
     Parser.add_option("-s", "--specifyaddress", dest="FixedAddress", action="store_true", type=None, help="Specify driver load address.")
+    Parser.add_option("-n", "--thread-number", type="int", dest="ThreadNumber", help="Maximum number of tools run in parallel to generate FFS files and FVs. 0 means the number of processors. Default is 1 (serial).")
     (Options, args) = Parser.parse_args()
     return Options
 
@@ -375,11 +387,17 @@ class GenFds :
                 Buffer.close()
                 return
         elif GenFds.OnlyGenerateThisFv == None:
+            #
+            # FVs not sharing any FFS file or nested FV are generated in parallel
+            #
+            JobList = []
             for FvName in GenFdsGlobalVariable.FdfParser.Profile.FvDict.keys():
-                Buffer = StringIO.StringIO('')
                 FvObj = GenFdsGlobalVariable.FdfParser.Profile.FvDict[FvName]
-                FvObj.AddToBuffer(Buffer)
-                Buffer.close()
+                Resources = None
+                if GenFdsGlobalVariable.ThreadNumber > 1:
+                    Resources = FvObj.GetResources()
+                JobList.append((lambda FvObj=FvObj: GenFds.GenFv(FvObj), Resources))
+            GenFdsGlobalVariable.RunJobs(JobList)
         
         if GenFds.OnlyGenerateThisFv == None and GenFds.OnlyGenerateThisFd == None and GenFds.OnlyGenerateThisCap == None:
             if GenFdsGlobalVariable.FdfParser.Profile.CapsuleDict != {}:
@@ -394,6 +412,15 @@ class GenFds :
                     OptRomObj = GenFdsGlobalVariable.FdfParser.Profile.OptRomDict[DriverName]
                     OptRomObj.AddToBuffer(None)
 
+    ## GenFv()
+    #
+    #   @param  FvObj           The FV to generate
+    #
+    def GenFv(FvObj):
+        Buffer = StringIO.StringIO('')
+        FvObj.AddToBuffer(Buffer)
+        Buffer.close()
+
     ## GetFvBlockSize()
     #
     #   @param  FvObj           Whose block size to get
@@ -538,6 +565,7 @@ class GenFds :
 
     ##Define GenFd as static function
     GenFd = staticmethod(GenFd)
+    GenFv = staticmethod(GenFv)
     GetFvBlockSize = staticmethod(GetFvBlockSize)
     DisplayFvSpaceInfo = staticmethod(DisplayFvSpaceInfo)
     PreprocessImage = staticmethod(PreprocessImage)
@@ -20,6 +20,7 @@ import sys
 import subprocess
 import struct
 import array
+import threading
 
 from Common.BuildToolError import *
 from Common import EdkLogger
@@ -74,13 +75,119 @@ class GenFdsGlobalVariable:
     # and EFI_FIRMWARE_FILE_SYSTEM3_GUID is passed to C GenFv.
     # At the end of generation of FV, pop the flag.
     # List is used as a stack to handle nested FV generation.
+    # Each thread has its own stack, see GetLargeFileInFvFlags().
     #
-    LargeFileInFvFlags = []
     EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
     LARGE_FILE_SIZE = 0x1000000
 
     SectionHeader = struct.Struct("3B 1B")
-    
+
+    #
+    # Maximum number of external tools run at the same time. 1 keeps the
+    # original serial behavior.
+    #
+    ThreadNumber = 1
+    #
+    # Only one thread at a time runs the Python side of GenFds (the workspace
+    # database and the global state above are not thread safe). A job thread
+    # holds JobLock all the time except while its external tool is running,
+    # which is where the parallelism comes from.
+    #
+    JobLock = threading.Condition()
+    ThreadData = threading.local()
+    RunningTools = 0
+
+    ## GetLargeFileInFvFlags
+    #
+    #   @retval list        The LargeFileInFvFlags stack of the current thread
+    #
+    @staticmethod
+    def GetLargeFileInFvFlags():
+        if not hasattr(GenFdsGlobalVariable.ThreadData, 'LargeFileInFvFlags'):
+            GenFdsGlobalVariable.ThreadData.LargeFileInFvFlags = []
+        return GenFdsGlobalVariable.ThreadData.LargeFileInFvFlags
+
+    ## RunJobs
+    #
+    #   Run a list of jobs, up to ThreadNumber of them at the same time.
+    #
+    #   Jobs are started in list order. A job does not start while an earlier
+    #   job sharing one of its resources is still running, and a job whose
+    #   resource set is None runs alone, so jobs writing the same files keep
+    #   their serial order and the generated images are the same as the ones
+    #   of a serial run.
+    #
+    #   @param  JobList     List of (Callable, Resources) tuples, Resources is
+    #                       a set of strings or None
+    #   @retval list        Return values of the callables, in list order
+    #
+    @staticmethod
+    def RunJobs(JobList):
+        if GenFdsGlobalVariable.ThreadNumber <= 1 or len(JobList) <= 1:
+            return [Job() for (Job, Resources) in JobList]
+
+        Lock = GenFdsGlobalVariable.JobLock
+        ThreadData = GenFdsGlobalVariable.ThreadData
+        Owner = not getattr(ThreadData, 'InJob', False)
+        if Owner:
+            Lock.acquire()
+            ThreadData.InJob = True
+
+        ParentFlags = GenFdsGlobalVariable.GetLargeFileInFvFlags()
+        Count = len(JobList)
+        Results = [None] * Count
+        # 0: pending, 1: running, 2: done
+        State = [0] * Count
+        Errors = {}
+
+        def IsReady(Index):
+            Resources = JobList[Index][1]
+            for Prior in range(0, Index):
+                if State[Prior] == 2:
+                    continue
+                PriorResources = JobList[Prior][1]
+                if Resources == None or PriorResources == None or not Resources.isdisjoint(PriorResources):
+                    return False
+            return True
+
+        def Worker(Index):
+            Lock.acquire()
+            ThreadData.InJob = True
+            ThreadData.LargeFileInFvFlags = [False]
+            try:
+                try:
+                    Results[Index] = JobList[Index][0]()
+                except:
+                    Errors[Index] = sys.exc_info()
+                if ThreadData.LargeFileInFvFlags[0] and ParentFlags:
+                    ParentFlags[-1] = True
+            finally:
+                State[Index] = 2
+                ThreadData.InJob = False
+                Lock.notifyAll()
+                Lock.release()
+
+        try:
+            Next = 0
+            while True:
+                while Next < Count and not Errors and \
+                      State.count(1) < GenFdsGlobalVariable.ThreadNumber and IsReady(Next):
+                    State[Next] = 1
+                    threading.Thread(target=Worker, args=(Next,)).start()
+                    Next = Next + 1
+                if State.count(1) == 0 and (Next == Count or Errors):
+                    break
+                Lock.wait()
+        finally:
+            if Owner:
+                ThreadData.InJob = False
+                Lock.release()
+
+        if Errors:
+            Info = Errors[min(Errors.keys())]
+            raise Info[0], Info[1], Info[2]
+        return Results
+
     ## LoadBuildRule
     #
     @staticmethod
@@ -407,9 +514,10 @@ class GenFdsGlobalVariable:
                 GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s needs update because of newer %s" % (Output, Input))
                 GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
 
+            LargeFileInFvFlags = GenFdsGlobalVariable.GetLargeFileInFvFlags()
             if (os.path.getsize(Output) >= GenFdsGlobalVariable.LARGE_FILE_SIZE and
-                GenFdsGlobalVariable.LargeFileInFvFlags):
-                GenFdsGlobalVariable.LargeFileInFvFlags[-1] = True 
+                LargeFileInFvFlags):
+                LargeFileInFvFlags[-1] = True 
 
     @staticmethod
     def GetAlignment (AlignString):
@@ -599,14 +707,29 @@ class GenFdsGlobalVariable:
             if GenFdsGlobalVariable.SharpCounter % GenFdsGlobalVariable.SharpNumberPerLine == 0:
                 sys.stdout.write('\n')
 
+        #
+        # Let other jobs run while the tool is running
+        #
+        InJob = getattr(GenFdsGlobalVariable.ThreadData, 'InJob', False)
+        if InJob:
+            while GenFdsGlobalVariable.RunningTools >= GenFdsGlobalVariable.ThreadNumber:
+                GenFdsGlobalVariable.JobLock.wait()
+            GenFdsGlobalVariable.RunningTools = GenFdsGlobalVariable.RunningTools + 1
+            GenFdsGlobalVariable.JobLock.release()
         try:
-            PopenObject = subprocess.Popen(' '.join(cmd), stdout=subprocess.PIPE, stderr= subprocess.PIPE, shell=True)
-        except Exception, X:
-            EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
-        (out, error) = PopenObject.communicate()
-
-        while PopenObject.returncode == None :
-            PopenObject.wait()
+            try:
+                PopenObject = subprocess.Popen(' '.join(cmd), stdout=subprocess.PIPE, stderr= subprocess.PIPE, shell=True)
+            except Exception, X:
+                EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
+            (out, error) = PopenObject.communicate()
+
+            while PopenObject.returncode == None :
+                PopenObject.wait()
+        finally:
+            if InJob:
+                GenFdsGlobalVariable.JobLock.acquire()
+                GenFdsGlobalVariable.RunningTools = GenFdsGlobalVariable.RunningTools - 1
+                GenFdsGlobalVariable.JobLock.notifyAll()
         if returnValue != [] and returnValue[0] != 0:
             #get command return value
             returnValue[0] = PopenObject.returncode
@@ -2676,7 +2676,8 @@ class WorkspaceDatabase(object):
                 os.remove(DbPath)
         
         # create db with optimized parameters
-        self.Conn = sqlite3.connect(DbPath, isolation_level='DEFERRED')
+        # (GenFds accesses it from its job threads, one thread at a time)
+        self.Conn = sqlite3.connect(DbPath, isolation_level='DEFERRED', check_same_thread=False)
         self.Conn.execute("PRAGMA synchronous=OFF")
         self.Conn.execute("PRAGMA temp_store=MEMORY")
         self.Conn.execute("PRAGMA count_changes=OFF")
@@ -36,6 +36,7 @@ from Common.ToolDefClassObject import *
 from Common.DataType import *
 from Common.BuildVersion import gBUILD_VERSION
 from AutoGen.AutoGen import *
+from AutoGen.BuildCache import BuildCache
 from Common.BuildToolError import *
 from Workspace.WorkspaceDatabase import *
 
@@ -367,7 +368,7 @@ class ModuleMakeUnit(BuildUnit):
     #   @param  Target      The build target name, one of gSupportedTarget
     #
     def __init__(self, Obj, Target):
-        Dependency = [ModuleMakeUnit(La, Target) for La in Obj.LibraryAutoGenList]
+        Dependency = [ModuleMakeUnit(La, Target) for La in Obj.LibraryAutoGenList if not La.CanSkipbyHash()]
         BuildUnit.__init__(self, Obj, Obj.BuildCommand, Target, Dependency, Obj.MakeFileDir)
         if Target in [None, "", "all"]:
             self.Target = "tbuild"
@@ -630,6 +631,8 @@ class BuildTask:
     def _CommandThread(self, Command, WorkingDir):
         try:
             LaunchCommand(Command, WorkingDir)
+            if GlobalData.gBuildCache != None:
+                GlobalData.gBuildCache.Save(self.BuildItem.BuildObject)
             self.CompleteFlag = True
         except:
             #
@@ -721,6 +724,7 @@ class Build():
         self.ThreadNumber   = BuildOptions.ThreadNumber
         self.SkipAutoGen    = BuildOptions.SkipAutoGen
         self.Reparse        = BuildOptions.Reparse
+        self.UseHashCache   = BuildOptions.UseHashCache
         self.SkuId          = BuildOptions.SkuId
         self.SpawnMode      = True
         self.BuildReport    = BuildReport(BuildOptions.ReportFile, BuildOptions.ReportType)
@@ -1379,6 +1383,9 @@ class Build():
     ## Build a platform in multi-thread mode
     #
     def _MultiThreadBuildPlatform(self):
+        # Modules are never skipped when they are cleaned or run
+        if self.UseHashCache and self.Target not in ['clean', 'cleanlib', 'cleanall', 'run']:
+            GlobalData.gBuildCache = BuildCache()
         for BuildTarget in self.BuildTargetList:
             GlobalData.gGlobalDefines['TARGET'] = BuildTarget
             for ToolChain in self.ToolChainList:
@@ -1433,6 +1440,9 @@ class Build():
                                 Ma.CreateAsBuiltInf()
                             if self.Target == "genmake":
                                 continue
+                        # Outputs of last build are still valid
+                        if Ma.CanSkipbyHash():
+                            continue
                         pModules.append(Ma)
                     self.Progress.Stop("done!")
 
@@ -1516,6 +1526,10 @@ class Build():
                     #
                     self._SaveMapFile(MapBuffer, Wa)
 
+        if GlobalData.gBuildCache != None:
+            EdkLogger.quiet("Build cache: %d module(s) reused, %d module(s) built" %
+                            (GlobalData.gBuildCache.HitCount, GlobalData.gBuildCache.MissCount))
+
     ## Generate GuidedSectionTools.txt in the FV directories.
     #
     def CreateGuidedSectionToolsFile(self):
@@ -1710,6 +1724,9 @@ def MyOptionParser():
              "This option can also be specified by setting *_*_*_BUILD_FLAGS in [BuildOptions] section of platform DSC. If they are both specified, this value "\
              "will override the setting in [BuildOptions] section of platform DSC.")
     Parser.add_option("-N", "--no-cache", action="store_true", dest="DisableCache", default=False, help="Disable build cache mechanism")
+    Parser.add_option("--hash", action="store_true", dest="UseHashCache", default=False,
+        help="Skip AutoGen and make of the modules whose sources, settings and library instances have the same content hash "\
+             "as in last build, and reuse their outputs. Only applies to multi-thread build of a platform.")
 
     (Opt, Args)=Parser.parse_args()
     return (Opt, Args)
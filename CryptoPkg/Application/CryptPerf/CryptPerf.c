@@ -0,0 +1,363 @@
+/** @file
+  Measures the throughput of the hash and block cipher backends. For buffer
+  sizes from 64 bytes to 64MB, SHA-1, SHA-256 and AES-128 are run over a fixed
+  period through the OpenSSL C code and through BaseCryptLib, which uses the SHA
+  Extensions and AES-NI when the processor has them. The results are printed
+  as MB per second.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BaseCryptLib.h>
+
+#include "OpenSslSupport.h"
+
+//
+// Environment Setting for OpenSSL-based UEFI Crypto Library.
+//
+#ifndef OPENSSL_SYSNAME_UWIN
+#define OPENSSL_SYSNAME_UWIN
+#endif
+
+#include <openssl/sha.h>
+#include <openssl/aes.h>
+
+#define CRYPT_PERF_SECONDS       1
+#define CRYPT_PERF_MAX_SIZE      SIZE_64MB
+#define CRYPT_PERF_CHECK_SIZE    SIZE_1KB
+
+typedef enum {
+  CryptPerfSha1,
+  CryptPerfSha256,
+  CryptPerfAesEcbEncrypt,
+  CryptPerfAesCbcEncrypt,
+  CryptPerfAesCbcDecrypt,
+  CryptPerfTestMax
+} CRYPT_PERF_TEST;
+
+typedef enum {
+  CryptPerfOpenSsl,
+  CryptPerfBaseCryptLib,
+  CryptPerfBackendMax
+} CRYPT_PERF_BACKEND;
+
+CHAR16  *mCryptPerfTestName[CryptPerfTestMax] = {
+  L"SHA-1",
+  L"SHA-256",
+  L"AES-128-ECB encrypt",
+  L"AES-128-CBC encrypt",
+  L"AES-128-CBC decrypt"
+};
+
+CHAR16  *mCryptPerfBackendName[CryptPerfBackendMax] = {
+  L"OpenSSL",
+  L"BaseCryptLib"
+};
+
+UINTN   mCryptPerfSize[] = {
+  64, SIZE_1KB, SIZE_16KB, SIZE_1MB, SIZE_64MB
+};
+
+UINT8   mCryptPerfKey[16] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+UINT8   mCryptPerfIvec[16] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+//
+// Contexts of both backends, set up once
+//
+VOID     *mSha1Context;
+VOID     *mSha256Context;
+VOID     *mAesContext;
+AES_KEY  mAesEncryptKey;
+AES_KEY  mAesDecryptKey;
+
+/**
+  Runs one operation of the given test on a buffer. AES is done in place.
+
+  @param[in]      Test          The test to run.
+  @param[in]      Backend       The backend to run the test with.
+  @param[in, out] Buffer        The data.
+  @param[in]      Size          The size of the data, a multiple of 16.
+  @param[out]     Digest        The digest of the hash tests.
+
+**/
+VOID
+RunCryptPerfOperation (
+  IN     CRYPT_PERF_TEST     Test,
+  IN     CRYPT_PERF_BACKEND  Backend,
+  IN OUT UINT8               *Buffer,
+  IN     UINTN               Size,
+  OUT    UINT8               *Digest
+  )
+{
+  SHA_CTX     Sha1Ctx;
+  SHA256_CTX  Sha256Ctx;
+  UINT8       Ivec[16];
+  UINTN       Index;
+
+  if (Backend == CryptPerfBaseCryptLib) {
+    switch (Test) {
+    case CryptPerfSha1:
+      Sha1Init (mSha1Context);
+      Sha1Update (mSha1Context, Buffer, Size);
+      Sha1Final (mSha1Context, Digest);
+      break;
+
+    case CryptPerfSha256:
+      Sha256Init (mSha256Context);
+      Sha256Update (mSha256Context, Buffer, Size);
+      Sha256Final (mSha256Context, Digest);
+      break;
+
+    case CryptPerfAesEcbEncrypt:
+      AesEcbEncrypt (mAesContext, Buffer, Size, Buffer);
+      break;
+
+    case CryptPerfAesCbcEncrypt:
+      AesCbcEncrypt (mAesContext, Buffer, Size, mCryptPerfIvec, Buffer);
+      break;
+
+    default:
+      AesCbcDecrypt (mAesContext, Buffer, Size, mCryptPerfIvec, Buffer);
+      break;
+    }
+    return;
+  }
+
+  switch (Test) {
+  case CryptPerfSha1:
+    SHA1_Init (&Sha1Ctx);
+    SHA1_Update (&Sha1Ctx, Buffer, Size);
+    SHA1_Final (Digest, &Sha1Ctx);
+    break;
+
+  case CryptPerfSha256:
+    SHA256_Init (&Sha256Ctx);
+    SHA256_Update (&Sha256Ctx, Buffer, Size);
+    SHA256_Final (Digest, &Sha256Ctx);
+    break;
+
+  case CryptPerfAesEcbEncrypt:
+    for (Index = 0; Index < Size; Index += AES_BLOCK_SIZE) {
+      AES_ecb_encrypt (Buffer + Index, Buffer + Index, &mAesEncryptKey, AES_ENCRYPT);
+    }
+    break;
+
+  case CryptPerfAesCbcEncrypt:
+    CopyMem (Ivec, mCryptPerfIvec, sizeof (Ivec));
+    AES_cbc_encrypt (Buffer, Buffer, Size, &mAesEncryptKey, Ivec, AES_ENCRYPT);
+    break;
+
+  default:
+    CopyMem (Ivec, mCryptPerfIvec, sizeof (Ivec));
+    AES_cbc_encrypt (Buffer, Buffer, Size, &mAesDecryptKey, Ivec, AES_DECRYPT);
+    break;
+  }
+}
+
+/**
+  Checks that both backends return the same result for a test.
+
+  @param[in] Test               The test to check.
+  @param[in] Buffer             The data, at least CRYPT_PERF_CHECK_SIZE bytes.
+
+  @retval TRUE                  The results match.
+  @retval FALSE                 The results differ.
+
+**/
+BOOLEAN
+CheckCryptPerfBackends (
+  IN CRYPT_PERF_TEST  Test,
+  IN UINT8            *Buffer
+  )
+{
+  UINT8  Data[CryptPerfBackendMax][CRYPT_PERF_CHECK_SIZE];
+  UINT8  Digest[CryptPerfBackendMax][SHA256_DIGEST_SIZE];
+  UINTN  Backend;
+
+  for (Backend = 0; Backend < CryptPerfBackendMax; Backend++) {
+    CopyMem (Data[Backend], Buffer, CRYPT_PERF_CHECK_SIZE);
+    ZeroMem (Digest[Backend], SHA256_DIGEST_SIZE);
+    RunCryptPerfOperation (Test, (CRYPT_PERF_BACKEND) Backend, Data[Backend], CRYPT_PERF_CHECK_SIZE, Digest[Backend]);
+  }
+
+  return (BOOLEAN) (CompareMem (Data[0], Data[1], CRYPT_PERF_CHECK_SIZE) == 0 &&
+                    CompareMem (Digest[0], Digest[1], SHA256_DIGEST_SIZE) == 0);
+}
+
+/**
+  Counts how many operations of the given test complete on a buffer within
+  CRYPT_PERF_SECONDS and prints the throughput.
+
+  @param[in] Test               The test to run.
+  @param[in] Backend            The backend to run the test with.
+  @param[in] Buffer             The data.
+  @param[in] Size               The size of the data.
+
+  @retval EFI_SUCCESS           The test ran.
+  @retval other                 The timer event could not be created.
+
+**/
+EFI_STATUS
+MeasureCryptPerf (
+  IN CRYPT_PERF_TEST     Test,
+  IN CRYPT_PERF_BACKEND  Backend,
+  IN UINT8               *Buffer,
+  IN UINTN               Size
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  UINTN       Count;
+  UINT8       Digest[SHA256_DIGEST_SIZE];
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The timer period is in 100ns units
+  //
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x32 (CRYPT_PERF_SECONDS, 10000000));
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (TimerEvent);
+    return Status;
+  }
+
+  for (Count = 0; gBS->CheckEvent (TimerEvent) == EFI_NOT_READY; Count++) {
+    RunCryptPerfOperation (Test, Backend, Buffer, Size, Digest);
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  Print (
+    L"%-20s %-13s %10d bytes %8ld MB per second\n",
+    mCryptPerfTestName[Test],
+    mCryptPerfBackendName[Backend],
+    (UINT32) Size,
+    DivU64x32 (MultU64x64 (Count, Size), CRYPT_PERF_SECONDS * SIZE_1MB)
+    );
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the image goes into a library that calls this
+  function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS       Status;
+  UINT8            *Buffer;
+  UINT32           Seed;
+  UINTN            Index;
+  UINTN            Test;
+  UINTN            Backend;
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  UINT32           RegEbx;
+  UINT32           RegEcx;
+#endif
+
+  Status         = EFI_OUT_OF_RESOURCES;
+  Buffer         = AllocatePool (CRYPT_PERF_MAX_SIZE);
+  mSha1Context   = AllocatePool (Sha1GetContextSize ());
+  mSha256Context = AllocatePool (Sha256GetContextSize ());
+  mAesContext    = AllocatePool (AesGetContextSize ());
+  if (Buffer == NULL || mSha1Context == NULL || mSha256Context == NULL || mAesContext == NULL) {
+    Print (L"Failed to allocate the test buffers\n");
+    goto Done;
+  }
+
+  if (!AesInit (mAesContext, mCryptPerfKey, 128) ||
+      AES_set_encrypt_key (mCryptPerfKey, 128, &mAesEncryptKey) != 0 ||
+      AES_set_decrypt_key (mCryptPerfKey, 128, &mAesDecryptKey) != 0) {
+    Print (L"Failed to set up the AES key\n");
+    Status = EFI_DEVICE_ERROR;
+    goto Done;
+  }
+
+  //
+  // Fill the buffer with a pseudo random sequence.
+  //
+  Seed = 0x12345678;
+  for (Index = 0; Index < CRYPT_PERF_MAX_SIZE; Index++) {
+    Seed = Seed * 1103515245 + 12345;
+    Buffer[Index] = (UINT8) (Seed >> 16);
+  }
+
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+  AsmCpuidEx (7, 0, NULL, &RegEbx, NULL, NULL);
+  AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+  Print (
+    L"SHA Extensions %s, AES-NI %s\n",
+    ((RegEbx & BIT29) != 0) ? L"present" : L"absent",
+    ((RegEcx & BIT25) != 0) ? L"present" : L"absent"
+    );
+#endif
+
+  Print (L"%d seconds per test\n", CRYPT_PERF_SECONDS);
+  Status = EFI_SUCCESS;
+  for (Test = 0; Test < CryptPerfTestMax; Test++) {
+    //
+    // Both backends must agree before they are compared.
+    //
+    if (!CheckCryptPerfBackends ((CRYPT_PERF_TEST) Test, Buffer)) {
+      Print (L"%s: OpenSSL and BaseCryptLib results differ\n", mCryptPerfTestName[Test]);
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    for (Index = 0; Index < sizeof (mCryptPerfSize) / sizeof (mCryptPerfSize[0]); Index++) {
+      for (Backend = 0; Backend < CryptPerfBackendMax; Backend++) {
+        MeasureCryptPerf ((CRYPT_PERF_TEST) Test, (CRYPT_PERF_BACKEND) Backend, Buffer, mCryptPerfSize[Index]);
+      }
+    }
+  }
+
+Done:
+  if (Buffer != NULL) {
+    FreePool (Buffer);
+  }
+  if (mSha1Context != NULL) {
+    FreePool (mSha1Context);
+  }
+  if (mSha256Context != NULL) {
+    FreePool (mSha256Context);
+  }
+  if (mAesContext != NULL) {
+    FreePool (mAesContext);
+  }
+  return Status;
+}
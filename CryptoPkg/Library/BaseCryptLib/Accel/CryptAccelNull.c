@@ -0,0 +1,87 @@
+/** @file
+  Null implementation of the processor accelerated SHA-1, SHA-256 and AES
+  block operations. The OpenSSL C code is used instead.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "InternalCryptLib.h"
+
+/**
+  Hashes whole 64-byte blocks into a SHA-1 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 5 SHA-1 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+InternalSha1HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  )
+{
+  return FALSE;
+}
+
+/**
+  Hashes whole 64-byte blocks into a SHA-256 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 8 SHA-256 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+InternalSha256HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  )
+{
+  return FALSE;
+}
+
+/**
+  Encrypts or decrypts 16-byte blocks in ECB or CBC mode, if the processor has
+  instructions for it.
+
+  @param[in]   RoundKeys  The OpenSSL encryption or decryption key schedule.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The data to process.
+  @param[in]   InputSize  Size of the data in bytes, a multiple of 16.
+  @param[in]   Ivec       The initialization vector in CBC mode, NULL in ECB mode.
+  @param[in]   Encrypt    TRUE to encrypt, FALSE to decrypt.
+  @param[out]  Output     The processed data.
+
+  @retval FALSE  This interface is not supported.
+
+**/
+BOOLEAN
+InternalAesCryptBlocks (
+  IN   CONST UINT32  *RoundKeys,
+  IN   UINTN         Rounds,
+  IN   CONST UINT8   *Input,
+  IN   UINTN         InputSize,
+  IN   CONST UINT8   *Ivec,     OPTIONAL
+  IN   BOOLEAN       Encrypt,
+  OUT  UINT8         *Output
+  )
+{
+  return FALSE;
+}
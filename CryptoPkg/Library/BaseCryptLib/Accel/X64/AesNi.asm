@@ -0,0 +1,178 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   AesNi.asm
+;
+; Abstract:
+;
+;   AES block encryption and decryption using the AES-NI instructions
+;
+;------------------------------------------------------------------------------
+
+    .code
+
+;------------------------------------------------------------------------------
+; Encrypt the block in xmm0 with the round keys at rcx, rdx rounds.
+;------------------------------------------------------------------------------
+AesNiEncryptBlock   PROC    PRIVATE
+    mov     r10, rcx
+    mov     r11, rdx
+    pxor    xmm0, [r10]
+AesNiEncryptRound:
+    add     r10, 10h
+    dec     r11
+    jz      AesNiEncryptLast
+    aesenc  xmm0, [r10]
+    jmp     AesNiEncryptRound
+AesNiEncryptLast:
+    aesenclast xmm0, [r10]
+    ret
+AesNiEncryptBlock   ENDP
+
+;------------------------------------------------------------------------------
+; Decrypt the block in xmm0 with the round keys at rcx, rdx rounds.
+;------------------------------------------------------------------------------
+AesNiDecryptBlock   PROC    PRIVATE
+    mov     r10, rcx
+    mov     r11, rdx
+    pxor    xmm0, [r10]
+AesNiDecryptRound:
+    add     r10, 10h
+    dec     r11
+    jz      AesNiDecryptLast
+    aesdec  xmm0, [r10]
+    jmp     AesNiDecryptRound
+AesNiDecryptLast:
+    aesdeclast xmm0, [r10]
+    ret
+AesNiDecryptBlock   ENDP
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalAesNiEcbEncrypt (
+;   IN   CONST UINT8  *RoundKeys,
+;   IN   UINTN        Rounds,
+;   IN   CONST UINT8  *Input,
+;   OUT  UINT8        *Output,
+;   IN   UINTN        Blocks
+;   );
+;------------------------------------------------------------------------------
+InternalAesNiEcbEncrypt PROC
+    mov     rax, [rsp + 28h]            ; rax <- Blocks
+    test    rax, rax
+    jz      EcbEncryptDone
+EcbEncryptBlock:
+    movdqu  xmm0, [r8]
+    call    AesNiEncryptBlock
+    movdqu  [r9], xmm0
+    add     r8, 10h
+    add     r9, 10h
+    dec     rax
+    jnz     EcbEncryptBlock
+EcbEncryptDone:
+    ret
+InternalAesNiEcbEncrypt ENDP
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalAesNiEcbDecrypt (
+;   IN   CONST UINT8  *RoundKeys,
+;   IN   UINTN        Rounds,
+;   IN   CONST UINT8  *Input,
+;   OUT  UINT8        *Output,
+;   IN   UINTN        Blocks
+;   );
+;------------------------------------------------------------------------------
+InternalAesNiEcbDecrypt PROC
+    mov     rax, [rsp + 28h]            ; rax <- Blocks
+    test    rax, rax
+    jz      EcbDecryptDone
+EcbDecryptBlock:
+    movdqu  xmm0, [r8]
+    call    AesNiDecryptBlock
+    movdqu  [r9], xmm0
+    add     r8, 10h
+    add     r9, 10h
+    dec     rax
+    jnz     EcbDecryptBlock
+EcbDecryptDone:
+    ret
+InternalAesNiEcbDecrypt ENDP
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalAesNiCbcEncrypt (
+;   IN   CONST UINT8  *RoundKeys,
+;   IN   UINTN        Rounds,
+;   IN   CONST UINT8  *Input,
+;   OUT  UINT8        *Output,
+;   IN   UINTN        Blocks,
+;   IN   CONST UINT8  *Ivec
+;   );
+;------------------------------------------------------------------------------
+InternalAesNiCbcEncrypt PROC
+    mov     rax, [rsp + 28h]            ; rax <- Blocks
+    mov     r10, [rsp + 30h]            ; r10 <- Ivec
+    movdqu  xmm0, [r10]                 ; xmm0 <- Ivec
+    test    rax, rax
+    jz      CbcEncryptDone
+CbcEncryptBlock:
+    movdqu  xmm1, [r8]
+    pxor    xmm0, xmm1                  ; xmm0 <- Input ^ previous ciphertext
+    call    AesNiEncryptBlock
+    movdqu  [r9], xmm0
+    add     r8, 10h
+    add     r9, 10h
+    dec     rax
+    jnz     CbcEncryptBlock
+CbcEncryptDone:
+    ret
+InternalAesNiCbcEncrypt ENDP
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalAesNiCbcDecrypt (
+;   IN   CONST UINT8  *RoundKeys,
+;   IN   UINTN        Rounds,
+;   IN   CONST UINT8  *Input,
+;   OUT  UINT8        *Output,
+;   IN   UINTN        Blocks,
+;   IN   CONST UINT8  *Ivec
+;   );
+;------------------------------------------------------------------------------
+InternalAesNiCbcDecrypt PROC
+    mov     rax, [rsp + 28h]            ; rax <- Blocks
+    mov     r10, [rsp + 30h]            ; r10 <- Ivec
+    movdqu  xmm2, [r10]                 ; xmm2 <- Ivec
+    test    rax, rax
+    jz      CbcDecryptDone
+CbcDecryptBlock:
+    movdqu  xmm0, [r8]
+    movdqa  xmm1, xmm0                  ; xmm1 <- ciphertext, the next Ivec
+    call    AesNiDecryptBlock
+    pxor    xmm0, xmm2
+    movdqa  xmm2, xmm1
+    movdqu  [r9], xmm0
+    add     r8, 10h
+    add     r9, 10h
+    dec     rax
+    jnz     CbcDecryptBlock
+CbcDecryptDone:
+    ret
+InternalAesNiCbcDecrypt ENDP
+
+    END
@@ -0,0 +1,298 @@
+/** @file
+  Dispatch of SHA-1, SHA-256 and AES block operations to the Intel SHA Extensions
+  and AES-NI instructions, when the processor supports them.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "InternalCryptLib.h"
+
+//
+// Maximum number of AES rounds (AES-256)
+//
+#define AES_NI_MAX_ROUNDS     14
+
+BOOLEAN  mCryptCpuFeatureChecked = FALSE;
+BOOLEAN  mCryptShaNiSupported    = FALSE;
+BOOLEAN  mCryptAesNiSupported    = FALSE;
+
+/**
+  Hashes 64-byte blocks into a SHA-256 state with the SHA Extensions.
+
+  @param[in, out]  State    The 8 SHA-256 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+**/
+VOID
+EFIAPI
+InternalSha256ShaNiBlocks (
+  IN OUT  UINT32      *State,
+  IN      CONST VOID  *Data,
+  IN      UINTN       Blocks
+  );
+
+/**
+  Hashes 64-byte blocks into a SHA-1 state with the SHA Extensions.
+
+  @param[in, out]  State    The 5 SHA-1 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+**/
+VOID
+EFIAPI
+InternalSha1ShaNiBlocks (
+  IN OUT  UINT32      *State,
+  IN      CONST VOID  *Data,
+  IN      UINTN       Blocks
+  );
+
+/**
+  Encrypts 16-byte blocks in ECB mode with AES-NI.
+
+  @param[in]   RoundKeys  The encryption round keys, 16-byte aligned.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The blocks to encrypt.
+  @param[out]  Output     The encrypted blocks.
+  @param[in]   Blocks     Number of blocks.
+
+**/
+VOID
+EFIAPI
+InternalAesNiEcbEncrypt (
+  IN   CONST UINT8  *RoundKeys,
+  IN   UINTN        Rounds,
+  IN   CONST UINT8  *Input,
+  OUT  UINT8        *Output,
+  IN   UINTN        Blocks
+  );
+
+/**
+  Decrypts 16-byte blocks in ECB mode with AES-NI.
+
+  @param[in]   RoundKeys  The decryption round keys, 16-byte aligned.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The blocks to decrypt.
+  @param[out]  Output     The decrypted blocks.
+  @param[in]   Blocks     Number of blocks.
+
+**/
+VOID
+EFIAPI
+InternalAesNiEcbDecrypt (
+  IN   CONST UINT8  *RoundKeys,
+  IN   UINTN        Rounds,
+  IN   CONST UINT8  *Input,
+  OUT  UINT8        *Output,
+  IN   UINTN        Blocks
+  );
+
+/**
+  Encrypts 16-byte blocks in CBC mode with AES-NI.
+
+  @param[in]   RoundKeys  The encryption round keys, 16-byte aligned.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The blocks to encrypt.
+  @param[out]  Output     The encrypted blocks.
+  @param[in]   Blocks     Number of blocks.
+  @param[in]   Ivec       The initialization vector.
+
+**/
+VOID
+EFIAPI
+InternalAesNiCbcEncrypt (
+  IN   CONST UINT8  *RoundKeys,
+  IN   UINTN        Rounds,
+  IN   CONST UINT8  *Input,
+  OUT  UINT8        *Output,
+  IN   UINTN        Blocks,
+  IN   CONST UINT8  *Ivec
+  );
+
+/**
+  Decrypts 16-byte blocks in CBC mode with AES-NI.
+
+  @param[in]   RoundKeys  The decryption round keys, 16-byte aligned.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The blocks to decrypt.
+  @param[out]  Output     The decrypted blocks.
+  @param[in]   Blocks     Number of blocks.
+  @param[in]   Ivec       The initialization vector.
+
+**/
+VOID
+EFIAPI
+InternalAesNiCbcDecrypt (
+  IN   CONST UINT8  *RoundKeys,
+  IN   UINTN        Rounds,
+  IN   CONST UINT8  *Input,
+  OUT  UINT8        *Output,
+  IN   UINTN        Blocks,
+  IN   CONST UINT8  *Ivec
+  );
+
+/**
+  Detects the SHA Extensions and AES-NI support of the processor once.
+
+**/
+VOID
+InternalCryptCheckCpuFeatures (
+  VOID
+  )
+{
+  UINT32  MaxLeaf;
+  UINT32  Ebx;
+  UINT32  Ecx;
+
+  if (mCryptCpuFeatureChecked) {
+    return;
+  }
+
+  AsmCpuid (0, &MaxLeaf, NULL, NULL, NULL);
+  AsmCpuid (1, NULL, NULL, &Ecx, NULL);
+
+  //
+  // CPUID.01H:ECX.AESNI[bit 25]
+  //
+  mCryptAesNiSupported = (BOOLEAN) ((Ecx & BIT25) != 0);
+
+  //
+  // CPUID.(EAX=07H, ECX=0H):EBX.SHA[bit 29]. The kernels also use SSSE3
+  // (CPUID.01H:ECX[bit 9]) and SSE4.1 (CPUID.01H:ECX[bit 19]) instructions.
+  //
+  if ((MaxLeaf >= 7) && ((Ecx & BIT9) != 0) && ((Ecx & BIT19) != 0)) {
+    AsmCpuidEx (7, 0, NULL, &Ebx, NULL, NULL);
+    mCryptShaNiSupported = (BOOLEAN) ((Ebx & BIT29) != 0);
+  }
+
+  mCryptCpuFeatureChecked = TRUE;
+}
+
+/**
+  Hashes whole 64-byte blocks into a SHA-1 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 5 SHA-1 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval TRUE   The blocks were hashed.
+  @retval FALSE  The processor is not supported, nothing was hashed.
+
+**/
+BOOLEAN
+InternalSha1HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  )
+{
+  InternalCryptCheckCpuFeatures ();
+  if (!mCryptShaNiSupported) {
+    return FALSE;
+  }
+
+  InternalSha1ShaNiBlocks (State, Data, Blocks);
+  return TRUE;
+}
+
+/**
+  Hashes whole 64-byte blocks into a SHA-256 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 8 SHA-256 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval TRUE   The blocks were hashed.
+  @retval FALSE  The processor is not supported, nothing was hashed.
+
+**/
+BOOLEAN
+InternalSha256HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  )
+{
+  InternalCryptCheckCpuFeatures ();
+  if (!mCryptShaNiSupported) {
+    return FALSE;
+  }
+
+  InternalSha256ShaNiBlocks (State, Data, Blocks);
+  return TRUE;
+}
+
+/**
+  Encrypts or decrypts 16-byte blocks in ECB or CBC mode, if the processor has
+  instructions for it.
+
+  The OpenSSL key schedule holds each round key as 4 big-endian words, while
+  AES-NI takes the round keys as byte strings, so the words are swapped into
+  an aligned copy of the schedule first. OpenSSL builds the decryption key
+  schedule of the equivalent inverse cipher, which is the form AESDEC uses.
+
+  @param[in]   RoundKeys  The OpenSSL encryption or decryption key schedule.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The data to process.
+  @param[in]   InputSize  Size of the data in bytes, a multiple of 16.
+  @param[in]   Ivec       The initialization vector in CBC mode, NULL in ECB mode.
+  @param[in]   Encrypt    TRUE to encrypt, FALSE to decrypt.
+  @param[out]  Output     The processed data.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The processor is not supported, nothing was processed.
+
+**/
+BOOLEAN
+InternalAesCryptBlocks (
+  IN   CONST UINT32  *RoundKeys,
+  IN   UINTN         Rounds,
+  IN   CONST UINT8   *Input,
+  IN   UINTN         InputSize,
+  IN   CONST UINT8   *Ivec,     OPTIONAL
+  IN   BOOLEAN       Encrypt,
+  OUT  UINT8         *Output
+  )
+{
+  UINT8   KeyBuffer[(AES_NI_MAX_ROUNDS + 1) * 16 + 15];
+  UINT32  *Keys;
+  UINTN   Index;
+
+  InternalCryptCheckCpuFeatures ();
+  if (!mCryptAesNiSupported || (Rounds > AES_NI_MAX_ROUNDS)) {
+    return FALSE;
+  }
+
+  Keys = (UINT32 *) ALIGN_POINTER (KeyBuffer, 16);
+  for (Index = 0; Index < 4 * (Rounds + 1); Index++) {
+    Keys[Index] = SwapBytes32 (RoundKeys[Index]);
+  }
+
+  if (Ivec == NULL) {
+    if (Encrypt) {
+      InternalAesNiEcbEncrypt ((UINT8 *) Keys, Rounds, Input, Output, InputSize / 16);
+    } else {
+      InternalAesNiEcbDecrypt ((UINT8 *) Keys, Rounds, Input, Output, InputSize / 16);
+    }
+  } else {
+    if (Encrypt) {
+      InternalAesNiCbcEncrypt ((UINT8 *) Keys, Rounds, Input, Output, InputSize / 16, Ivec);
+    } else {
+      InternalAesNiCbcDecrypt ((UINT8 *) Keys, Rounds, Input, Output, InputSize / 16, Ivec);
+    }
+  }
+
+  ZeroMem (KeyBuffer, sizeof (KeyBuffer));
+  return TRUE;
+}
@@ -0,0 +1,173 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   Sha1ShaNi.asm
+;
+; Abstract:
+;
+;   SHA-1 block transform using the Intel SHA Extensions
+;
+; Notes:
+;
+;   The SHA instructions are encoded as bytes, for assemblers without them.
+;
+;------------------------------------------------------------------------------
+
+    .const
+
+ALIGN 16
+Sha1ByteFlip    DD  0c0d0e0fh, 08090a0bh, 04050607h, 00010203h
+
+    .code
+
+;------------------------------------------------------------------------------
+; Move the message words of the next 4 rounds into xmm6. xmm3 - xmm6 hold the
+; last 16 message words, rax is the index of the 4 rounds.
+;------------------------------------------------------------------------------
+Sha1NextMessage PROC    PRIVATE
+    movdqa  xmm0, xmm3
+    cmp     rax, 4
+    jb      Sha1Rotate
+    DB      0fh, 38h, 0c9h, 0c4h        ; sha1msg1 xmm0, xmm4
+    pxor    xmm0, xmm5
+    DB      0fh, 38h, 0cah, 0c6h        ; sha1msg2 xmm0, xmm6
+Sha1Rotate:
+    movdqa  xmm3, xmm4
+    movdqa  xmm4, xmm5
+    movdqa  xmm5, xmm6
+    movdqa  xmm6, xmm0
+    inc     rax
+    ret
+Sha1NextMessage ENDP
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalSha1ShaNiBlocks (
+;   IN OUT  UINT32      *State,
+;   IN      CONST VOID  *Data,
+;   IN      UINTN       Blocks
+;   );
+;------------------------------------------------------------------------------
+InternalSha1ShaNiBlocks PROC
+    sub     rsp, 58h
+    movdqu  [rsp], xmm6                 ; xmm6 - xmm10 are non-volatile
+    movdqu  [rsp + 10h], xmm7
+    movdqu  [rsp + 20h], xmm8
+    movdqu  [rsp + 30h], xmm9
+    movdqu  [rsp + 40h], xmm10
+
+    movdqu  xmm1, [rcx]                 ; xmm1 <- ABCD
+    pshufd  xmm1, xmm1, 1Bh
+    pxor    xmm2, xmm2
+    pinsrd  xmm2, dword ptr [rcx + 10h], 3  ; xmm2 <- E
+    movdqu  xmm8, xmmword ptr [Sha1ByteFlip]
+
+    test    r8, r8
+    jz      Sha1Done
+
+Sha1Block:
+    movdqa  xmm9, xmm1                  ; save the state of this block
+    movdqa  xmm10, xmm2
+    movdqu  xmm3, [rdx]                 ; xmm3 - xmm6 <- W[0..15]
+    pshufb  xmm3, xmm8
+    movdqu  xmm4, [rdx + 10h]
+    pshufb  xmm4, xmm8
+    movdqu  xmm5, [rdx + 20h]
+    pshufb  xmm5, xmm8
+    movdqu  xmm6, [rdx + 30h]
+    pshufb  xmm6, xmm8
+    xor     rax, rax
+
+    ;
+    ; Rounds 0 - 3
+    ;
+    call    Sha1NextMessage
+    paddd   xmm2, xmm6
+    movdqa  xmm7, xmm1
+    DB      0fh, 3ah, 0cch, 0cah, 00h   ; sha1rnds4 xmm1, xmm2, 0
+    movdqa  xmm2, xmm7
+
+    ;
+    ; Rounds 4 - 19
+    ;
+    mov     r9, 4
+Sha1Rounds0:
+    call    Sha1NextMessage
+    DB      0fh, 38h, 0c8h, 0d6h        ; sha1nexte xmm2, xmm6
+    movdqa  xmm7, xmm1
+    DB      0fh, 3ah, 0cch, 0cah, 00h   ; sha1rnds4 xmm1, xmm2, 0
+    movdqa  xmm2, xmm7
+    dec     r9
+    jnz     Sha1Rounds0
+
+    ;
+    ; Rounds 20 - 39
+    ;
+    mov     r9, 5
+Sha1Rounds1:
+    call    Sha1NextMessage
+    DB      0fh, 38h, 0c8h, 0d6h        ; sha1nexte xmm2, xmm6
+    movdqa  xmm7, xmm1
+    DB      0fh, 3ah, 0cch, 0cah, 01h   ; sha1rnds4 xmm1, xmm2, 1
+    movdqa  xmm2, xmm7
+    dec     r9
+    jnz     Sha1Rounds1
+
+    ;
+    ; Rounds 40 - 59
+    ;
+    mov     r9, 5
+Sha1Rounds2:
+    call    Sha1NextMessage
+    DB      0fh, 38h, 0c8h, 0d6h        ; sha1nexte xmm2, xmm6
+    movdqa  xmm7, xmm1
+    DB      0fh, 3ah, 0cch, 0cah, 02h   ; sha1rnds4 xmm1, xmm2, 2
+    movdqa  xmm2, xmm7
+    dec     r9
+    jnz     Sha1Rounds2
+
+    ;
+    ; Rounds 60 - 79
+    ;
+    mov     r9, 5
+Sha1Rounds3:
+    call    Sha1NextMessage
+    DB      0fh, 38h, 0c8h, 0d6h        ; sha1nexte xmm2, xmm6
+    movdqa  xmm7, xmm1
+    DB      0fh, 3ah, 0cch, 0cah, 03h   ; sha1rnds4 xmm1, xmm2, 3
+    movdqa  xmm2, xmm7
+    dec     r9
+    jnz     Sha1Rounds3
+
+    DB      41h, 0fh, 38h, 0c8h, 0d2h   ; sha1nexte xmm2, xmm10
+    paddd   xmm1, xmm9
+    add     rdx, 40h
+    dec     r8
+    jnz     Sha1Block
+
+Sha1Done:
+    pshufd  xmm1, xmm1, 1Bh
+    movdqu  [rcx], xmm1
+    pextrd  dword ptr [rcx + 10h], xmm2, 3
+
+    movdqu  xmm6, [rsp]
+    movdqu  xmm7, [rsp + 10h]
+    movdqu  xmm8, [rsp + 20h]
+    movdqu  xmm9, [rsp + 30h]
+    movdqu  xmm10, [rsp + 40h]
+    add     rsp, 58h
+    ret
+InternalSha1ShaNiBlocks ENDP
+
+    END
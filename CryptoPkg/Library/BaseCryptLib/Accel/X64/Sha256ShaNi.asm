@@ -0,0 +1,147 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   Sha256ShaNi.asm
+;
+; Abstract:
+;
+;   SHA-256 block transform using the Intel SHA Extensions
+;
+; Notes:
+;
+;   The SHA instructions are encoded as bytes, for assemblers without them.
+;
+;------------------------------------------------------------------------------
+
+    .const
+
+ALIGN 16
+Sha256ByteFlip  DD  00010203h, 04050607h, 08090a0bh, 0c0d0e0fh
+
+Sha256K         DD  0428a2f98h, 071374491h, 0b5c0fbcfh, 0e9b5dba5h
+                DD  03956c25bh, 059f111f1h, 0923f82a4h, 0ab1c5ed5h
+                DD  0d807aa98h, 012835b01h, 0243185beh, 0550c7dc3h
+                DD  072be5d74h, 080deb1feh, 09bdc06a7h, 0c19bf174h
+                DD  0e49b69c1h, 0efbe4786h, 00fc19dc6h, 0240ca1cch
+                DD  02de92c6fh, 04a7484aah, 05cb0a9dch, 076f988dah
+                DD  0983e5152h, 0a831c66dh, 0b00327c8h, 0bf597fc7h
+                DD  0c6e00bf3h, 0d5a79147h, 006ca6351h, 014292967h
+                DD  027b70a85h, 02e1b2138h, 04d2c6dfch, 053380d13h
+                DD  0650a7354h, 0766a0abbh, 081c2c92eh, 092722c85h
+                DD  0a2bfe8a1h, 0a81a664bh, 0c24b8b70h, 0c76c51a3h
+                DD  0d192e819h, 0d6990624h, 0f40e3585h, 0106aa070h
+                DD  019a4c116h, 01e376c08h, 02748774ch, 034b0bcb5h
+                DD  0391c0cb3h, 04ed8aa4ah, 05b9cca4fh, 0682e6ff3h
+                DD  0748f82eeh, 078a5636fh, 084c87814h, 08cc70208h
+                DD  090befffah, 0a4506cebh, 0bef9a3f7h, 0c67178f2h
+
+    .code
+
+;------------------------------------------------------------------------------
+; VOID
+; EFIAPI
+; InternalSha256ShaNiBlocks (
+;   IN OUT  UINT32      *State,
+;   IN      CONST VOID  *Data,
+;   IN      UINTN       Blocks
+;   );
+;------------------------------------------------------------------------------
+InternalSha256ShaNiBlocks   PROC
+    sub     rsp, 58h
+    movdqu  [rsp], xmm6                 ; xmm6 - xmm10 are non-volatile
+    movdqu  [rsp + 10h], xmm7
+    movdqu  [rsp + 20h], xmm8
+    movdqu  [rsp + 30h], xmm9
+    movdqu  [rsp + 40h], xmm10
+
+    movdqu  xmm1, [rcx]                 ; xmm1 <- DCBA
+    movdqu  xmm2, [rcx + 10h]           ; xmm2 <- HGFE
+    pshufd  xmm1, xmm1, 0B1h            ; xmm1 <- CDAB
+    pshufd  xmm2, xmm2, 1Bh             ; xmm2 <- EFGH
+    movdqa  xmm7, xmm1
+    palignr xmm1, xmm2, 8               ; xmm1 <- ABEF
+    pblendw xmm2, xmm7, 0F0h            ; xmm2 <- CDGH
+    movdqu  xmm8, xmmword ptr [Sha256ByteFlip]
+
+    test    r8, r8
+    jz      Sha256Done
+
+Sha256Block:
+    movdqa  xmm9, xmm1                  ; save the state of this block
+    movdqa  xmm10, xmm2
+    movdqu  xmm3, [rdx]                 ; xmm3 - xmm6 <- W[0..15]
+    pshufb  xmm3, xmm8
+    movdqu  xmm4, [rdx + 10h]
+    pshufb  xmm4, xmm8
+    movdqu  xmm5, [rdx + 20h]
+    pshufb  xmm5, xmm8
+    movdqu  xmm6, [rdx + 30h]
+    pshufb  xmm6, xmm8
+    lea     r10, [Sha256K]
+    xor     rax, rax
+
+Sha256Rounds:
+    ;
+    ; xmm3 - xmm6 hold the last 16 message words. Move the 4 words for these
+    ; rounds into xmm6, computing them from the previous ones after round 15.
+    ;
+    movdqa  xmm7, xmm3
+    cmp     rax, 4
+    jb      Sha256Rotate
+    DB      0fh, 38h, 0cch, 0fch        ; sha256msg1 xmm7, xmm4
+    movdqa  xmm0, xmm6
+    palignr xmm0, xmm5, 4
+    paddd   xmm7, xmm0
+    DB      0fh, 38h, 0cdh, 0feh        ; sha256msg2 xmm7, xmm6
+Sha256Rotate:
+    movdqa  xmm3, xmm4
+    movdqa  xmm4, xmm5
+    movdqa  xmm5, xmm6
+    movdqa  xmm6, xmm7
+
+    movdqu  xmm0, [r10]                 ; xmm0 <- W + K for 4 rounds
+    paddd   xmm0, xmm6
+    DB      0fh, 38h, 0cbh, 0d1h        ; sha256rnds2 xmm2, xmm1, xmm0
+    pshufd  xmm0, xmm0, 0Eh
+    DB      0fh, 38h, 0cbh, 0cah        ; sha256rnds2 xmm1, xmm2, xmm0
+
+    add     r10, 10h
+    inc     rax
+    cmp     rax, 16
+    jb      Sha256Rounds
+
+    paddd   xmm1, xmm9
+    paddd   xmm2, xmm10
+    add     rdx, 40h
+    dec     r8
+    jnz     Sha256Block
+
+Sha256Done:
+    pshufd  xmm1, xmm1, 1Bh             ; xmm1 <- FEBA
+    pshufd  xmm2, xmm2, 0B1h            ; xmm2 <- DCHG
+    movdqa  xmm7, xmm1
+    pblendw xmm1, xmm2, 0F0h            ; xmm1 <- DCBA
+    palignr xmm2, xmm7, 8               ; xmm2 <- HGFE
+    movdqu  [rcx], xmm1
+    movdqu  [rcx + 10h], xmm2
+
+    movdqu  xmm6, [rsp]
+    movdqu  xmm7, [rsp + 10h]
+    movdqu  xmm8, [rsp + 20h]
+    movdqu  xmm9, [rsp + 30h]
+    movdqu  xmm10, [rsp + 40h]
+    add     rsp, 58h
+    ret
+InternalSha256ShaNiBlocks   ENDP
+
+    END
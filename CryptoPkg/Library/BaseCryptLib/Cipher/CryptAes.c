@@ -128,6 +128,13 @@ AesEcbEncrypt (
   
   AesKey = (AES_KEY *) AesContext;
 
+  //
+  // Use the processor's AES instructions if it has them
+  //
+  if (InternalAesCryptBlocks ((CONST UINT32 *) AesKey->rd_key, (UINTN) AesKey->rounds, Input, InputSize, NULL, TRUE, Output)) {
+    return TRUE;
+  }
+
   //
   // Perform AES data encryption with ECB mode (block-by-block)
   //
@@ -185,6 +192,13 @@ AesEcbDecrypt (
 
   AesKey = (AES_KEY *) AesContext;
 
+  //
+  // Use the processor's AES instructions if it has them
+  //
+  if (InternalAesCryptBlocks ((CONST UINT32 *) (AesKey + 1)->rd_key, (UINTN) (AesKey + 1)->rounds, Input, InputSize, NULL, FALSE, Output)) {
+    return TRUE;
+  }
+
   //
   // Perform AES data decryption with ECB mode (block-by-block)
   //
@@ -252,6 +266,13 @@ AesCbcEncrypt (
   AesKey = (AES_KEY *) AesContext;
   CopyMem (IvecBuffer, Ivec, AES_BLOCK_SIZE);
 
+  //
+  // Use the processor's AES instructions if it has them
+  //
+  if (InternalAesCryptBlocks ((CONST UINT32 *) AesKey->rd_key, (UINTN) AesKey->rounds, Input, InputSize, IvecBuffer, TRUE, Output)) {
+    return TRUE;
+  }
+
   //
   // Perform AES data encryption with CBC mode
   //
@@ -314,6 +335,13 @@ AesCbcDecrypt (
   AesKey = (AES_KEY *) AesContext;
   CopyMem (IvecBuffer, Ivec, AES_BLOCK_SIZE);
 
+  //
+  // Use the processor's AES instructions if it has them
+  //
+  if (InternalAesCryptBlocks ((CONST UINT32 *) (AesKey + 1)->rd_key, (UINTN) (AesKey + 1)->rounds, Input, InputSize, IvecBuffer, FALSE, Output)) {
+    return TRUE;
+  }
+
   //
   // Perform AES data decryption with CBC mode
   //
@@ -123,6 +123,12 @@ Sha1Update (
   IN      UINTN       DataSize
   )
 {
+  SHA_CTX      *Context;
+  CONST UINT8  *Bytes;
+  UINTN        Fill;
+  UINTN        Length;
+  SHA_LONG     Low;
+
   //
   // Check input parameters.
   //
@@ -137,10 +143,42 @@ Sha1Update (
     return FALSE;
   }
 
+  Context = (SHA_CTX *) Sha1Context;
+  Bytes   = (CONST UINT8 *) Data;
+
+  //
+  // Complete the block buffered in the context through OpenSSL, then hash the
+  // whole blocks with the processor's SHA instructions if it has them.
+  //
+  Fill = (SHA_CBLOCK - ((Context->Nl >> 3) & (SHA_CBLOCK - 1))) & (SHA_CBLOCK - 1);
+  if (DataSize >= Fill + SHA_CBLOCK) {
+    if (!SHA1_Update (Context, Bytes, Fill)) {
+      return FALSE;
+    }
+    Bytes    += Fill;
+    DataSize -= Fill;
+
+    Length = DataSize & ~((UINTN) SHA_CBLOCK - 1);
+    if (InternalSha1HashBlocks ((UINT32 *) &Context->h0, Bytes, Length / SHA_CBLOCK)) {
+      //
+      // Account for the hashed bits the way OpenSSL does.
+      //
+      Low = (SHA_LONG) (Context->Nl + (SHA_LONG) (Length << 3));
+      if (Low < Context->Nl) {
+        Context->Nh++;
+      }
+      Context->Nh += (SHA_LONG) (Length >> 29);
+      Context->Nl  = Low;
+
+      Bytes    += Length;
+      DataSize -= Length;
+    }
+  }
+
   //
   // OpenSSL SHA-1 Hash Update
   //
-  return (BOOLEAN) (SHA1_Update ((SHA_CTX *) Sha1Context, Data, DataSize));
+  return (BOOLEAN) (SHA1_Update (Context, Bytes, DataSize));
 }
 
 /**
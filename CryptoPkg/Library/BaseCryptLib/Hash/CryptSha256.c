@@ -122,6 +122,12 @@ Sha256Update (
   IN      UINTN       DataSize
   )
 {
+  SHA256_CTX   *Context;
+  CONST UINT8  *Bytes;
+  UINTN        Fill;
+  UINTN        Length;
+  SHA_LONG     Low;
+
   //
   // Check input parameters.
   //
@@ -136,10 +142,42 @@ Sha256Update (
     return FALSE;
   }
 
+  Context = (SHA256_CTX *) Sha256Context;
+  Bytes   = (CONST UINT8 *) Data;
+
+  //
+  // Complete the block buffered in the context through OpenSSL, then hash the
+  // whole blocks with the processor's SHA instructions if it has them.
+  //
+  Fill = (SHA256_CBLOCK - ((Context->Nl >> 3) & (SHA256_CBLOCK - 1))) & (SHA256_CBLOCK - 1);
+  if (DataSize >= Fill + SHA256_CBLOCK) {
+    if (!SHA256_Update (Context, Bytes, Fill)) {
+      return FALSE;
+    }
+    Bytes    += Fill;
+    DataSize -= Fill;
+
+    Length = DataSize & ~((UINTN) SHA256_CBLOCK - 1);
+    if (InternalSha256HashBlocks (Context->h, Bytes, Length / SHA256_CBLOCK)) {
+      //
+      // Account for the hashed bits the way OpenSSL does.
+      //
+      Low = (SHA_LONG) (Context->Nl + (SHA_LONG) (Length << 3));
+      if (Low < Context->Nl) {
+        Context->Nh++;
+      }
+      Context->Nh += (SHA_LONG) (Length >> 29);
+      Context->Nl  = Low;
+
+      Bytes    += Length;
+      DataSize -= Length;
+    }
+  }
+
   //
   // OpenSSL SHA-256 Hash Update
   //
-  return (BOOLEAN) (SHA256_Update ((SHA256_CTX *) Sha256Context, Data, DataSize));
+  return (BOOLEAN) (SHA256_Update (Context, Bytes, DataSize));
 }
 
 /**
@@ -30,5 +30,70 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define OPENSSL_SYSNAME_UWIN
 #endif
 
+/**
+  Hashes whole 64-byte blocks into a SHA-1 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 5 SHA-1 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval TRUE   The blocks were hashed.
+  @retval FALSE  The processor is not supported, nothing was hashed.
+
+**/
+BOOLEAN
+InternalSha1HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  );
+
+/**
+  Hashes whole 64-byte blocks into a SHA-256 state, if the processor has
+  instructions for it.
+
+  @param[in, out]  State    The 8 SHA-256 state words.
+  @param[in]       Data     The blocks to hash.
+  @param[in]       Blocks   Number of blocks.
+
+  @retval TRUE   The blocks were hashed.
+  @retval FALSE  The processor is not supported, nothing was hashed.
+
+**/
+BOOLEAN
+InternalSha256HashBlocks (
+  IN OUT  UINT32       *State,
+  IN      CONST UINT8  *Data,
+  IN      UINTN        Blocks
+  );
+
+/**
+  Encrypts or decrypts 16-byte blocks in ECB or CBC mode, if the processor has
+  instructions for it.
+
+  @param[in]   RoundKeys  The OpenSSL encryption or decryption key schedule.
+  @param[in]   Rounds     Number of rounds.
+  @param[in]   Input      The data to process.
+  @param[in]   InputSize  Size of the data in bytes, a multiple of 16.
+  @param[in]   Ivec       The initialization vector in CBC mode, NULL in ECB mode.
+  @param[in]   Encrypt    TRUE to encrypt, FALSE to decrypt.
+  @param[out]  Output     The processed data.
+
+  @retval TRUE   The data was processed.
+  @retval FALSE  The processor is not supported, nothing was processed.
+
+**/
+BOOLEAN
+InternalAesCryptBlocks (
+  IN   CONST UINT32  *RoundKeys,
+  IN   UINTN         Rounds,
+  IN   CONST UINT8   *Input,
+  IN   UINTN         InputSize,
+  IN   CONST UINT8   *Ivec,     OPTIONAL
+  IN   BOOLEAN       Encrypt,
+  OUT  UINT8         *Output
+  );
+
 #endif
 
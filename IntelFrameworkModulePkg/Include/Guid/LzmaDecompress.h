@@ -1,7 +1,7 @@
 /** @file
   Lzma Custom decompress algorithm Guid definition.
 
-Copyright (c) 2009 - 2012, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2009 - 2014, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials are licensed and made available under 
 the terms and conditions of the BSD License that accompanies this distribution.  
 The full text of the license may be found at
@@ -29,7 +29,16 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define LZMAF86_CUSTOM_DECOMPRESS_GUID  \
   { 0xD42AE6BD, 0x1352, 0x4bfb, { 0x90, 0x9A, 0xCA, 0x72, 0xA6, 0xEA, 0xE8, 0x89 } }
 
+///
+/// The Global ID used to identify a section of an FFS file of type
+/// EFI_SECTION_GUID_DEFINED, whose contents have been split into chunks
+/// compressed independently using LZMA.
+///
+#define LZMA_CHUNKED_CUSTOM_DECOMPRESS_GUID  \
+  { 0x26A4A09F, 0x43D8, 0x4E58, { 0xA3, 0xF5, 0x50, 0xCA, 0x90, 0xCF, 0xA4, 0xEE } }
+
 extern GUID gLzmaCustomDecompressGuid;
 extern GUID gLzmaF86CustomDecompressGuid;
+extern GUID gLzmaChunkedCustomDecompressGuid;
 
 #endif
@@ -0,0 +1,254 @@
+/** @file
+  Chunked LZMA Decompress GUIDed Section Extraction.
+
+  The data of a chunked LZMA section is a LZMA_CHUNKED_HEADER, followed by the
+  compressed size of every chunk and by the chunks themselves. Each chunk is a
+  complete LZMA stream, so the build tool can compress the chunks in parallel.
+  The chunks are decompressed one after the other into consecutive parts of
+  the output buffer.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+/**
+  Walk the chunks of a chunked LZMA buffer, checking that they are consistent
+  with the header, and decompress them when Destination is not NULL.
+
+  @param  Source          The source buffer containing the chunked data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  Destination     The destination buffer to store the decompressed data,
+                          or NULL to only check the chunks.
+  @param  Scratch         A temporary scratch buffer that is used to perform the decompression.
+  @param  DestinationSize Return the size, in bytes, of the uncompressed data.
+  @param  ScratchSize     Return the size, in bytes, of the scratch buffer required
+                          to decompress every chunk.
+
+  @retval RETURN_SUCCESS            The chunks are consistent, and decompressed
+                                    if Destination is not NULL.
+  @retval RETURN_INVALID_PARAMETER  The source buffer is corrupted.
+**/
+RETURN_STATUS
+LzmaChunkedDecompressWorker (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  IN  VOID        *Destination,   OPTIONAL
+  IN  VOID        *Scratch,       OPTIONAL
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  RETURN_STATUS               Status;
+  CONST LZMA_CHUNKED_HEADER   *Header;
+  CONST UINT32                *ChunkSizes;
+  CONST UINT8                 *Chunk;
+  UINT32                      Offset;
+  UINT32                      OutputOffset;
+  UINT32                      ExpectedSize;
+  UINT32                      ChunkOutputSize;
+  UINT32                      ChunkScratchSize;
+  UINT32                      Index;
+
+  Header = (CONST LZMA_CHUNKED_HEADER *) Source;
+  if ((SourceSize < sizeof (LZMA_CHUNKED_HEADER)) ||
+      (Header->ChunkCount > (SourceSize - sizeof (LZMA_CHUNKED_HEADER)) / sizeof (UINT32)) ||
+      ((Header->ChunkCount == 0) != (Header->UncompressedSize == 0)) ||
+      ((Header->ChunkCount != 0) && (Header->ChunkSize == 0))) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  ChunkSizes   = (CONST UINT32 *) (Header + 1);
+  Offset       = (UINT32) (sizeof (LZMA_CHUNKED_HEADER) + Header->ChunkCount * sizeof (UINT32));
+  OutputOffset = 0;
+  *ScratchSize = 0;
+
+  for (Index = 0; Index < Header->ChunkCount; Index++) {
+    if ((ChunkSizes[Index] < LZMA_CHUNK_HEADER_SIZE) || (ChunkSizes[Index] > SourceSize - Offset)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    //
+    // Every chunk holds ChunkSize bytes except the last one, which holds the rest.
+    //
+    ExpectedSize = Header->UncompressedSize - OutputOffset;
+    if (Index + 1 < Header->ChunkCount) {
+      if (Header->ChunkSize >= ExpectedSize) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      ExpectedSize = Header->ChunkSize;
+    } else if (ExpectedSize > Header->ChunkSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Chunk  = (CONST UINT8 *) Source + Offset;
+    Status = LzmaUefiDecompressGetInfo (Chunk, ChunkSizes[Index], &ChunkOutputSize, &ChunkScratchSize);
+    if (RETURN_ERROR (Status) || (ChunkOutputSize != ExpectedSize)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    *ScratchSize = MAX (*ScratchSize, ChunkScratchSize);
+
+    if (Destination != NULL) {
+      Status = LzmaUefiDecompress (Chunk, ChunkSizes[Index], (UINT8 *) Destination + OutputOffset, Scratch);
+      if (RETURN_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    Offset       += ChunkSizes[Index];
+    OutputOffset += ChunkOutputSize;
+  }
+
+  *DestinationSize = Header->UncompressedSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Examines a chunked LZMA GUIDed section and returns the size of the decoded buffer
+  and the size of the scratch buffer required to decode it.
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section. See the Attributes
+                                 field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  if (IS_SECTION2 (InputSection)) {
+    if (!CompareGuid (
+        &gLzmaChunkedCustomDecompressGuid,
+        &(((EFI_GUID_DEFINED_SECTION2 *) InputSection)->SectionDefinitionGuid))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->Attributes;
+
+    return LzmaChunkedDecompressWorker (
+             (UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset,
+             SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset,
+             NULL,
+             NULL,
+             OutputBufferSize,
+             ScratchBufferSize
+             );
+  } else {
+    if (!CompareGuid (
+        &gLzmaChunkedCustomDecompressGuid,
+        &(((EFI_GUID_DEFINED_SECTION *) InputSection)->SectionDefinitionGuid))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *) InputSection)->Attributes;
+
+    return LzmaChunkedDecompressWorker (
+             (UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset,
+             SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset,
+             NULL,
+             NULL,
+             OutputBufferSize,
+             ScratchBufferSize
+             );
+  }
+}
+
+/**
+  Decompress a chunked LZMA GUIDed section into a caller allocated output buffer.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer  A pointer to a buffer that contains the result of a decode operation.
+  @param[out] ScratchBuffer A caller allocated buffer that may be required by this function
+                            as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                            A pointer to the authentication status of the decoded output buffer.
+                            See the definition of authentication status in the EFI_PEI_GUIDED_SECTION_EXTRACTION_PPI
+                            section of the PI Specification. EFI_AUTH_STATUS_PLATFORM_OVERRIDE must
+                            never be set by this handler.
+
+  @retval  RETURN_SUCCESS            The buffer specified by InputSection was decoded.
+  @retval  RETURN_INVALID_PARAMETER  The section specified by InputSection can not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer,        OPTIONAL
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  UINT32            OutputBufferSize;
+  UINT32            ScratchBufferSize;
+
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (InputSection != NULL);
+
+  if (IS_SECTION2 (InputSection)) {
+    if (!CompareGuid (
+        &gLzmaChunkedCustomDecompressGuid,
+        &(((EFI_GUID_DEFINED_SECTION2 *) InputSection)->SectionDefinitionGuid))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    //
+    // Authentication is set to Zero, which may be ignored.
+    //
+    *AuthenticationStatus = 0;
+
+    return LzmaChunkedDecompressWorker (
+             (UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset,
+             SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset,
+             *OutputBuffer,
+             ScratchBuffer,
+             &OutputBufferSize,
+             &ScratchBufferSize
+             );
+  } else {
+    if (!CompareGuid (
+        &gLzmaChunkedCustomDecompressGuid,
+        &(((EFI_GUID_DEFINED_SECTION *) InputSection)->SectionDefinitionGuid))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    //
+    // Authentication is set to Zero, which may be ignored.
+    //
+    *AuthenticationStatus = 0;
+
+    return LzmaChunkedDecompressWorker (
+             (UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset,
+             SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset,
+             *OutputBuffer,
+             ScratchBuffer,
+             &OutputBufferSize,
+             &ScratchBufferSize
+             );
+  }
+}
@@ -182,7 +182,8 @@ LzmaGuidedSectionExtraction (
 
 
 /**
-  Register LzmaDecompress and LzmaDecompressGetInfo handlers with LzmaCustomerDecompressGuid.
+  Register LzmaDecompress and LzmaDecompressGetInfo handlers with LzmaCustomerDecompressGuid,
+  and the chunked handlers with LzmaChunkedCustomDecompressGuid.
 
   @retval  RETURN_SUCCESS            Register successfully.
   @retval  RETURN_OUT_OF_RESOURCES   No enough memory to store this handler.
@@ -192,10 +193,21 @@ EFIAPI
 LzmaDecompressLibConstructor (
   )
 {
+  RETURN_STATUS  Status;
+
+  Status = ExtractGuidedSectionRegisterHandlers (
+             &gLzmaCustomDecompressGuid,
+             LzmaGuidedSectionGetInfo,
+             LzmaGuidedSectionExtraction
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
   return ExtractGuidedSectionRegisterHandlers (
-          &gLzmaCustomDecompressGuid,
-          LzmaGuidedSectionGetInfo,
-          LzmaGuidedSectionExtraction
-          );      
+           &gLzmaChunkedCustomDecompressGuid,
+           LzmaChunkedGuidedSectionGetInfo,
+           LzmaChunkedGuidedSectionExtraction
+           );
 }
 
@@ -22,6 +22,21 @@
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Guid/LzmaDecompress.h>
 
+//
+// The LZMA properties and the uncompressed size in front of every LZMA stream.
+//
+#define LZMA_CHUNK_HEADER_SIZE  13
+
+//
+// Header of the data of a chunked LZMA section.
+//
+typedef struct {
+  UINT32  UncompressedSize;
+  UINT32  ChunkSize;      ///< Uncompressed size of every chunk but the last one.
+  UINT32  ChunkCount;
+//UINT32  CompressedChunkSize[ChunkCount];
+} LZMA_CHUNKED_HEADER;
+
 /**
   Given a Lzma compressed source buffer, this function retrieves the size of 
   the uncompressed buffer and the size of the scratch buffer required 
@@ -92,5 +107,56 @@ LzmaUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+/**
+  Examines a chunked LZMA GUIDed section and returns the size of the decoded buffer
+  and the size of the scratch buffer required to decode it.
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section. See the Attributes
+                                 field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  );
+
+/**
+  Decompress a chunked LZMA GUIDed section into a caller allocated output buffer.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer  A pointer to a buffer that contains the result of a decode operation.
+  @param[out] ScratchBuffer A caller allocated buffer that may be required by this function
+                            as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                            A pointer to the authentication status of the decoded output buffer.
+                            See the definition of authentication status in the EFI_PEI_GUIDED_SECTION_EXTRACTION_PPI
+                            section of the PI Specification. EFI_AUTH_STATUS_PLATFORM_OVERRIDE must
+                            never be set by this handler.
+
+  @retval  RETURN_SUCCESS            The buffer specified by InputSection was decoded.
+  @retval  RETURN_INVALID_PARAMETER  The section specified by InputSection can not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer,        OPTIONAL
+  OUT       UINT32  *AuthenticationStatus
+  );
+
 #endif
 
@@ -0,0 +1,154 @@
+/** @file
+  Measures the throughput of the CRC32 implementations. For buffer sizes from
+  16 bytes to 32MB, CalculateCrc32() of BaseLib and the CalculateCrc32() boot
+  service are each run over a fixed period, and the results are printed as MB
+  per second.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#define CRC32_PERF_SECONDS       1
+#define CRC32_PERF_MAX_SIZE      SIZE_32MB
+
+typedef enum {
+  Crc32PerfBaseLib,
+  Crc32PerfBootService
+} CRC32_PERF_TEST;
+
+UINTN   mCrc32PerfSize[] = {
+  16, 64, 256, SIZE_1KB, SIZE_4KB, SIZE_16KB, SIZE_64KB, SIZE_1MB, SIZE_32MB
+};
+
+/**
+  Counts how many CRC32 operations of the given test complete on a buffer
+  within CRC32_PERF_SECONDS and prints the throughput.
+
+  @param[in] Test               The test to run.
+  @param[in] Description        The description of the test to print.
+  @param[in] Buffer             The buffer to compute the CRC32 of.
+  @param[in] Size               The size of the buffer.
+
+  @retval EFI_SUCCESS           The test ran.
+  @retval other                 The timer event could not be created.
+
+**/
+EFI_STATUS
+MeasureCrc32Perf (
+  IN CRC32_PERF_TEST  Test,
+  IN CHAR16           *Description,
+  IN VOID             *Buffer,
+  IN UINTN            Size
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  UINTN       Count;
+  UINT32      Crc;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The timer period is in 100ns units
+  //
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x32 (CRC32_PERF_SECONDS, 10000000));
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (TimerEvent);
+    return Status;
+  }
+
+  for (Count = 0; gBS->CheckEvent (TimerEvent) == EFI_NOT_READY; Count++) {
+    if (Test == Crc32PerfBaseLib) {
+      Crc = CalculateCrc32 (Buffer, Size);
+    } else {
+      gBS->CalculateCrc32 (Buffer, Size, &Crc);
+    }
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  Print (
+    L"%-24s %10d bytes %10ld MB per second\n",
+    Description,
+    (UINT32) Size,
+    DivU64x32 (MultU64x64 (Count, Size), CRC32_PERF_SECONDS * SIZE_1MB)
+    );
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the image goes into a library that calls this
+  function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINT8       *Buffer;
+  UINT32      Crc;
+  UINT32      BootServiceCrc;
+  UINTN       Index;
+
+  Buffer = AllocatePool (CRC32_PERF_MAX_SIZE);
+  if (Buffer == NULL) {
+    Print (L"Failed to allocate the test buffer\n");
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Fill the buffer with a pseudo random sequence.
+  //
+  Crc = 0x12345678;
+  for (Index = 0; Index < CRC32_PERF_MAX_SIZE; Index++) {
+    Crc = Crc * 1103515245 + 12345;
+    Buffer[Index] = (UINT8) (Crc >> 16);
+  }
+
+  Print (L"%d seconds per test\n", CRC32_PERF_SECONDS);
+  for (Index = 0; Index < sizeof (mCrc32PerfSize) / sizeof (mCrc32PerfSize[0]); Index++) {
+    //
+    // Both implementations must agree before they are compared.
+    //
+    Crc = CalculateCrc32 (Buffer, mCrc32PerfSize[Index]);
+    gBS->CalculateCrc32 (Buffer, mCrc32PerfSize[Index], &BootServiceCrc);
+    if (Crc != BootServiceCrc) {
+      Print (L"CRC32 mismatch at %d bytes: %08x, boot service %08x\n", (UINT32) mCrc32PerfSize[Index], Crc, BootServiceCrc);
+      FreePool (Buffer);
+      return EFI_DEVICE_ERROR;
+    }
+
+    MeasureCrc32Perf (Crc32PerfBaseLib,     L"BaseLib CalculateCrc32",  Buffer, mCrc32PerfSize[Index]);
+    MeasureCrc32Perf (Crc32PerfBootService, L"gBS->CalculateCrc32",     Buffer, mCrc32PerfSize[Index]);
+  }
+
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/** @file
+  Measures the request rate of the HII Config Routing protocol. The current
+  configuration of every varstore is exported once, then ExtractConfig() of
+  each <ConfigHdr>, ExtractConfig() of each full <ConfigRequest> and
+  RouteConfig() of each unchanged <ConfigResp> are counted over a fixed
+  period each, and the results are printed as requests per second.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+#include <Protocol/HiiConfigRouting.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#define HII_ROUTING_PERF_SECONDS   2
+
+typedef enum {
+  HiiRoutingPerfExtractHdr,
+  HiiRoutingPerfExtractRequest,
+  HiiRoutingPerfRoute,
+  HiiRoutingPerfExport
+} HII_ROUTING_PERF_TEST;
+
+//
+// The strings of one varstore taken from the ExportConfig() result.
+//
+typedef struct {
+  EFI_STRING  ConfigHdr;        // <ConfigHdr>
+  EFI_STRING  ConfigRequest;    // <ConfigHdr> and the <RequestElement>s of <ConfigResp>
+  EFI_STRING  ConfigResp;       // <ConfigResp> without <AltResp>
+} HII_ROUTING_PERF_STORAGE;
+
+EFI_HII_CONFIG_ROUTING_PROTOCOL  *mHiiConfigRouting;
+HII_ROUTING_PERF_STORAGE         *mStorage;
+UINTN                            mStorageCount;
+
+/**
+  Runs one request of the given test.
+
+  @param[in] Test               The test to run.
+  @param[in] Iteration          The number of requests run so far.
+
+  @retval EFI_SUCCESS           The request succeeded.
+  @retval other                 The request failed.
+
+**/
+EFI_STATUS
+RunHiiRoutingPerfOperation (
+  IN HII_ROUTING_PERF_TEST  Test,
+  IN UINTN                  Iteration
+  )
+{
+  EFI_STATUS                Status;
+  HII_ROUTING_PERF_STORAGE  *Storage;
+  EFI_STRING                Progress;
+  EFI_STRING                Results;
+
+  Storage = &mStorage[Iteration % mStorageCount];
+  Results = NULL;
+
+  switch (Test) {
+  case HiiRoutingPerfExtractHdr:
+    Status = mHiiConfigRouting->ExtractConfig (mHiiConfigRouting, Storage->ConfigHdr, &Progress, &Results);
+    break;
+
+  case HiiRoutingPerfExtractRequest:
+    Status = mHiiConfigRouting->ExtractConfig (mHiiConfigRouting, Storage->ConfigRequest, &Progress, &Results);
+    break;
+
+  case HiiRoutingPerfRoute:
+    Status = mHiiConfigRouting->RouteConfig (mHiiConfigRouting, Storage->ConfigResp, &Progress);
+    break;
+
+  default:
+    Status = mHiiConfigRouting->ExportConfig (mHiiConfigRouting, &Results);
+    break;
+  }
+
+  if (Results != NULL) {
+    FreePool (Results);
+  }
+
+  return Status;
+}
+
+/**
+  Counts how many requests of the given test complete within
+  HII_ROUTING_PERF_SECONDS and prints the rate.
+
+  @param[in] Test               The test to run.
+  @param[in] Description        The description of the test to print.
+
+  @retval EFI_SUCCESS           The test ran.
+  @retval other                 The timer event could not be created.
+
+**/
+EFI_STATUS
+MeasureHiiRoutingPerf (
+  IN HII_ROUTING_PERF_TEST  Test,
+  IN CHAR16                 *Description
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  UINTN       Count;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The timer period is in 100ns units
+  //
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x32 (HII_ROUTING_PERF_SECONDS, 10000000));
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (TimerEvent);
+    return Status;
+  }
+
+  for (Count = 0; gBS->CheckEvent (TimerEvent) == EFI_NOT_READY; Count++) {
+    RunHiiRoutingPerfOperation (Test, Count);
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  Print (L"%-32s %10ld per second\n", Description, (UINT64) (Count / HII_ROUTING_PERF_SECONDS));
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the length of the <ConfigHdr> at the beginning of a configuration
+  string, i.e. up to the '&' or the end of the string after the PATH value.
+
+  @param[in] String             String in <ConfigResp> format.
+
+  @return The number of Unicode characters of the <ConfigHdr>, 0 if String
+          has no PATH.
+
+**/
+UINTN
+GetConfigHdrLength (
+  IN EFI_STRING  String
+  )
+{
+  EFI_STRING  StringPtr;
+
+  StringPtr = StrStr (String, L"&PATH=");
+  if (StringPtr == NULL) {
+    return 0;
+  }
+
+  for (StringPtr += StrLen (L"&PATH="); *StringPtr != L'\0' && *StringPtr != L'&'; StringPtr++);
+  return StringPtr - String;
+}
+
+/**
+  Splits the <MultiConfigAltResp> returned by ExportConfig() into the strings
+  of each varstore, skipping the <AltResp> of the default stores.
+
+  @param[in] MultiConfigAltResp The ExportConfig() result. It is modified.
+
+  @retval EFI_SUCCESS           mStorage and mStorageCount are filled in.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory for the strings.
+
+**/
+EFI_STATUS
+CollectStorage (
+  IN EFI_STRING  MultiConfigAltResp
+  )
+{
+  EFI_STRING                StringPtr;
+  EFI_STRING                NextPtr;
+  UINTN                     Count;
+  UINTN                     HdrLength;
+  HII_ROUTING_PERF_STORAGE  *Storage;
+  EFI_STRING                ElementPtr;
+  EFI_STRING                ElementEnd;
+  EFI_STRING                RequestPtr;
+  UINTN                     Length;
+
+  Count = 1;
+  for (StringPtr = StrStr (MultiConfigAltResp, L"&GUID="); StringPtr != NULL; StringPtr = StrStr (StringPtr + 1, L"&GUID=")) {
+    Count++;
+  }
+
+  mStorage = AllocateZeroPool (Count * sizeof (HII_ROUTING_PERF_STORAGE));
+  if (mStorage == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mStorageCount = 0;
+  for (StringPtr = MultiConfigAltResp; StringPtr != NULL; StringPtr = NextPtr) {
+    //
+    // Terminate this <ConfigResp> or <AltResp> at the next "&GUID=".
+    //
+    NextPtr = StrStr (StringPtr, L"&GUID=");
+    if (NextPtr != NULL) {
+      *NextPtr = L'\0';
+      NextPtr++;
+    }
+
+    HdrLength = GetConfigHdrLength (StringPtr);
+    if (HdrLength == 0 || StrnCmp (StringPtr + HdrLength, L"&ALTCFG=", StrLen (L"&ALTCFG=")) == 0) {
+      continue;
+    }
+
+    Storage = &mStorage[mStorageCount];
+    Storage->ConfigHdr     = AllocateCopyPool ((HdrLength + 1) * sizeof (CHAR16), StringPtr);
+    Storage->ConfigResp    = AllocateCopyPool (StrSize (StringPtr), StringPtr);
+    Storage->ConfigRequest = AllocateZeroPool (StrSize (StringPtr));
+    if (Storage->ConfigHdr == NULL || Storage->ConfigResp == NULL || Storage->ConfigRequest == NULL) {
+      mStorageCount++;
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Storage->ConfigHdr[HdrLength] = L'\0';
+
+    //
+    // Build the <ConfigRequest> from the <ConfigResp>: keep OFFSET and WIDTH,
+    // drop VALUE and keep only the name of each name/value pair.
+    //
+    CopyMem (Storage->ConfigRequest, StringPtr, HdrLength * sizeof (CHAR16));
+    RequestPtr = Storage->ConfigRequest + HdrLength;
+    for (ElementPtr = StringPtr + HdrLength; *ElementPtr == L'&'; ElementPtr = ElementEnd) {
+      for (ElementEnd = ElementPtr + 1; *ElementEnd != L'\0' && *ElementEnd != L'&'; ElementEnd++);
+      if (StrnCmp (ElementPtr, L"&VALUE=", StrLen (L"&VALUE=")) == 0) {
+        continue;
+      }
+      if (StrnCmp (ElementPtr, L"&OFFSET=", StrLen (L"&OFFSET=")) == 0 ||
+          StrnCmp (ElementPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) == 0) {
+        Length = ElementEnd - ElementPtr;
+      } else {
+        for (Length = 1; ElementPtr + Length < ElementEnd && ElementPtr[Length] != L'='; Length++);
+      }
+      CopyMem (RequestPtr, ElementPtr, Length * sizeof (CHAR16));
+      RequestPtr += Length;
+    }
+
+    mStorageCount++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the image goes into a library that calls this 
+  function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.  
+  @param[in] SystemTable    A pointer to the EFI System Table.
+  
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  EFI_STRING  Results;
+  UINTN       Index;
+
+  Status = gBS->LocateProtocol (&gEfiHiiConfigRoutingProtocolGuid, NULL, (VOID **) &mHiiConfigRouting);
+  if (EFI_ERROR (Status)) {
+    Print (L"HII Config Routing protocol is not found - %r\n", Status);
+    return Status;
+  }
+
+  Status = mHiiConfigRouting->ExportConfig (mHiiConfigRouting, &Results);
+  if (EFI_ERROR (Status)) {
+    Print (L"ExportConfig failed - %r\n", Status);
+    return Status;
+  }
+
+  Status = CollectStorage (Results);
+  FreePool (Results);
+
+  if (!EFI_ERROR (Status) && mStorageCount == 0) {
+    Print (L"No varstore is exported\n");
+    Status = EFI_NOT_FOUND;
+  }
+
+  if (!EFI_ERROR (Status)) {
+    //
+    // Every request must succeed before the requests are timed.
+    //
+    for (Index = 0; Index < mStorageCount * HiiRoutingPerfExport; Index++) {
+      Status = RunHiiRoutingPerfOperation ((HII_ROUTING_PERF_TEST) (Index / mStorageCount), Index);
+      if (EFI_ERROR (Status)) {
+        Print (L"Request failed on %s - %r\n", mStorage[Index % mStorageCount].ConfigHdr, Status);
+        break;
+      }
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Print (L"%d varstores, %d seconds per test\n", (UINT32) mStorageCount, HII_ROUTING_PERF_SECONDS);
+    MeasureHiiRoutingPerf (HiiRoutingPerfExtractHdr,     L"ExtractConfig (<ConfigHdr>)");
+    MeasureHiiRoutingPerf (HiiRoutingPerfExtractRequest, L"ExtractConfig (<ConfigRequest>)");
+    MeasureHiiRoutingPerf (HiiRoutingPerfRoute,          L"RouteConfig (unchanged)");
+    MeasureHiiRoutingPerf (HiiRoutingPerfExport,         L"ExportConfig");
+  }
+
+  for (Index = 0; Index < mStorageCount; Index++) {
+    if (mStorage[Index].ConfigHdr != NULL) {
+      FreePool (mStorage[Index].ConfigHdr);
+    }
+    if (mStorage[Index].ConfigRequest != NULL) {
+      FreePool (mStorage[Index].ConfigRequest);
+    }
+    if (mStorage[Index].ConfigResp != NULL) {
+      FreePool (mStorage[Index].ConfigResp);
+    }
+  }
+  if (mStorage != NULL) {
+    FreePool (mStorage);
+  }
+
+  return Status;
+}
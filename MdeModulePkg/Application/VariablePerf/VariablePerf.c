@@ -0,0 +1,196 @@
+/** @file
+  Measures the lookup rate of the Variable services. A set of volatile test
+  variables is created, then GetVariable() hits, GetVariable() misses and
+  GetNextVariableName() steps are counted over a fixed period each, and the
+  results are printed as operations per second.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PrintLib.h>
+
+#define VARIABLE_PERF_VARIABLE_COUNT   256
+#define VARIABLE_PERF_NAME_LENGTH      32
+#define VARIABLE_PERF_SECONDS          2
+
+typedef enum {
+  VariablePerfGetHit,
+  VariablePerfGetMiss,
+  VariablePerfGetNext
+} VARIABLE_PERF_TEST;
+
+EFI_GUID  mVariablePerfGuid = { 0x363800cf, 0xd336, 0x4913, { 0x96, 0x84, 0x83, 0xa2, 0x94, 0xc2, 0xf7, 0x48 } };
+
+CHAR16    mVariablePerfName[VARIABLE_PERF_VARIABLE_COUNT][VARIABLE_PERF_NAME_LENGTH];
+
+/**
+  Runs one operation of the given test.
+
+  @param[in]      Test          The test to run.
+  @param[in]      Iteration     The number of operations run so far.
+  @param[in, out] NextName      The GetNextVariableName() iteration name buffer.
+  @param[in, out] NextGuid      The GetNextVariableName() iteration GUID.
+
+**/
+VOID
+RunVariablePerfOperation (
+  IN     VARIABLE_PERF_TEST  Test,
+  IN     UINTN               Iteration,
+  IN OUT CHAR16              *NextName,
+  IN OUT EFI_GUID            *NextGuid
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Data;
+  UINTN       DataSize;
+
+  DataSize = sizeof (Data);
+  switch (Test) {
+  case VariablePerfGetHit:
+    gRT->GetVariable (
+           mVariablePerfName[Iteration % VARIABLE_PERF_VARIABLE_COUNT],
+           &mVariablePerfGuid,
+           NULL,
+           &DataSize,
+           &Data
+           );
+    break;
+
+  case VariablePerfGetMiss:
+    gRT->GetVariable (L"VariablePerfMissing", &mVariablePerfGuid, NULL, &DataSize, &Data);
+    break;
+
+  case VariablePerfGetNext:
+    DataSize = VARIABLE_PERF_NAME_LENGTH * sizeof (CHAR16) * 8;
+    Status = gRT->GetNextVariableName (&DataSize, NextName, NextGuid);
+    if (EFI_ERROR (Status)) {
+      //
+      // Wrap around to the first variable
+      //
+      NextName[0] = L'\0';
+    }
+    break;
+  }
+}
+
+/**
+  Counts how many operations of the given test complete within
+  VARIABLE_PERF_SECONDS and prints the rate.
+
+  @param[in] Test               The test to run.
+  @param[in] Description        The description of the test to print.
+
+  @retval EFI_SUCCESS           The test ran.
+  @retval other                 The timer event could not be created.
+
+**/
+EFI_STATUS
+MeasureVariablePerf (
+  IN VARIABLE_PERF_TEST  Test,
+  IN CHAR16              *Description
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  UINTN       Count;
+  CHAR16      NextName[VARIABLE_PERF_NAME_LENGTH * 8];
+  EFI_GUID    NextGuid;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  NextName[0] = L'\0';
+  ZeroMem (&NextGuid, sizeof (NextGuid));
+
+  //
+  // The timer period is in 100ns units
+  //
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x32 (VARIABLE_PERF_SECONDS, 10000000));
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (TimerEvent);
+    return Status;
+  }
+
+  for (Count = 0; gBS->CheckEvent (TimerEvent) == EFI_NOT_READY; Count++) {
+    RunVariablePerfOperation (Test, Count, NextName, &NextGuid);
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  Print (L"%-32s %10ld per second\n", Description, (UINT64) (Count / VARIABLE_PERF_SECONDS));
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the image goes into a library that calls this 
+  function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.  
+  @param[in] SystemTable    A pointer to the EFI System Table.
+  
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+
+  //
+  // Create the test variables
+  //
+  for (Index = 0; Index < VARIABLE_PERF_VARIABLE_COUNT; Index++) {
+    UnicodeSPrint (mVariablePerfName[Index], sizeof (mVariablePerfName[Index]), L"VariablePerf%04d", Index);
+    Status = gRT->SetVariable (
+                    mVariablePerfName[Index],
+                    &mVariablePerfGuid,
+                    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                    sizeof (Index),
+                    &Index
+                    );
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to create test variable %s - %r\n", mVariablePerfName[Index], Status);
+      break;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Print (L"%d test variables, %d seconds per test\n", VARIABLE_PERF_VARIABLE_COUNT, VARIABLE_PERF_SECONDS);
+    MeasureVariablePerf (VariablePerfGetHit,  L"GetVariable (existing)");
+    MeasureVariablePerf (VariablePerfGetMiss, L"GetVariable (not found)");
+    MeasureVariablePerf (VariablePerfGetNext, L"GetNextVariableName");
+  }
+
+  //
+  // Delete the test variables
+  //
+  while (Index-- != 0) {
+    gRT->SetVariable (mVariablePerfName[Index], &mVariablePerfGuid, 0, 0, NULL);
+  }
+
+  return Status;
+}
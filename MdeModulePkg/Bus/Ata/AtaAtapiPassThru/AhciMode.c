@@ -528,6 +528,7 @@ AhciBuildCommand (
   UINTN      MemAddr;
   DATA_64    Data64;
   UINT32     Offset;
+  UINTN      CmdListIndex;
 
   //
   // Filling the PRDT
@@ -594,16 +595,20 @@ AhciBuildCommand (
     AhciRegisters->AhciCommandTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
   }
 
+  //
+  // Each port has its own command list.
+  //
+  CmdListIndex = (UINTN) Port * EFI_AHCI_MAX_COMMAND_SLOTS + CommandSlotNumber;
   CopyMem (
-    (VOID *) ((UINTN) AhciRegisters->AhciCmdList + (UINTN) CommandSlotNumber * sizeof (EFI_AHCI_COMMAND_LIST)),
+    &AhciRegisters->AhciCmdList[CmdListIndex],
     CommandList,
     sizeof (EFI_AHCI_COMMAND_LIST)
     );
 
   Data64.Uint64 = (UINT64)(UINTN) AhciRegisters->AhciCommandTablePciAddr;
-  AhciRegisters->AhciCmdList[CommandSlotNumber].AhciCmdCtba  = Data64.Uint32.Lower32;
-  AhciRegisters->AhciCmdList[CommandSlotNumber].AhciCmdCtbau = Data64.Uint32.Upper32;
-  AhciRegisters->AhciCmdList[CommandSlotNumber].AhciCmdPmp   = PortMultiplier;
+  AhciRegisters->AhciCmdList[CmdListIndex].AhciCmdCtba  = Data64.Uint32.Lower32;
+  AhciRegisters->AhciCmdList[CmdListIndex].AhciCmdCtbau = Data64.Uint32.Upper32;
+  AhciRegisters->AhciCmdList[CmdListIndex].AhciCmdPmp   = PortMultiplier;
 
 }
 
@@ -795,7 +800,7 @@ AhciPioTransfer (
           break;
         }
 
-        PrdCount = *(volatile UINT32 *) (&(AhciRegisters->AhciCmdList[0].AhciCmdPrdbc));
+        PrdCount = *(volatile UINT32 *) (&(AhciRegisters->AhciCmdList[Port * EFI_AHCI_MAX_COMMAND_SLOTS].AhciCmdPrdbc));
         if (PrdCount == DataCount) {
           break;
         }
@@ -1240,28 +1245,26 @@ AhciStopCommand (
 }
 
 /**
-  Start command for give slot on specific port.
+  Enable the FIS receive and set PxCMD.ST for giving port, so that the commands
+  issued through PxCI are processed.
 
   @param  PciIo              The PCI IO protocol instance.
   @param  Port               The number of port.
-  @param  CommandSlot        The number of Command Slot.
   @param  Timeout            The timeout value of start, uses 100ns as a unit.
 
-  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_DEVICE_ERROR   The port start unsuccessfully.
   @retval EFI_TIMEOUT        The operation is time out.
-  @retval EFI_SUCCESS        The command start successfully.
+  @retval EFI_SUCCESS        The port start successfully.
 
 **/
 EFI_STATUS
 EFIAPI
-AhciStartCommand (
+AhciStartPort (
   IN  EFI_PCI_IO_PROTOCOL       *PciIo,
   IN  UINT8                     Port,
-  IN  UINT8                     CommandSlot,
   IN  UINT64                    Timeout
   )
 {
-  UINT32     CmdSlotBit;
   EFI_STATUS Status;
   UINT32     PortStatus;
   UINT32     StartCmd;
@@ -1274,8 +1277,6 @@ AhciStartCommand (
   //
   Capability = AhciReadReg(PciIo, EFI_AHCI_CAPABILITY_OFFSET);
 
-  CmdSlotBit = (UINT32) (1 << CommandSlot);
-
   AhciClearPortStatus (
     PciIo,
     Port
@@ -1322,6 +1323,42 @@ AhciStartCommand (
   Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
   AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_ST | StartCmd);
 
+  return EFI_SUCCESS;
+}
+
+/**
+  Start command for give slot on specific port.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  Port               The number of port.
+  @param  CommandSlot        The number of Command Slot.
+  @param  Timeout            The timeout value of start, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_TIMEOUT        The operation is time out.
+  @retval EFI_SUCCESS        The command start successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciStartCommand (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  UINT8                     Port,
+  IN  UINT8                     CommandSlot,
+  IN  UINT64                    Timeout
+  )
+{
+  UINT32     CmdSlotBit;
+  EFI_STATUS Status;
+  UINT32     Offset;
+
+  CmdSlotBit = (UINT32) (1 << CommandSlot);
+
+  Status = AhciStartPort (PciIo, Port, Timeout);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   //
   // Setting the command
   //
@@ -1405,6 +1442,420 @@ AhciPortReset (
   return EFI_SUCCESS;
 }
 
+/**
+  Build the command table and the command list entry of a native command queuing
+  command. Every port and command slot has its own command table so that the
+  queued commands can be outstanding at the same time.
+
+  @param  AhciRegisters         The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port                  The number of port.
+  @param  PortMultiplier        The timeout value of stop.
+  @param  CommandFis            The control fis will be used for the transfer.
+  @param  Read                  The transfer direction.
+  @param  CommandSlotNumber     The command slot will be used for the transfer.
+  @param  DataPhysicalAddr      The pointer to the data buffer pci bus master address.
+  @param  DataLength            The data count to be transferred.
+
+**/
+VOID
+EFIAPI
+AhciBuildNcqCommand (
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     EFI_AHCI_COMMAND_FIS       *CommandFis,
+  IN     BOOLEAN                    Read,
+  IN     UINT8                      CommandSlotNumber,
+  IN     EFI_PHYSICAL_ADDRESS       DataPhysicalAddr,
+  IN     UINT32                     DataLength
+  )
+{
+  EFI_AHCI_NCQ_COMMAND_TABLE *CommandTable;
+  EFI_AHCI_COMMAND_LIST      *CommandList;
+  UINTN                      Index;
+  UINT32                     PrdtNumber;
+  UINT32                     PrdtIndex;
+  UINTN                      RemainedData;
+  UINT64                     MemAddr;
+  DATA_64                    Data64;
+
+  PrdtNumber = (UINT32)DivU64x32 (((UINT64)DataLength + EFI_AHCI_MAX_DATA_PER_PRDT - 1), EFI_AHCI_MAX_DATA_PER_PRDT);
+  ASSERT (PrdtNumber <= EFI_AHCI_NCQ_MAX_PRDT);
+
+  Index        = (UINTN) Port * EFI_AHCI_MAX_COMMAND_SLOTS + CommandSlotNumber;
+  CommandTable = &AhciRegisters->AhciNcqCommandTable[Index];
+  ZeroMem (CommandTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+
+  CommandFis->AhciCFisPmNum = PortMultiplier;
+  CopyMem (&CommandTable->CommandFis, CommandFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+  RemainedData = (UINTN) DataLength;
+  MemAddr      = DataPhysicalAddr;
+  for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+    if (RemainedData < EFI_AHCI_MAX_DATA_PER_PRDT) {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = (UINT32)RemainedData - 1;
+    } else {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = EFI_AHCI_MAX_DATA_PER_PRDT - 1;
+    }
+
+    Data64.Uint64 = MemAddr;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+    RemainedData -= EFI_AHCI_MAX_DATA_PER_PRDT;
+    MemAddr      += EFI_AHCI_MAX_DATA_PER_PRDT;
+  }
+
+  if (PrdtNumber > 0) {
+    CommandTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
+  }
+
+  CommandList = &AhciRegisters->AhciCmdList[Index];
+  ZeroMem (CommandList, sizeof (EFI_AHCI_COMMAND_LIST));
+  CommandList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+  CommandList->AhciCmdW     = Read ? 0 : 1;
+  CommandList->AhciCmdPmp   = PortMultiplier;
+  CommandList->AhciCmdPrdtl = PrdtNumber;
+
+  Data64.Uint64 = (UINT64)(UINTN) &AhciRegisters->AhciNcqCommandTablePciAddr[Index];
+  CommandList->AhciCmdCtba  = Data64.Uint32.Lower32;
+  CommandList->AhciCmdCtbau = Data64.Uint32.Upper32;
+}
+
+/**
+  Check whether the native command queuing command in the given slot is done.
+
+  @param[in]       PciIo             The PCI IO protocol instance.
+  @param[in]       AhciRegisters     The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port              The number of port.
+  @param[in]       CommandSlot       The command slot used by the command.
+  @param[in, out]  Task              Optional. Pointer to the ATA_NONBLOCK_TASK used by
+                                     non-blocking mode. If NULL, then just try once.
+
+  @retval EFI_NOT_READY     The command is still outstanding.
+  @retval EFI_TIMEOUT       The retry times out.
+  @retval EFI_DEVICE_ERROR  The command or another command queued on the port failed.
+  @retval EFI_SUCCESS       The command completes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciCheckNcqCommand (
+  IN     EFI_PCI_IO_PROTOCOL        *PciIo,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      CommandSlot,
+  IN OUT ATA_NONBLOCK_TASK          *Task
+  )
+{
+  UINT32     SlotBit;
+  UINT32     Offset;
+  UINT32     Outstanding;
+
+  if (Task != NULL) {
+    Task->RetryTimes--;
+  }
+
+  //
+  // The error recovery stops the port, which also clears PxSACT and PxCI, so
+  // the aborted commands have to be checked first.
+  //
+  SlotBit = (UINT32) (1 << CommandSlot);
+  if ((AhciRegisters->NcqAbortedSlots[Port] & SlotBit) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Offset      = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+  Outstanding = AhciReadReg (PciIo, Offset);
+  Offset      = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+  Outstanding |= AhciReadReg (PciIo, Offset);
+  if ((Outstanding & SlotBit) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The HBA stops processing the queue of the port when any queued command fails.
+  //
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+  if ((AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_IS_TFES) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+  if ((AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_TFD_ERR) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if ((Task != NULL) && !Task->InfiniteWait && (Task->RetryTimes == 0)) {
+    return EFI_TIMEOUT;
+  } else {
+    return EFI_NOT_READY;
+  }
+}
+
+/**
+  Recover a port from a failed native command queuing command.
+
+  A device aborts all the commands queued on it when one of them fails, so all
+  the outstanding commands of the port are marked as aborted and the port is
+  reset to bring the device out of the error state.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqErrorRecovery (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port
+  )
+{
+  EFI_STATUS Status;
+  UINT32     Offset;
+
+  DEBUG ((EFI_D_ERROR, "AHCI port [%d] queued command error, outstanding slots %x\n", Port, AhciRegisters->NcqActiveSlots[Port]));
+
+  AhciRegisters->NcqAbortedSlots[Port] |= AhciRegisters->NcqActiveSlots[Port];
+
+  Status = AhciPortReset (PciIo, Port, EFI_AHCI_BUS_RESET_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // Wait for the device to post its signature after the COMRESET.
+  //
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+  AhciWaitMmioSet (
+    PciIo,
+    Offset,
+    EFI_AHCI_PORT_TFD_BSY | EFI_AHCI_PORT_TFD_DRQ,
+    0,
+    EFI_AHCI_BUS_RESET_TIMEOUT
+    );
+
+  AhciClearPortStatus (PciIo, Port);
+}
+
+/**
+  Start a native command queuing (READ/WRITE FPDMA QUEUED) data transfer on
+  specific port.
+
+  The command gets a free command slot of the port and is issued without waiting
+  for the commands already outstanding on the port, so up to the queue depth of
+  the device can be in flight at the same time on each port. The command slot
+  number is used as the NCQ tag.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The timeout value of stop.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of non data transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_DEVICE_ERROR    The data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_UNSUPPORTED     The port doesn't support native command queuing.
+  @retval EFI_NOT_READY       The command isn't finished yet, or all the command
+                              slots of the port are in use.
+  @retval EFI_SUCCESS         The data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     BOOLEAN                    Read,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK       *AtaStatusBlock,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT32                     DataCount,
+  IN     UINT64                     Timeout,
+  IN     ATA_NONBLOCK_TASK          *Task
+  )
+{
+  EFI_STATUS                    Status;
+  UINT32                        Offset;
+  EFI_PHYSICAL_ADDRESS          PhyAddr;
+  VOID                          *Map;
+  UINTN                         MapLength;
+  EFI_PCI_IO_PROTOCOL_OPERATION Flag;
+  EFI_AHCI_COMMAND_FIS          CFis;
+  UINT32                        FreeSlots;
+  UINT8                         Slot;
+  UINT64                        Delay;
+  EFI_PCI_IO_PROTOCOL           *PciIo;
+
+  PciIo = Instance->PciIo;
+
+  if (PciIo == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (AhciRegisters->NcqQueueDepth[Port] == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((Task == NULL) || (!Task->IsStart)) {
+    FreeSlots = ~AhciRegisters->NcqActiveSlots[Port];
+    if (AhciRegisters->NcqQueueDepth[Port] < EFI_AHCI_MAX_COMMAND_SLOTS) {
+      FreeSlots &= (UINT32) ((1 << AhciRegisters->NcqQueueDepth[Port]) - 1);
+    }
+
+    if (FreeSlots == 0) {
+      return EFI_NOT_READY;
+    }
+    Slot = (UINT8) LowBitSet32 (FreeSlots);
+
+    if (Read) {
+      Flag = EfiPciIoOperationBusMasterWrite;
+    } else {
+      Flag = EfiPciIoOperationBusMasterRead;
+    }
+
+    MapLength = DataCount;
+    Status = PciIo->Map (
+                      PciIo,
+                      Flag,
+                      MemoryAddr,
+                      &MapLength,
+                      &PhyAddr,
+                      &Map
+                      );
+
+    if (EFI_ERROR (Status) || (DataCount != MapLength)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    //
+    // The tag of a queued command is in the bits 7:3 of the sector count field,
+    // and the bit 7 of the device field is the FUA bit rather than an obsolete
+    // bit which is always set for the other commands.
+    //
+    AhciBuildCommandFis (&CFis, AtaCommandBlock);
+    CFis.AhciCFisSecCount = (UINT8) (Slot << 3);
+    CFis.AhciCFisDevHead  = (UINT8) (AtaCommandBlock->AtaDeviceHead | BIT6);
+
+    AhciBuildNcqCommand (
+      AhciRegisters,
+      Port,
+      PortMultiplier,
+      &CFis,
+      Read,
+      Slot,
+      PhyAddr,
+      DataCount
+      );
+
+    //
+    // Only the first queued command starts the port. PxSACT and PxCI are
+    // written with the bit of the new slot alone since writing zero bits
+    // has no effect on them.
+    //
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+    if ((AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_CMD_ST) == 0) {
+      Status = AhciStartPort (PciIo, Port, Timeout);
+      if (EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Map);
+        return Status;
+      }
+    }
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWriteReg (PciIo, Offset, (UINT32) (1 << Slot));
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+    AhciWriteReg (PciIo, Offset, (UINT32) (1 << Slot));
+
+    AhciRegisters->NcqActiveSlots[Port] |= (UINT32) (1 << Slot);
+
+    if (Task != NULL) {
+      Task->IsStart     = TRUE;
+      Task->Map         = Map;
+      Task->CommandSlot = Slot;
+    }
+  } else {
+    Slot = Task->CommandSlot;
+    Map  = Task->Map;
+  }
+
+  //
+  // Wait for command compelte
+  //
+  if (Task != NULL) {
+    //
+    // For Non-blocking
+    //
+    Status = AhciCheckNcqCommand (PciIo, AhciRegisters, Port, Slot, Task);
+    if (Status == EFI_NOT_READY) {
+      return Status;
+    }
+  } else {
+    Delay = DivU64x32 (Timeout, 1000) + 1;
+    do {
+      Status = AhciCheckNcqCommand (PciIo, AhciRegisters, Port, Slot, NULL);
+      if (Status != EFI_NOT_READY) {
+        break;
+      }
+
+      //
+      // Stall for 100 microseconds.
+      //
+      MicroSecondDelay (100);
+
+      Delay--;
+    } while ((Timeout == 0) || (Delay > 0));
+
+    if (Status == EFI_NOT_READY) {
+      Status = EFI_TIMEOUT;
+    }
+  }
+
+  if (EFI_ERROR (Status) &&
+      ((AhciRegisters->NcqAbortedSlots[Port] & (UINT32) (1 << Slot)) == 0)) {
+    AhciNcqErrorRecovery (PciIo, AhciRegisters, Port);
+  }
+
+  //
+  // Release the slot, and stop the port once its queue is empty as the other
+  // transfer functions expect an idle port to be stopped.
+  //
+  AhciRegisters->NcqActiveSlots[Port]  &= (UINT32) ~(1 << Slot);
+  AhciRegisters->NcqAbortedSlots[Port] &= (UINT32) ~(1 << Slot);
+  if (AhciRegisters->NcqActiveSlots[Port] == 0) {
+    AhciStopCommand (
+      PciIo,
+      Port,
+      Timeout
+      );
+
+    AhciDisableFisReceive (
+      PciIo,
+      Port,
+      Timeout
+      );
+  }
+
+  PciIo->Unmap (PciIo, Map);
+
+  AhciDumpPortStatus (PciIo, Port, AtaStatusBlock);
+  if (EFI_ERROR (Status) && (AtaStatusBlock != NULL)) {
+    AtaStatusBlock->AtaStatus |= BIT0;
+  }
+
+  return Status;
+}
+
 /**
   Do AHCI HBA reset.
 
@@ -1964,6 +2415,8 @@ AhciCreateTransferDescriptor (
   EFI_PHYSICAL_ADDRESS  AhciRFisPciAddr;
   EFI_PHYSICAL_ADDRESS  AhciCmdListPciAddr;
   EFI_PHYSICAL_ADDRESS  AhciCommandTablePciAddr;
+  UINT64                MaxNcqCommandTableSize;
+  EFI_PHYSICAL_ADDRESS  AhciNcqCommandTablePciAddr;
 
   Buffer = NULL;
   //
@@ -2033,10 +2486,11 @@ AhciCreateTransferDescriptor (
 
   //
   // Allocate memory for command list
-  // Note that the implemenation is a single task model which only use a command list for all ports.
+  // Each port has its own 1K bytes command list so that the ports can run commands
+  // at the same time.
   //
   Buffer = NULL;
-  MaxCommandListSize = MaxCommandSlotNumber * sizeof (EFI_AHCI_COMMAND_LIST);
+  MaxCommandListSize = MaxPortNumber * EFI_AHCI_MAX_COMMAND_SLOTS * sizeof (EFI_AHCI_COMMAND_LIST);
   Status = PciIo->AllocateBuffer (
                     PciIo,
                     AllocateAnyPages,
@@ -2142,6 +2596,52 @@ AhciCreateTransferDescriptor (
   }
   AhciRegisters->AhciCommandTablePciAddr = (EFI_AHCI_COMMAND_TABLE *)(UINTN)AhciCommandTablePciAddr;
 
+  //
+  // Allocate memory for the command tables of native command queuing, one per port
+  // and command slot. Native command queuing is just not used if it fails.
+  //
+  if ((Capability & EFI_AHCI_CAP_SNCQ) != 0) {
+    Buffer = NULL;
+    MaxNcqCommandTableSize = MaxPortNumber * EFI_AHCI_MAX_COMMAND_SLOTS * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+                      &Buffer,
+                      0
+                      );
+    if (!EFI_ERROR (Status)) {
+      ZeroMem (Buffer, (UINTN)MaxNcqCommandTableSize);
+      Bytes  = (UINTN)MaxNcqCommandTableSize;
+
+      Status = PciIo->Map (
+                        PciIo,
+                        EfiPciIoOperationBusMasterCommonBuffer,
+                        Buffer,
+                        &Bytes,
+                        &AhciNcqCommandTablePciAddr,
+                        &AhciRegisters->MapNcqCommandTable
+                        );
+      if (!EFI_ERROR (Status) && (Bytes == MaxNcqCommandTableSize) &&
+          (Support64Bit || (AhciNcqCommandTablePciAddr <= 0x100000000ULL))) {
+        AhciRegisters->AhciNcqCommandTable        = Buffer;
+        AhciRegisters->AhciNcqCommandTablePciAddr = (EFI_AHCI_NCQ_COMMAND_TABLE *)(UINTN)AhciNcqCommandTablePciAddr;
+        AhciRegisters->MaxNcqCommandTableSize     = MaxNcqCommandTableSize;
+      } else {
+        if (!EFI_ERROR (Status)) {
+          PciIo->Unmap (PciIo, AhciRegisters->MapNcqCommandTable);
+        }
+        PciIo->FreeBuffer (
+                 PciIo,
+                 EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+                 Buffer
+                 );
+      }
+    }
+  }
+
   return EFI_SUCCESS;
   //
   // Map error or unable to map the whole CmdList buffer into a contiguous region.
@@ -2188,6 +2688,11 @@ Error6:
 
   The function is designed to initialize ATA host controller.
 
+  All the implemented ports are started at first, then they are polled together
+  until each of them either has a device ready for commands or is found empty, so
+  the device detection time of the ports overlaps. At last the devices found are
+  identified and configured one by one.
+
   @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
 
 **/
@@ -2214,7 +2719,11 @@ AhciModeInitialization (
   EFI_ATA_DEVICE_TYPE              DeviceType;
   EFI_ATA_COLLECTIVE_MODE          *SupportedModes;
   EFI_ATA_TRANSFER_MODE            TransferMode;
-  UINT32                           PhyDetectDelay;
+  UINT8                            MaxCommandSlotNumber;
+  UINT32                           SkipPortBitMap;
+  UINT32                           PendingPortBitMap;
+  EFI_AHCI_PORT_INIT_STATE         PortState[EFI_AHCI_MAX_PORTS];
+  UINT32                           PortDelay[EFI_AHCI_MAX_PORTS];
 
   if (Instance == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -2243,6 +2752,7 @@ AhciModeInitialization (
   // Get the number of command slots per port supported by this HBA.
   //
   MaxPortNumber        = (UINT8) ((Capability & 0x1F) + 1);
+  MaxCommandSlotNumber = (UINT8) (((Capability & 0x1F00) >> 8) + 1);
 
   //
   // Get the bit map of those ports exposed by this HBA.
@@ -2250,6 +2760,11 @@ AhciModeInitialization (
   //
   PortImplementBitMap  = AhciReadReg(PciIo, EFI_AHCI_PI_OFFSET);
 
+  //
+  // The ports which the platform knows to be unused are not probed at all.
+  //
+  SkipPortBitMap       = PcdGet32 (PcdAtaAhciPortSkipMask);
+
   AhciRegisters = &Instance->AhciRegisters;
   Status = AhciCreateTransferDescriptor (PciIo, AhciRegisters);
 
@@ -2257,7 +2772,11 @@ AhciModeInitialization (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  PendingPortBitMap = 0;
   for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port ++) {
+    PortState[Port] = EfiAhciPortEmpty;
+    PortDelay[Port] = 0;
+
     if ((PortImplementBitMap & (BIT0 << Port)) != 0) {
       //
       // According to AHCI spec, MaxPortNumber should be equal or greater than the number of implemented ports.
@@ -2267,7 +2786,11 @@ AhciModeInitialization (
         // Should never be here.
         //
         ASSERT (FALSE);
-        return EFI_SUCCESS;
+        break;
+      }
+
+      if ((SkipPortBitMap & (BIT0 << Port)) != 0) {
+        continue;
       }
 
       IdeInit->NotifyPhase (IdeInit, EfiIdeBeforeChannelEnumeration, Port);
@@ -2281,7 +2804,7 @@ AhciModeInitialization (
       Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_FBU;
       AhciWriteReg (PciIo, Offset, Data64.Uint32.Upper32);
 
-      Data64.Uint64 = (UINTN) (AhciRegisters->AhciCmdListPciAddr);
+      Data64.Uint64 = (UINTN) (AhciRegisters->AhciCmdListPciAddr + Port * EFI_AHCI_MAX_COMMAND_SLOTS);
       Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
       AhciWriteReg (PciIo, Offset, Data64.Uint32.Lower32);
       Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
@@ -2290,6 +2813,12 @@ AhciModeInitialization (
       Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
       Data = AhciReadReg (PciIo, Offset);
       if ((Data & EFI_AHCI_PORT_CMD_CPD) != 0) {
+        //
+        // The cold presence detection tells at once whether a device is attached.
+        //
+        if ((Data & EFI_AHCI_PORT_CMD_CPS) == 0) {
+          continue;
+        }
         AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_POD);
       }
 
@@ -2330,37 +2859,48 @@ AhciModeInitialization (
       }
 
       //
-      // Wait no longer than 10 ms to wait the Phy to detect the presence of a device.
-      // It's the requirment from SATA1.0a spec section 5.2.
+      // Wait no longer than PcdAtaAhciPhyDetectTimeout ms (10 ms by default, the requirment
+      // from SATA1.0a spec section 5.2) for the Phy to detect the presence of a device.
       //
-      PhyDetectDelay = EFI_AHCI_BUS_PHY_DETECT_TIMEOUT;
-      Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SSTS;
-      do {
-        Data = AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_SSTS_DET_MASK;
-        if ((Data == EFI_AHCI_PORT_SSTS_DET_PCE) || (Data == EFI_AHCI_PORT_SSTS_DET)) {
-          break;
-        }
-
-        MicroSecondDelay (1000);
-        PhyDetectDelay--;
-      } while (PhyDetectDelay > 0);
+      PortState[Port]    = EfiAhciPortPhyDetect;
+      PortDelay[Port]    = PcdGet32 (PcdAtaAhciPhyDetectTimeout);
+      PendingPortBitMap |= (UINT32) (BIT0 << Port);
+    }
+  }
 
-      if (PhyDetectDelay == 0) {
-        //
-        // No device detected at this port.
-        // Clear PxCMD.SUD for those ports at which there are no device present.
-        //
-        Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
-        AhciAndReg (PciIo, Offset, (UINT32) ~(EFI_AHCI_PORT_CMD_SUD));
+  //
+  // Poll all the started ports every millisecond until each of them has a device
+  // ready or is given up.
+  //
+  while (PendingPortBitMap != 0) {
+    for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port ++) {
+      if ((PendingPortBitMap & (BIT0 << Port)) == 0) {
         continue;
       }
 
-      //
-      // According to SATA1.0a spec section 5.2, we need to wait for PxTFD.BSY and PxTFD.DRQ
-      // and PxTFD.ERR to be zero. The maximum wait time is 16s which is defined at ATA spec.
-      //
-      PhyDetectDelay = 16 * 1000;
-      do {
+      switch (PortState[Port]) {
+      case EfiAhciPortPhyDetect:
+        Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SSTS;
+        Data = AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_SSTS_DET_MASK;
+        if ((Data == EFI_AHCI_PORT_SSTS_DET_PCE) || (Data == EFI_AHCI_PORT_SSTS_DET)) {
+          //
+          // According to SATA1.0a spec section 5.2, we need to wait for PxTFD.BSY and PxTFD.DRQ
+          // and PxTFD.ERR to be zero. The maximum wait time is 16s which is defined at ATA spec.
+          //
+          PortState[Port] = EfiAhciPortWaitReady;
+          PortDelay[Port] = 16 * 1000;
+        } else if (PortDelay[Port] == 0) {
+          //
+          // No device detected at this port.
+          // Clear PxCMD.SUD for those ports at which there are no device present.
+          //
+          Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+          AhciAndReg (PciIo, Offset, (UINT32) ~(EFI_AHCI_PORT_CMD_SUD));
+          PortState[Port] = EfiAhciPortEmpty;
+        }
+        break;
+
+      case EfiAhciPortWaitReady:
         Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SERR;
         if (AhciReadReg(PciIo, Offset) != 0) {
           AhciWriteReg (PciIo, Offset, AhciReadReg(PciIo, Offset));
@@ -2369,127 +2909,153 @@ AhciModeInitialization (
 
         Data = AhciReadReg (PciIo, Offset) & EFI_AHCI_PORT_TFD_MASK;
         if (Data == 0) {
-          break;
+          //
+          // When the first D2H register FIS is received, the content of PxSIG register is updated.
+          //
+          PortState[Port] = EfiAhciPortWaitSignature;
+          PortDelay[Port] = 16 * 1000;
+        } else if (PortDelay[Port] == 0) {
+          PortState[Port] = EfiAhciPortEmpty;
         }
+        break;
 
-        MicroSecondDelay (1000);
-        PhyDetectDelay--;
-      } while (PhyDetectDelay > 0);
+      case EfiAhciPortWaitSignature:
+        Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SIG;
+        Data = AhciReadReg (PciIo, Offset) & 0x0000FFFF;
+        if (Data == 0x00000101) {
+          PortState[Port] = EfiAhciPortReady;
+        } else if (PortDelay[Port] == 0) {
+          PortState[Port] = EfiAhciPortEmpty;
+        }
+        break;
 
-      if (PhyDetectDelay == 0) {
-        continue;
+      default:
+        break;
       }
 
-      //
-      // When the first D2H register FIS is received, the content of PxSIG register is updated.
-      //
-      Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SIG;
-      Status = AhciWaitMmioSet (
-                 PciIo,
-                 Offset,
-                 0x0000FFFF,
-                 0x00000101,
-                 EFI_TIMER_PERIOD_SECONDS(16)
-                 );
-      if (EFI_ERROR (Status)) {
-        continue;
+      if ((PortState[Port] == EfiAhciPortReady) || (PortState[Port] == EfiAhciPortEmpty)) {
+        PendingPortBitMap &= (UINT32) ~(BIT0 << Port);
+      } else if (PortDelay[Port] > 0) {
+        PortDelay[Port]--;
       }
+    }
 
-      Data = AhciReadReg (PciIo, Offset);
-      if ((Data & EFI_AHCI_ATAPI_SIG_MASK) == EFI_AHCI_ATAPI_DEVICE_SIG) {
-        Status = AhciIdentifyPacket (PciIo, AhciRegisters, Port, 0, &Buffer);
-
-        if (EFI_ERROR (Status)) {
-          continue;
-        }
+    if (PendingPortBitMap != 0) {
+      MicroSecondDelay (1000);
+    }
+  }
 
-        DeviceType = EfiIdeCdrom;
-      } else if ((Data & EFI_AHCI_ATAPI_SIG_MASK) == EFI_AHCI_ATA_DEVICE_SIG) {
-        Status = AhciIdentify (PciIo, AhciRegisters, Port, 0, &Buffer);
+  for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port ++) {
+    if (PortState[Port] != EfiAhciPortReady) {
+      continue;
+    }
 
-        if (EFI_ERROR (Status)) {
-          REPORT_STATUS_CODE (EFI_PROGRESS_CODE, (EFI_PERIPHERAL_FIXED_MEDIA | EFI_P_EC_NOT_DETECTED));
-          continue;
-        }
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SIG;
+    Data = AhciReadReg (PciIo, Offset);
+    if ((Data & EFI_AHCI_ATAPI_SIG_MASK) == EFI_AHCI_ATAPI_DEVICE_SIG) {
+      Status = AhciIdentifyPacket (PciIo, AhciRegisters, Port, 0, &Buffer);
 
-        DeviceType = EfiIdeHarddisk;
-      } else {
+      if (EFI_ERROR (Status)) {
         continue;
       }
-      DEBUG ((EFI_D_INFO, "port [%d] port mulitplier [%d] has a [%a]\n",
-              Port, 0, DeviceType == EfiIdeCdrom ? "cdrom" : "harddisk"));
 
-      //
-      // If the device is a hard disk, then try to enable S.M.A.R.T feature
-      //
-      if ((DeviceType == EfiIdeHarddisk) && PcdGetBool (PcdAtaSmartEnable)) {
-        AhciAtaSmartSupport (
-          PciIo,
-          AhciRegisters,
-          Port,
-          0,
-          &Buffer,
-          NULL
-          );
-      }
+      DeviceType = EfiIdeCdrom;
+    } else if ((Data & EFI_AHCI_ATAPI_SIG_MASK) == EFI_AHCI_ATA_DEVICE_SIG) {
+      Status = AhciIdentify (PciIo, AhciRegisters, Port, 0, &Buffer);
 
-      //
-      // Submit identify data to IDE controller init driver
-      //
-      IdeInit->SubmitData (IdeInit, Port, 0, &Buffer);
-
-      //
-      // Now start to config ide device parameter and transfer mode.
-      //
-      Status = IdeInit->CalculateMode (
-                          IdeInit,
-                          Port,
-                          0,
-                          &SupportedModes
-                          );
       if (EFI_ERROR (Status)) {
-        DEBUG ((EFI_D_ERROR, "Calculate Mode Fail, Status = %r\n", Status));
+        REPORT_STATUS_CODE (EFI_PROGRESS_CODE, (EFI_PERIPHERAL_FIXED_MEDIA | EFI_P_EC_NOT_DETECTED));
         continue;
       }
 
-      //
-      // Set best supported PIO mode on this IDE device
-      //
-      if (SupportedModes->PioMode.Mode <= EfiAtaPioMode2) {
-        TransferMode.ModeCategory = EFI_ATA_MODE_DEFAULT_PIO;
-      } else {
-        TransferMode.ModeCategory = EFI_ATA_MODE_FLOW_PIO;
-      }
+      DeviceType = EfiIdeHarddisk;
+    } else {
+      continue;
+    }
+    DEBUG ((EFI_D_INFO, "port [%d] port mulitplier [%d] has a [%a]\n",
+            Port, 0, DeviceType == EfiIdeCdrom ? "cdrom" : "harddisk"));
 
-      TransferMode.ModeNumber = (UINT8) (SupportedModes->PioMode.Mode);
+    //
+    // If the device is a hard disk, then try to enable S.M.A.R.T feature
+    //
+    if ((DeviceType == EfiIdeHarddisk) && PcdGetBool (PcdAtaSmartEnable)) {
+      AhciAtaSmartSupport (
+        PciIo,
+        AhciRegisters,
+        Port,
+        0,
+        &Buffer,
+        NULL
+        );
+    }
 
-      //
-      // Set supported DMA mode on this IDE device. Note that UDMA & MDMA cann't
-      // be set together. Only one DMA mode can be set to a device. If setting
-      // DMA mode operation fails, we can continue moving on because we only use
-      // PIO mode at boot time. DMA modes are used by certain kind of OS booting
-      //
-      if (SupportedModes->UdmaMode.Valid) {
-        TransferMode.ModeCategory = EFI_ATA_MODE_UDMA;
-        TransferMode.ModeNumber = (UINT8) (SupportedModes->UdmaMode.Mode);
-      } else if (SupportedModes->MultiWordDmaMode.Valid) {
-        TransferMode.ModeCategory = EFI_ATA_MODE_MDMA;
-        TransferMode.ModeNumber = (UINT8) SupportedModes->MultiWordDmaMode.Mode;
-      }
+    //
+    // Submit identify data to IDE controller init driver
+    //
+    IdeInit->SubmitData (IdeInit, Port, 0, &Buffer);
 
-      Status = AhciDeviceSetFeature (PciIo, AhciRegisters, Port, 0, 0x03, (UINT32)(*(UINT8 *)&TransferMode));
-      if (EFI_ERROR (Status)) {
-        DEBUG ((EFI_D_ERROR, "Set transfer Mode Fail, Status = %r\n", Status));
-        continue;
-      }
+    //
+    // Now start to config ide device parameter and transfer mode.
+    //
+    Status = IdeInit->CalculateMode (
+                        IdeInit,
+                        Port,
+                        0,
+                        &SupportedModes
+                        );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "Calculate Mode Fail, Status = %r\n", Status));
+      continue;
+    }
 
-      //
-      // Found a ATA or ATAPI device, add it into the device list.
-      //
-      CreateNewDeviceInfo (Instance, Port, 0, DeviceType, &Buffer);
-      if (DeviceType == EfiIdeHarddisk) {
-        REPORT_STATUS_CODE (EFI_PROGRESS_CODE, (EFI_PERIPHERAL_FIXED_MEDIA | EFI_P_PC_ENABLE));
-      }
+    //
+    // Set best supported PIO mode on this IDE device
+    //
+    if (SupportedModes->PioMode.Mode <= EfiAtaPioMode2) {
+      TransferMode.ModeCategory = EFI_ATA_MODE_DEFAULT_PIO;
+    } else {
+      TransferMode.ModeCategory = EFI_ATA_MODE_FLOW_PIO;
+    }
+
+    TransferMode.ModeNumber = (UINT8) (SupportedModes->PioMode.Mode);
+
+    //
+    // Set supported DMA mode on this IDE device. Note that UDMA & MDMA cann't
+    // be set together. Only one DMA mode can be set to a device. If setting
+    // DMA mode operation fails, we can continue moving on because we only use
+    // PIO mode at boot time. DMA modes are used by certain kind of OS booting
+    //
+    if (SupportedModes->UdmaMode.Valid) {
+      TransferMode.ModeCategory = EFI_ATA_MODE_UDMA;
+      TransferMode.ModeNumber = (UINT8) (SupportedModes->UdmaMode.Mode);
+    } else if (SupportedModes->MultiWordDmaMode.Valid) {
+      TransferMode.ModeCategory = EFI_ATA_MODE_MDMA;
+      TransferMode.ModeNumber = (UINT8) SupportedModes->MultiWordDmaMode.Mode;
+    }
+
+    Status = AhciDeviceSetFeature (PciIo, AhciRegisters, Port, 0, 0x03, (UINT32)(*(UINT8 *)&TransferMode));
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "Set transfer Mode Fail, Status = %r\n", Status));
+      continue;
+    }
+
+    //
+    // Use native command queuing on the port if both the HBA and the device support
+    // it. The queue depth is limited by the command slots of the HBA and word 75
+    // of the identify data.
+    //
+    if ((DeviceType == EfiIdeHarddisk) && (AhciRegisters->AhciNcqCommandTable != NULL) &&
+        ((Buffer.AtaData.serial_ata_capabilities & BIT8) != 0)) {
+      AhciRegisters->NcqQueueDepth[Port] = (UINT8) MIN (MaxCommandSlotNumber, (Buffer.AtaData.queue_depth & 0x1F) + 1);
+      DEBUG ((EFI_D_INFO, "port [%d] uses native command queuing, depth [%d]\n", Port, AhciRegisters->NcqQueueDepth[Port]));
+    }
+
+    //
+    // Found a ATA or ATAPI device, add it into the device list.
+    //
+    CreateNewDeviceInfo (Instance, Port, 0, DeviceType, &Buffer);
+    if (DeviceType == EfiIdeHarddisk) {
+      REPORT_STATUS_CODE (EFI_PROGRESS_CODE, (EFI_PERIPHERAL_FIXED_MEDIA | EFI_P_PC_ENABLE));
     }
   }
 
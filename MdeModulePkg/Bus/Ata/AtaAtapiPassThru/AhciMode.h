@@ -18,6 +18,7 @@
 
 #define EFI_AHCI_CAPABILITY_OFFSET             0x0000
 #define   EFI_AHCI_CAP_SSS                     BIT27
+#define   EFI_AHCI_CAP_SNCQ                    BIT30
 #define   EFI_AHCI_CAP_S64A                    BIT31
 #define EFI_AHCI_GHC_OFFSET                    0x0004
 #define   EFI_AHCI_GHC_RESET                   BIT0
@@ -27,6 +28,7 @@
 #define EFI_AHCI_PI_OFFSET                     0x000C
 
 #define EFI_AHCI_MAX_PORTS                     32
+#define EFI_AHCI_MAX_COMMAND_SLOTS             32
 
 typedef struct {
   UINT32  Lower32;
@@ -61,6 +63,12 @@ typedef union {
 //
 #define EFI_AHCI_MAX_DATA_PER_PRDT             0x400000
 
+//
+// The command tables used by queued commands only need to describe the largest
+// transfer a single ATA command can do (65536 sectors, 32M bytes).
+//
+#define EFI_AHCI_NCQ_MAX_PRDT                  8
+
 #define EFI_AHCI_FIS_REGISTER_H2D              0x27      //Register FIS - Host to Device
 #define   EFI_AHCI_FIS_REGISTER_H2D_LENGTH     20 
 #define EFI_AHCI_FIS_REGISTER_D2H              0x34      //Register FIS - Device to Host
@@ -128,6 +136,7 @@ typedef union {
 #define   EFI_AHCI_PORT_CMD_PMA                BIT17
 #define   EFI_AHCI_PORT_CMD_HPCP               BIT18
 #define   EFI_AHCI_PORT_CMD_MPSP               BIT19
+#define   EFI_AHCI_PORT_CMD_CPS                BIT16
 #define   EFI_AHCI_PORT_CMD_CPD                BIT20
 #define   EFI_AHCI_PORT_CMD_ESP                BIT21
 #define   EFI_AHCI_PORT_CMD_ATAPI              BIT24
@@ -182,6 +191,18 @@ typedef union {
 #define EFI_AHCI_PORT_SNTF                     0x003C
 
 
+//
+// The states of a port while AhciModeInitialization () waits for the devices
+// of all the ports at the same time.
+//
+typedef enum {
+  EfiAhciPortEmpty,
+  EfiAhciPortPhyDetect,
+  EfiAhciPortWaitReady,
+  EfiAhciPortWaitSignature,
+  EfiAhciPortReady
+} EFI_AHCI_PORT_INIT_STATE;
+
 #pragma pack(1)
 //
 // Command List structure includes total 32 entries.
@@ -266,6 +287,17 @@ typedef struct {
   EFI_AHCI_COMMAND_PRDT     PrdtTable[65535];     // The scatter/gather list for data transfer
 } EFI_AHCI_COMMAND_TABLE;
 
+//
+// Command table used by the native command queuing commands, one per port and
+// command slot.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;       // A software constructed FIS.
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;         // 12 or 16 bytes ATAPI cmd.
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[EFI_AHCI_NCQ_MAX_PRDT];
+} EFI_AHCI_NCQ_COMMAND_TABLE;
+
 //
 // Received FIS structure
 //
@@ -296,6 +328,17 @@ typedef struct {
   VOID                      *MapRFis;
   VOID                      *MapCmdList;
   VOID                      *MapCommandTable;
+  //
+  // Resources for native command queuing. The command tables are only
+  // allocated when the HBA supports it.
+  //
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTable;
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTablePciAddr;
+  UINT64                    MaxNcqCommandTableSize;
+  VOID                      *MapNcqCommandTable;
+  UINT8                     NcqQueueDepth[EFI_AHCI_MAX_PORTS];    // 0 if the port doesn't queue commands.
+  UINT32                    NcqActiveSlots[EFI_AHCI_MAX_PORTS];   // Slots owned by outstanding queued commands.
+  UINT32                    NcqAbortedSlots[EFI_AHCI_MAX_PORTS];  // Slots aborted by the error recovery.
 } EFI_AHCI_REGISTERS;
 
 /**
@@ -355,6 +355,37 @@ AtaPassThruPassThruExecute (
                      Task
                      );
           break;
+        case EFI_ATA_PASS_THRU_PROTOCOL_FPDMA:
+          if (Packet->InTransferLength != 0) {
+            Status = AhciNcqTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       TRUE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->InDataBuffer,
+                       Packet->InTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          } else {
+            Status = AhciNcqTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       FALSE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->OutDataBuffer,
+                       Packet->OutTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          }
+          break;
         default :
           return EFI_UNSUPPORTED;
       }
@@ -384,23 +415,60 @@ AsyncNonBlockingTransferRoutine (
   )
 {
   LIST_ENTRY                   *Entry;
+  LIST_ENTRY                   *NextEntry;
   LIST_ENTRY                   *EntryHeader;
   ATA_NONBLOCK_TASK            *Task;
   EFI_STATUS                   Status;
   ATA_ATAPI_PASS_THRU_INSTANCE *Instance;
+  BOOLEAN                      IsQueued;
+  UINT32                       PortBit;
+  UINT32                       BusyPorts;
+  UINT32                       NonQueuedBusyPorts;
+  UINT32                       BlockedPorts;
 
   Instance   = (ATA_ATAPI_PASS_THRU_INSTANCE *) Context;
   EntryHeader = &Instance->NonBlockingTaskList;
+
+  //
+  // Collect the ports which have started tasks. The queued (NCQ) commands use their
+  // own command tables, so they can run on all the ports at the same time. The other
+  // commands share the single command table (or the IDE channels), so only one of
+  // them can be in flight at a time, and never together with queued commands on
+  // the same port.
+  //
+  BusyPorts          = 0;
+  NonQueuedBusyPorts = 0;
+  for (Entry = GetFirstNode (EntryHeader); !IsNull (EntryHeader, Entry); Entry = GetNextNode (EntryHeader, Entry)) {
+    Task = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if (Task->IsStart) {
+      PortBit    = (UINT32) (1 << (Task->Port % EFI_AHCI_MAX_PORTS));
+      BusyPorts |= PortBit;
+      if ((Instance->Mode != EfiAtaAhciMode) || (Task->Packet->Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+        NonQueuedBusyPorts |= PortBit;
+      }
+    }
+  }
+
   //
-  // Get the Taks from the Taks List and execute it, until there is
-  // no task in the list or the device is busy with task (EFI_NOT_READY).
+  // Walk the task list in order. A task is started only when all the earlier tasks
+  // of the same port have been started, so the tasks of a port are still issued
+  // in the order they are submitted.
   //
-  while (TRUE) {
-    if (!IsListEmpty (EntryHeader)) {
-      Entry = GetFirstNode (EntryHeader);
-      Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
-    } else {
-      return;
+  BlockedPorts = 0;
+  for (Entry = GetFirstNode (EntryHeader); !IsNull (EntryHeader, Entry); Entry = NextEntry) {
+    NextEntry = GetNextNode (EntryHeader, Entry);
+    Task      = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    PortBit   = (UINT32) (1 << (Task->Port % EFI_AHCI_MAX_PORTS));
+    IsQueued  = (BOOLEAN) ((Instance->Mode == EfiAtaAhciMode) &&
+                           (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA));
+
+    if (!Task->IsStart) {
+      if (((BlockedPorts & PortBit) != 0) ||
+          (IsQueued && ((NonQueuedBusyPorts & PortBit) != 0)) ||
+          (!IsQueued && ((NonQueuedBusyPorts != 0) || ((BusyPorts & PortBit) != 0)))) {
+        BlockedPorts |= PortBit;
+        continue;
+      }
     }
 
     Status = AtaPassThruPassThruExecute (
@@ -412,25 +480,40 @@ AsyncNonBlockingTransferRoutine (
                );
 
     //
-    // If the data transfer meet a error, remove all tasks in the list since these tasks are
-    // associated with one task from Ata Bus and signal the event with error status.
+    // For Non blocking mode, the Status of EFI_NOT_READY means the operation
+    // is not finished yet, or a queued command waits for a free command slot.
     //
-    if ((Status != EFI_NOT_READY) && (Status != EFI_SUCCESS)) {
-      DestroyAsynTaskList (Instance, TRUE);
-      break;
+    if (Status == EFI_NOT_READY) {
+      if (Task->IsStart) {
+        BusyPorts |= PortBit;
+        if (!IsQueued) {
+          NonQueuedBusyPorts |= PortBit;
+        }
+      } else {
+        BlockedPorts |= PortBit;
+      }
+      continue;
     }
 
     //
-    // For Non blocking mode, the Status of EFI_NOT_READY means the operation
-    // is not finished yet. Otherwise the operation is successful.
+    // A finished non-queued task was the only task in flight on its port.
     //
-    if (Status == EFI_NOT_READY) {
-      break;
-    } else {
-      RemoveEntryList (&Task->Link);
-      gBS->SignalEvent (Task->Event);
-      FreePool (Task);
+    if (!IsQueued) {
+      NonQueuedBusyPorts &= ~PortBit;
+      BusyPorts          &= ~PortBit;
+    }
+
+    //
+    // If the data transfer meet a error, only signal the event of this task with
+    // error status. The tasks of the other ports are not affected.
+    //
+    if (EFI_ERROR (Status)) {
+      Task->Packet->Asb->AtaStatus |= 0x01;
     }
+
+    RemoveEntryList (&Task->Link);
+    gBS->SignalEvent (Task->Event);
+    FreePool (Task);
   }
 }
 
@@ -912,6 +995,17 @@ AtaAtapiPassThruStop (
 
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    if (AhciRegisters->AhciNcqCommandTable != NULL) {
+      PciIo->Unmap (
+               PciIo,
+               AhciRegisters->MapNcqCommandTable
+               );
+      PciIo->FreeBuffer (
+               PciIo,
+               EFI_SIZE_TO_PAGES ((UINTN) AhciRegisters->MaxNcqCommandTableSize),
+               AhciRegisters->AhciNcqCommandTable
+               );
+    }
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
@@ -1324,6 +1418,17 @@ AtaPassThruPassThru (
     return EFI_BAD_BUFFER_SIZE;
   }
 
+  //
+  // Native command queuing is only available in AHCI mode for the hard disks
+  // directly attached to the ports which support it.
+  //
+  if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) &&
+      ((Instance->Mode != EfiAtaAhciMode) || (PortMultiplierPort != 0) ||
+       (DeviceInfo->Type != EfiIdeHarddisk) ||
+       (Instance->AhciRegisters.NcqQueueDepth[Port % EFI_AHCI_MAX_PORTS] == 0))) {
+    return EFI_UNSUPPORTED;
+  }
+
   //
   // For non-blocking mode, queue the Task into the list.
   //
@@ -1352,6 +1457,21 @@ AtaPassThruPassThru (
 
     return EFI_SUCCESS;
   } else {
+    //
+    // Before starting the blocking command, push to finish all non-blocking
+    // tasks since the command may need the port or the command slot in use
+    // by them.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    while (!IsListEmpty (&Instance->NonBlockingTaskList)) {
+      AsyncNonBlockingTransferRoutine (NULL, Instance);
+      //
+      // Stall for 100us.
+      //
+      MicroSecondDelay (100);
+    }
+    gBS->RestoreTPL (OldTpl);
+
     return AtaPassThruPassThruExecute (
              Port,
              PortMultiplierPort,
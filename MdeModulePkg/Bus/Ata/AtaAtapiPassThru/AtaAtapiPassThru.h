@@ -140,6 +140,7 @@ struct _ATA_NONBLOCK_TASK {
   VOID                              *TableMap;       // Pointer to PRD table map.
   EFI_ATA_DMA_PRD                   *MapBaseAddress; //  Pointer to range Base address for Map.
   UINTN                             PageCount;       //  The page numbers used by PCIO freebuffer.
+  UINT8                             CommandSlot;     //  The AHCI command slot used by a queued command.
 };
 
 //
@@ -1150,6 +1151,52 @@ AhciDmaTransfer (
   IN     ATA_NONBLOCK_TASK            *Task
   );
 
+/**
+  Start a native command queuing (READ/WRITE FPDMA QUEUED) data transfer on
+  specific port.
+
+  The command gets a free command slot of the port and is issued without waiting
+  for the commands already outstanding on the port, so up to the queue depth of
+  the device can be in flight at the same time on each port. The command slot
+  number is used as the NCQ tag.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The timeout value of stop.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of non data transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_DEVICE_ERROR    The data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_UNSUPPORTED     The port doesn't support native command queuing.
+  @retval EFI_NOT_READY       The command isn't finished yet, or all the command
+                              slots of the port are in use.
+  @retval EFI_SUCCESS         The data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS           *AhciRegisters,
+  IN     UINT8                        Port,
+  IN     UINT8                        PortMultiplier,
+  IN     BOOLEAN                      Read,
+  IN     EFI_ATA_COMMAND_BLOCK        *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK         *AtaStatusBlock,
+  IN OUT VOID                         *MemoryAddr,
+  IN     UINT32                       DataCount,
+  IN     UINT64                       Timeout,
+  IN     ATA_NONBLOCK_TASK            *Task
+  );
+
 /**
   Start a PIO data transfer on specific port.
 
@@ -137,6 +137,11 @@ typedef struct {
 
   BOOLEAN                               UdmaValid;
   BOOLEAN                               Lba48Bit;
+  //
+  // The device supports native command queuing. It is cleared if the
+  // ATA pass through protocol can't queue commands.
+  //
+  BOOLEAN                               NcqValid;
 
   //
   // Cached data for ATA identify data
@@ -30,6 +30,9 @@
 #define ATA_CMD_TRUST_SEND        0x5E
 #define ATA_CMD_TRUST_SEND_DMA    0x5F
 
+#define ATA_CMD_READ_FPDMA_QUEUED  0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+
 //
 // Look up table (UdmaValid, IsWrite) for EFI_ATA_PASS_THRU_CMD_PROTOCOL
 //
@@ -343,6 +346,15 @@ IdentifyAtaDevice (
     AtaDevice->Lba48Bit = FALSE;
   }
 
+  //
+  // Check whether the WORD 76 (Serial ATA capabilities) reports native command queuing
+  //
+  if (AtaDevice->UdmaValid &&
+      (IdentifyData->serial_ata_capabilities != 0xFFFF) &&
+      ((IdentifyData->serial_ata_capabilities & BIT8) != 0)) {
+    AtaDevice->NcqValid = TRUE;
+  }
+
   //
   // Block Media Information:
   //
@@ -477,8 +489,10 @@ TransferAtaDevice (
   IN EFI_EVENT                            Event OPTIONAL
   )
 {
+  EFI_STATUS                        Status;
   EFI_ATA_COMMAND_BLOCK             *Acb;
   EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  BOOLEAN                           UseNcq;
 
   //
   // Ensure AtaDevice->UdmaValid, AtaDevice->Lba48Bit and IsWrite are valid boolean values
@@ -490,19 +504,39 @@ TransferAtaDevice (
   // Prepare for ATA command block.
   //
   Acb = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
-  Acb->AtaCommand = mAtaCommands[AtaDevice->UdmaValid][AtaDevice->Lba48Bit][IsWrite];
-  Acb->AtaSectorNumber = (UINT8) StartLba;
-  Acb->AtaCylinderLow = (UINT8) RShiftU64 (StartLba, 8);
-  Acb->AtaCylinderHigh = (UINT8) RShiftU64 (StartLba, 16);
-  Acb->AtaDeviceHead = (UINT8) (BIT7 | BIT6 | BIT5 | (AtaDevice->PortMultiplierPort << 4));
-  Acb->AtaSectorCount = (UINT8) TransferLength;
-  if (AtaDevice->Lba48Bit) {
+  UseNcq = (BOOLEAN) (AtaDevice->NcqValid && (Event != NULL));
+  if (UseNcq) {
+    //
+    // Non-blocking transfers use the native command queuing commands so that several
+    // of them can be in flight on the device at the same time. They always take a
+    // 48-bit LBA and the sector count in the features field. The tag in the sector
+    // count field is assigned by the ATA pass through driver.
+    //
+    Acb->AtaCommand = IsWrite ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+    Acb->AtaSectorNumber = (UINT8) StartLba;
+    Acb->AtaCylinderLow = (UINT8) RShiftU64 (StartLba, 8);
+    Acb->AtaCylinderHigh = (UINT8) RShiftU64 (StartLba, 16);
     Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
     Acb->AtaCylinderLowExp = (UINT8) RShiftU64 (StartLba, 32);
     Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
-    Acb->AtaSectorCountExp = (UINT8) (TransferLength >> 8);
+    Acb->AtaDeviceHead = (UINT8) BIT6;
+    Acb->AtaFeatures = (UINT8) TransferLength;
+    Acb->AtaFeaturesExp = (UINT8) (TransferLength >> 8);
   } else {
-    Acb->AtaDeviceHead = (UINT8) (Acb->AtaDeviceHead | RShiftU64 (StartLba, 24));
+    Acb->AtaCommand = mAtaCommands[AtaDevice->UdmaValid][AtaDevice->Lba48Bit][IsWrite];
+    Acb->AtaSectorNumber = (UINT8) StartLba;
+    Acb->AtaCylinderLow = (UINT8) RShiftU64 (StartLba, 8);
+    Acb->AtaCylinderHigh = (UINT8) RShiftU64 (StartLba, 16);
+    Acb->AtaDeviceHead = (UINT8) (BIT7 | BIT6 | BIT5 | (AtaDevice->PortMultiplierPort << 4));
+    Acb->AtaSectorCount = (UINT8) TransferLength;
+    if (AtaDevice->Lba48Bit) {
+      Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
+      Acb->AtaCylinderLowExp = (UINT8) RShiftU64 (StartLba, 32);
+      Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
+      Acb->AtaSectorCountExp = (UINT8) (TransferLength >> 8);
+    } else {
+      Acb->AtaDeviceHead = (UINT8) (Acb->AtaDeviceHead | RShiftU64 (StartLba, 24));
+    }
   }
 
   //
@@ -522,7 +556,11 @@ TransferAtaDevice (
     Packet->InTransferLength = TransferLength;
   }
 
-  Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
+  if (UseNcq) {
+    Packet->Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  } else {
+    Packet->Protocol = mAtaPassThruCmdProtocols[AtaDevice->UdmaValid][IsWrite];
+  }
   Packet->Length = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
   //
   // |------------------------|-----------------|------------------------|-----------------|
@@ -557,7 +595,21 @@ TransferAtaDevice (
     Packet->Timeout  = EFI_TIMER_PERIOD_SECONDS (DivU64x32 (MultU64x32 (TransferLength, AtaDevice->BlockMedia.BlockSize), 3300000) + 31);
   }
 
-  return AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  Status = AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+  if (UseNcq && (Status == EFI_UNSUPPORTED)) {
+    //
+    // The ATA pass through driver can't queue commands (e.g. IDE mode, or the
+    // AHCI HBA doesn't support it). Use the DMA commands from now on.
+    //
+    AtaDevice->NcqValid = FALSE;
+    FreeAlignedBuffer (Packet->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+    if (Packet->Acb != NULL) {
+      FreePool (Packet->Acb);
+    }
+    return TransferAtaDevice (AtaDevice, TaskPacket, Buffer, StartLba, TransferLength, IsWrite, Event);
+  }
+
+  return Status;
 }
 
 /**
@@ -812,7 +864,11 @@ AccessAtaDevice(
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // The device handles several queued commands at the same time, so only
+    // serialize the requests when it can't queue them.
+    //
+    if (!AtaDevice->NcqValid && !IsListEmpty (&AtaDevice->AtaSubTaskList)) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
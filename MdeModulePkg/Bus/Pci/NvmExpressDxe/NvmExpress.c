@@ -118,6 +118,8 @@ EnumerateNvmeDevNamespace (
     Device->DriverBindingHandle = Private->DriverBindingHandle;
     Device->Controller          = Private;
 
+    InitializeListHead (&Device->AsyncQueue);
+
     //
     // Build BlockIo media structure
     //
@@ -147,6 +149,15 @@ EnumerateNvmeDevNamespace (
     Device->BlockIo.WriteBlocks  = NvmeBlockIoWriteBlocks;
     Device->BlockIo.FlushBlocks  = NvmeBlockIoFlushBlocks;
 
+    //
+    // Create BlockIo2 Protocol instance
+    //
+    Device->BlockIo2.Media          = &Device->Media;
+    Device->BlockIo2.Reset          = NvmeBlockIoResetEx;
+    Device->BlockIo2.ReadBlocksEx   = NvmeBlockIoReadBlocksEx;
+    Device->BlockIo2.WriteBlocksEx  = NvmeBlockIoWriteBlocksEx;
+    Device->BlockIo2.FlushBlocksEx  = NvmeBlockIoFlushBlocksEx;
+
     //
     // Create DiskInfo Protocol instance
     //
@@ -197,6 +208,8 @@ EnumerateNvmeDevNamespace (
                     Device->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &Device->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &Device->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &Device->DiskInfo,
                     NULL
@@ -333,6 +346,8 @@ UnregisterNvmeNamespace (
   EFI_PCI_IO_PROTOCOL                      *PciIo;
   EFI_BLOCK_IO_PROTOCOL                    *BlockIo;
   NVME_DEVICE_PRIVATE_DATA                 *Device;
+  BOOLEAN                                  IsEmpty;
+  EFI_TPL                                  OldTpl;
 
   BlockIo = NULL;
 
@@ -350,6 +365,21 @@ UnregisterNvmeNamespace (
 
   Device = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (BlockIo);
 
+  //
+  // Wait for the device's asynchronous I/O queue to become empty.
+  //
+  while (TRUE) {
+    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    IsEmpty = IsListEmpty (&Device->AsyncQueue);
+    gBS->RestoreTPL (OldTpl);
+
+    if (IsEmpty) {
+      break;
+    }
+
+    gBS->Stall (100);
+  }
+
   //
   // Close the child handle
   //
@@ -361,8 +391,8 @@ UnregisterNvmeNamespace (
          );
 
   //
-  // The Nvm Express driver installs the BlockIo and DiskInfo in the DriverBindingStart().
-  // Here should uninstall both of them.
+  // The Nvm Express driver installs the BlockIo, BlockIo2 and DiskInfo in the DriverBindingStart().
+  // Here should uninstall all of them.
   //
   Status = gBS->UninstallMultipleProtocolInterfaces (
                   Handle,
@@ -370,6 +400,8 @@ UnregisterNvmeNamespace (
                   Device->DevicePath,
                   &gEfiBlockIoProtocolGuid,
                   &Device->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &Device->BlockIo2,
                   &gEfiDiskInfoProtocolGuid,
                   &Device->DiskInfo,
                   NULL
@@ -654,19 +686,21 @@ NvmExpressDriverBindingStart (
     }
 
     //
-    // 4 x 4kB aligned buffers will be carved out of this buffer.
+    // 6 x 4kB aligned buffers will be carved out of this buffer.
     // 1st 4kB boundary is the start of the admin submission queue.
     // 2nd 4kB boundary is the start of the admin completion queue.
     // 3rd 4kB boundary is the start of I/O submission queue #1.
     // 4th 4kB boundary is the start of I/O completion queue #1.
+    // 5th 4kB boundary is the start of I/O submission queue #2.
+    // 6th 4kB boundary is the start of I/O completion queue #2.
     //
-    // Allocate 4 pages of memory, then map it for bus master read and write.
+    // Allocate 6 pages of memory, then map it for bus master read and write.
     //
     Status = PciIo->AllocateBuffer (
                       PciIo,
                       AllocateAnyPages,
                       EfiBootServicesData,
-                      4,
+                      NVME_QUEUE_BUFFER_PAGES,
                       (VOID**)&Private->Buffer,
                       0
                       );
@@ -674,7 +708,7 @@ NvmExpressDriverBindingStart (
       goto Exit2;
     }
 
-    Bytes = EFI_PAGES_TO_SIZE (4);
+    Bytes = EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES);
     Status = PciIo->Map (
                       PciIo,
                       EfiPciIoOperationBusMasterCommonBuffer,
@@ -684,12 +718,44 @@ NvmExpressDriverBindingStart (
                       &Private->Mapping
                       );
 
-    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (4))) {
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES))) {
       goto Exit2;
     }
 
     Private->BufferPciAddr = (UINT8 *)(UINTN)MappedAddr;
-    ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (4));
+    ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES));
+
+    //
+    // Allocate the PRP list pool, then map it for bus master read and write.
+    //
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      NVME_PRP_LIST_POOL_PAGES,
+                      (VOID**)&Private->PrpListPool,
+                      0
+                      );
+    if (EFI_ERROR (Status)) {
+      goto Exit2;
+    }
+
+    Bytes = EFI_PAGES_TO_SIZE (NVME_PRP_LIST_POOL_PAGES);
+    Status = PciIo->Map (
+                      PciIo,
+                      EfiPciIoOperationBusMasterCommonBuffer,
+                      Private->PrpListPool,
+                      &Bytes,
+                      &MappedAddr,
+                      &Private->PrpListPoolMapping
+                      );
+
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_PRP_LIST_POOL_PAGES))) {
+      goto Exit2;
+    }
+
+    Private->PrpListPoolPciAddr = (UINT8 *)(UINTN)MappedAddr;
+    Private->PrpListPoolFree    = MAX_UINT64;
 
     Private->Signature = NVME_CONTROLLER_PRIVATE_DATA_SIGNATURE;
     Private->ControllerHandle          = Controller;
@@ -702,7 +768,9 @@ NvmExpressDriverBindingStart (
     Private->Passthru.GetNextNamespace = NvmExpressGetNextNamespace;
     Private->Passthru.BuildDevicePath  = NvmExpressBuildDevicePath;
     Private->Passthru.GetNamespace     = NvmExpressGetNamespace;
-    Private->PassThruMode.Attributes   = NVM_EXPRESS_PASS_THRU_ATTRIBUTES_PHYSICAL;
+    Private->PassThruMode.Attributes   = NVM_EXPRESS_PASS_THRU_ATTRIBUTES_PHYSICAL | NVM_EXPRESS_PASS_THRU_ATTRIBUTES_NONBLOCKIO;
+    InitializeListHead (&Private->AsyncPassThruQueue);
+    InitializeListHead (&Private->UnsubmittedSubtasks);
 
     Status = NvmeControllerInit (Private);
 
@@ -710,6 +778,29 @@ NvmExpressDriverBindingStart (
       goto Exit2;
     }
 
+    //
+    // Start the asynchronous I/O completion monitor
+    //
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    ProcessAsyncTaskList,
+                    Private,
+                    &Private->TimerEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      goto Exit2;
+    }
+
+    Status = gBS->SetTimer (
+                    Private->TimerEvent,
+                    TimerPeriodic,
+                    NVME_HC_ASYNC_TIMER
+                    );
+    if (EFI_ERROR (Status)) {
+      goto Exit2;
+    }
+
     Status = gBS->InstallMultipleProtocolInterfaces (
                     &Controller,
                     &gEfiCallerIdGuid,
@@ -773,12 +864,28 @@ Exit1:
          NULL
          );
 Exit2:
+  if ((Private != NULL) && (Private->TimerEvent != NULL)) {
+    gBS->CloseEvent (Private->TimerEvent);
+  }
+
   if ((Private != NULL) && (Private->Mapping != NULL)) {
     PciIo->Unmap (PciIo, Private->Mapping);
   }
 
   if ((Private != NULL) && (Private->Buffer != NULL)) {
-    PciIo->FreeBuffer (PciIo, 4, Private->Buffer);
+    PciIo->FreeBuffer (PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
+  }
+
+  if ((Private != NULL) && (Private->PrpListPoolMapping != NULL)) {
+    PciIo->Unmap (PciIo, Private->PrpListPoolMapping);
+  }
+
+  if ((Private != NULL) && (Private->PrpListPool != NULL)) {
+    PciIo->FreeBuffer (PciIo, NVME_PRP_LIST_POOL_PAGES, Private->PrpListPool);
+  }
+
+  if ((Private != NULL) && (Private->ControllerData != NULL)) {
+    FreePool (Private->ControllerData);
   }
 
   if (Private != NULL) {
@@ -844,6 +951,8 @@ NvmExpressDriverBindingStop (
   BOOLEAN                             AllChildrenStopped;
   UINTN                               Index;
   NVME_CONTROLLER_PRIVATE_DATA        *Private;
+  BOOLEAN                             IsEmpty;
+  EFI_TPL                             OldTpl;
 
   if (NumberOfChildren == 0) {
     Status = gBS->OpenProtocol (
@@ -863,12 +972,41 @@ NvmExpressDriverBindingStop (
             NULL
             );
 
+      //
+      // Wait for the asynchronous PassThru queue to become empty, then stop
+      // the completion monitor.
+      //
+      while (TRUE) {
+        OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+        IsEmpty = IsListEmpty (&Private->AsyncPassThruQueue) &&
+                  IsListEmpty (&Private->UnsubmittedSubtasks);
+        gBS->RestoreTPL (OldTpl);
+
+        if (IsEmpty) {
+          break;
+        }
+
+        gBS->Stall (100);
+      }
+
+      if (Private->TimerEvent != NULL) {
+        gBS->CloseEvent (Private->TimerEvent);
+      }
+
       if (Private->Mapping != NULL) {
         Private->PciIo->Unmap (Private->PciIo, Private->Mapping);
       }
 
       if (Private->Buffer != NULL) {
-        Private->PciIo->FreeBuffer (Private->PciIo, 4, Private->Buffer);
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
+      }
+
+      if (Private->PrpListPoolMapping != NULL) {
+        Private->PciIo->Unmap (Private->PciIo, Private->PrpListPoolMapping);
+      }
+
+      if (Private->PrpListPool != NULL) {
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_PRP_LIST_POOL_PAGES, Private->PrpListPool);
       }
 
       FreePool (Private->ControllerData);
@@ -27,6 +27,7 @@
 #include <Protocol/DevicePath.h>
 #include <Protocol/PciIo.h>
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/DiskInfo.h>
 #include <Protocol/DriverSupportedEfiVersion.h>
 
@@ -62,7 +63,36 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 #define NVME_CSQ_SIZE                             1     // Number of I/O submission queue entries, which is 0-based
 #define NVME_CCQ_SIZE                             1     // Number of I/O completion queue entries, which is 0-based
 
-#define NVME_MAX_IO_QUEUES                        2     // Number of I/O queues supported by the driver
+//
+// The asynchronous I/O queue pair is deep so that several commands can be in flight at
+// once. One 4kB page holds at most 64 submission queue entries. The actual depth is
+// further limited by CAP.MQES of the controller.
+//
+#define NVME_ASYNC_CSQ_SIZE                       63    // Number of asynchronous I/O submission queue entries, which is 0-based
+#define NVME_ASYNC_CCQ_SIZE                       63    // Number of asynchronous I/O completion queue entries, which is 0-based
+
+#define NVME_MAX_QUEUES                           3     // Number of queues (admin, sync I/O and async I/O) supported by the driver
+
+//
+// Internal queue ID of the asynchronous I/O queue pair. Non-blocking PassThru requests
+// for NVME_IO_QUEUE are carried out on it.
+//
+#define NVME_ASYNC_IO_QUEUE                       2
+
+//
+// Number of 4kB pages carved into the submission & completion queues.
+//
+#define NVME_QUEUE_BUFFER_PAGES                   (NVME_MAX_QUEUES * 2)
+
+//
+// Pre-mapped PRP list pages shared by the I/O queues, so that commands spanning more
+// than two memory pages don't allocate and map a PRP list each. One page is enough for
+// transfers of up to NVME_PRP_ENTRIES_PER_PAGE pages; larger transfers fall back to
+// allocating the PRP lists on demand.
+//
+#define NVME_PRP_LIST_POOL_PAGES                  64    // At most 64, as the free pages are tracked in a UINT64 bitmap
+#define NVME_PRP_ENTRIES_PER_PAGE                 (EFI_PAGE_SIZE / sizeof (UINT64))
+#define NVME_PRP_LIST_POOL_NONE                   ((UINTN) -1)
 
 #define NVME_CONTROLLER_ID                        0
 
@@ -71,6 +101,12 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 //
 #define NVME_GENERIC_TIMEOUT                      EFI_TIMER_PERIOD_SECONDS (5)
 
+//
+// Interval of the timer which reaps the asynchronous I/O completion queue and submits
+// queued BlockIo2 sub-tasks.
+//
+#define NVME_HC_ASYNC_TIMER                       EFI_TIMER_PERIOD_MILLISECONDS (1)
+
 //
 // Unique signature for private data structure.
 //
@@ -102,11 +138,11 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   //
   // 6 x 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
-  // 2nd 4kB boundary is the start of submission queue #1.
-  // 3rd 4kB boundary is the start of the admin completion queue.
-  // 4th 4kB boundary is the start of completion queue #1.
-  // 5th 4kB boundary is the start of the first PRP list page.
-  // 6th 4kB boundary is the start of the second PRP list page.
+  // 2nd 4kB boundary is the start of the admin completion queue.
+  // 3rd 4kB boundary is the start of I/O submission queue #1.
+  // 4th 4kB boundary is the start of I/O completion queue #1.
+  // 5th 4kB boundary is the start of I/O submission queue #2 (asynchronous).
+  // 6th 4kB boundary is the start of I/O completion queue #2 (asynchronous).
   //
   UINT8                           *Buffer;
   UINT8                           *BufferPciAddr;
@@ -114,19 +150,26 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   //
   // Pointers to 4kB aligned submission & completion queues.
   //
-  NVME_SQ                         *SqBuffer[NVME_MAX_IO_QUEUES];
-  NVME_CQ                         *CqBuffer[NVME_MAX_IO_QUEUES];
-  NVME_SQ                         *SqBufferPciAddr[NVME_MAX_IO_QUEUES];
-  NVME_CQ                         *CqBufferPciAddr[NVME_MAX_IO_QUEUES];
+  NVME_SQ                         *SqBuffer[NVME_MAX_QUEUES];
+  NVME_CQ                         *CqBuffer[NVME_MAX_QUEUES];
+  NVME_SQ                         *SqBufferPciAddr[NVME_MAX_QUEUES];
+  NVME_CQ                         *CqBufferPciAddr[NVME_MAX_QUEUES];
 
   //
   // Submission and completion queue indices.
   //
-  NVME_SQTDBL                     SqTdbl[NVME_MAX_IO_QUEUES];
-  NVME_CQHDBL                     CqHdbl[NVME_MAX_IO_QUEUES];
+  NVME_SQTDBL                     SqTdbl[NVME_MAX_QUEUES];
+  NVME_CQHDBL                     CqHdbl[NVME_MAX_QUEUES];
+
+  UINT8                           Pt[NVME_MAX_QUEUES];
+  UINT16                          Cid[NVME_MAX_QUEUES];
 
-  UINT8                           Pt[2];
-  UINT16                          Cid[2];
+  //
+  // 0-based depth of the asynchronous I/O queue pair, and the last submission
+  // queue head reported by the controller for it.
+  //
+  UINT16                          AsyncQueueSize;
+  UINT16                          AsyncSqHead;
 
   //
   // Nvme controller capabilities
@@ -134,6 +177,23 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_CAP                        Cap;
 
   VOID                            *Mapping;
+
+  //
+  // Pool of pre-mapped PRP list pages. A set bit in PrpListPoolFree means the
+  // corresponding page is available.
+  //
+  UINT8                           *PrpListPool;
+  UINT8                           *PrpListPoolPciAddr;
+  VOID                            *PrpListPoolMapping;
+  UINT64                          PrpListPoolFree;
+
+  //
+  // For asynchronous I/O: the periodic timer reaping completions, the commands
+  // that are in flight, and the BlockIo2 sub-tasks waiting for a free slot.
+  //
+  EFI_EVENT                       TimerEvent;
+  LIST_ENTRY                      AsyncPassThruQueue;
+  LIST_ENTRY                      UnsubmittedSubtasks;
 };
 
 #define NVME_CONTROLLER_PRIVATE_DATA_FROM_PASS_THRU(a) \
@@ -167,8 +227,14 @@ struct _NVME_DEVICE_PRIVATE_DATA {
 
   EFI_BLOCK_IO_MEDIA                Media;
   EFI_BLOCK_IO_PROTOCOL             BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL            BlockIo2;
   EFI_DISK_INFO_PROTOCOL            DiskInfo;
 
+  //
+  // BlockIo2 requests of this namespace which are not completed yet
+  //
+  LIST_ENTRY                        AsyncQueue;
+
   EFI_LBA                           NumBlocks;
 
   CHAR16                            ModelName[80];
@@ -195,6 +261,73 @@ struct _NVME_DEVICE_PRIVATE_DATA {
       NVME_DEVICE_PRIVATE_DATA_SIGNATURE \
       )
 
+#define NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO2(a) \
+  CR (a, \
+      NVME_DEVICE_PRIVATE_DATA, \
+      BlockIo2, \
+      NVME_DEVICE_PRIVATE_DATA_SIGNATURE \
+      )
+
+//
+// Nvme asynchronous passthru request.
+//
+#define NVME_PASS_THRU_ASYNC_REQ_SIG           SIGNATURE_32 ('N', 'P', 'A', 'R')
+
+typedef struct {
+  UINT32                                   Signature;
+  LIST_ENTRY                               Link;
+
+  NVM_EXPRESS_PASS_THRU_COMMAND_PACKET     *Packet;
+  UINT16                                   CommandId;
+  VOID                                     *MapData;
+  VOID                                     *MapMeta;
+  VOID                                     *MapPrpList;
+  UINTN                                    PrpListNo;
+  VOID                                     *PrpListHost;
+  UINTN                                    PrpListPoolIndex;
+  EFI_EVENT                                CallerEvent;
+} NVME_PASS_THRU_ASYNC_REQ;
+
+#define NVME_PASS_THRU_ASYNC_REQ_FROM_THIS(a) \
+  CR (a, \
+      NVME_PASS_THRU_ASYNC_REQ, \
+      Link, \
+      NVME_PASS_THRU_ASYNC_REQ_SIG \
+      )
+
+//
+// Nvme BlockIo2 request, split into one sub-task per NVMe command.
+//
+#define NVME_BLKIO2_REQUEST_SIGNATURE          SIGNATURE_32 ('N', 'B', '2', 'R')
+
+typedef struct {
+  UINT32                                   Signature;
+  LIST_ENTRY                               Link;
+
+  EFI_BLOCK_IO2_TOKEN                      *Token;
+  UINTN                                    PendingSubtaskNum;
+} NVME_BLKIO2_REQUEST;
+
+#define NVME_BLKIO2_REQUEST_FROM_LINK(a) \
+  CR (a, NVME_BLKIO2_REQUEST, Link, NVME_BLKIO2_REQUEST_SIGNATURE)
+
+#define NVME_BLKIO2_SUBTASK_SIGNATURE          SIGNATURE_32 ('N', 'B', '2', 'S')
+
+typedef struct {
+  UINT32                                   Signature;
+  LIST_ENTRY                               Link;
+
+  UINT32                                   NamespaceId;
+  EFI_EVENT                                Event;
+  NVME_BLKIO2_REQUEST                      *BlockIo2Request;
+  NVM_EXPRESS_PASS_THRU_COMMAND_PACKET     CommandPacket;
+  NVM_EXPRESS_COMMAND                      Command;
+  NVM_EXPRESS_RESPONSE                     Response;
+} NVME_BLKIO2_SUBTASK;
+
+#define NVME_BLKIO2_SUBTASK_FROM_LINK(a) \
+  CR (a, NVME_BLKIO2_SUBTASK, Link, NVME_BLKIO2_SUBTASK_SIGNATURE)
+
 /**
   Retrieves a Unicode string that is the user readable name of the driver.
 
@@ -491,6 +624,25 @@ NvmExpressPassThru (
   IN     EFI_EVENT                                   Event OPTIONAL
   );
 
+/**
+  Call back function when the timer event is signaled.
+
+  Reaps the asynchronous I/O completion queue, signals the events of the completed
+  asynchronous PassThru requests, and submits the queued BlockIo2 sub-tasks while
+  there is room in the asynchronous I/O submission queue.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT                    Event,
+  IN VOID*                        Context
+  );
+
 /**
   Used to retrieve the list of namespaces defined on an NVM Express controller.
 
@@ -148,6 +148,287 @@ WriteSectors (
   return Status;
 }
 
+/**
+  Get the maximum number of blocks transferred by a single NVMe read or write command.
+
+  The limit is the Maximum Data Transfer Size of the controller, further capped so that
+  the PRP list of a command fits in one page of the pre-mapped PRP list pool.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+
+  @return The maximum number of blocks per command.
+
+**/
+UINT32
+NvmeMaxTransferBlocks (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA     *Controller;
+  UINT32                           BlockSize;
+  UINT32                           MaxTransferBlocks;
+
+  Controller = Device->Controller;
+  BlockSize  = Device->Media.BlockSize;
+
+  if (Controller->ControllerData->Mdts != 0) {
+    MaxTransferBlocks = (1 << (Controller->ControllerData->Mdts)) * (1 << (Controller->Cap.Mpsmin + 12)) / BlockSize;
+  } else {
+    MaxTransferBlocks = 1024;
+  }
+
+  return MIN (MaxTransferBlocks, (UINT32) (EFI_PAGES_TO_SIZE (NVME_PRP_ENTRIES_PER_PAGE) / BlockSize));
+}
+
+/**
+  Nonblocking I/O callback function when the sub-task of a BlockIo2 request is completed.
+
+  @param[in]  Event                 The Event this notify function registered to.
+  @param[in]  Context               Pointer to the context data registered to the
+                                    Event.
+
+**/
+VOID
+EFIAPI
+AsyncIoCallback (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  NVME_BLKIO2_SUBTASK         *Subtask;
+  NVME_BLKIO2_REQUEST         *Request;
+  EFI_BLOCK_IO2_TOKEN         *Token;
+
+  gBS->CloseEvent (Event);
+
+  Subtask = (NVME_BLKIO2_SUBTASK *) Context;
+  Request = Subtask->BlockIo2Request;
+  Token   = Request->Token;
+
+  if (Subtask->CommandPacket.ControllerStatus != NVM_EXPRESS_STATUS_CONTROLLER_READY) {
+    Token->TransactionStatus = EFI_DEVICE_ERROR;
+  }
+
+  FreePool (Subtask);
+
+  //
+  // The BlockIo2 request completes with its last sub-task.
+  //
+  Request->PendingSubtaskNum--;
+  if (Request->PendingSubtaskNum == 0) {
+    RemoveEntryList (&Request->Link);
+    gBS->SignalEvent (Token->Event);
+    FreePool (Request);
+  }
+}
+
+/**
+  Create a sub-task which reads or writes some sectors as one NVMe command.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Request                The BlockIo2 request the sub-task belongs to.
+  @param  IsRead                 TRUE for a read, FALSE for a write.
+  @param  Buffer                 The data buffer of the sub-task.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number of the sub-task.
+
+  @return The sub-task, or NULL if there are not enough resources.
+
+**/
+NVME_BLKIO2_SUBTASK *
+NvmeCreateBlkIo2Subtask (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device,
+  IN NVME_BLKIO2_REQUEST                *Request,
+  IN BOOLEAN                            IsRead,
+  IN UINT64                             Buffer,
+  IN UINT64                             Lba,
+  IN UINT32                             Blocks
+  )
+{
+  NVME_BLKIO2_SUBTASK                      *Subtask;
+  EFI_STATUS                               Status;
+
+  Subtask = AllocateZeroPool (sizeof (NVME_BLKIO2_SUBTASK));
+  if (Subtask == NULL) {
+    return NULL;
+  }
+
+  Subtask->Signature       = NVME_BLKIO2_SUBTASK_SIGNATURE;
+  Subtask->NamespaceId     = Device->NamespaceId;
+  Subtask->BlockIo2Request = Request;
+
+  Subtask->CommandPacket.NvmeCmd      = &Subtask->Command;
+  Subtask->CommandPacket.NvmeResponse = &Subtask->Response;
+
+  //
+  // The command ID is assigned by PassThru for the asynchronous I/O queue.
+  //
+  Subtask->Command.Cdw0.Opcode = IsRead ? NVME_IO_READ_OPC : NVME_IO_WRITE_OPC;
+  Subtask->Command.Nsid        = Device->NamespaceId;
+  Subtask->Command.Cdw10       = (UINT32)Lba;
+  Subtask->Command.Cdw11       = (UINT32)(Lba >> 32);
+  Subtask->Command.Cdw12       = (Blocks - 1) & 0xFFFF;
+  Subtask->Command.Flags       = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+
+  Subtask->CommandPacket.TransferBuffer = (VOID *)(UINTN)Buffer;
+  Subtask->CommandPacket.TransferLength = Blocks * Device->Media.BlockSize;
+  Subtask->CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+  Subtask->CommandPacket.QueueId        = NVME_IO_QUEUE;
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  AsyncIoCallback,
+                  Subtask,
+                  &Subtask->Event
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Subtask);
+    return NULL;
+  }
+
+  return Subtask;
+}
+
+/**
+  Nonblocking read or write of some blocks.
+
+  The request is split into sub-tasks of at most NvmeMaxTransferBlocks() blocks each,
+  which are queued to the controller and submitted by the asynchronous timer handler
+  as soon as the asynchronous I/O queue has room. Token->Event is signaled once all
+  sub-tasks are completed.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  IsRead                 TRUE for a read, FALSE for a write.
+  @param  Buffer                 The data buffer.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  Token                  The BlockIo2 token of the request.
+
+  @retval EFI_SUCCESS            The request is queued.
+  @retval EFI_OUT_OF_RESOURCES   The request could not be queued due to a lack of resources.
+
+**/
+EFI_STATUS
+NvmeAsyncReadWrite (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device,
+  IN BOOLEAN                            IsRead,
+  IN VOID                               *Buffer,
+  IN UINT64                             Lba,
+  IN UINTN                              Blocks,
+  IN EFI_BLOCK_IO2_TOKEN                *Token
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA     *Controller;
+  NVME_BLKIO2_REQUEST              *Request;
+  NVME_BLKIO2_SUBTASK              *Subtask;
+  LIST_ENTRY                       SubtaskList;
+  LIST_ENTRY                       *Link;
+  UINT32                           BlockSize;
+  UINT32                           MaxTransferBlocks;
+  UINT32                           TransferBlocks;
+  UINTN                            SubtaskNum;
+  EFI_TPL                          OldTpl;
+
+  Controller        = Device->Controller;
+  BlockSize         = Device->Media.BlockSize;
+  MaxTransferBlocks = NvmeMaxTransferBlocks (Device);
+
+  Request = AllocateZeroPool (sizeof (NVME_BLKIO2_REQUEST));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request->Signature = NVME_BLKIO2_REQUEST_SIGNATURE;
+  Request->Token     = Token;
+
+  InitializeListHead (&SubtaskList);
+  SubtaskNum = 0;
+  while (Blocks > 0) {
+    TransferBlocks = (UINT32) MIN (Blocks, MaxTransferBlocks);
+    Subtask = NvmeCreateBlkIo2Subtask (Device, Request, IsRead, (UINT64)(UINTN)Buffer, Lba, TransferBlocks);
+    if (Subtask == NULL) {
+      while (!IsListEmpty (&SubtaskList)) {
+        Link    = GetFirstNode (&SubtaskList);
+        Subtask = NVME_BLKIO2_SUBTASK_FROM_LINK (Link);
+        RemoveEntryList (Link);
+        gBS->CloseEvent (Subtask->Event);
+        FreePool (Subtask);
+      }
+      FreePool (Request);
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    InsertTailList (&SubtaskList, &Subtask->Link);
+    SubtaskNum++;
+
+    Blocks -= TransferBlocks;
+    Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + TransferBlocks * BlockSize);
+    Lba    += TransferBlocks;
+  }
+
+  Request->PendingSubtaskNum = SubtaskNum;
+
+  //
+  // Hand the sub-tasks over to the timer handler in one go, so that they are
+  // submitted back to back.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&Device->AsyncQueue, &Request->Link);
+  while (!IsListEmpty (&SubtaskList)) {
+    Link = GetFirstNode (&SubtaskList);
+    RemoveEntryList (Link);
+    InsertTailList (&Controller->UnsubmittedSubtasks, Link);
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read or write some blocks, keeping several NVMe commands in flight, and wait for
+  the completion.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  IsRead                 TRUE for a read, FALSE for a write.
+  @param  Buffer                 The data buffer.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeQueuedReadWrite (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device,
+  IN BOOLEAN                            IsRead,
+  IN VOID                               *Buffer,
+  IN UINT64                             Lba,
+  IN UINTN                              Blocks
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_BLOCK_IO2_TOKEN              Token;
+
+  Status = gBS->CreateEvent (0, TPL_NOTIFY, NULL, NULL, &Token.Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Token.TransactionStatus = EFI_SUCCESS;
+  Status = NvmeAsyncReadWrite (Device, IsRead, Buffer, Lba, Blocks, &Token);
+  if (!EFI_ERROR (Status)) {
+    while (gBS->CheckEvent (Token.Event) == EFI_NOT_READY) {
+      CpuPause ();
+    }
+    Status = Token.TransactionStatus;
+  }
+
+  gBS->CloseEvent (Token.Event);
+  return Status;
+}
+
 /**
   Read some blocks from the device.
 
@@ -170,36 +451,26 @@ NvmeRead (
 {
   EFI_STATUS                       Status;
   UINT32                           BlockSize;
-  NVME_CONTROLLER_PRIVATE_DATA     *Controller;
   UINT32                           MaxTransferBlocks;
   UINTN                            OrginalBlocks;
 
   Status        = EFI_SUCCESS;
-  Controller    = Device->Controller;
   BlockSize     = Device->Media.BlockSize;
   OrginalBlocks = Blocks;
 
-  if (Controller->ControllerData->Mdts != 0) {
-    MaxTransferBlocks = (1 << (Controller->ControllerData->Mdts)) * (1 << (Controller->Cap.Mpsmin + 12)) / BlockSize;
+  MaxTransferBlocks = NvmeMaxTransferBlocks (Device);
+
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Large transfers are split into several commands which are kept in flight
+    // on the asynchronous I/O queue, rather than issued one after another.
+    //
+    Status = NvmeQueuedReadWrite (Device, TRUE, Buffer, Lba, Blocks);
   } else {
-    MaxTransferBlocks = 1024;
+    Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
   }
-
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
-
-    if (EFI_ERROR(Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((EFI_D_INFO, "NvmeRead()  Lba = 0x%08x, Original = 0x%08x, Remaining = 0x%08x, BlockSize = 0x%x Status = %r\n", Lba, OrginalBlocks, Blocks, BlockSize, Status));
@@ -229,36 +500,26 @@ NvmeWrite (
 {
   EFI_STATUS                       Status;
   UINT32                           BlockSize;
-  NVME_CONTROLLER_PRIVATE_DATA     *Controller;
   UINT32                           MaxTransferBlocks;
   UINTN                            OrginalBlocks;
 
   Status        = EFI_SUCCESS;
-  Controller    = Device->Controller;
   BlockSize     = Device->Media.BlockSize;
   OrginalBlocks = Blocks;
 
-  if (Controller->ControllerData->Mdts != 0) {
-    MaxTransferBlocks = (1 << (Controller->ControllerData->Mdts)) * (1 << (Controller->Cap.Mpsmin + 12)) / BlockSize;
+  MaxTransferBlocks = NvmeMaxTransferBlocks (Device);
+
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Large transfers are split into several commands which are kept in flight
+    // on the asynchronous I/O queue, rather than issued one after another.
+    //
+    Status = NvmeQueuedReadWrite (Device, FALSE, Buffer, Lba, Blocks);
   } else {
-    MaxTransferBlocks = 1024;
+    Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
   }
-
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
-
-    if (EFI_ERROR(Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((EFI_D_INFO, "NvmeWrite() Lba = 0x%08x, Original = 0x%08x, Remaining = 0x%08x, BlockSize = 0x%x Status = %r\n", Lba, OrginalBlocks, Blocks, BlockSize, Status));
@@ -313,6 +574,39 @@ NvmeFlush (
 }
 
 
+/**
+  Wait for all the asynchronous I/O of the controller to complete, so that
+  the tokens of the pending BlockIo2 requests are signaled and their subtasks
+  are freed before the controller is re-initialized.
+
+  @param  Private              The pointer to the NVME_CONTROLLER_PRIVATE_DATA.
+
+**/
+VOID
+NvmeWaitAllAsyncTasks (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  BOOLEAN                         IsEmpty;
+  EFI_TPL                         OldTpl;
+
+  //
+  // Wait for the asynchronous PassThru queue to become empty.
+  //
+  while (TRUE) {
+    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    IsEmpty = IsListEmpty (&Private->AsyncPassThruQueue) &&
+              IsListEmpty (&Private->UnsubmittedSubtasks);
+    gBS->RestoreTPL (OldTpl);
+
+    if (IsEmpty) {
+      break;
+    }
+
+    gBS->Stall (100);
+  }
+}
+
 /**
   Reset the Block Device.
 
@@ -340,15 +634,17 @@ NvmeBlockIoReset (
     return EFI_INVALID_PARAMETER;
   }
 
+  Device  = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This);
+
+  Private = Device->Controller;
+
+  NvmeWaitAllAsyncTasks (Private);
+
   //
   // For Nvm Express subsystem, reset block device means reset controller.
   //
   OldTpl  = gBS->RaiseTPL (TPL_CALLBACK);
 
-  Device  = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This);
-
-  Private = Device->Controller;
-
   Status  = NvmeControllerInit (Private);
 
   gBS->RestoreTPL (OldTpl);
@@ -561,3 +857,331 @@ NvmeBlockIoFlushBlocks (
 
   return Status;
 }
+
+/**
+  Reset the block device hardware.
+
+  @param[in]  This                 Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification Indicates that the driver may perform a more
+                                   exhausive verfication operation of the device
+                                   during reset.
+
+  @retval EFI_SUCCESS          The device was reset.
+  @retval EFI_DEVICE_ERROR     The device is not functioning properly and could
+                               not be reset.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoResetEx (
+  IN  EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN  BOOLEAN                 ExtendedVerification
+  )
+{
+  EFI_STATUS                      Status;
+  NVME_DEVICE_PRIVATE_DATA        *Device;
+  NVME_CONTROLLER_PRIVATE_DATA    *Private;
+  EFI_TPL                         OldTpl;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device  = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO2 (This);
+  Private = Device->Controller;
+
+  NvmeWaitAllAsyncTasks (Private);
+
+  OldTpl  = gBS->RaiseTPL (TPL_CALLBACK);
+
+  Status  = NvmeControllerInit (Private);
+
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+/**
+  Read BufferSize bytes from Lba into Buffer.
+
+  This function reads the requested number of blocks from the device. All the
+  blocks are read, or an error is returned.
+  If EFI_DEVICE_ERROR, EFI_NO_MEDIA,_or EFI_MEDIA_CHANGED is returned and
+  non-blocking I/O is being used, the Event associated with this request will
+  not be signaled.
+
+  @param[in]       This       Indicates a pointer to the calling context.
+  @param[in]       MediaId    Id of the media, changes every time the media is
+                              replaced.
+  @param[in]       Lba        The starting Logical Block Address to read from.
+  @param[in, out]  Token      A pointer to the token associated with the transaction.
+  @param[in]       BufferSize Size of Buffer, must be a multiple of device block size.
+  @param[out]      Buffer     A pointer to the destination buffer for the data. The
+                              caller is responsible for either having implicit or
+                              explicit ownership of the buffer.
+
+  @retval EFI_SUCCESS           The read request was queued if Token->Event is
+                                not NULL.The data was read correctly from the
+                                device if the Token->Event is NULL.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing
+                                the read.
+  @retval EFI_NO_MEDIA          There is no media in the device.
+  @retval EFI_MEDIA_CHANGED     The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE   The BufferSize parameter is not a multiple of the
+                                intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER The read request contains LBAs that are not valid,
+                                or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack
+                                of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+     OUT VOID                   *Buffer
+  )
+{
+  NVME_DEVICE_PRIVATE_DATA          *Device;
+  EFI_STATUS                        Status;
+  EFI_BLOCK_IO_MEDIA                *Media;
+  UINTN                             BlockSize;
+  UINTN                             NumberOfBlocks;
+  UINTN                             IoAlign;
+  EFI_TPL                           OldTpl;
+
+  //
+  // Check parameters.
+  //
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Media = This->Media;
+
+  if (MediaId != Media->MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (BufferSize == 0) {
+    if ((Token != NULL) && (Token->Event != NULL)) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
+    return EFI_SUCCESS;
+  }
+
+  BlockSize = Media->BlockSize;
+  if ((BufferSize % BlockSize) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  NumberOfBlocks  = BufferSize / BlockSize;
+  if ((Lba + NumberOfBlocks - 1) > Media->LastBlock) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  IoAlign = Media->IoAlign;
+  if (IoAlign > 0 && (((UINTN) Buffer & (IoAlign - 1)) != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO2 (This);
+
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    Status = NvmeAsyncReadWrite (Device, TRUE, Buffer, Lba, NumberOfBlocks, Token);
+  } else {
+    OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+    Status = NvmeRead (Device, Buffer, Lba, NumberOfBlocks);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+/**
+  Write BufferSize bytes from Lba into Buffer.
+
+  This function writes the requested number of blocks to the device. All blocks
+  are written, or an error is returned.If EFI_DEVICE_ERROR, EFI_NO_MEDIA,
+  EFI_WRITE_PROTECTED or EFI_MEDIA_CHANGED is returned and non-blocking I/O is
+  being used, the Event associated with this request will not be signaled.
+
+  @param[in]       This       Indicates a pointer to the calling context.
+  @param[in]       MediaId    The media ID that the write request is for.
+  @param[in]       Lba        The starting logical block address to be written. The
+                              caller is responsible for writing to only legitimate
+                              locations.
+  @param[in, out]  Token      A pointer to the token associated with the transaction.
+  @param[in]       BufferSize Size of Buffer, must be a multiple of device block size.
+  @param[in]       Buffer     A pointer to the source buffer for the data.
+
+  @retval EFI_SUCCESS           The write request was queued if Event is not
+                                NULL.
+                                The data was written correctly to the device if
+                                the Event is NULL.
+  @retval EFI_WRITE_PROTECTED   The device can not be written to.
+  @retval EFI_NO_MEDIA          There is no media in the device.
+  @retval EFI_MEDIA_CHNAGED     The MediaId does not matched the current device.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing
+                                the write.
+  @retval EFI_BAD_BUFFER_SIZE   The Buffer was not a multiple of the block size
+                                of the device.
+  @retval EFI_INVALID_PARAMETER The write request contains LBAs that are not valid,
+                                or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack
+                                of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  NVME_DEVICE_PRIVATE_DATA          *Device;
+  EFI_STATUS                        Status;
+  EFI_BLOCK_IO_MEDIA                *Media;
+  UINTN                             BlockSize;
+  UINTN                             NumberOfBlocks;
+  UINTN                             IoAlign;
+  EFI_TPL                           OldTpl;
+
+  //
+  // Check parameters.
+  //
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Media = This->Media;
+
+  if (MediaId != Media->MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (BufferSize == 0) {
+    if ((Token != NULL) && (Token->Event != NULL)) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
+    return EFI_SUCCESS;
+  }
+
+  BlockSize = Media->BlockSize;
+  if ((BufferSize % BlockSize) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  NumberOfBlocks  = BufferSize / BlockSize;
+  if ((Lba + NumberOfBlocks - 1) > Media->LastBlock) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  IoAlign = Media->IoAlign;
+  if (IoAlign > 0 && (((UINTN) Buffer & (IoAlign - 1)) != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO2 (This);
+
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    Status = NvmeAsyncReadWrite (Device, FALSE, Buffer, Lba, NumberOfBlocks, Token);
+  } else {
+    OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+    Status = NvmeWrite (Device, Buffer, Lba, NumberOfBlocks);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  return Status;
+}
+
+/**
+  Flush the Block Device.
+
+  If EFI_DEVICE_ERROR, EFI_NO_MEDIA,_EFI_WRITE_PROTECTED or EFI_MEDIA_CHANGED
+  is returned and non-blocking I/O is being used, the Event associated with
+  this request will not be signaled.
+
+  @param[in]      This     Indicates a pointer to the calling context.
+  @param[in,out]  Token    A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS          The flush request was queued if Event is not NULL.
+                               All outstanding data was written correctly to the
+                               device if the Event is NULL.
+  @retval EFI_DEVICE_ERROR     The device reported an error while writting back
+                               the data.
+  @retval EFI_WRITE_PROTECTED  The device cannot be written to.
+  @retval EFI_NO_MEDIA         There is no media in the device.
+  @retval EFI_MEDIA_CHANGED    The MediaId is not for the current media.
+  @retval EFI_OUT_OF_RESOURCES The request could not be completed due to a lack
+                               of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token
+  )
+{
+  NVME_DEVICE_PRIVATE_DATA          *Device;
+  EFI_STATUS                        Status;
+  BOOLEAN                           IsEmpty;
+  EFI_TPL                           OldTpl;
+
+  //
+  // Check parameters.
+  //
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device = NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO2 (This);
+
+  //
+  // Wait for all the BlockIo2 requests of the namespace to complete, so that the
+  // flush covers the data they wrote.
+  //
+  while (TRUE) {
+    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    IsEmpty = IsListEmpty (&Device->AsyncQueue);
+    gBS->RestoreTPL (OldTpl);
+
+    if (IsEmpty) {
+      break;
+    }
+
+    gBS->Stall (100);
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Status = NvmeFlush (Device);
+  gBS->RestoreTPL (OldTpl);
+
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = Status;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
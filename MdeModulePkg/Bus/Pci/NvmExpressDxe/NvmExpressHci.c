@@ -685,35 +685,43 @@ NvmeCreateIoCompletionQueue (
   NVM_EXPRESS_RESPONSE                     Response;
   EFI_STATUS                               Status;
   NVME_ADMIN_CRIOCQ                        CrIoCq;
-
-  ZeroMem (&CommandPacket, sizeof(NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
-  ZeroMem (&Command, sizeof(NVM_EXPRESS_COMMAND));
-  ZeroMem (&Response, sizeof(NVM_EXPRESS_RESPONSE));
-  ZeroMem (&CrIoCq, sizeof(NVME_ADMIN_CRIOCQ));
-
-  CommandPacket.NvmeCmd      = &Command;
-  CommandPacket.NvmeResponse = &Response;
-
-  Command.Cdw0.Opcode = NVME_ADMIN_CRIOCQ_OPC;
-  Command.Cdw0.Cid    = Private->Cid[0]++;
-  CommandPacket.TransferBuffer = Private->CqBufferPciAddr[1];
-  CommandPacket.TransferLength = EFI_PAGE_SIZE;
-  CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
-  CommandPacket.QueueId        = NVME_ADMIN_QUEUE;
-
-  CrIoCq.Qid   = NVME_IO_QUEUE;
-  CrIoCq.Qsize = NVME_CCQ_SIZE;
-  CrIoCq.Pc    = 1;
-  CopyMem (&CommandPacket.NvmeCmd->Cdw10, &CrIoCq, sizeof (NVME_ADMIN_CRIOCQ));
-  CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID;
-
-  Status = Private->Passthru.PassThru (
-                               &Private->Passthru,
-                               0,
-                               0,
-                               &CommandPacket,
-                               NULL
-                               );
+  UINT16                                   Index;
+
+  Status = EFI_SUCCESS;
+
+  for (Index = NVME_IO_QUEUE; Index < NVME_MAX_QUEUES; Index++) {
+    ZeroMem (&CommandPacket, sizeof(NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+    ZeroMem (&Command, sizeof(NVM_EXPRESS_COMMAND));
+    ZeroMem (&Response, sizeof(NVM_EXPRESS_RESPONSE));
+    ZeroMem (&CrIoCq, sizeof(NVME_ADMIN_CRIOCQ));
+
+    CommandPacket.NvmeCmd      = &Command;
+    CommandPacket.NvmeResponse = &Response;
+
+    Command.Cdw0.Opcode = NVME_ADMIN_CRIOCQ_OPC;
+    Command.Cdw0.Cid    = Private->Cid[0]++;
+    CommandPacket.TransferBuffer = Private->CqBufferPciAddr[Index];
+    CommandPacket.TransferLength = EFI_PAGE_SIZE;
+    CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+    CommandPacket.QueueId        = NVME_ADMIN_QUEUE;
+
+    CrIoCq.Qid   = Index;
+    CrIoCq.Qsize = (Index == NVME_ASYNC_IO_QUEUE) ? Private->AsyncQueueSize : NVME_CCQ_SIZE;
+    CrIoCq.Pc    = 1;
+    CopyMem (&CommandPacket.NvmeCmd->Cdw10, &CrIoCq, sizeof (NVME_ADMIN_CRIOCQ));
+    CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID;
+
+    Status = Private->Passthru.PassThru (
+                                 &Private->Passthru,
+                                 0,
+                                 0,
+                                 &CommandPacket,
+                                 NULL
+                                 );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
 
   return Status;
 }
@@ -737,37 +745,45 @@ NvmeCreateIoSubmissionQueue (
   NVM_EXPRESS_RESPONSE                     Response;
   EFI_STATUS                               Status;
   NVME_ADMIN_CRIOSQ                        CrIoSq;
-
-  ZeroMem (&CommandPacket, sizeof(NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
-  ZeroMem (&Command, sizeof(NVM_EXPRESS_COMMAND));
-  ZeroMem (&Response, sizeof(NVM_EXPRESS_RESPONSE));
-  ZeroMem (&CrIoSq, sizeof(NVME_ADMIN_CRIOSQ));
-
-  CommandPacket.NvmeCmd      = &Command;
-  CommandPacket.NvmeResponse = &Response;
-
-  Command.Cdw0.Opcode = NVME_ADMIN_CRIOSQ_OPC;
-  Command.Cdw0.Cid    = Private->Cid[0]++;
-  CommandPacket.TransferBuffer = Private->SqBufferPciAddr[1];
-  CommandPacket.TransferLength = EFI_PAGE_SIZE;
-  CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
-  CommandPacket.QueueId        = NVME_ADMIN_QUEUE;
-
-  CrIoSq.Qid   = NVME_IO_QUEUE;
-  CrIoSq.Qsize = NVME_CSQ_SIZE;
-  CrIoSq.Pc    = 1;
-  CrIoSq.Cqid  = NVME_IO_QUEUE;
-  CrIoSq.Qprio = 0;
-  CopyMem (&CommandPacket.NvmeCmd->Cdw10, &CrIoSq, sizeof (NVME_ADMIN_CRIOSQ));
-  CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID;
-
-  Status = Private->Passthru.PassThru (
-                               &Private->Passthru,
-                               0,
-                               0,
-                               &CommandPacket,
-                               NULL
-                               );
+  UINT16                                   Index;
+
+  Status = EFI_SUCCESS;
+
+  for (Index = NVME_IO_QUEUE; Index < NVME_MAX_QUEUES; Index++) {
+    ZeroMem (&CommandPacket, sizeof(NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+    ZeroMem (&Command, sizeof(NVM_EXPRESS_COMMAND));
+    ZeroMem (&Response, sizeof(NVM_EXPRESS_RESPONSE));
+    ZeroMem (&CrIoSq, sizeof(NVME_ADMIN_CRIOSQ));
+
+    CommandPacket.NvmeCmd      = &Command;
+    CommandPacket.NvmeResponse = &Response;
+
+    Command.Cdw0.Opcode = NVME_ADMIN_CRIOSQ_OPC;
+    Command.Cdw0.Cid    = Private->Cid[0]++;
+    CommandPacket.TransferBuffer = Private->SqBufferPciAddr[Index];
+    CommandPacket.TransferLength = EFI_PAGE_SIZE;
+    CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+    CommandPacket.QueueId        = NVME_ADMIN_QUEUE;
+
+    CrIoSq.Qid   = Index;
+    CrIoSq.Qsize = (Index == NVME_ASYNC_IO_QUEUE) ? Private->AsyncQueueSize : NVME_CSQ_SIZE;
+    CrIoSq.Pc    = 1;
+    CrIoSq.Cqid  = Index;
+    CrIoSq.Qprio = 0;
+    CopyMem (&CommandPacket.NvmeCmd->Cdw10, &CrIoSq, sizeof (NVME_ADMIN_CRIOSQ));
+    CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID;
+
+    Status = Private->Passthru.PassThru (
+                                 &Private->Passthru,
+                                 0,
+                                 0,
+                                 &CommandPacket,
+                                 NULL
+                                 );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
 
   return Status;
 }
@@ -848,8 +864,11 @@ NvmeControllerInit (
   //
   ASSERT ((Private->Cap.Mpsmin + 12) <= EFI_PAGE_SHIFT);
 
-  Private->Cid[0] = 0;
-  Private->Cid[1] = 0;
+  //
+  // The asynchronous I/O queue is as deep as both the driver and the controller allow.
+  // CAP.MQES is 0-based as well.
+  //
+  Private->AsyncQueueSize = (UINT16) MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes);
 
   Status = NvmeDisableController (Private);
 
@@ -857,6 +876,16 @@ NvmeControllerInit (
     return Status;
   }
 
+  //
+  // Disabling the controller resets all the queues, so start over with empty ones.
+  //
+  ZeroMem (Private->Cid, sizeof (Private->Cid));
+  ZeroMem (Private->Pt, sizeof (Private->Pt));
+  ZeroMem (Private->SqTdbl, sizeof (Private->SqTdbl));
+  ZeroMem (Private->CqHdbl, sizeof (Private->CqHdbl));
+  Private->AsyncSqHead = 0;
+  ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES));
+
   //
   // set number of entries admin submission & completion queues.
   //
@@ -888,14 +917,21 @@ NvmeControllerInit (
   Private->SqBufferPciAddr[1] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr + 2 * EFI_PAGE_SIZE);
   Private->CqBuffer[1]        = (NVME_CQ *)(UINTN)(Private->Buffer + 3 * EFI_PAGE_SIZE);
   Private->CqBufferPciAddr[1] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + 3 * EFI_PAGE_SIZE);
+  Private->SqBuffer[2]        = (NVME_SQ *)(UINTN)(Private->Buffer + 4 * EFI_PAGE_SIZE);
+  Private->SqBufferPciAddr[2] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr + 4 * EFI_PAGE_SIZE);
+  Private->CqBuffer[2]        = (NVME_CQ *)(UINTN)(Private->Buffer + 5 * EFI_PAGE_SIZE);
+  Private->CqBufferPciAddr[2] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + 5 * EFI_PAGE_SIZE);
 
   DEBUG ((EFI_D_INFO, "Private->Buffer = [%016X]\n", (UINT64)(UINTN)Private->Buffer));
   DEBUG ((EFI_D_INFO, "Admin Submission Queue size (Aqa.Asqs) = [%08X]\n", Aqa.Asqs));
   DEBUG ((EFI_D_INFO, "Admin Completion Queue size (Aqa.Acqs) = [%08X]\n", Aqa.Acqs));
   DEBUG ((EFI_D_INFO, "Admin Submission Queue (SqBuffer[0]) = [%016X]\n", Private->SqBuffer[0]));
   DEBUG ((EFI_D_INFO, "Admin Completion Queue (CqBuffer[0]) = [%016X]\n", Private->CqBuffer[0]));
-  DEBUG ((EFI_D_INFO, "I/O   Submission Queue (SqBuffer[1]) = [%016X]\n", Private->SqBuffer[1]));
-  DEBUG ((EFI_D_INFO, "I/O   Completion Queue (CqBuffer[1]) = [%016X]\n", Private->CqBuffer[1]));
+  DEBUG ((EFI_D_INFO, "Sync  I/O Submission Queue (SqBuffer[1]) = [%016X]\n", Private->SqBuffer[1]));
+  DEBUG ((EFI_D_INFO, "Sync  I/O Completion Queue (CqBuffer[1]) = [%016X]\n", Private->CqBuffer[1]));
+  DEBUG ((EFI_D_INFO, "Async I/O Submission Queue (SqBuffer[2]) = [%016X]\n", Private->SqBuffer[2]));
+  DEBUG ((EFI_D_INFO, "Async I/O Completion Queue (CqBuffer[2]) = [%016X]\n", Private->CqBuffer[2]));
+  DEBUG ((EFI_D_INFO, "Async I/O Queue size = [%08X]\n", Private->AsyncQueueSize));
 
   //
   // Program admin queue attributes.
@@ -930,7 +966,7 @@ NvmeControllerInit (
   }
 
   //
-  // Create one I/O completion queue.
+  // Create the sync and async I/O completion queues.
   //
   Status = NvmeCreateIoCompletionQueue (Private);
   if (EFI_ERROR(Status)) {
@@ -938,7 +974,7 @@ NvmeControllerInit (
   }
 
   //
-  // Create one I/O Submission queue.
+  // Create the sync and async I/O submission queues.
   //
   Status = NvmeCreateIoSubmissionQueue (Private);
   if (EFI_ERROR(Status)) {
@@ -946,12 +982,14 @@ NvmeControllerInit (
   }
 
   //
-  // Allocate buffer for Identify Controller data
+  // Allocate buffer for Identify Controller data, unless the controller is being reset
   //
-  Private->ControllerData = (NVME_ADMIN_CONTROLLER_DATA *)AllocateZeroPool (sizeof(NVME_ADMIN_CONTROLLER_DATA));
-
   if (Private->ControllerData == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+    Private->ControllerData = (NVME_ADMIN_CONTROLLER_DATA *)AllocateZeroPool (sizeof(NVME_ADMIN_CONTROLLER_DATA));
+
+    if (Private->ControllerData == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
   //
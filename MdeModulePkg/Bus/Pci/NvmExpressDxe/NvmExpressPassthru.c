@@ -24,7 +24,7 @@
 
 GLOBAL_REMOVE_IF_UNREFERENCED NVM_EXPRESS_PASS_THRU_MODE gNvmExpressPassThruMode = {
   0,
-  NVM_EXPRESS_PASS_THRU_ATTRIBUTES_PHYSICAL | NVM_EXPRESS_PASS_THRU_ATTRIBUTES_CMD_SET_NVME,
+  NVM_EXPRESS_PASS_THRU_ATTRIBUTES_PHYSICAL | NVM_EXPRESS_PASS_THRU_ATTRIBUTES_NONBLOCKIO | NVM_EXPRESS_PASS_THRU_ATTRIBUTES_CMD_SET_NVME,
   sizeof (UINTN),
   0x10000,
   0,
@@ -292,7 +292,7 @@ NvmeCreatePrpList (
   //
   ZeroMem (*PrpListHost, Bytes);
   for (PrpListIndex = 0; PrpListIndex < *PrpListNo - 1; ++PrpListIndex) {
-    PrpListBase = *(UINT8*)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
+    PrpListBase = (UINT64)(UINTN)*PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
 
     for (PrpEntryIndex = 0; PrpEntryIndex < PrpEntryNo; ++PrpEntryIndex) {
       if (PrpEntryIndex != PrpEntryNo - 1) {
@@ -312,7 +312,7 @@ NvmeCreatePrpList (
   //
   // Fill last PRP list.
   //
-  PrpListBase = *(UINT64*)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
+  PrpListBase = (UINT64)(UINTN)*PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
   for (PrpEntryIndex = 0; PrpEntryIndex < ((Remainder != 0) ? Remainder : PrpEntryNo); ++PrpEntryIndex) {
     *((UINT64*)(UINTN)PrpListBase + PrpEntryIndex) = PhysicalAddr;
     PhysicalAddr += EFI_PAGE_SIZE;
@@ -326,6 +326,84 @@ EXIT:
 }
 
 
+/**
+  Take a PRP list page from the pre-mapped PRP list pool of the controller and fill it.
+  A single PRP list page is used, so at most NVME_PRP_ENTRIES_PER_PAGE entries fit.
+
+  @param[in]  Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  PhysicalAddr            The physical base address of data buffer.
+  @param[in]  Pages                   The number of pages to be transfered.
+  @param[out] PoolIndex               The index of the PRP list page in the pool.
+
+  @retval The device address of the PRP list, or NULL if the pool can't serve the request.
+
+**/
+VOID*
+NvmeAllocatePooledPrpList (
+  IN     NVME_CONTROLLER_PRIVATE_DATA *Private,
+  IN     EFI_PHYSICAL_ADDRESS         PhysicalAddr,
+  IN     UINTN                        Pages,
+     OUT UINTN                        *PoolIndex
+  )
+{
+  EFI_TPL                     OldTpl;
+  UINTN                       Index;
+  UINTN                       PrpEntryIndex;
+  UINT64                      *PrpList;
+
+  *PoolIndex = NVME_PRP_LIST_POOL_NONE;
+
+  if ((Private->PrpListPool == NULL) || (Pages > NVME_PRP_ENTRIES_PER_PAGE)) {
+    return NULL;
+  }
+
+  //
+  // The pool is shared by the sync path and the asynchronous timer handler.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Private->PrpListPoolFree == 0) {
+    gBS->RestoreTPL (OldTpl);
+    return NULL;
+  }
+  Index = (UINTN) LowBitSet64 (Private->PrpListPoolFree);
+  Private->PrpListPoolFree &= ~LShiftU64 (1, Index);
+  gBS->RestoreTPL (OldTpl);
+
+  PrpList = (UINT64 *)(Private->PrpListPool + EFI_PAGES_TO_SIZE (Index));
+  for (PrpEntryIndex = 0; PrpEntryIndex < Pages; ++PrpEntryIndex) {
+    PrpList[PrpEntryIndex] = PhysicalAddr;
+    PhysicalAddr += EFI_PAGE_SIZE;
+  }
+
+  *PoolIndex = Index;
+  return (VOID *)(Private->PrpListPoolPciAddr + EFI_PAGES_TO_SIZE (Index));
+}
+
+/**
+  Give a PRP list page back to the pre-mapped PRP list pool of the controller.
+
+  @param[in]  Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  PoolIndex               The index returned by NvmeAllocatePooledPrpList().
+
+**/
+VOID
+NvmeFreePooledPrpList (
+  IN     NVME_CONTROLLER_PRIVATE_DATA *Private,
+  IN     UINTN                        PoolIndex
+  )
+{
+  EFI_TPL                     OldTpl;
+
+  if (PoolIndex == NVME_PRP_LIST_POOL_NONE) {
+    return;
+  }
+
+  ASSERT (PoolIndex < NVME_PRP_LIST_POOL_PAGES);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Private->PrpListPoolFree |= LShiftU64 (1, PoolIndex);
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
   both blocking I/O and nonblocking I/O. The blocking I/O functionality is required, and the nonblocking
@@ -387,7 +465,10 @@ NvmExpressPassThru (
   UINT64                        *Prp;
   VOID                          *PrpListHost;
   UINTN                         PrpListNo;
+  UINTN                         PrpListPoolIndex;
   UINT32                        Data;
+  NVME_PASS_THRU_ASYNC_REQ      *AsyncRequest;
+  EFI_TPL                       OldTpl;
 
   //
   // check the data fields in Packet parameter.
@@ -404,38 +485,79 @@ NvmExpressPassThru (
     return EFI_INVALID_PARAMETER;
   }
 
-  Private     = NVME_CONTROLLER_PRIVATE_DATA_FROM_PASS_THRU (This);
-  PciIo       = Private->PciIo;
-  MapData     = NULL;
-  MapMeta     = NULL;
-  MapPrpList  = NULL;
-  PrpListHost = NULL;
-  PrpListNo   = 0;
-  Prp         = NULL;
-  TimerEvent  = NULL;
-  Status      = EFI_SUCCESS;
+  if (Packet->NvmeCmd->Nsid != NamespaceId) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Private          = NVME_CONTROLLER_PRIVATE_DATA_FROM_PASS_THRU (This);
+  PciIo            = Private->PciIo;
+  MapData          = NULL;
+  MapMeta          = NULL;
+  MapPrpList       = NULL;
+  PrpListHost      = NULL;
+  PrpListNo        = 0;
+  PrpListPoolIndex = NVME_PRP_LIST_POOL_NONE;
+  Prp              = NULL;
+  TimerEvent       = NULL;
+  AsyncRequest     = NULL;
+  Status           = EFI_SUCCESS;
 
+  //
+  // Non-blocking I/O commands go to the deep asynchronous I/O queue. Admin commands
+  // are always executed as blocking I/O.
+  //
   Qid = Packet->QueueId;
-  Sq  = Private->SqBuffer[Qid] + Private->SqTdbl[Qid].Sqt;
-  Cq  = Private->CqBuffer[Qid] + Private->CqHdbl[Qid].Cqh;
+  if ((Event != NULL) && (Qid == NVME_IO_QUEUE)) {
+    Qid = NVME_ASYNC_IO_QUEUE;
+  }
 
-  if (Packet->NvmeCmd->Nsid != NamespaceId) {
-    return EFI_INVALID_PARAMETER;
+  //
+  // The asynchronous I/O queue is shared with the timer handler, so own it at TPL_NOTIFY.
+  //
+  OldTpl = TPL_APPLICATION;
+  if (Qid == NVME_ASYNC_IO_QUEUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    //
+    // Keep one slot empty, a full queue has the tail right behind the head.
+    //
+    if ((Private->SqTdbl[Qid].Sqt + 1) % (Private->AsyncQueueSize + 1) == Private->AsyncSqHead) {
+      gBS->RestoreTPL (OldTpl);
+      return EFI_NOT_READY;
+    }
+
+    AsyncRequest = AllocateZeroPool (sizeof (NVME_PASS_THRU_ASYNC_REQ));
+    if (AsyncRequest == NULL) {
+      gBS->RestoreTPL (OldTpl);
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
+  Sq  = Private->SqBuffer[Qid] + Private->SqTdbl[Qid].Sqt;
+  Cq  = Private->CqBuffer[Qid] + Private->CqHdbl[Qid].Cqh;
+
   ZeroMem (Sq, sizeof (NVME_SQ));
   Sq->Opc  = Packet->NvmeCmd->Cdw0.Opcode;
   Sq->Fuse = Packet->NvmeCmd->Cdw0.FusedOperation;
   Sq->Cid  = Packet->NvmeCmd->Cdw0.Cid;
   Sq->Nsid = Packet->NvmeCmd->Nsid;
 
+  //
+  // Completions of the asynchronous I/O queue come back in any order, so the
+  // command ID is generated here to match them with the requests.
+  //
+  if (Qid == NVME_ASYNC_IO_QUEUE) {
+    Sq->Cid = Private->Cid[Qid]++;
+  }
+
   //
   // Currently we only support PRP for data transfer, SGL is NOT supported.
   //
   ASSERT (Sq->Psdt == 0);
   if (Sq->Psdt != 0) {
     DEBUG ((EFI_D_ERROR, "NvmExpressPassThru: doesn't support SGL mechanism\n"));
-    return EFI_UNSUPPORTED;
+    Status = EFI_UNSUPPORTED;
+    goto EXIT;
   }
 
   Sq->Prp[0] = (UINT64)(UINTN)Packet->TransferBuffer;
@@ -462,7 +584,8 @@ NvmExpressPassThru (
                       &MapData
                       );
     if (EFI_ERROR (Status) || (Packet->TransferLength != MapLength)) {
-      return EFI_OUT_OF_RESOURCES;
+      Status = EFI_OUT_OF_RESOURCES;
+      goto EXIT;
     }
 
     Sq->Prp[0] = PhyAddr;
@@ -480,12 +603,8 @@ NvmExpressPassThru (
                         &MapMeta
                         );
       if (EFI_ERROR (Status) || (Packet->MetadataLength != MapLength)) {
-        PciIo->Unmap (
-                 PciIo,
-                 MapData
-                 );
-
-        return EFI_OUT_OF_RESOURCES;
+        Status = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
       }
       Sq->Mptr = PhyAddr;
     }
@@ -499,12 +618,16 @@ NvmExpressPassThru (
 
   if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
     //
-    // Create PrpList for remaining data buffer.
+    // Create PrpList for remaining data buffer, preferably from the pre-mapped pool.
     //
     PhyAddr = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
-    Prp = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+    Prp = NvmeAllocatePooledPrpList (Private, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListPoolIndex);
     if (Prp == NULL) {
-      goto EXIT;
+      Prp = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+      if (Prp == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto EXIT;
+      }
     }
 
     Sq->Prp[1] = (UINT64)(UINTN)Prp;
@@ -534,7 +657,11 @@ NvmExpressPassThru (
   //
   // Ring the submission queue doorbell.
   //
-  Private->SqTdbl[Qid].Sqt ^= 1;
+  if (Qid == NVME_ASYNC_IO_QUEUE) {
+    Private->SqTdbl[Qid].Sqt = (UINT16) ((Private->SqTdbl[Qid].Sqt + 1) % (Private->AsyncQueueSize + 1));
+  } else {
+    Private->SqTdbl[Qid].Sqt ^= 1;
+  }
   Data = ReadUnaligned32 ((UINT32*)&Private->SqTdbl[Qid]);
   PciIo->Mem.Write (
                PciIo,
@@ -545,6 +672,27 @@ NvmExpressPassThru (
                &Data
                );
 
+  //
+  // For non-blocking I/O, hand the mappings over to the asynchronous request. The
+  // timer handler releases them and signals Event once the command completes.
+  //
+  if (Qid == NVME_ASYNC_IO_QUEUE) {
+    AsyncRequest->Signature        = NVME_PASS_THRU_ASYNC_REQ_SIG;
+    AsyncRequest->Packet           = Packet;
+    AsyncRequest->CommandId        = Sq->Cid;
+    AsyncRequest->MapData          = MapData;
+    AsyncRequest->MapMeta          = MapMeta;
+    AsyncRequest->MapPrpList       = MapPrpList;
+    AsyncRequest->PrpListNo        = PrpListNo;
+    AsyncRequest->PrpListHost      = PrpListHost;
+    AsyncRequest->PrpListPoolIndex = PrpListPoolIndex;
+    AsyncRequest->CallerEvent      = Event;
+    InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
+
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
   Status = gBS->CreateEvent (
                   EVT_TIMER,
                   TPL_CALLBACK,
@@ -624,16 +772,174 @@ EXIT:
              );
   }
 
-  if (Prp != NULL) {
+  if (PrpListHost != NULL) {
     PciIo->FreeBuffer (PciIo, PrpListNo, PrpListHost);
   }
 
+  NvmeFreePooledPrpList (Private, PrpListPoolIndex);
+
   if (TimerEvent != NULL) {
     gBS->CloseEvent (TimerEvent);
   }
+
+  if (AsyncRequest != NULL) {
+    FreePool (AsyncRequest);
+    gBS->RestoreTPL (OldTpl);
+  }
   return Status;
 }
 
+/**
+  Call back function when the timer event is signaled.
+
+  Reaps the asynchronous I/O completion queue, signals the events of the completed
+  asynchronous PassThru requests, and submits the queued BlockIo2 sub-tasks while
+  there is room in the asynchronous I/O submission queue.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT                    Event,
+  IN VOID*                        Context
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA         *Private;
+  EFI_PCI_IO_PROTOCOL                  *PciIo;
+  NVME_CQ                              *Cq;
+  UINT16                               QueueId;
+  UINT32                               Data;
+  LIST_ENTRY                           *Link;
+  NVME_PASS_THRU_ASYNC_REQ             *AsyncRequest;
+  NVM_EXPRESS_PASS_THRU_COMMAND_PACKET *Packet;
+  NVME_BLKIO2_SUBTASK                  *Subtask;
+  EFI_BLOCK_IO2_TOKEN                  *Token;
+  BOOLEAN                              HasNewItem;
+  EFI_STATUS                           Status;
+
+  Private    = (NVME_CONTROLLER_PRIVATE_DATA *)Context;
+  PciIo      = Private->PciIo;
+  QueueId    = NVME_ASYNC_IO_QUEUE;
+  Cq         = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+  HasNewItem = FALSE;
+
+  //
+  // Reap all the completion queue entries posted since the last run. Completions
+  // are matched with the requests by command ID, as the controller may complete
+  // the commands out of order.
+  //
+  while (Cq->Pt != Private->Pt[QueueId]) {
+    Private->AsyncSqHead = Cq->Sqhd;
+
+    for (Link = GetFirstNode (&Private->AsyncPassThruQueue);
+         !IsNull (&Private->AsyncPassThruQueue, Link);
+         Link = GetNextNode (&Private->AsyncPassThruQueue, Link)) {
+      AsyncRequest = NVME_PASS_THRU_ASYNC_REQ_FROM_THIS (Link);
+      if (AsyncRequest->CommandId == Cq->Cid) {
+        break;
+      }
+    }
+
+    if (!IsNull (&Private->AsyncPassThruQueue, Link)) {
+      RemoveEntryList (Link);
+      Packet = AsyncRequest->Packet;
+
+      CopyMem (Packet->NvmeResponse, Cq, sizeof (NVM_EXPRESS_RESPONSE));
+      if ((Cq->Sct == 0) && (Cq->Sc == 0)) {
+        Packet->ControllerStatus = NVM_EXPRESS_STATUS_CONTROLLER_READY;
+      } else {
+        Packet->ControllerStatus = NVM_EXPRESS_STATUS_CONTROLLER_CMD_ERROR;
+        DEBUG_CODE_BEGIN();
+          NvmeDumpStatus (Cq);
+        DEBUG_CODE_END();
+      }
+
+      if (AsyncRequest->MapData != NULL) {
+        PciIo->Unmap (PciIo, AsyncRequest->MapData);
+      }
+      if (AsyncRequest->MapMeta != NULL) {
+        PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
+      }
+      if (AsyncRequest->MapPrpList != NULL) {
+        PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
+      }
+      if (AsyncRequest->PrpListHost != NULL) {
+        PciIo->FreeBuffer (PciIo, AsyncRequest->PrpListNo, AsyncRequest->PrpListHost);
+      }
+      NvmeFreePooledPrpList (Private, AsyncRequest->PrpListPoolIndex);
+
+      gBS->SignalEvent (AsyncRequest->CallerEvent);
+      FreePool (AsyncRequest);
+    } else {
+      DEBUG ((EFI_D_ERROR, "ProcessAsyncTaskList: no request for command ID 0x%x\n", Cq->Cid));
+    }
+
+    Private->CqHdbl[QueueId].Cqh++;
+    if (Private->CqHdbl[QueueId].Cqh > Private->AsyncQueueSize) {
+      Private->CqHdbl[QueueId].Cqh = 0;
+      Private->Pt[QueueId] ^= 1;
+    }
+
+    Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+    HasNewItem = TRUE;
+  }
+
+  //
+  // Release all the reaped entries to the controller with a single doorbell write.
+  //
+  if (HasNewItem) {
+    Data = ReadUnaligned32 ((UINT32*)&Private->CqHdbl[QueueId]);
+    PciIo->Mem.Write (
+                 PciIo,
+                 EfiPciIoWidthUint32,
+                 NVME_BAR,
+                 NVME_CQHDBL_OFFSET(QueueId, Private->Cap.Dstrd),
+                 1,
+                 &Data
+                 );
+  }
+
+  //
+  // Submit the queued BlockIo2 sub-tasks in order, until the submission queue is full.
+  //
+  while (!IsListEmpty (&Private->UnsubmittedSubtasks)) {
+    Link    = GetFirstNode (&Private->UnsubmittedSubtasks);
+    Subtask = NVME_BLKIO2_SUBTASK_FROM_LINK (Link);
+    Token   = Subtask->BlockIo2Request->Token;
+
+    if (EFI_ERROR (Token->TransactionStatus)) {
+      //
+      // The request already failed, complete the rest of it without touching the device.
+      //
+      RemoveEntryList (Link);
+      Subtask->CommandPacket.ControllerStatus = NVM_EXPRESS_STATUS_CONTROLLER_DEVICE_ERROR;
+      gBS->SignalEvent (Subtask->Event);
+      continue;
+    }
+
+    Status = Private->Passthru.PassThru (
+                                 &Private->Passthru,
+                                 Subtask->NamespaceId,
+                                 0,
+                                 &Subtask->CommandPacket,
+                                 Subtask->Event
+                                 );
+    if (Status == EFI_NOT_READY) {
+      break;
+    }
+
+    RemoveEntryList (Link);
+    if (EFI_ERROR (Status)) {
+      Subtask->CommandPacket.ControllerStatus = NVM_EXPRESS_STATUS_CONTROLLER_DEVICE_ERROR;
+      gBS->SignalEvent (Subtask->Event);
+    }
+  }
+}
+
 /**
   Used to retrieve the list of namespaces defined on an NVM Express controller.
 
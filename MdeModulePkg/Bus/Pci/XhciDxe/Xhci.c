@@ -91,6 +91,16 @@ EFI_USB2_HC_PROTOCOL gXhciUsb2HcTemplate = {
   0x0
 };
 
+//
+// Template for Xhci's Usb2 Host Controller Async Bulk Protocol Instance.
+//
+EDKII_USB2_HC_ASYNC_BULK_PROTOCOL gXhciUsb2HcAsyncBulkTemplate = {
+  XhcAsyncBulkTransfer,
+  XhcCancelAsyncBulkTransfer,
+  XhcAsyncBulkPoll,
+  XHC_ASYNC_BULK_QUEUE_DEPTH
+};
+
 /**
   Retrieves the capability of root hub ports.
 
@@ -1647,6 +1657,193 @@ XhcAsyncIsochronousTransfer (
   return EFI_UNSUPPORTED;
 }
 
+/**
+  Queue a bulk transfer to a bulk endpoint of a USB device and return without
+  waiting for it to complete.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  MaximumPacketLength   Maximum packet size the endpoint is capable of
+                                sending or receiving.
+  @param  Data                  The data buffer of the transfer.
+  @param  DataLength            The length of the data buffer.
+  @param  Translator            A pointr to the transaction translator data.
+  @param  CallBackFunction      The function to call when the transfer completes.
+  @param  Context               Context to CallBackFunction.
+
+  @retval EFI_SUCCESS           The transfer is queued.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The queue of the endpoint is full, or the request
+                                failed due to a lack of resources.
+  @retval EFI_DEVICE_ERROR      The request failed due to host controller error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAsyncBulkTransfer (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress,
+  IN UINT8                               DeviceSpeed,
+  IN UINTN                               MaximumPacketLength,
+  IN VOID                                *Data,
+  IN UINTN                               DataLength,
+  IN EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK     CallBackFunction,
+  IN VOID                                *Context OPTIONAL
+  )
+{
+  USB_XHCI_INSTANCE       *Xhc;
+  TRANSFER_RING           *Ring;
+  URB                     *Urb;
+  UINT8                   SlotId;
+  UINT8                   Dci;
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+
+  //
+  // Validate the parameters
+  //
+  if ((Data == NULL) || (DataLength == 0) || (CallBackFunction == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((DeviceSpeed == EFI_USB_SPEED_LOW) ||
+      ((DeviceSpeed == EFI_USB_SPEED_FULL) && (MaximumPacketLength > 64)) ||
+      ((EFI_USB_SPEED_HIGH == DeviceSpeed) && (MaximumPacketLength > 512)) ||
+      ((EFI_USB_SPEED_SUPER == DeviceSpeed) && (MaximumPacketLength > 1024))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_ASYNC_BULK_THIS (This);
+  Status = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((EFI_D_ERROR, "XhcAsyncBulkTransfer: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  //
+  // Check if the device is still enabled before every transaction.
+  //
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  Dci  = XhcEndpointToDci ((UINT8) (EndPointAddress & 0x0F), (UINT8) (XHCI_IS_DATAIN (EndPointAddress) ? EfiUsbDataIn : EfiUsbDataOut));
+  ASSERT (Dci < 32);
+  Ring = (TRANSFER_RING *)(UINTN) Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1];
+  if (Ring == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    goto ON_EXIT;
+  }
+
+  if (XhcAsyncBulkQueueDepth (Ring, NULL) >= XHC_ASYNC_BULK_QUEUE_DEPTH) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  //
+  // Append the TD of the new URB to the transfer ring behind the TDs already
+  // queued, and let the xHC run it without waiting for its completion. The
+  // completion is picked up from the event ring by XhcProcessAsyncBulkTransfers().
+  //
+  Urb = XhcCreateUrb (
+          Xhc,
+          DeviceAddress,
+          EndPointAddress,
+          DeviceSpeed,
+          MaximumPacketLength,
+          XHC_BULK_TRANSFER,
+          NULL,
+          Data,
+          DataLength,
+          CallBackFunction,
+          Context
+          );
+
+  if (Urb == NULL) {
+    DEBUG ((EFI_D_ERROR, "XhcAsyncBulkTransfer: failed to create URB\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  InsertTailList (&Ring->AsyncBulkQueue, &Urb->UrbList);
+  if (Xhc->AsyncBulkCount++ == 0) {
+    gBS->SetTimer (Xhc->AsyncBulkTimer, TimerPeriodic, XHC_ASYNC_BULK_TIMER_INTERVAL);
+  }
+
+  XhcRingDoorBell (Xhc, SlotId, Dci);
+  Status = EFI_SUCCESS;
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Cancel all the asynchronous bulk transfers queued on an endpoint of a USB device.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS           The transfers of the endpoint are cancelled.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR      The endpoint could not be stopped.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcCancelAsyncBulkTransfer (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress
+  )
+{
+  USB_XHCI_INSTANCE       *Xhc;
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_ASYNC_BULK_THIS (This);
+  Status = XhciDelAsyncBulkTransfer (Xhc, DeviceAddress, EndPointAddress);
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Complete the asynchronous bulk transfers the xHC has finished and call their
+  callbacks.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+
+  @retval EFI_SUCCESS           The completed transfers are processed.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAsyncBulkPoll (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This
+  )
+{
+  EFI_TPL                 OldTpl;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+  XhcProcessAsyncBulkTransfers (XHC_FROM_ASYNC_BULK_THIS (This), OldTpl);
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Entry point for EFI drivers.
 
@@ -1786,6 +1983,7 @@ XhcCreateUsbHc (
   Xhc->DevicePath            = DevicePath;
   Xhc->OriginalPciAttributes = OriginalPciAttributes;
   CopyMem (&Xhc->Usb2Hc, &gXhciUsb2HcTemplate, sizeof (EFI_USB2_HC_PROTOCOL));
+  CopyMem (&Xhc->Usb2HcAsyncBulk, &gXhciUsb2HcAsyncBulkTemplate, sizeof (EDKII_USB2_HC_ASYNC_BULK_PROTOCOL));
 
   InitializeListHead (&Xhc->AsyncIntTransfers);
 
@@ -1836,6 +2034,23 @@ XhcCreateUsbHc (
     goto ON_ERROR;
   }
 
+  //
+  // Create the asynchronous bulk transfer timer, it is armed when the first
+  // asynchronous bulk transfer is queued.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  XhcMonitorAsyncBulkTransfers,
+                  Xhc,
+                  &Xhc->AsyncBulkTimer
+                  );
+
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (Xhc->PollTimer);
+    goto ON_ERROR;
+  }
+
   return Xhc;
 
 ON_ERROR:
@@ -1869,12 +2084,17 @@ XhcExitBootService (
   // and uninstall the XHCI protocl.
   //
   gBS->SetTimer (Xhc->PollTimer, TimerCancel, 0);
+  gBS->SetTimer (Xhc->AsyncBulkTimer, TimerCancel, 0);
   XhcHaltHC (Xhc, XHC_GENERIC_TIMEOUT);
 
   if (Xhc->PollTimer != NULL) {
     gBS->CloseEvent (Xhc->PollTimer);
   }
 
+  if (Xhc->AsyncBulkTimer != NULL) {
+    gBS->CloseEvent (Xhc->AsyncBulkTimer);
+  }
+
   XhcClearBiosOwnership (Xhc);
 
   //
@@ -2069,11 +2289,26 @@ XhcDriverBindingStart (
     goto FREE_POOL;
   }
 
+  //
+  // The asynchronous bulk protocol is optional for the USB bus driver, don't
+  // fail the start if it can't be installed.
+  //
+  Status = gBS->InstallProtocolInterface (
+                  &Controller,
+                  &gEdkiiUsb2HcAsyncBulkProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &Xhc->Usb2HcAsyncBulk
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "XhcDriverBindingStart: failed to install USB2_HC async bulk Protocol\n"));
+  }
+
   DEBUG ((EFI_D_INFO, "XhcDriverBindingStart: XHCI started for controller @ %x\n", Controller));
   return EFI_SUCCESS;
 
 FREE_POOL:
   gBS->CloseEvent (Xhc->PollTimer);
+  gBS->CloseEvent (Xhc->AsyncBulkTimer);
   XhcFreeSched (Xhc);
   FreePool (Xhc);
 
@@ -2160,6 +2395,12 @@ XhcDriverBindingStop (
   Xhc   = XHC_FROM_THIS (Usb2Hc);
   PciIo = Xhc->PciIo;
 
+  gBS->UninstallProtocolInterface (
+         Controller,
+         &gEdkiiUsb2HcAsyncBulkProtocolGuid,
+         &Xhc->Usb2HcAsyncBulk
+         );
+
   //
   // Stop AsyncRequest Polling timer then stop the XHCI driver
   // and uninstall the XHCI protocl.
@@ -2186,6 +2427,10 @@ XhcDriverBindingStop (
     gBS->CloseEvent (Xhc->PollTimer);
   }
 
+  if (Xhc->AsyncBulkTimer != NULL) {
+    gBS->CloseEvent (Xhc->AsyncBulkTimer);
+  }
+
   if (Xhc->ExitBootServiceEvent != NULL) {
     gBS->CloseEvent (Xhc->ExitBootServiceEvent);
   }
@@ -19,6 +19,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Uefi.h>
 
 #include <Protocol/Usb2HostController.h>
+#include <Protocol/Usb2HcAsyncBulk.h>
 #include <Protocol/PciIo.h>
 
 #include <Guid/EventGroup.h>
@@ -70,6 +71,15 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 // The unit is 100us, takes 50ms as interval.
 //
 #define XHC_ASYNC_TIMER_INTERVAL     EFI_TIMER_PERIOD_MILLISECONDS(50)
+//
+// XHC async bulk transfer timer interval, it runs only while asynchronous
+// bulk transfers are queued. The unit is 100ns, takes 1ms as interval.
+//
+#define XHC_ASYNC_BULK_TIMER_INTERVAL  EFI_TIMER_PERIOD_MILLISECONDS(1)
+//
+// The maximum number of asynchronous bulk transfers queued on an endpoint.
+//
+#define XHC_ASYNC_BULK_QUEUE_DEPTH   16
 
 //
 // XHC raises TPL to TPL_NOTIFY to serialize all its operations
@@ -109,6 +119,7 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 
 #define XHCI_INSTANCE_SIG              SIGNATURE_32 ('x', 'h', 'c', 'i')
 #define XHC_FROM_THIS(a)               CR(a, USB_XHCI_INSTANCE, Usb2Hc, XHCI_INSTANCE_SIG)
+#define XHC_FROM_ASYNC_BULK_THIS(a)    CR(a, USB_XHCI_INSTANCE, Usb2HcAsyncBulk, XHCI_INSTANCE_SIG)
 
 #define USB_DESC_TYPE_HUB              0x29
 #define USB_DESC_TYPE_HUB_SUPER_SPEED  0x2a
@@ -213,6 +224,7 @@ struct _USB_XHCI_INSTANCE {
   USBHC_MEM_POOL            *MemPool;
 
   EFI_USB2_HC_PROTOCOL      Usb2Hc;
+  EDKII_USB2_HC_ASYNC_BULK_PROTOCOL  Usb2HcAsyncBulk;
 
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
 
@@ -223,6 +235,12 @@ struct _USB_XHCI_INSTANCE {
   EFI_EVENT                 ExitBootServiceEvent;
   EFI_EVENT                 PollTimer;
   LIST_ENTRY                AsyncIntTransfers;
+  //
+  // The asynchronous bulk URBs are queued on the transfer rings of their
+  // endpoints. AsyncBulkTimer runs while AsyncBulkCount isn't zero.
+  //
+  EFI_EVENT                 AsyncBulkTimer;
+  UINTN                     AsyncBulkCount;
 
   UINT8                     CapLength;    ///< Capability Register Length
   XHC_HCSPARAMS1            HcSParams1;   ///< Structural Parameters 1
@@ -729,4 +747,78 @@ XhcAsyncIsochronousTransfer (
   IN     VOID                                *Context
   );
 
+/**
+  Queue a bulk transfer to a bulk endpoint of a USB device and return without
+  waiting for it to complete.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  MaximumPacketLength   Maximum packet size the endpoint is capable of
+                                sending or receiving.
+  @param  Data                  The data buffer of the transfer.
+  @param  DataLength            The length of the data buffer.
+  @param  Translator            A pointr to the transaction translator data.
+  @param  CallBackFunction      The function to call when the transfer completes.
+  @param  Context               Context to CallBackFunction.
+
+  @retval EFI_SUCCESS           The transfer is queued.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The queue of the endpoint is full, or the request
+                                failed due to a lack of resources.
+  @retval EFI_DEVICE_ERROR      The request failed due to host controller error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAsyncBulkTransfer (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress,
+  IN UINT8                               DeviceSpeed,
+  IN UINTN                               MaximumPacketLength,
+  IN VOID                                *Data,
+  IN UINTN                               DataLength,
+  IN EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK     CallBackFunction,
+  IN VOID                                *Context OPTIONAL
+  );
+
+/**
+  Cancel all the asynchronous bulk transfers queued on an endpoint of a USB device.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS           The transfers of the endpoint are cancelled.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR      The endpoint could not be stopped.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcCancelAsyncBulkTransfer (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress
+  );
+
+/**
+  Complete the asynchronous bulk transfers the xHC has finished and call their
+  callbacks.
+
+  @param  This                  This EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+
+  @retval EFI_SUCCESS           The completed transfers are processed.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAsyncBulkPoll (
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This
+  );
+
 #endif
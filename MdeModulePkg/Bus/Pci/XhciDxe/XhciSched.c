@@ -175,7 +175,6 @@ XhcCreateUrb (
   Urb->Context  = Context;
 
   Status = XhcCreateTransferTrb (Xhc, Urb);
-  ASSERT_EFI_ERROR (Status);
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "XhcCreateUrb: XhcCreateTransferTrb Failed, Status = %r\n", Status));
     FreePool (Urb);
@@ -209,6 +208,42 @@ XhcFreeUrb (
   FreePool (Urb);
 }
 
+/**
+  Count the asynchronous bulk URBs queued on a transfer ring.
+
+  @param  Ring                  The transfer ring.
+  @param  TrbNum                Return the number of TRBs their TDs occupy.
+
+  @return The number of asynchronous bulk URBs queued on the ring.
+
+**/
+UINTN
+XhcAsyncBulkQueueDepth (
+  IN  TRANSFER_RING       *Ring,
+  OUT UINTN               *TrbNum OPTIONAL
+  )
+{
+  LIST_ENTRY              *Entry;
+  LIST_ENTRY              *Next;
+  URB                     *Urb;
+  UINTN                   Depth;
+
+  Depth = 0;
+  if (TrbNum != NULL) {
+    *TrbNum = 0;
+  }
+
+  EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Ring->AsyncBulkQueue) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    Depth++;
+    if (TrbNum != NULL) {
+      *TrbNum += Urb->TrbNum;
+    }
+  }
+
+  return Depth;
+}
+
 /**
   Create a transfer TRB.
 
@@ -237,6 +272,8 @@ XhcCreateTransferTrb (
   EFI_PHYSICAL_ADDRESS          PhyAddr;
   VOID                          *Map;
   EFI_STATUS                    Status;
+  LINK_TRB                      *LinkTrb;
+  UINTN                         QueuedTrbNum;
 
   SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
   if (SlotId == 0) {
@@ -374,15 +411,34 @@ XhcCreateTransferTrb (
 
     case ED_BULK_OUT:
     case ED_BULK_IN:
+      //
+      // Chain all the TRBs of a bulk transfer into one TD, so the controller
+      // streams the whole buffer and only interrupts on the last TRB, or on
+      // the TRB where a short packet ends the TD. The data buffer of a TRB
+      // must not cross a 64KB boundary. [xHCI1.1-4.11.7.1]
+      // The TD, together with the TDs of the asynchronous bulk transfers still
+      // queued on the ring, must leave at least one of the TRBs before the Link
+      // TRB free, otherwise the enqueue pointer would wrap onto a TRB the xHC
+      // has not consumed yet.
+      //
+      TrbNum = (((UINTN) Urb->DataPhy & 0xFFFF) + Urb->DataLen + 0xFFFF) >> 16;
+      XhcAsyncBulkQueueDepth (EPRing, &QueuedTrbNum);
+      if (TrbNum + QueuedTrbNum >= EPRing->TrbNumber - 1) {
+        DEBUG ((EFI_D_ERROR, "XhcCreateTransferTrb: 0x%x bytes need more TRBs than the transfer ring has free\n", Urb->DataLen));
+        Xhc->PciIo->Unmap (Xhc->PciIo, Urb->DataMap);
+        Urb->DataMap = NULL;
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      LinkTrb  = (LINK_TRB *) ((TRB_TEMPLATE *) EPRing->RingSeg0 + EPRing->TrbNumber - 1);
       TotalLen = 0;
       Len      = 0;
       TrbNum   = 0;
       TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
       while (TotalLen < Urb->DataLen) {
-        if ((TotalLen + 0x10000) >= Urb->DataLen) {
+        Len = 0x10000 - (((UINTN) Urb->DataPhy + TotalLen) & 0xFFFF);
+        if ((TotalLen + Len) >= Urb->DataLen) {
           Len = Urb->DataLen - TotalLen;
-        } else {
-          Len = 0x10000;
         }
         TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
         TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
@@ -391,8 +447,19 @@ XhcCreateTransferTrb (
         TrbStart->TrbNormal.TDSize    = 0;
         TrbStart->TrbNormal.IntTarget = 0;
         TrbStart->TrbNormal.ISP       = 1;
-        TrbStart->TrbNormal.IOC       = 1;
         TrbStart->TrbNormal.Type      = TRB_TYPE_NORMAL;
+        if ((TotalLen + Len) < Urb->DataLen) {
+          TrbStart->TrbNormal.CH      = 1;
+        } else {
+          TrbStart->TrbNormal.IOC     = 1;
+        }
+
+        //
+        // The Link TRB is part of the TD when the chain wraps around the ring.
+        //
+        if ((TRB_TEMPLATE *) (TrbStart + 1) == (TRB_TEMPLATE *) LinkTrb) {
+          LinkTrb->CH = TrbStart->TrbNormal.CH;
+        }
         //
         // Update the cycle bit
         //
@@ -623,6 +690,54 @@ XhcInitSched (
   DEBUG ((EFI_D_INFO, "XhcInitSched:XHC_EVENTRING=0x%x\n", Xhc->EventRing.EventRingSeg0));
 }
 
+/**
+  Move the dequeue pointer of a stopped endpoint to the enqueue pointer of its
+  transfer ring through XHCI's Set_TR_Dequeue_Pointer cmd, so the xHC skips all
+  the TDs left on the ring.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  SlotId                The slot id of the device.
+  @param  Dci                   The device context index of endpoint.
+  @param  Ring                  The transfer ring of the endpoint.
+
+  @retval EFI_SUCCESS           The dequeue pointer is set.
+  @retval Others                Failed to set the dequeue pointer.
+
+**/
+EFI_STATUS
+XhcSetTrDequeuePointer (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  UINT8               SlotId,
+  IN  UINT8               Dci,
+  IN  TRANSFER_RING       *Ring
+  )
+{
+  EFI_STATUS                  Status;
+  EVT_TRB_COMMAND_COMPLETION  *EvtTrb;
+  CMD_SET_TR_DEQ_POINTER      CmdSetTRDeq;
+  EFI_PHYSICAL_ADDRESS        PhyAddr;
+
+  ZeroMem (&CmdSetTRDeq, sizeof (CmdSetTRDeq));
+  PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Ring->RingEnqueue, sizeof (CMD_SET_TR_DEQ_POINTER));
+  CmdSetTRDeq.PtrLo    = XHC_LOW_32BIT (PhyAddr) | Ring->RingPCS;
+  CmdSetTRDeq.PtrHi    = XHC_HIGH_32BIT (PhyAddr);
+  CmdSetTRDeq.CycleBit = 1;
+  CmdSetTRDeq.Type     = TRB_TYPE_SET_TR_DEQUE;
+  CmdSetTRDeq.Endpoint = Dci;
+  CmdSetTRDeq.SlotId   = SlotId;
+  Status = XhcCmdTransfer (
+             Xhc,
+             (TRB_TEMPLATE *) (UINTN) &CmdSetTRDeq,
+             XHC_GENERIC_TIMEOUT,
+             (TRB_TEMPLATE **) (UINTN) &EvtTrb
+             );
+  if (EFI_ERROR(Status)) {
+    DEBUG ((EFI_D_ERROR, "XhcSetTrDequeuePointer: Set Dequeue Pointer Failed, Status = %r\n", Status));
+  }
+
+  return Status;
+}
+
 /**
   System software shall use a Reset Endpoint Command (section 4.11.4.7) to remove the Halted
   condition in the xHC. After the successful completion of the Reset Endpoint Command, the Endpoint
@@ -647,10 +762,8 @@ XhcRecoverHaltedEndpoint (
   EFI_STATUS                  Status;
   EVT_TRB_COMMAND_COMPLETION  *EvtTrb;
   CMD_TRB_RESET_ENDPOINT      CmdTrbResetED;
-  CMD_SET_TR_DEQ_POINTER      CmdSetTRDeq;
   UINT8                       Dci;
   UINT8                       SlotId;
-  EFI_PHYSICAL_ADDRESS        PhyAddr;
 
   Status = EFI_SUCCESS;
   SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
@@ -684,20 +797,7 @@ XhcRecoverHaltedEndpoint (
   //
   // 2)Set dequeue pointer
   //
-  ZeroMem (&CmdSetTRDeq, sizeof (CmdSetTRDeq));
-  PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Urb->Ring->RingEnqueue, sizeof (CMD_SET_TR_DEQ_POINTER));
-  CmdSetTRDeq.PtrLo    = XHC_LOW_32BIT (PhyAddr) | Urb->Ring->RingPCS;
-  CmdSetTRDeq.PtrHi    = XHC_HIGH_32BIT (PhyAddr);
-  CmdSetTRDeq.CycleBit = 1;
-  CmdSetTRDeq.Type     = TRB_TYPE_SET_TR_DEQUE;
-  CmdSetTRDeq.Endpoint = Dci;
-  CmdSetTRDeq.SlotId   = SlotId;
-  Status = XhcCmdTransfer (
-             Xhc,
-             (TRB_TEMPLATE *) (UINTN) &CmdSetTRDeq,
-             XHC_GENERIC_TIMEOUT,
-             (TRB_TEMPLATE **) (UINTN) &EvtTrb
-             );
+  Status = XhcSetTrDequeuePointer (Xhc, SlotId, Dci, Urb->Ring);
   if (EFI_ERROR(Status)) {
     DEBUG ((EFI_D_ERROR, "XhcRecoverHaltedEndpoint: Set Dequeue Pointer Failed, Status = %r\n", Status));
     goto Done;
@@ -712,6 +812,52 @@ Done:
   return Status;
 }
 
+/**
+  Make the xHC skip the TDs left on the transfer ring of an endpoint, which are
+  the TDs it has not completed yet. A running endpoint is stopped and a halted
+  one is reset, then the dequeue pointer is moved to the enqueue pointer of the
+  ring and the endpoint is restarted with nothing to do.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  Urb                   A URB on the transfer ring of the endpoint.
+
+  @retval EFI_SUCCESS           The TDs are skipped.
+  @retval Others                Failed to skip the TDs.
+
+**/
+EFI_STATUS
+XhcSkipQueuedTds (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 *Urb
+  )
+{
+  EFI_STATUS                  Status;
+  UINT8                       Dci;
+  UINT8                       SlotId;
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
+  if (SlotId == 0) {
+    return EFI_DEVICE_ERROR;
+  }
+  Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
+  ASSERT (Dci < 32);
+
+  Status = XhcStopEndpoint (Xhc, SlotId, Dci);
+  if (EFI_ERROR (Status)) {
+    //
+    // A halted endpoint can't be stopped, the recovery resets it instead.
+    //
+    return XhcRecoverHaltedEndpoint (Xhc, Urb);
+  }
+
+  Status = XhcSetTrDequeuePointer (Xhc, SlotId, Dci, Urb->Ring);
+  if (!EFI_ERROR (Status)) {
+    XhcRingDoorBell (Xhc, SlotId, Dci);
+  }
+
+  return Status;
+}
+
 /**
   Create XHCI event ring.
 
@@ -841,6 +987,7 @@ CreateTransferRing (
   TransferRing->RingEnqueue  = (TRB_TEMPLATE *) TransferRing->RingSeg0;
   TransferRing->RingDequeue  = (TRB_TEMPLATE *) TransferRing->RingSeg0;
   TransferRing->RingPCS      = 1;
+  InitializeListHead (&TransferRing->AsyncBulkQueue);
   //
   // 4.9.2 Transfer Ring Management
   // To form a ring (or circular queue) a Link TRB may be inserted at the end of a ring to
@@ -1017,12 +1164,95 @@ IsTransferRingTrb (
   return FALSE;
 }
 
+/**
+  Check if the Trb belongs to the TRBs created for the URB.
+
+  @param Trb    The TRB to be checked.
+  @param Urb    The URB to be checked.
+
+  @retval TRUE  The Trb is one of the TRBs of the URB.
+  @retval FALSE The Trb is not any TRB of the URB.
+
+**/
+BOOLEAN
+IsUrbTrb (
+  IN  TRB_TEMPLATE        *Trb,
+  IN  URB                 *Urb
+  )
+{
+  TRB_TEMPLATE  *CheckedTrb;
+  UINTN         Index;
+
+  CheckedTrb = Urb->TrbStart;
+  for (Index = 0; Index < Urb->TrbNum; Index++) {
+    if (Trb == CheckedTrb) {
+      return TRUE;
+    }
+    CheckedTrb++;
+    if ((UINT8) CheckedTrb->Type == TRB_TYPE_LINK) {
+      CheckedTrb = (TRB_TEMPLATE *) Urb->Ring->RingSeg0;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Check if the Trb is a transaction of the asynchronous bulk URBs queued on the
+  endpoint the transfer event is reported for.
+
+  @param Xhc    The XHCI Instance.
+  @param EvtTrb The transfer event.
+  @param Trb    The TRB the event is reported for.
+  @param Urb    The pointer to the matched Urb.
+
+  @retval TRUE  The Trb is matched with an asynchronous bulk URB.
+  @retval FALSE The Trb is not matched with any asynchronous bulk URB.
+
+**/
+BOOLEAN
+IsAsyncBulkTrb (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  EVT_TRB_TRANSFER    *EvtTrb,
+  IN  TRB_TEMPLATE        *Trb,
+  OUT URB                 **Urb
+  )
+{
+  LIST_ENTRY              *Entry;
+  LIST_ENTRY              *Next;
+  TRANSFER_RING           *Ring;
+  URB                     *CheckedUrb;
+
+  if ((EvtTrb->Type != TRB_TYPE_TRANS_EVENT) || (EvtTrb->SlotId == 0) || (EvtTrb->EndpointId == 0) ||
+      !Xhc->UsbDevContext[EvtTrb->SlotId].Enabled) {
+    return FALSE;
+  }
+
+  Ring = (TRANSFER_RING *)(UINTN) Xhc->UsbDevContext[EvtTrb->SlotId].EndpointTransferRing[EvtTrb->EndpointId - 1];
+  if (Ring == NULL) {
+    return FALSE;
+  }
+
+  EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Ring->AsyncBulkQueue) {
+    CheckedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (IsUrbTrb (Trb, CheckedUrb)) {
+      *Urb = CheckedUrb;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 /**
   Check the URB's execution result and update the URB's
   result accordingly.
 
+  The events of the asynchronous transfers are handled on the way, so
+  Urb may be NULL to only handle those.
+
   @param  Xhc             The XHCI Instance.
-  @param  Urb             The URB to check result.
+  @param  Urb             The URB to check result, or NULL.
 
   @return Whether the result of URB transfer is finialized.
 
@@ -1044,20 +1274,23 @@ XhcCheckUrbResult (
   UINT32                  High;
   UINT32                  Low;
   EFI_PHYSICAL_ADDRESS    PhyAddr;
+  UINT64                  TrbData;
 
-  ASSERT ((Xhc != NULL) && (Urb != NULL));
+  ASSERT (Xhc != NULL);
 
   Status   = EFI_SUCCESS;
   AsyncUrb = NULL;
 
-  if (Urb->Finished) {
+  if ((Urb != NULL) && Urb->Finished) {
     goto EXIT;
   }
 
   EvtTrb = NULL;
 
   if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
-    Urb->Result |= EFI_USB_ERR_SYSTEM;
+    if (Urb != NULL) {
+      Urb->Result |= EFI_USB_ERR_SYSTEM;
+    }
     Status       = EFI_DEVICE_ERROR;
     goto EXIT;
   }
@@ -1093,14 +1326,28 @@ XhcCheckUrbResult (
     // the urb is current checked one or in the XHCI's async transfer list.
     // This way is used to avoid that those completed async transfer events don't get
     // handled in time and are flushed by newer coming events.
+    // The asynchronous bulk URBs are checked first as they share the transfer
+    // ring with the synchronous bulk URBs of the endpoint.
     //
-    if (IsTransferRingTrb (TRBPtr, Urb)) {
+    if (IsAsyncBulkTrb (Xhc, EvtTrb, TRBPtr, &AsyncUrb)) {
+      CheckedUrb = AsyncUrb;
+    } else if ((Urb != NULL) && IsTransferRingTrb (TRBPtr, Urb)) {
       CheckedUrb = Urb;
     } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {    
       CheckedUrb = AsyncUrb;
     } else {
       continue;
     }
+
+    //
+    // A short packet in a chained bulk TD may be reported twice, once for the
+    // short TRB and once for the last TRB of the TD. Skip the events which
+    // come after the URB is finished or belong to the TD of a previous URB.
+    //
+    if (CheckedUrb->Finished ||
+        ((CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) && !IsUrbTrb (TRBPtr, CheckedUrb))) {
+      continue;
+    }
   
     switch (EvtTrb->Completecode) {
       case TRB_COMPLETION_STALL_ERROR:
@@ -1133,11 +1380,27 @@ XhcCheckUrbResult (
           DEBUG ((EFI_D_ERROR, "XhcCheckUrbResult: short packet happens!\n"));
         }
 
+        //
+        // The TRB's offset in the data buffer plus the bytes it moved gives
+        // the bytes transferred so far. Lenth is the residual of the TRB.
+        //
         TRBType = (UINT8) (TRBPtr->Type);
         if ((TRBType == TRB_TYPE_DATA_STAGE) ||
             (TRBType == TRB_TYPE_NORMAL) ||
             (TRBType == TRB_TYPE_ISOCH)) {
-          CheckedUrb->Completed += (CheckedUrb->DataLen - EvtTrb->Lenth);
+          TrbData = TRBPtr->Parameter1 | LShiftU64 ((UINT64) TRBPtr->Parameter2, 32);
+          CheckedUrb->Completed = (UINTN) (TrbData - (UINTN) CheckedUrb->DataPhy) +
+                                  ((TRB *) TRBPtr)->TrbNormal.Lenth - EvtTrb->Lenth;
+        }
+
+        //
+        // A short packet ends a chained bulk TD at the short TRB.
+        //
+        if ((EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) &&
+            (CheckedUrb->Ep.Type == XHC_BULK_TRANSFER)) {
+          CheckedUrb->Finished = TRUE;
+          CheckedUrb->EvtTrb   = (TRB_TEMPLATE *)EvtTrb;
+          continue;
         }
 
         break;
@@ -1160,7 +1423,10 @@ XhcCheckUrbResult (
       CheckedUrb->EndDone = TRUE;
     }
 
-    if (CheckedUrb->StartDone && CheckedUrb->EndDone) {
+    //
+    // Only the last TRB of a chained bulk TD interrupts on completion.
+    //
+    if ((CheckedUrb->StartDone || (CheckedUrb->Ep.Type == XHC_BULK_TRANSFER)) && CheckedUrb->EndDone) {
       CheckedUrb->Finished = TRUE;
       CheckedUrb->EvtTrb   = (TRB_TEMPLATE *)EvtTrb;
     }
@@ -1322,6 +1588,85 @@ XhciDelAllAsyncIntTransfers (
   }
 }
 
+/**
+  Free the asynchronous bulk URBs queued on a transfer ring which is going to be
+  freed. Their callbacks are not called.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  Ring                  The transfer ring.
+
+**/
+VOID
+XhciDelAsyncBulkTransfers (
+  IN USB_XHCI_INSTANCE    *Xhc,
+  IN TRANSFER_RING        *Ring
+  )
+{
+  LIST_ENTRY              *Entry;
+  LIST_ENTRY              *Next;
+  URB                     *Urb;
+
+  EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Ring->AsyncBulkQueue) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    RemoveEntryList (&Urb->UrbList);
+    XhcFreeUrb (Xhc, Urb);
+    Xhc->AsyncBulkCount--;
+  }
+
+  if (Xhc->AsyncBulkCount == 0) {
+    gBS->SetTimer (Xhc->AsyncBulkTimer, TimerCancel, 0);
+  }
+}
+
+/**
+  Cancel the asynchronous bulk transfers queued on the device endpoint. The xHC
+  is made to skip their TDs, then the URBs are freed without calling back.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpNum                 The endpoint of the target.
+
+  @retval EFI_SUCCESS           The asynchronous bulk transfers are cancelled.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR      The xHC could not be made to skip the TDs.
+
+**/
+EFI_STATUS
+XhciDelAsyncBulkTransfer (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  UINT8               BusAddr,
+  IN  UINT8               EpNum
+  )
+{
+  TRANSFER_RING           *Ring;
+  URB                     *Urb;
+  UINT8                   SlotId;
+  UINT8                   Dci;
+  EFI_STATUS              Status;
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, BusAddr);
+  if (SlotId == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  Dci  = XhcEndpointToDci ((UINT8) (EpNum & 0x0F), (UINT8) (((EpNum & 0x80) != 0) ? EfiUsbDataIn : EfiUsbDataOut));
+  ASSERT (Dci < 32);
+  Ring = (TRANSFER_RING *)(UINTN) Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1];
+  if ((Ring == NULL) || IsListEmpty (&Ring->AsyncBulkQueue)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Urb    = EFI_LIST_CONTAINER (GetFirstNode (&Ring->AsyncBulkQueue), URB, UrbList);
+  Status = XhcSkipQueuedTds (Xhc, Urb);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "XhciDelAsyncBulkTransfer: failed to skip the queued TDs, Status = %r\n", Status));
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  XhciDelAsyncBulkTransfers (Xhc, Ring);
+  return Status;
+}
+
 /**
   Update the queue head for next round of asynchronous transfer
 
@@ -1509,6 +1854,130 @@ XhcMonitorAsyncRequests (
   gBS->RestoreTPL (OldTpl);
 }
 
+/**
+  Complete the asynchronous bulk URBs whose TDs the xHC has finished. The URBs
+  of an endpoint are completed in the order they were queued, and their callbacks
+  are called at the TPL of the caller of this function.
+
+  This function must be called at XHC_TPL.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  OldTpl                The TPL to call the callbacks at.
+
+**/
+VOID
+XhcProcessAsyncBulkTransfers (
+  IN USB_XHCI_INSTANCE    *Xhc,
+  IN EFI_TPL              OldTpl
+  )
+{
+  LIST_ENTRY                      *Entry;
+  LIST_ENTRY                      *Next;
+  TRANSFER_RING                   *Ring;
+  URB                             *Urb;
+  URB                             *QueuedUrb;
+  VOID                            *Data;
+  UINTN                           Completed;
+  UINT32                          Result;
+  EFI_ASYNC_USB_TRANSFER_CALLBACK Callback;
+  VOID                            *Context;
+  UINTN                           SlotId;
+  UINTN                           Dci;
+
+  if (Xhc->AsyncBulkCount == 0) {
+    return;
+  }
+
+  //
+  // Update the URBs with all the transfer events the xHC has posted.
+  //
+  XhcCheckUrbResult (Xhc, NULL);
+  Xhc->PciIo->Flush (Xhc->PciIo);
+
+  for (SlotId = 1; (SlotId < 256) && (Xhc->AsyncBulkCount != 0); SlotId++) {
+    for (Dci = 1; Dci < 32; Dci++) {
+      //
+      // Complete the finished URBs at the head of the queue. Look the ring up
+      // again after each callback, the callback may have removed the device.
+      //
+      while (Xhc->UsbDevContext[SlotId].Enabled) {
+        Ring = (TRANSFER_RING *)(UINTN) Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1];
+        if ((Ring == NULL) || IsListEmpty (&Ring->AsyncBulkQueue)) {
+          break;
+        }
+
+        Urb = EFI_LIST_CONTAINER (GetFirstNode (&Ring->AsyncBulkQueue), URB, UrbList);
+        if (!Urb->Finished) {
+          break;
+        }
+
+        if ((Urb->Result != EFI_USB_NOERROR) && (Urb->Result != EFI_USB_ERR_NOTEXECUTE)) {
+          //
+          // The failed TD may have halted the endpoint. Make the xHC skip the
+          // TDs behind it, and complete their URBs as not executed. Clearing
+          // the halt of the device endpoint is left to the device driver.
+          //
+          if (EFI_ERROR (XhcSkipQueuedTds (Xhc, Urb))) {
+            DEBUG ((EFI_D_ERROR, "XhcProcessAsyncBulkTransfers: failed to skip the queued TDs\n"));
+          }
+
+          EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Ring->AsyncBulkQueue) {
+            QueuedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+            if (QueuedUrb != Urb) {
+              QueuedUrb->Result   = EFI_USB_ERR_NOTEXECUTE;
+              QueuedUrb->Finished = TRUE;
+            }
+          }
+        }
+
+        RemoveEntryList (&Urb->UrbList);
+        Xhc->AsyncBulkCount--;
+
+        Data      = Urb->Data;
+        Completed = Urb->Completed;
+        Result    = Urb->Result;
+        Callback  = Urb->Callback;
+        Context   = Urb->Context;
+
+        //
+        // Unmap the data buffer before the callback looks at the data.
+        //
+        XhcFreeUrb (Xhc, Urb);
+
+        gBS->RestoreTPL (OldTpl);
+        Callback (Data, Completed, Context, Result);
+        gBS->RaiseTPL (XHC_TPL);
+      }
+    }
+  }
+
+  if (Xhc->AsyncBulkCount == 0) {
+    gBS->SetTimer (Xhc->AsyncBulkTimer, TimerCancel, 0);
+  }
+}
+
+/**
+  Asynchronous bulk transfer periodic check handler. The timer only runs
+  while asynchronous bulk transfers are queued.
+
+  @param  Event                 Asynchronous bulk transfer event.
+  @param  Context               Pointer to USB_XHCI_INSTANCE.
+
+**/
+VOID
+EFIAPI
+XhcMonitorAsyncBulkTransfers (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  EFI_TPL                 OldTpl;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+  XhcProcessAsyncBulkTransfers ((USB_XHCI_INSTANCE *) Context, OldTpl);
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   Monitor the port status change. Enable/Disable device slot if there is a device attached/detached.
 
@@ -2372,6 +2841,7 @@ XhcDisableSlotCmd (
   //
   for (Index = 0; Index < 31; Index++) {
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
+      XhciDelAsyncBulkTransfers (Xhc, (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
         UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
@@ -2479,6 +2949,7 @@ XhcDisableSlotCmd64 (
   //
   for (Index = 0; Index < 31; Index++) {
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
+      XhciDelAsyncBulkTransfers (Xhc, (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
         UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
@@ -3166,6 +3637,7 @@ XhcSetInterface (
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
+        XhciDelAsyncBulkTransfers (Xhc, (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
           UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
@@ -3363,6 +3835,7 @@ XhcSetInterface64 (
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
+        XhciDelAsyncBulkTransfers (Xhc, (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
           UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
@@ -147,6 +147,10 @@ typedef struct _TRANSFER_RING {
   TRB_TEMPLATE              *RingEnqueue;
   TRB_TEMPLATE              *RingDequeue;
   UINT32                    RingPCS;
+  //
+  // The asynchronous bulk URBs whose TDs are on the ring, in ring order.
+  //
+  LIST_ENTRY                AsyncBulkQueue;
 } TRANSFER_RING;
 
 typedef struct _EVENT_RING {
@@ -850,6 +854,72 @@ XhciDelAllAsyncIntTransfers (
   IN USB_XHCI_INSTANCE    *Xhc
   );
 
+/**
+  Cancel the asynchronous bulk transfers queued on the device endpoint. The xHC
+  is made to skip their TDs, then the URBs are freed without calling back.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpNum                 The endpoint of the target.
+
+  @retval EFI_SUCCESS           The asynchronous bulk transfers are cancelled.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR      The xHC could not be made to skip the TDs.
+
+**/
+EFI_STATUS
+XhciDelAsyncBulkTransfer (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  UINT8               BusAddr,
+  IN  UINT8               EpNum
+  );
+
+/**
+  Free the asynchronous bulk URBs queued on a transfer ring which is going to be
+  freed. Their callbacks are not called.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  Ring                  The transfer ring.
+
+**/
+VOID
+XhciDelAsyncBulkTransfers (
+  IN USB_XHCI_INSTANCE    *Xhc,
+  IN TRANSFER_RING        *Ring
+  );
+
+/**
+  Count the asynchronous bulk URBs queued on a transfer ring.
+
+  @param  Ring                  The transfer ring.
+  @param  TrbNum                Return the number of TRBs their TDs occupy.
+
+  @return The number of asynchronous bulk URBs queued on the ring.
+
+**/
+UINTN
+XhcAsyncBulkQueueDepth (
+  IN  TRANSFER_RING       *Ring,
+  OUT UINTN               *TrbNum OPTIONAL
+  );
+
+/**
+  Complete the asynchronous bulk URBs whose TDs the xHC has finished. The URBs
+  of an endpoint are completed in the order they were queued, and their callbacks
+  are called at the TPL of the caller of this function.
+
+  This function must be called at XHC_TPL.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  OldTpl                The TPL to call the callbacks at.
+
+**/
+VOID
+XhcProcessAsyncBulkTransfers (
+  IN USB_XHCI_INSTANCE    *Xhc,
+  IN EFI_TPL              OldTpl
+  );
+
 /**
   Set Bios Ownership
 
@@ -935,6 +1005,21 @@ XhcMonitorAsyncRequests (
   IN VOID                 *Context
   );
 
+/**
+  Asynchronous bulk transfer periodic check handler. The timer only runs
+  while asynchronous bulk transfers are queued.
+
+  @param  Event                 Asynchronous bulk transfer event.
+  @param  Context               Pointer to USB_XHCI_INSTANCE.
+
+**/
+VOID
+EFIAPI
+XhcMonitorAsyncBulkTransfers (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  );
+
 /**
   Monitor the port status change. Enable/Disable device slot if there is a device attached/detached.
 
@@ -1317,6 +1402,25 @@ XhcRecoverHaltedEndpoint (
   IN  URB                 *Urb
   );
 
+/**
+  Stop endpoint through XHCI's Stop_Endpoint cmd.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  SlotId                The slot id to be configured.
+  @param  Dci                   The device context index of endpoint.
+
+  @retval EFI_SUCCESS           Stop endpoint successfully.
+  @retval Others                Failed to stop endpoint.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcStopEndpoint (
+  IN USB_XHCI_INSTANCE      *Xhc,
+  IN UINT8                  SlotId,
+  IN UINT8                  Dci
+  );
+
 /**
   Create a new URB for a new transaction.
 
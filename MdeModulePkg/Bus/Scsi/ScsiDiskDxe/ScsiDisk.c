@@ -238,6 +238,11 @@ ScsiDiskDriverBindingStart (
   ScsiDiskDevice->BlkIo.ReadBlocks  = ScsiDiskReadBlocks;
   ScsiDiskDevice->BlkIo.WriteBlocks = ScsiDiskWriteBlocks;
   ScsiDiskDevice->BlkIo.FlushBlocks = ScsiDiskFlushBlocks;
+  ScsiDiskDevice->BlkIo2.Media         = &ScsiDiskDevice->BlkIoMedia;
+  ScsiDiskDevice->BlkIo2.Reset         = ScsiDiskResetEx;
+  ScsiDiskDevice->BlkIo2.ReadBlocksEx  = ScsiDiskReadBlocksEx;
+  ScsiDiskDevice->BlkIo2.WriteBlocksEx = ScsiDiskWriteBlocksEx;
+  ScsiDiskDevice->BlkIo2.FlushBlocksEx = ScsiDiskFlushBlocksEx;
   ScsiDiskDevice->Handle            = Controller;
 
   ScsiIo->GetDeviceType (ScsiIo, &(ScsiDiskDevice->DeviceType));
@@ -307,6 +312,8 @@ ScsiDiskDriverBindingStart (
                       &Controller,
                       &gEfiBlockIoProtocolGuid,
                       &ScsiDiskDevice->BlkIo,
+                      &gEfiBlockIo2ProtocolGuid,
+                      &ScsiDiskDevice->BlkIo2,
                       &gEfiDiskInfoProtocolGuid,
                       &ScsiDiskDevice->DiskInfo,
                       NULL
@@ -394,6 +401,8 @@ ScsiDiskDriverBindingStop (
                   Controller,
                   &gEfiBlockIoProtocolGuid,
                   &ScsiDiskDevice->BlkIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &ScsiDiskDevice->BlkIo2,
                   &gEfiDiskInfoProtocolGuid,
                   &ScsiDiskDevice->DiskInfo,
                   NULL
@@ -521,6 +530,12 @@ ScsiDiskReadBlocks (
             &ScsiDiskDevice->BlkIo,
             &ScsiDiskDevice->BlkIo
             );
+      gBS->ReinstallProtocolInterface (
+            ScsiDiskDevice->Handle,
+            &gEfiBlockIo2ProtocolGuid,
+            &ScsiDiskDevice->BlkIo2,
+            &ScsiDiskDevice->BlkIo2
+            );
       Status = EFI_MEDIA_CHANGED;
       goto Done;
     }
@@ -639,6 +654,12 @@ ScsiDiskWriteBlocks (
             &ScsiDiskDevice->BlkIo,
             &ScsiDiskDevice->BlkIo
             );
+      gBS->ReinstallProtocolInterface (
+            ScsiDiskDevice->Handle,
+            &gEfiBlockIo2ProtocolGuid,
+            &ScsiDiskDevice->BlkIo2,
+            &ScsiDiskDevice->BlkIo2
+            );
       Status = EFI_MEDIA_CHANGED;
       goto Done;
     }
@@ -724,6 +745,156 @@ ScsiDiskFlushBlocks (
 }
 
 
+/**
+  Reset SCSI Disk.
+
+  @param  This                 The pointer of EFI_BLOCK_IO2_PROTOCOL
+  @param  ExtendedVerification The flag about if extend verificate
+
+  @retval EFI_SUCCESS          The device was reset.
+  @retval EFI_DEVICE_ERROR     The device is not functioning properly and could
+                               not be reset.
+  @return EFI_STATUS is returned from EFI_SCSI_IO_PROTOCOL.ResetDevice().
+
+**/
+EFI_STATUS
+EFIAPI
+ScsiDiskResetEx (
+  IN  EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN  BOOLEAN                 ExtendedVerification
+  )
+{
+  SCSI_DISK_DEV *ScsiDiskDevice;
+
+  ScsiDiskDevice = SCSI_DISK_DEV_FROM_BLKIO2 (This);
+
+  return ScsiDiskReset (&ScsiDiskDevice->BlkIo, ExtendedVerification);
+}
+
+/**
+  The function is to Read Block from SCSI Disk.
+
+  The SCSI I/O requests are issued in blocking mode, so a request with a valid
+  Token->Event is completed before this function returns and the event is
+  signaled at that point.
+
+  @param  This       The pointer of EFI_BLOCK_IO2_PROTOCOL.
+  @param  MediaId    The Id of Media detected
+  @param  Lba        The logic block address
+  @param  Token      A pointer to the token associated with the transaction.
+  @param  BufferSize The size of Buffer
+  @param  Buffer     The buffer to fill the read out data
+
+  @retval EFI_SUCCESS           Successfully to read out block.
+  @retval EFI_DEVICE_ERROR      Fail to detect media.
+  @retval EFI_NO_MEDIA          Media is not present.
+  @retval EFI_MEDIA_CHANGED     Media has changed.
+  @retval EFI_BAD_BUFFER_SIZE   The Buffer was not a multiple of the block size of the device.
+  @retval EFI_INVALID_PARAMETER Invalid parameter passed in.
+
+**/
+EFI_STATUS
+EFIAPI
+ScsiDiskReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+     OUT VOID                     *Buffer
+  )
+{
+  SCSI_DISK_DEV       *ScsiDiskDevice;
+  EFI_STATUS          Status;
+
+  ScsiDiskDevice = SCSI_DISK_DEV_FROM_BLKIO2 (This);
+
+  Status = ScsiDiskReadBlocks (&ScsiDiskDevice->BlkIo, MediaId, Lba, BufferSize, Buffer);
+
+  if ((Token != NULL) && (Token->Event != NULL) && !EFI_ERROR (Status)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+/**
+  The function is to Write Block to SCSI Disk.
+
+  The SCSI I/O requests are issued in blocking mode, so a request with a valid
+  Token->Event is completed before this function returns and the event is
+  signaled at that point.
+
+  @param  This       The pointer of EFI_BLOCK_IO2_PROTOCOL
+  @param  MediaId    The Id of Media detected
+  @param  Lba        The logic block address
+  @param  Token      A pointer to the token associated with the transaction.
+  @param  BufferSize The size of Buffer
+  @param  Buffer     The buffer to fill the read out data
+
+  @retval EFI_SUCCESS           Successfully to write the blocks.
+  @retval EFI_WRITE_PROTECTED   The device can not be written to.
+  @retval EFI_DEVICE_ERROR      Fail to detect media.
+  @retval EFI_NO_MEDIA          Media is not present.
+  @retval EFI_MEDIA_CHNAGED     Media has changed.
+  @retval EFI_BAD_BUFFER_SIZE   The Buffer was not a multiple of the block size of the device.
+  @retval EFI_INVALID_PARAMETER Invalid parameter passed in.
+
+**/
+EFI_STATUS
+EFIAPI
+ScsiDiskWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+  IN     VOID                     *Buffer
+  )
+{
+  SCSI_DISK_DEV       *ScsiDiskDevice;
+  EFI_STATUS          Status;
+
+  ScsiDiskDevice = SCSI_DISK_DEV_FROM_BLKIO2 (This);
+
+  Status = ScsiDiskWriteBlocks (&ScsiDiskDevice->BlkIo, MediaId, Lba, BufferSize, Buffer);
+
+  if ((Token != NULL) && (Token->Event != NULL) && !EFI_ERROR (Status)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+/**
+  Flush Block to Disk.
+
+  EFI_SUCCESS is returned directly, the event in Token is signaled if any.
+
+  @param  This              The pointer of EFI_BLOCK_IO2_PROTOCOL
+  @param  Token             A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS       All outstanding data was written to the device
+
+**/
+EFI_STATUS
+EFIAPI
+ScsiDiskFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token
+  )
+{
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Detect Device and read out capacity ,if error occurs, parse the sense key.
 
@@ -1034,6 +1205,11 @@ ScsiDiskInquiryDevice (
             ScsiDiskDevice->BlkIo.Media->OptimalTransferLengthGranularity = 
               (BlockLimits->OptimalTransferLengthGranularity2 << 8) |
                BlockLimits->OptimalTransferLengthGranularity1;
+            ScsiDiskDevice->MaxTransferBlocks =
+              ((UINT32) BlockLimits->MaximumTransferLength4 << 24) |
+              ((UINT32) BlockLimits->MaximumTransferLength3 << 16) |
+              ((UINT32) BlockLimits->MaximumTransferLength2 << 8)  |
+               (UINT32) BlockLimits->MaximumTransferLength1;
           }
 
           FreeAlignedBuffer (BlockLimits, sizeof (EFI_SCSI_BLOCK_LIMITS_VPD_PAGE));
@@ -1811,6 +1987,17 @@ ScsiDiskReadSectors (
     MaxBlock         = 0xFFFFFFFF;
   }
 
+  //
+  // Honor the maximum transfer length reported by the device, and keep the
+  // byte count of one command within the 32-bit DataLength of the SCSI packet.
+  //
+  if ((ScsiDiskDevice->MaxTransferBlocks != 0) && (ScsiDiskDevice->MaxTransferBlocks < MaxBlock)) {
+    MaxBlock         = ScsiDiskDevice->MaxTransferBlocks;
+  }
+  if (MaxBlock > MAX_UINT32 / BlockSize) {
+    MaxBlock         = MAX_UINT32 / BlockSize;
+  }
+
   PtrBuffer = Buffer;
 
   while (BlocksRemaining > 0) {
@@ -1956,6 +2143,17 @@ ScsiDiskWriteSectors (
     MaxBlock         = 0xFFFFFFFF;
   }
 
+  //
+  // Honor the maximum transfer length reported by the device, and keep the
+  // byte count of one command within the 32-bit DataLength of the SCSI packet.
+  //
+  if ((ScsiDiskDevice->MaxTransferBlocks != 0) && (ScsiDiskDevice->MaxTransferBlocks < MaxBlock)) {
+    MaxBlock         = ScsiDiskDevice->MaxTransferBlocks;
+  }
+  if (MaxBlock > MAX_UINT32 / BlockSize) {
+    MaxBlock         = MAX_UINT32 / BlockSize;
+  }
+
   PtrBuffer = Buffer;
 
   while (BlocksRemaining > 0) {
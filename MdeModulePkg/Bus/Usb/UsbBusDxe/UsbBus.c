@@ -31,6 +31,13 @@ EFI_USB_IO_PROTOCOL mUsbIoProtocol = {
   UsbIoPortReset
 };
 
+EDKII_USB_IO_ASYNC_BULK_PROTOCOL mUsbIoAsyncBulkProtocol = {
+  UsbIoAsyncBulkTransfer,
+  UsbIoCancelAsyncBulkTransfer,
+  UsbIoAsyncBulkPoll,
+  0
+};
+
 EFI_DRIVER_BINDING_PROTOCOL mUsbBusDriverBinding = {
   UsbBusControllerDriverSupported,
   UsbBusControllerDriverStart,
@@ -880,6 +887,157 @@ ON_EXIT:
 }
 
 
+/**
+  Queue a bulk transfer to the device endpoint without waiting for it
+  to complete. The transfer is queued on the host controller, which calls
+  CallBackFunction when the transfer completes.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+  @param  DeviceEndpoint         The device endpoint.
+  @param  Data                   The data to transfer.
+  @param  DataLength             The length of the data to transfer.
+  @param  CallBackFunction       The function to call when the transfer completes.
+  @param  Context                The context to the callback.
+
+  @retval EFI_SUCCESS            The bulk transfer is queued.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to queue the transfer.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAsyncBulkTransfer (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint,
+  IN VOID                              *Data,
+  IN UINTN                             DataLength,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK   CallBackFunction,
+  IN VOID                              *Context OPTIONAL
+  )
+{
+  USB_DEVICE              *Dev;
+  USB_INTERFACE           *UsbIf;
+  USB_ENDPOINT_DESC       *EpDesc;
+  EFI_TPL                 OldTpl;
+  EFI_STATUS              Status;
+
+  if ((USB_ENDPOINT_ADDR (DeviceEndpoint) == 0) || (USB_ENDPOINT_ADDR (DeviceEndpoint) > 15) ||
+      (CallBackFunction == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl  = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf   = USB_INTERFACE_FROM_USBIO_ASYNC_BULK (This);
+  Dev     = UsbIf->Device;
+
+  EpDesc  = UsbGetEndpointDesc (UsbIf, DeviceEndpoint);
+
+  if ((EpDesc == NULL) || (USB_ENDPOINT_TYPE (&EpDesc->Desc) != USB_ENDPOINT_BULK)) {
+    Status = EFI_INVALID_PARAMETER;
+    goto ON_EXIT;
+  }
+
+  ASSERT (Dev->Bus->Usb2HcAsyncBulk != NULL);
+  Status = Dev->Bus->Usb2HcAsyncBulk->AsyncBulkTransfer (
+                                        Dev->Bus->Usb2HcAsyncBulk,
+                                        Dev->Address,
+                                        DeviceEndpoint,
+                                        Dev->Speed,
+                                        EpDesc->Desc.MaxPacketSize,
+                                        Data,
+                                        DataLength,
+                                        &Dev->Translator,
+                                        CallBackFunction,
+                                        Context
+                                        );
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+
+/**
+  Cancel the bulk transfers queued on the device endpoint.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+  @param  DeviceEndpoint         The device endpoint.
+
+  @retval EFI_SUCCESS            The bulk transfers are cancelled.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to cancel the transfers.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoCancelAsyncBulkTransfer (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint
+  )
+{
+  USB_DEVICE              *Dev;
+  USB_INTERFACE           *UsbIf;
+  USB_ENDPOINT_DESC       *EpDesc;
+  EFI_TPL                 OldTpl;
+  EFI_STATUS              Status;
+
+  if ((USB_ENDPOINT_ADDR (DeviceEndpoint) == 0) || (USB_ENDPOINT_ADDR (DeviceEndpoint) > 15)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl  = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf   = USB_INTERFACE_FROM_USBIO_ASYNC_BULK (This);
+  Dev     = UsbIf->Device;
+
+  EpDesc  = UsbGetEndpointDesc (UsbIf, DeviceEndpoint);
+
+  if ((EpDesc == NULL) || (USB_ENDPOINT_TYPE (&EpDesc->Desc) != USB_ENDPOINT_BULK)) {
+    Status = EFI_INVALID_PARAMETER;
+    goto ON_EXIT;
+  }
+
+  ASSERT (Dev->Bus->Usb2HcAsyncBulk != NULL);
+  Status = Dev->Bus->Usb2HcAsyncBulk->CancelAsyncBulkTransfer (
+                                        Dev->Bus->Usb2HcAsyncBulk,
+                                        Dev->Address,
+                                        DeviceEndpoint
+                                        );
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+
+/**
+  Let the host controller complete the bulk transfers it has finished.
+  The TPL is not raised because the callbacks of the completed transfers
+  are invoked at the TPL of the caller.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+
+  @retval EFI_SUCCESS            The finished transfers are completed.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAsyncBulkPoll (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This
+  )
+{
+  USB_INTERFACE           *UsbIf;
+  EDKII_USB2_HC_ASYNC_BULK_PROTOCOL  *Usb2HcAsyncBulk;
+
+  UsbIf           = USB_INTERFACE_FROM_USBIO_ASYNC_BULK (This);
+  Usb2HcAsyncBulk = UsbIf->Device->Bus->Usb2HcAsyncBulk;
+
+  ASSERT (Usb2HcAsyncBulk != NULL);
+  return Usb2HcAsyncBulk->Poll (Usb2HcAsyncBulk);
+}
+
+
 /**
   Install Usb Bus Protocol on host controller, and start the Usb bus.
 
@@ -974,6 +1132,22 @@ UsbBusBuildProtocol (
     if (UsbBus->Usb2Hc->MajorRevision == 0x3) {
       UsbBus->MaxDevices = 256;
     }
+
+    //
+    // The asynchronous bulk protocol is optional. It is only used through
+    // USB2_HC, so it needs not be opened BY_DRIVER.
+    //
+    Status = gBS->OpenProtocol (
+                    Controller,
+                    &gEdkiiUsb2HcAsyncBulkProtocolGuid,
+                    (VOID **) &UsbBus->Usb2HcAsyncBulk,
+                    This->DriverBindingHandle,
+                    Controller,
+                    EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                    );
+    if (EFI_ERROR (Status)) {
+      UsbBus->Usb2HcAsyncBulk = NULL;
+    }
   }
 
   UsbHcReset (UsbBus, EFI_USB_HC_RESET_GLOBAL);
@@ -22,6 +22,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/Usb2HostController.h>
 #include <Protocol/UsbHostController.h>
 #include <Protocol/UsbIo.h>
+#include <Protocol/Usb2HcAsyncBulk.h>
+#include <Protocol/UsbIoAsyncBulk.h>
 #include <Protocol/DevicePath.h>
 
 #include <Library/BaseLib.h>
@@ -100,9 +102,11 @@ typedef struct _USB_HUB_API    USB_HUB_API;
 // root hub]
 //
 // According to USB2.0, Chapter 11.5.1.5 Resetting,
-// the worst case for TDRST is 20ms
+// the worst case for TDRST is 20ms. The hub times the
+// reset itself and reports its end by C_PORT_RESET, so
+// only the minimum 10ms is stalled before polling it.
 //
-#define USB_SET_PORT_RESET_STALL       (20 * USB_BUS_1_MILLISECOND)
+#define USB_SET_PORT_RESET_STALL       (10 * USB_BUS_1_MILLISECOND)
 #define USB_SET_ROOT_PORT_RESET_STALL  (50 * USB_BUS_1_MILLISECOND)
 
 //
@@ -150,6 +154,9 @@ typedef struct _USB_HUB_API    USB_HUB_API;
 #define USB_INTERFACE_FROM_USBIO(a) \
           CR(a, USB_INTERFACE, UsbIo, USB_INTERFACE_SIGNATURE)
 
+#define USB_INTERFACE_FROM_USBIO_ASYNC_BULK(a) \
+          CR(a, USB_INTERFACE, UsbIoAsyncBulk, USB_INTERFACE_SIGNATURE)
+
 #define USB_BUS_FROM_THIS(a) \
           CR(a, USB_BUS, BusId, USB_BUS_SIGNATURE)
 
@@ -215,6 +222,7 @@ struct _USB_INTERFACE {
   //
   EFI_HANDLE                Handle;
   EFI_USB_IO_PROTOCOL       UsbIo;
+  EDKII_USB_IO_ASYNC_BULK_PROTOCOL  UsbIoAsyncBulk;
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
   BOOLEAN                   IsManaged;
 
@@ -254,6 +262,11 @@ struct _USB_BUS {
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
   EFI_USB2_HC_PROTOCOL      *Usb2Hc;
   EFI_USB_HC_PROTOCOL       *UsbHc;
+  //
+  // The optional asynchronous bulk protocol of the host controller. The
+  // interfaces get the USB IO asynchronous bulk protocol if it is present.
+  //
+  EDKII_USB2_HC_ASYNC_BULK_PROTOCOL  *Usb2HcAsyncBulk;
 
   //
   // Recorded the max supported usb devices.
@@ -663,6 +676,65 @@ UsbIoPortReset (
   IN EFI_USB_IO_PROTOCOL  *This
   );
 
+/**
+  Queue a bulk transfer to the device endpoint without waiting for it
+  to complete.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+  @param  DeviceEndpoint         The device endpoint.
+  @param  Data                   The data to transfer.
+  @param  DataLength             The length of the data to transfer.
+  @param  CallBackFunction       The function to call when the transfer completes.
+  @param  Context                The context to the callback.
+
+  @retval EFI_SUCCESS            The bulk transfer is queued.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to queue the transfer.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAsyncBulkTransfer (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint,
+  IN VOID                              *Data,
+  IN UINTN                             DataLength,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK   CallBackFunction,
+  IN VOID                              *Context OPTIONAL
+  );
+
+/**
+  Cancel the bulk transfers queued on the device endpoint.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+  @param  DeviceEndpoint         The device endpoint.
+
+  @retval EFI_SUCCESS            The bulk transfers are cancelled.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to cancel the transfers.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoCancelAsyncBulkTransfer (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint
+  );
+
+/**
+  Let the host controller complete the bulk transfers it has finished.
+
+  @param  This                   The USB IO asynchronous bulk instance.
+
+  @retval EFI_SUCCESS            The finished transfers are completed.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAsyncBulkPoll (
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This
+  );
+
 /**
   Install Usb Bus Protocol on host controller, and start the Usb bus.
 
@@ -763,6 +835,7 @@ UsbBusControllerDriverStop (
   );
 
 extern EFI_USB_IO_PROTOCOL            mUsbIoProtocol;
+extern EDKII_USB_IO_ASYNC_BULK_PROTOCOL  mUsbIoAsyncBulkProtocol;
 extern EFI_DRIVER_BINDING_PROTOCOL    mUsbBusDriverBinding;
 extern EFI_COMPONENT_NAME_PROTOCOL    mUsbBusComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL   mUsbBusComponentName2;
@@ -61,6 +61,14 @@ UsbFreeInterface (
 {
   UsbCloseHostProtoByChild (UsbIf->Device->Bus, UsbIf->Handle);
 
+  if (UsbIf->UsbIoAsyncBulk.AsyncBulkTransfer != NULL) {
+    gBS->UninstallProtocolInterface (
+           UsbIf->Handle,
+           &gEdkiiUsbIoAsyncBulkProtocolGuid,
+           &UsbIf->UsbIoAsyncBulk
+           );
+  }
+
   gBS->UninstallMultipleProtocolInterfaces (
          UsbIf->Handle,
          &gEfiDevicePathProtocolGuid,
@@ -172,6 +180,31 @@ UsbCreateInterface (
     goto ON_ERROR;
   }
 
+  //
+  // Install the USB IO asynchronous bulk protocol if the host controller
+  // supports it. The interface works without it, so a failure is not fatal.
+  //
+  if (Device->Bus->Usb2HcAsyncBulk != NULL) {
+    CopyMem (
+      &(UsbIf->UsbIoAsyncBulk),
+      &mUsbIoAsyncBulkProtocol,
+      sizeof (EDKII_USB_IO_ASYNC_BULK_PROTOCOL)
+      );
+    UsbIf->UsbIoAsyncBulk.MaxQueueDepth = Device->Bus->Usb2HcAsyncBulk->MaxQueueDepth;
+
+    Status = gBS->InstallProtocolInterface (
+                    &UsbIf->Handle,
+                    &gEdkiiUsbIoAsyncBulkProtocolGuid,
+                    EFI_NATIVE_INTERFACE,
+                    &UsbIf->UsbIoAsyncBulk
+                    );
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "UsbCreateInterface: failed to install UsbIoAsyncBulk - %r\n", Status));
+      ZeroMem (&UsbIf->UsbIoAsyncBulk, sizeof (EDKII_USB_IO_ASYNC_BULK_PROTOCOL));
+    }
+  }
+
   return UsbIf;
 
 ON_ERROR:
@@ -639,6 +672,8 @@ UsbFindChild (
 
 /**
   Enumerate and configure the new device on the port of this HUB interface.
+  The caller must have waited USB_WAIT_PORT_STABLE_STALL after the connect
+  change so that the connection is debounced before the port is reset.
 
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
@@ -668,8 +703,6 @@ UsbEnumerateNewDev (
   HubApi  = HubIf->HubApi;  
   Address = Bus->MaxDevices;
 
-  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
-  
   //
   // Hub resets the device for at least 10 milliseconds.
   // Host learns device speed. If device is of low/full speed
@@ -857,20 +890,25 @@ ON_ERROR:
 
 
 /**
-  Process the events on the port.
+  Process the events on the port. The device previously attached to the port
+  is removed. If a new device is connected, the port change is left pending
+  and the caller enumerates the device with UsbEnumerateNewDev once the
+  connection is debounced, then clears the port change.
 
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
+  @param  NewDevice             Return TRUE if a new device is connected and
+                                waits to be enumerated.
 
-  @retval EFI_SUCCESS           The device is enumerated (added or removed).
-  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
-  @retval Others                Failed to enumerate the device.
+  @retval EFI_SUCCESS           The port events are processed.
+  @retval Others                Failed to process the port events.
 
 **/
 EFI_STATUS
 UsbEnumeratePort (
-  IN USB_INTERFACE        *HubIf,
-  IN UINT8                Port
+  IN  USB_INTERFACE       *HubIf,
+  IN  UINT8               Port,
+  OUT BOOLEAN             *NewDevice
   )
 {
   USB_HUB_API             *HubApi;
@@ -878,8 +916,9 @@ UsbEnumeratePort (
   EFI_USB_PORT_STATUS     PortState;
   EFI_STATUS              Status;
 
-  Child   = NULL;
-  HubApi  = HubIf->HubApi;
+  Child      = NULL;
+  HubApi     = HubIf->HubApi;
+  *NewDevice = FALSE;
 
   //
   // Host learns of the new device by polling the hub for port changes.
@@ -960,20 +999,90 @@ UsbEnumeratePort (
   
   if (USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_CONNECTION)) {
     //
-    // Now, new device connected, enumerate and configure the device 
+    // Now, new device connected. Leave the port change pending, the device
+    // is enumerated and configured after the connection is debounced.
     //
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: new device connected at port %d\n", Port));
-    Status = UsbEnumerateNewDev (HubIf, Port);
-  
-  } else {
-    DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
+    *NewDevice = TRUE;
+    return EFI_SUCCESS;
   }
-  
+
+  DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
   HubApi->ClearPortChange (HubIf, Port);
   return Status;
 }
 
 
+/**
+  Process the events on the ports of this HUB interface, then enumerate the
+  newly connected devices. All ports are scanned first so that the debounce
+  interval of the newly connected devices is waited for only once. The new
+  devices are then reset, addressed and configured one at a time in ascending
+  port order, because only one device may respond at the default address, and
+  to keep the assigned addresses deterministic.
+
+  @param  HubIf                 The HUB interface whose ports are enumerated.
+  @param  ChangeMap             The bitmap of the changed ports, in which bit 0
+                                of the first byte is the hub itself. If NULL,
+                                all the ports are processed.
+
+**/
+VOID
+UsbEnumeratePorts (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                *ChangeMap  OPTIONAL
+  )
+{
+  USB_HUB_API             *HubApi;
+  UINT8                   NewDevMap[32];
+  UINT8                   Byte;
+  UINT8                   Bit;
+  UINT8                   Index;
+  BOOLEAN                 NewDevice;
+  BOOLEAN                 Pending;
+  EFI_STATUS              Status;
+
+  HubApi  = HubIf->HubApi;
+  Pending = FALSE;
+  ZeroMem (NewDevMap, sizeof (NewDevMap));
+
+  //
+  // HUB starts its port index with 1.
+  //
+  Byte  = 0;
+  Bit   = 1;
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    if ((ChangeMap == NULL) || USB_BIT_IS_SET (ChangeMap[Byte], USB_BIT (Bit))) {
+      Status = UsbEnumeratePort (HubIf, Index, &NewDevice);
+
+      if (!EFI_ERROR (Status) && NewDevice) {
+        NewDevMap[Index / 8] |= (UINT8) USB_BIT (Index % 8);
+        Pending               = TRUE;
+      }
+    }
+
+    USB_NEXT_BIT (Byte, Bit);
+  }
+
+  if (!Pending) {
+    return ;
+  }
+
+  //
+  // Debounce all the new connections at once.
+  //
+  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    if (USB_BIT_IS_SET (NewDevMap[Index / 8], USB_BIT (Index % 8))) {
+      UsbEnumerateNewDev (HubIf, Index);
+      HubApi->ClearPortChange (HubIf, Index);
+    }
+  }
+}
+
+
 /**
   Enumerate all the changed hub ports.
 
@@ -989,8 +1098,6 @@ UsbHubEnumeration (
   )
 {
   USB_INTERFACE           *HubIf;
-  UINT8                   Byte;
-  UINT8                   Bit;
   UINT8                   Index;
   USB_DEVICE              *Child;
   
@@ -1010,19 +1117,7 @@ UsbHubEnumeration (
     return ;
   }
 
-  //
-  // HUB starts its port index with 1.
-  //
-  Byte  = 0;
-  Bit   = 1;
-
-  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
-    if (USB_BIT_IS_SET (HubIf->ChangeMap[Byte], USB_BIT (Bit))) {
-      UsbEnumeratePort (HubIf, Index);
-    }
-
-    USB_NEXT_BIT (Byte, Bit);
-  }
+  UsbEnumeratePorts (HubIf, HubIf->ChangeMap);
 
   UsbHubAckHubStatus (HubIf->Device);
 
@@ -1058,7 +1153,7 @@ UsbRootHubEnumeration (
       DEBUG (( EFI_D_INFO, "UsbEnumeratePort: The device disconnect fails at port %d from root hub %p, try again\n", Index, RootHub));
       UsbRemoveDevice (Child);
     }
-    
-    UsbEnumeratePort (RootHub, Index);
   }
+
+  UsbEnumeratePorts (RootHub, NULL);
 }
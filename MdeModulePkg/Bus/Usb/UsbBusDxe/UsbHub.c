@@ -984,14 +984,13 @@ UsbHubResetPort (
   }
 
   //
-  // Drive the reset signal for worst 20ms. Check USB 2.0 Spec
-  // section 7.1.7.5 for timing requirements.
+  // The hub drives the reset signal for 10ms to 20ms on its own. Check
+  // USB 2.0 Spec section 7.1.7.5 for timing requirements. Wait for the
+  // minimum reset time only, then check USB_PORT_STAT_C_RESET bit to see
+  // if the resetting state is done.
   //
   gBS->Stall (USB_SET_PORT_RESET_STALL);
 
-  //
-  // Check USB_PORT_STAT_C_RESET bit to see if the resetting state is done.
-  //
   ZeroMem (&PortState, sizeof (EFI_USB_PORT_STATUS));
 
   for (Index = 0; Index < USB_WAIT_PORT_STS_CHANGE_LOOP; Index++) {
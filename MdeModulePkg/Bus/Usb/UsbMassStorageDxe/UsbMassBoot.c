@@ -713,7 +713,7 @@ UsbBootDetectMedia (
 
 ON_ERROR:
   //
-  // Detect whether it is necessary to reinstall the Block I/O Protocol.
+  // Detect whether it is necessary to reinstall the Block I/O and Block I/O 2 Protocols.
   //
   // MediaId may change in RequestSense for MediaChanged
   // MediaPresent may change in RequestSense for NoMedia
@@ -739,6 +739,12 @@ ON_ERROR:
            &UsbMass->BlockIo,
            &UsbMass->BlockIo
            );
+    gBS->ReinstallProtocolInterface (
+           UsbMass->Controller,
+           &gEfiBlockIo2ProtocolGuid,
+           &UsbMass->BlockIo2,
+           &UsbMass->BlockIo2
+           );
 
     ASSERT (EfiGetCurrentTpl () == TPL_CALLBACK);
     gBS->RaiseTPL (OldTpl);
@@ -765,6 +771,40 @@ ON_ERROR:
 }
 
 
+/**
+  Get the number of blocks carried by the next READ or WRITE command.
+
+  @param  UsbMass                The USB mass storage device
+  @param  TotalBlock             The number of blocks left to transfer
+  @param  MaxBlock               The largest block count the command can hold
+
+  @return The number of blocks to carry.
+
+**/
+UINT32
+UsbBootGetCarryBlocks (
+  IN  USB_MASS_DEVICE       *UsbMass,
+  IN  UINTN                 TotalBlock,
+  IN  UINT32                MaxBlock
+  )
+{
+  UINT32                    Count;
+
+  Count = UsbMass->MaxCarrySize / UsbMass->BlockIoMedia.BlockSize;
+  if (Count == 0) {
+    Count = 1;
+  }
+  if (Count > MaxBlock) {
+    Count = MaxBlock;
+  }
+  if (TotalBlock < Count) {
+    Count = (UINT32) TotalBlock;
+  }
+
+  return Count;
+}
+
+
 /**
   Read some blocks from the device.
 
@@ -801,13 +841,13 @@ UsbBootReadBlocks (
     // on the device. We must split the total block because the READ10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) UsbBootGetCarryBlocks (UsbMass, TotalBlock, MAX_UINT16);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
-    // USB command's upper limit timeout is 5s. [USB2.0-9.2.6.1]
+    // USB command's upper limit timeout is 5s for every 64KB. [USB2.0-9.2.6.1]
     //
-    Timeout = (UINT32) USB_BOOT_GENERAL_CMD_TIMEOUT;
+    Timeout = (UINT32) USB_BOOT_IO_TIMEOUT (ByteSize);
 
     //
     // Fill in the command then execute
@@ -877,13 +917,13 @@ UsbBootWriteBlocks (
     // on the device. We must split the total block because the WRITE10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) UsbBootGetCarryBlocks (UsbMass, TotalBlock, MAX_UINT16);
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
-    // USB command's upper limit timeout is 5s. [USB2.0-9.2.6.1]
+    // USB command's upper limit timeout is 5s for every 64KB. [USB2.0-9.2.6.1]
     //
-    Timeout = (UINT32) USB_BOOT_GENERAL_CMD_TIMEOUT;
+    Timeout = (UINT32) USB_BOOT_IO_TIMEOUT (ByteSize);
 
     //
     // Fill in the write10 command block
@@ -939,7 +979,7 @@ UsbBootReadBlocks16 (
 {
   UINT8                     ReadCmd[16];
   EFI_STATUS                Status;
-  UINT16                    Count;
+  UINT32                    Count;
   UINT32                    BlockSize;
   UINT32                    ByteSize;
   UINT32                    Timeout;
@@ -951,13 +991,13 @@ UsbBootReadBlocks16 (
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
-    ByteSize  = (UINT32)Count * BlockSize;
+    Count     = UsbBootGetCarryBlocks (UsbMass, TotalBlock, MAX_UINT32);
+    ByteSize  = Count * BlockSize;
 
     //
-    // USB command's upper limit timeout is 5s. [USB2.0-9.2.6.1]
+    // USB command's upper limit timeout is 5s for every 64KB. [USB2.0-9.2.6.1]
     //
-    Timeout = (UINT32) USB_BOOT_GENERAL_CMD_TIMEOUT;
+    Timeout = (UINT32) USB_BOOT_IO_TIMEOUT (ByteSize);
 
     //
     // Fill in the command then execute
@@ -1013,7 +1053,7 @@ UsbBootWriteBlocks16 (
 {
   UINT8                 WriteCmd[16];
   EFI_STATUS            Status;
-  UINT16                Count;
+  UINT32                Count;
   UINT32                BlockSize;
   UINT32                ByteSize;
   UINT32                Timeout;
@@ -1025,13 +1065,13 @@ UsbBootWriteBlocks16 (
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
-    ByteSize  = (UINT32)Count * BlockSize;
+    Count     = UsbBootGetCarryBlocks (UsbMass, TotalBlock, MAX_UINT32);
+    ByteSize  = Count * BlockSize;
 
     //
-    // USB command's upper limit timeout is 5s. [USB2.0-9.2.6.1]
+    // USB command's upper limit timeout is 5s for every 64KB. [USB2.0-9.2.6.1]
     //
-    Timeout = (UINT32) USB_BOOT_GENERAL_CMD_TIMEOUT;
+    Timeout = (UINT32) USB_BOOT_IO_TIMEOUT (ByteSize);
 
     //
     // Fill in the write16 command block
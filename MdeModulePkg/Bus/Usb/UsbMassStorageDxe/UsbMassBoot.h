@@ -64,9 +64,14 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define USB_PDT_SIMPLE_DIRECT           0x0E       ///< Simplified direct access device
 
 //
-// Other parameters, Max carried size is 512B * 128 = 64KB
+// Max data size carried by one READ/WRITE command. Devices with a bulk
+// endpoint below the high speed packet size keep the 64KB used so far,
+// high speed and faster devices carry up to 1MB per command to save
+// the CBW/CSW round trips of Bulk-Only Transport.
 //
-#define USB_BOOT_IO_BLOCKS              128
+#define USB_BOOT_IO_CARRY_SIZE          SIZE_64KB
+#define USB_BOOT_MAX_CARRY_SIZE         SIZE_1MB
+#define USB_BOOT_HS_BULK_PACKET_SIZE    512
 
 //
 // Retry mass command times, set by experience
@@ -87,6 +92,13 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // 
 #define USB_BOOT_GENERAL_CMD_TIMEOUT    (5 * USB_MASS_1_SECOND)
 
+//
+// READ/WRITE commands are allowed the 5s limit for every 64KB they carry,
+// so a large transfer on slow media doesn't time out.
+//
+#define USB_BOOT_IO_TIMEOUT(ByteSize)   \
+        (USB_BOOT_GENERAL_CMD_TIMEOUT * (((ByteSize) + USB_BOOT_IO_CARRY_SIZE - 1) / USB_BOOT_IO_CARRY_SIZE))
+
 //
 // The required commands are INQUIRY, READ CAPACITY, TEST UNIT READY,
 // READ10, WRITE10, and REQUEST SENSE. The BLOCK_IO protocol uses LBA
@@ -270,6 +282,23 @@ UsbBootDetectMedia (
   IN  USB_MASS_DEVICE       *UsbMass
   );
 
+/**
+  Get the number of blocks carried by the next READ or WRITE command.
+
+  @param  UsbMass                The USB mass storage device
+  @param  TotalBlock             The number of blocks left to transfer
+  @param  MaxBlock               The largest block count the command can hold
+
+  @return The number of blocks to carry.
+
+**/
+UINT32
+UsbBootGetCarryBlocks (
+  IN  USB_MASS_DEVICE       *UsbMass,
+  IN  UINTN                 TotalBlock,
+  IN  UINT32                MaxBlock
+  );
+
 /**
   Read some blocks from the device.
 
@@ -27,6 +27,58 @@ USB_MASS_TRANSPORT mUsbBotTransport = {
   UsbBotCleanUp
 };
 
+/**
+  Find the USB IO asynchronous bulk protocol installed on the same handle
+  as the USB IO protocol instance.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+
+  @return The USB IO asynchronous bulk protocol instance, or NULL if the USB
+          bus driver doesn't provide one for the interface.
+
+**/
+EDKII_USB_IO_ASYNC_BULK_PROTOCOL *
+UsbBotGetAsyncBulk (
+  IN  EFI_USB_IO_PROTOCOL       *UsbIo
+  )
+{
+  EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *UsbIoAsyncBulk;
+  EFI_USB_IO_PROTOCOL               *HandleUsbIo;
+  EFI_HANDLE                        *Handles;
+  UINTN                             HandleNum;
+  UINTN                             Index;
+  EFI_STATUS                        Status;
+
+  UsbIoAsyncBulk = NULL;
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEdkiiUsbIoAsyncBulkProtocolGuid,
+                  NULL,
+                  &HandleNum,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < HandleNum; Index++) {
+    Status = gBS->HandleProtocol (Handles[Index], &gEfiUsbIoProtocolGuid, (VOID **) &HandleUsbIo);
+    if (EFI_ERROR (Status) || (HandleUsbIo != UsbIo)) {
+      continue;
+    }
+
+    Status = gBS->HandleProtocol (Handles[Index], &gEdkiiUsbIoAsyncBulkProtocolGuid, (VOID **) &UsbIoAsyncBulk);
+    if (EFI_ERROR (Status)) {
+      UsbIoAsyncBulk = NULL;
+    }
+    break;
+  }
+
+  FreePool (Handles);
+  return UsbIoAsyncBulk;
+}
+
 /**
   Initializes USB BOT protocol.
 
@@ -117,6 +169,15 @@ UsbBotInit (
   //
   UsbBot->CbwTag = 0x01;
 
+  //
+  // The data and status phases of a data-in command are both queued on the
+  // bulk-in endpoint, so at least two transfers must fit in its queue.
+  //
+  UsbBot->UsbIoAsyncBulk = UsbBotGetAsyncBulk (UsbIo);
+  if ((UsbBot->UsbIoAsyncBulk != NULL) && (UsbBot->UsbIoAsyncBulk->MaxQueueDepth < 2)) {
+    UsbBot->UsbIoAsyncBulk = NULL;
+  }
+
   if (Context != NULL) {
     *Context = UsbBot;
   } else {
@@ -130,6 +191,42 @@ ON_ERROR:
   return Status;
 }
 
+/**
+  Fill in the Command Block Wrapper of a command.
+
+  @param  UsbBot                The USB BOT device
+  @param  Cbw                   The Command Block Wrapper to fill in
+  @param  Cmd                   The command to transfer to device
+  @param  CmdLen                The length of the command
+  @param  DataDir               The direction of the data
+  @param  TransLen              The expected length of the data
+  @param  Lun                   The number of logic unit
+
+**/
+VOID
+UsbBotFillCbw (
+  IN  USB_BOT_PROTOCOL        *UsbBot,
+  OUT USB_BOT_CBW             *Cbw,
+  IN  UINT8                   *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  UINT32                  TransLen,
+  IN  UINT8                   Lun
+  )
+{
+  ASSERT ((CmdLen > 0) && (CmdLen <= USB_BOT_MAX_CMDLEN));
+
+  Cbw->Signature = USB_BOT_CBW_SIGNATURE;
+  Cbw->Tag       = UsbBot->CbwTag;
+  Cbw->DataLen   = TransLen;
+  Cbw->Flag      = (UINT8) ((DataDir == EfiUsbDataIn) ? BIT7 : 0);
+  Cbw->Lun       = Lun;
+  Cbw->CmdLen    = CmdLen;
+
+  ZeroMem (Cbw->CmdBlock, USB_BOT_MAX_CMDLEN);
+  CopyMem (Cbw->CmdBlock, Cmd, CmdLen);
+}
+
 /**
   Send the command to the device using Bulk-Out endpoint.
 
@@ -165,20 +262,10 @@ UsbBotSendCommand (
   UINTN                     DataLen;
   UINTN                     Timeout;
 
-  ASSERT ((CmdLen > 0) && (CmdLen <= USB_BOT_MAX_CMDLEN));
-
   //
   // Fill in the Command Block Wrapper.
   //
-  Cbw.Signature = USB_BOT_CBW_SIGNATURE;
-  Cbw.Tag       = UsbBot->CbwTag;
-  Cbw.DataLen   = TransLen;
-  Cbw.Flag      = (UINT8) ((DataDir == EfiUsbDataIn) ? BIT7 : 0);
-  Cbw.Lun       = Lun;
-  Cbw.CmdLen    = CmdLen;
-
-  ZeroMem (Cbw.CmdBlock, USB_BOT_MAX_CMDLEN);
-  CopyMem (Cbw.CmdBlock, Cmd, CmdLen);
+  UsbBotFillCbw (UsbBot, &Cbw, Cmd, CmdLen, DataDir, TransLen, Lun);
 
   Result  = 0;
   DataLen = sizeof (USB_BOT_CBW);
@@ -376,6 +463,281 @@ UsbBotGetStatus (
 }
 
 
+/**
+  Record the completion of a bulk transfer queued by the BOT protocol.
+
+  @param  Data                  The data buffer of the transfer.
+  @param  DataLength            The length of the data transferred.
+  @param  Context               The USB_BOT_ASYNC_TRANSFER of the transfer.
+  @param  Status                The EFI_USB_ERR_x result of the transfer.
+
+  @retval EFI_SUCCESS           The completion is recorded.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbBotAsyncBulkCallback (
+  IN  VOID                    *Data,
+  IN  UINTN                   DataLength,
+  IN  VOID                    *Context,
+  IN  UINT32                  Status
+  )
+{
+  USB_BOT_ASYNC_TRANSFER    *Transfer;
+
+  Transfer             = (USB_BOT_ASYNC_TRANSFER *) Context;
+  Transfer->DataLength = DataLength;
+  Transfer->Result     = Status;
+  Transfer->Done       = TRUE;
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Wait for a queued bulk transfer to complete.
+
+  @param  UsbBot                The USB BOT device
+  @param  Transfer              The transfer to wait for
+  @param  Timeout               The time in microseconds to wait, 0 to wait
+                                until the transfer completes
+
+  @retval TRUE                  The transfer has completed.
+  @retval FALSE                 The transfer didn't complete in time.
+
+**/
+BOOLEAN
+UsbBotWaitAsyncTransfer (
+  IN USB_BOT_PROTOCOL         *UsbBot,
+  IN USB_BOT_ASYNC_TRANSFER   *Transfer,
+  IN UINTN                    Timeout
+  )
+{
+  UINTN                     Elapsed;
+
+  for (Elapsed = 0; ; Elapsed += USB_BOT_ASYNC_POLL_STALL) {
+    UsbBot->UsbIoAsyncBulk->Poll (UsbBot->UsbIoAsyncBulk);
+    if (Transfer->Done) {
+      return TRUE;
+    }
+
+    if ((Timeout != 0) && (Elapsed >= Timeout)) {
+      return FALSE;
+    }
+
+    gBS->Stall (USB_BOT_ASYNC_POLL_STALL);
+  }
+}
+
+
+/**
+  Cancel the bulk transfers still queued on both bulk endpoints, so that
+  the endpoints can be used by synchronous transfers again.
+
+  @param  UsbBot                The USB BOT device
+
+**/
+VOID
+UsbBotCancelAsyncTransfers (
+  IN USB_BOT_PROTOCOL         *UsbBot
+  )
+{
+  UsbBot->UsbIoAsyncBulk->CancelAsyncBulkTransfer (
+                            UsbBot->UsbIoAsyncBulk,
+                            UsbBot->BulkOutEndpoint->EndpointAddress
+                            );
+  UsbBot->UsbIoAsyncBulk->CancelAsyncBulkTransfer (
+                            UsbBot->UsbIoAsyncBulk,
+                            UsbBot->BulkInEndpoint->EndpointAddress
+                            );
+}
+
+
+/**
+  Execute a command with the command, data and status phases queued to the
+  host controller at once, instead of waiting for each phase to complete
+  before the next one is issued.
+
+  The errors are handled the same way as by UsbBotSendCommand(),
+  UsbBotDataTransfer() and UsbBotGetStatus(). Whenever the status can't be
+  taken from the queued CSW, the queues are cancelled and the status is
+  read again by UsbBotGetStatus().
+
+  @param  UsbBot                The USB BOT device
+  @param  Cmd                   The command to transfer to device
+  @param  CmdLen                The length of the command
+  @param  DataDir               The direction of the data
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait the data phase to complete
+  @param  CmdStatus             The result of the command execution
+
+  @retval EFI_SUCCESS           Command execute result is retrieved and in the CmdStatus.
+  @retval EFI_NOT_READY         The device return NAK to the command
+  @retval Others                Failed to execute the command
+
+**/
+EFI_STATUS
+UsbBotExecCommandAsync (
+  IN  USB_BOT_PROTOCOL        *UsbBot,
+  IN  UINT8                   *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT8                   *CmdStatus
+  )
+{
+  EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *UsbIoAsyncBulk;
+  EFI_USB_ENDPOINT_DESCRIPTOR       *Endpoint;
+  USB_BOT_CBW                       Cbw;
+  USB_BOT_CSW                       Csw;
+  USB_BOT_ASYNC_TRANSFER            CbwTransfer;
+  USB_BOT_ASYNC_TRANSFER            DataTransfer;
+  USB_BOT_ASYNC_TRANSFER            CswTransfer;
+  BOOLEAN                           HasData;
+  EFI_STATUS                        Status;
+
+  UsbIoAsyncBulk = UsbBot->UsbIoAsyncBulk;
+  HasData        = (BOOLEAN) ((DataDir != EfiUsbNoData) && (DataLen != 0));
+
+  if (DataDir == EfiUsbDataIn) {
+    Endpoint = UsbBot->BulkInEndpoint;
+  } else {
+    Endpoint = UsbBot->BulkOutEndpoint;
+  }
+
+  UsbBotFillCbw (UsbBot, &Cbw, Cmd, CmdLen, DataDir, DataLen, Lun);
+  ZeroMem (&Csw, sizeof (USB_BOT_CSW));
+  ZeroMem (&CbwTransfer, sizeof (USB_BOT_ASYNC_TRANSFER));
+  ZeroMem (&DataTransfer, sizeof (USB_BOT_ASYNC_TRANSFER));
+  ZeroMem (&CswTransfer, sizeof (USB_BOT_ASYNC_TRANSFER));
+
+  //
+  // Queue the CBW on the bulk-out endpoint, the data on its endpoint, and
+  // the CSW on the bulk-in endpoint. The host controller moves on to the
+  // next phase as soon as the device is ready for it.
+  //
+  Status = UsbIoAsyncBulk->AsyncBulkTransfer (
+                             UsbIoAsyncBulk,
+                             UsbBot->BulkOutEndpoint->EndpointAddress,
+                             &Cbw,
+                             sizeof (USB_BOT_CBW),
+                             UsbBotAsyncBulkCallback,
+                             &CbwTransfer
+                             );
+  if (!EFI_ERROR (Status) && HasData) {
+    Status = UsbIoAsyncBulk->AsyncBulkTransfer (
+                               UsbIoAsyncBulk,
+                               Endpoint->EndpointAddress,
+                               Data,
+                               DataLen,
+                               UsbBotAsyncBulkCallback,
+                               &DataTransfer
+                               );
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = UsbIoAsyncBulk->AsyncBulkTransfer (
+                               UsbIoAsyncBulk,
+                               UsbBot->BulkInEndpoint->EndpointAddress,
+                               &Csw,
+                               sizeof (USB_BOT_CSW),
+                               UsbBotAsyncBulkCallback,
+                               &CswTransfer
+                               );
+  }
+  if (EFI_ERROR (Status)) {
+    //
+    // The CBW may have been sent already, so the device needs a reset recovery.
+    //
+    DEBUG ((EFI_D_ERROR, "UsbBotExecCommandAsync: failed to queue the transfers (%r)\n", Status));
+    UsbBotCancelAsyncTransfers (UsbBot);
+    UsbBotResetDevice (UsbBot, FALSE);
+    return Status;
+  }
+
+  //
+  // Command phase. Return immediately if device rejects the command.
+  //
+  if (!UsbBotWaitAsyncTransfer (UsbBot, &CbwTransfer, USB_BOT_SEND_CBW_TIMEOUT)) {
+    UsbBotCancelAsyncTransfers (UsbBot);
+    return EFI_TIMEOUT;
+  }
+
+  if (CbwTransfer.Result != EFI_USB_NOERROR) {
+    UsbBotCancelAsyncTransfers (UsbBot);
+    if (USB_IS_ERROR (CbwTransfer.Result, EFI_USB_ERR_STALL) && DataDir == EfiUsbDataOut) {
+      //
+      // Respond to Bulk-Out endpoint stall with a Reset Recovery,
+      // according to section 5.3.1 of USB Mass Storage Class Bulk-Only Transport Spec, v1.0.
+      //
+      UsbBotResetDevice (UsbBot, FALSE);
+    } else if (USB_IS_ERROR (CbwTransfer.Result, EFI_USB_ERR_NAK)) {
+      return EFI_NOT_READY;
+    }
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // Data phase. The host should attempt to receive the CSW no matter
+  // whether the data transfer succeeds or fails.
+  //
+  if (HasData) {
+    if (!UsbBotWaitAsyncTransfer (UsbBot, &DataTransfer, Timeout)) {
+      DEBUG ((EFI_D_ERROR, "UsbBotExecCommandAsync: data transfer (%r)\n", EFI_TIMEOUT));
+      UsbBotCancelAsyncTransfers (UsbBot);
+      UsbBotResetDevice (UsbBot, FALSE);
+      goto GET_STATUS;
+    }
+
+    if (DataTransfer.Result != EFI_USB_NOERROR) {
+      UsbBotCancelAsyncTransfers (UsbBot);
+      if (USB_IS_ERROR (DataTransfer.Result, EFI_USB_ERR_STALL)) {
+        DEBUG ((EFI_D_INFO, "UsbBotExecCommandAsync: Data Stall\n"));
+        UsbClearEndpointStall (UsbBot->UsbIo, Endpoint->EndpointAddress);
+      } else {
+        DEBUG ((EFI_D_ERROR, "UsbBotExecCommandAsync: data transfer result %x\n", DataTransfer.Result));
+      }
+      goto GET_STATUS;
+    }
+  }
+
+  //
+  // Status phase.
+  //
+  if (!UsbBotWaitAsyncTransfer (UsbBot, &CswTransfer, USB_BOT_RECV_CSW_TIMEOUT)) {
+    UsbBotCancelAsyncTransfers (UsbBot);
+    goto GET_STATUS;
+  }
+
+  if (CswTransfer.Result != EFI_USB_NOERROR) {
+    if (USB_IS_ERROR (CswTransfer.Result, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbBot->UsbIo, UsbBot->BulkInEndpoint->EndpointAddress);
+    }
+    goto GET_STATUS;
+  }
+
+  if ((Csw.Signature != USB_BOT_CSW_SIGNATURE) || (Csw.CmdStatus == USB_BOT_COMMAND_ERROR)) {
+    //
+    // CSW is invalid or reports a phase error, so perform reset recovery
+    //
+    UsbBotResetDevice (UsbBot, FALSE);
+    goto GET_STATUS;
+  }
+
+  *CmdStatus = Csw.CmdStatus;
+  UsbBot->CbwTag++;
+
+  return EFI_SUCCESS;
+
+GET_STATUS:
+  return UsbBotGetStatus (UsbBot, DataLen, CmdStatus);
+}
+
+
 /**
   Call the USB Mass Storage Class BOT protocol to issue
   the command/data/status circle to execute the commands.
@@ -416,6 +778,20 @@ UsbBotExecCommand (
   *CmdStatus  = USB_MASS_CMD_FAIL;
   UsbBot      = (USB_BOT_PROTOCOL *) Context;
 
+  if (UsbBot->UsbIoAsyncBulk != NULL) {
+    Status = UsbBotExecCommandAsync (UsbBot, Cmd, CmdLen, DataDir, Data, DataLen, Lun, Timeout, &Result);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "UsbBotExecCommand: UsbBotExecCommandAsync (%r)\n", Status));
+      return Status;
+    }
+
+    if (Result == 0) {
+      *CmdStatus = USB_MASS_CMD_SUCCESS;
+    }
+
+    return EFI_SUCCESS;
+  }
+
   //
   // Send the command to the device. Return immediately if device
   // rejects the command.
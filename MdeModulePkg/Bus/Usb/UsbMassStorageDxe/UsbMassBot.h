@@ -53,6 +53,11 @@ extern USB_MASS_TRANSPORT mUsbBotTransport;
 #define USB_BOT_RECV_CSW_TIMEOUT     (3 * USB_MASS_1_SECOND)
 #define USB_BOT_RESET_DEVICE_TIMEOUT (3 * USB_MASS_1_SECOND)
 
+//
+// Interval to poll the queued bulk transfers for completion, 10 microseconds
+//
+#define USB_BOT_ASYNC_POLL_STALL     10
+
 #pragma pack(1)
 ///
 /// The CBW (Command Block Wrapper) structures used by the USB BOT protocol.
@@ -87,8 +92,22 @@ typedef struct {
   EFI_USB_ENDPOINT_DESCRIPTOR   *BulkOutEndpoint;
   UINT32                        CbwTag;
   EFI_USB_IO_PROTOCOL           *UsbIo;
+  //
+  // If the USB bus driver provides the asynchronous bulk protocol, the
+  // command, data and status phases are queued at once.
+  //
+  EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *UsbIoAsyncBulk;
 } USB_BOT_PROTOCOL;
 
+///
+/// The completion of a bulk transfer queued by the BOT protocol.
+///
+typedef struct {
+  BOOLEAN                       Done;
+  UINTN                         DataLength;
+  UINT32                        Result;
+} USB_BOT_ASYNC_TRANSFER;
+
 /**
   Initializes USB BOT protocol.
 
@@ -330,6 +330,216 @@ UsbMassFlushBlocks (
   return EFI_SUCCESS;
 }
 
+/**
+  Reset the block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.Reset().
+  It resets the block device hardware.
+  ExtendedVerification is ignored in this implementation.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  ExtendedVerification   Indicates that the driver may perform a more exhaustive
+                                 verification operation of the device during reset.
+
+  @retval EFI_SUCCESS            The block device was reset.
+  @retval EFI_DEVICE_ERROR       The block device is not functioning correctly and could not be reset.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN BOOLEAN                  ExtendedVerification
+  )
+{
+  USB_MASS_DEVICE *UsbMass;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  return UsbMassReset (&UsbMass->BlockIo, ExtendedVerification);
+}
+
+
+/**
+  Reads the requested number of blocks from the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  Bulk-Only and CBI transports carry one command at a time, so the request
+  is completed before returning and the event in Token, if any, is signaled
+  then.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the read request is for.
+  @param  Lba                    The starting logical block address to read from on the device.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 A pointer to the destination buffer for the data. The caller is
+                                 responsible for either having implicit or explicit ownership of the buffer.
+
+  @retval EFI_SUCCESS            The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the read operation.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER  The read request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+     OUT VOID                   *Buffer
+  )
+{
+  USB_MASS_DEVICE     *UsbMass;
+  EFI_STATUS          Status;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  Status  = UsbMassReadBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+
+  if ((Token != NULL) && (Token->Event != NULL) && !EFI_ERROR (Status)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+
+/**
+  Writes a specified number of blocks to the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  Bulk-Only and CBI transports carry one command at a time, so the request
+  is completed before returning and the event in Token, if any, is signaled
+  then.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the write request is for.
+  @param  Lba                    The starting logical block address to be written.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 Pointer to the source buffer for the data.
+
+  @retval EFI_SUCCESS            The data were written correctly to the device.
+  @retval EFI_WRITE_PROTECTED    The device cannot be written to.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the write operation.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic
+                                 block size of the device.
+  @retval EFI_INVALID_PARAMETER  The write request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  USB_MASS_DEVICE     *UsbMass;
+  EFI_STATUS          Status;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+
+  Status  = UsbMassWriteBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+
+  if ((Token != NULL) && (Token->Event != NULL) && !EFI_ERROR (Status)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+
+/**
+  Flushes all modified data to a physical block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  USB mass storage device doesn't support write cache,
+  so signal the event in Token, if any, and return EFI_SUCCESS directly.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  Token                  A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS            All outstanding data were written correctly to the device.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to write data.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Get the max data size carried by one READ/WRITE command of the device.
+
+  Full and low speed devices, whose bulk endpoints are smaller than the
+  high speed packet size, keep the 64KB carry size. Faster devices carry
+  up to USB_BOOT_MAX_CARRY_SIZE with one command.
+
+  @param  UsbIo                  The USB I/O Protocol instance of the device.
+
+  @return The max data size in bytes.
+
+**/
+UINT32
+UsbMassGetMaxCarrySize (
+  IN EFI_USB_IO_PROTOCOL      *UsbIo
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR   EndPoint;
+  EFI_STATUS                    Status;
+  UINT8                         Index;
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+  if (EFI_ERROR (Status)) {
+    return USB_BOOT_IO_CARRY_SIZE;
+  }
+
+  for (Index = 0; Index < Interface.NumEndpoints; Index++) {
+    Status = UsbIo->UsbGetEndpointDescriptor (UsbIo, Index, &EndPoint);
+    if (EFI_ERROR (Status)) {
+      return USB_BOOT_IO_CARRY_SIZE;
+    }
+
+    if (USB_IS_BULK_ENDPOINT (EndPoint.Attributes) &&
+        (EndPoint.MaxPacketSize < USB_BOOT_HS_BULK_PACKET_SIZE)) {
+      return USB_BOOT_IO_CARRY_SIZE;
+    }
+  }
+
+  return USB_BOOT_MAX_CARRY_SIZE;
+}
+
 /**
   Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
 
@@ -483,10 +693,28 @@ UsbMassInitMultiLun (
   UINT8                            Index;
   EFI_STATUS                       Status;
   EFI_STATUS                       ReturnStatus;
+  UINT32                           MaxCarrySize;
 
   ASSERT (MaxLun > 0);
   ReturnStatus = EFI_NOT_FOUND;
 
+  //
+  // All the LUNs share the bulk endpoints, so get the carry size once
+  // from the USB I/O Protocol opened by driver in Start().
+  //
+  MaxCarrySize = USB_BOOT_IO_CARRY_SIZE;
+  Status = gBS->OpenProtocol (
+                  Controller,
+                  &gEfiUsbIoProtocolGuid,
+                  (VOID **) &UsbIo,
+                  This->DriverBindingHandle,
+                  Controller,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (!EFI_ERROR (Status)) {
+    MaxCarrySize = UsbMassGetMaxCarrySize (UsbIo);
+  }
+
   for (Index = 0; Index <= MaxLun; Index++) { 
 
     DEBUG ((EFI_D_INFO, "UsbMassInitMultiLun: Start to initialize No.%d logic unit\n", Index));
@@ -502,10 +730,16 @@ UsbMassInitMultiLun (
     UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
     UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
     UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+    UsbMass->BlockIo2.Media         = &UsbMass->BlockIoMedia;
+    UsbMass->BlockIo2.Reset         = UsbMassResetEx;
+    UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+    UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+    UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
     UsbMass->OpticalStorage       = FALSE;
     UsbMass->Transport            = Transport;
     UsbMass->Context              = Context;
     UsbMass->Lun                  = Index;
+    UsbMass->MaxCarrySize         = MaxCarrySize;
     
     //
     // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -546,6 +780,8 @@ UsbMassInitMultiLun (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -578,6 +814,8 @@ UsbMassInitMultiLun (
              UsbMass->DevicePath,
              &gEfiBlockIoProtocolGuid,
              &UsbMass->BlockIo,
+             &gEfiBlockIo2ProtocolGuid,
+             &UsbMass->BlockIo2,
              &gEfiDiskInfoProtocolGuid,
              &UsbMass->DiskInfo,
              NULL
@@ -643,9 +881,15 @@ UsbMassInitNonLun (
   UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
   UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
   UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+  UsbMass->BlockIo2.Media         = &UsbMass->BlockIoMedia;
+  UsbMass->BlockIo2.Reset         = UsbMassResetEx;
+  UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+  UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+  UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
   UsbMass->OpticalStorage       = FALSE;
   UsbMass->Transport            = Transport;
   UsbMass->Context              = Context;
+  UsbMass->MaxCarrySize         = UsbMassGetMaxCarrySize (UsbIo);
   
   //
   // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -662,6 +906,8 @@ UsbMassInitNonLun (
                   &Controller,
                   &gEfiBlockIoProtocolGuid,
                   &UsbMass->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &UsbMass->BlockIo2,
                   &gEfiDiskInfoProtocolGuid,
                   &UsbMass->DiskInfo,
                   NULL
@@ -969,6 +1215,8 @@ USBMassDriverBindingStop (
                     Controller,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -1029,6 +1277,8 @@ USBMassDriverBindingStop (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -161,6 +161,10 @@ PopBool (
   it will be cleared by CoreSchedule(), and then the driver can be
   dispatched.
 
+  Every protocol GUID pushed by the dependency expression is registered
+  with the protocol database, so that CoreDispatcher() only evaluates the
+  expression again after one of those protocols has been installed.
+
   @param  DriverEntry           DriverEntry element to update .
 
   @retval EFI_SUCCESS           It always works.
@@ -171,7 +175,9 @@ CorePreProcessDepex (
   IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
   )
 {
-  UINT8  *Iterator;
+  UINT8     *Iterator;
+  UINT8     *End;
+  EFI_GUID  DriverGuid;
 
   Iterator = DriverEntry->Depex;
   if (*Iterator == EFI_DEP_SOR) {
@@ -190,6 +196,39 @@ CorePreProcessDepex (
     CopyMem (&DriverEntry->BeforeAfterGuid, Iterator + 1, sizeof (EFI_GUID));
   }
 
+  //
+  // Build the reverse index from protocol GUID to this driver. If any GUID
+  // can not be registered, the driver falls back to being evaluated on
+  // every pass of the dispatcher.
+  //
+  DriverEntry->DepexDirty   = TRUE;
+  DriverEntry->DepexTracked = TRUE;
+  End = (UINT8 *)DriverEntry->Depex + DriverEntry->DepexSize;
+  while (Iterator < End && *Iterator != EFI_DEP_END) {
+    switch (*Iterator) {
+    case EFI_DEP_PUSH:
+    case EFI_DEP_BEFORE:
+    case EFI_DEP_AFTER:
+      if ((UINTN)(End - Iterator) < sizeof (EFI_GUID) + 1) {
+        DriverEntry->DepexTracked = FALSE;
+        return EFI_SUCCESS;
+      }
+      if (*Iterator == EFI_DEP_PUSH) {
+        CopyMem (&DriverGuid, Iterator + 1, sizeof (EFI_GUID));
+        if (EFI_ERROR (CoreRegisterProtocolDepexReference (&DriverGuid, &DriverEntry->DepexDirty))) {
+          DriverEntry->DepexTracked = FALSE;
+          return EFI_SUCCESS;
+        }
+      }
+      Iterator += sizeof (EFI_GUID) + 1;
+      break;
+
+    default:
+      Iterator++;
+      break;
+    }
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -332,6 +332,7 @@ CoreSchedule (
       CoreAcquireDispatcherLock ();
       DriverEntry->Unrequested  = FALSE;
       DriverEntry->Dependent    = TRUE;
+      DriverEntry->DepexDirty   = TRUE;
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -582,6 +583,15 @@ CoreDispatcher (
       }
 
       if (DriverEntry->Dependent) {
+        //
+        // A tracked DEPEX can only change result after one of the protocols
+        // it pushes has been installed, so skip it until that happens. The
+        // flag is cleared first so an install during evaluation is not lost.
+        //
+        if (DriverEntry->DepexTracked && !DriverEntry->DepexDirty) {
+          continue;
+        }
+        DriverEntry->DepexDirty = FALSE;
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
@@ -53,6 +53,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/TcgService.h>
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
+#include <Protocol/TimerDeadline.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -76,6 +77,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseLib.h>
 #include <Library/HobLib.h>
 #include <Library/PerformanceLib.h>
+#include <Library/PrintLib.h>
 #include <Library/UefiDecompressLib.h>
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Library/CacheMaintenanceLib.h>
@@ -169,6 +171,14 @@ typedef struct {
   BOOLEAN                         Initialized;
   BOOLEAN                         DepexProtocolError;
 
+  //
+  // DepexTracked is TRUE when every protocol pushed by the DEPEX has been
+  // registered with the protocol database; DepexDirty is then set whenever
+  // one of them is installed and CoreIsSchedulable() need only run when set.
+  //
+  BOOLEAN                         DepexTracked;
+  BOOLEAN                         DepexDirty;
+
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
@@ -200,6 +210,7 @@ extern EFI_DXE_SERVICES                         *gDxeCoreDS;
 extern EFI_HANDLE                               gDxeCoreImageHandle;
 
 extern EFI_DECOMPRESS_PROTOCOL                  gEfiDecompress;
+extern EDKII_TIMER_DEADLINE_PROTOCOL            gTimerDeadline;
 
 extern EFI_RUNTIME_ARCH_PROTOCOL                *gRuntime;
 extern EFI_CPU_ARCH_PROTOCOL                    *gCpu;
@@ -239,6 +250,26 @@ CoreInitializePool (
   );
 
 
+/**
+  Dump the pool usage statistics of every memory type.
+
+**/
+VOID
+CoreDumpPoolStatistics (
+  VOID
+  );
+
+
+/**
+  Dump the statistics of every event group.
+
+**/
+VOID
+CoreDumpEventGroupStatistics (
+  VOID
+  );
+
+
 /**
   Called to initialize the memory map and add descriptors to
   the current descriptor list.
@@ -406,6 +437,26 @@ CoreTimerTick (
   );
 
 
+/**
+  Returns the time left before the earliest armed timer event expires.
+
+  @param  This                   The EDKII_TIMER_DEADLINE_PROTOCOL instance
+  @param  TimeToExpire           The number of 100ns units until the earliest
+                                 timer event expires, 0 if it's already due
+
+  @retval EFI_SUCCESS            TimeToExpire is returned
+  @retval EFI_INVALID_PARAMETER  TimeToExpire is NULL
+  @retval EFI_NOT_FOUND          No timer event is armed
+
+**/
+EFI_STATUS
+EFIAPI
+CoreGetNextTimerDeadline (
+  IN  CONST EDKII_TIMER_DEADLINE_PROTOCOL *This,
+  OUT       UINT64                        *TimeToExpire
+  );
+
+
 /**
   Initialize the dispatcher. Initialize the notification function that runs when
   an FV2 protocol is added to the system.
@@ -454,6 +505,24 @@ CorePreProcessDepex (
   );
 
 
+/**
+  Record that a dispatcher driver's DEPEX references a protocol, so that
+  DepexDirty is set each time an interface of the protocol is installed.
+
+  @param  Protocol               The ID of the protocol referenced by the DEPEX
+  @param  DepexDirty             Flag of the driver to set on install
+
+  @retval EFI_SUCCESS            The reference was recorded
+  @retval EFI_OUT_OF_RESOURCES   There is not enough memory to record it
+
+**/
+EFI_STATUS
+CoreRegisterProtocolDepexReference (
+  IN EFI_GUID   *Protocol,
+  IN BOOLEAN    *DepexDirty
+  );
+
+
 
 /**
   Terminates all boot services.
@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // DXE Core Global Variables for Protocols from PEI
 //
 EFI_HANDLE                                mDecompressHandle = NULL;
+EFI_HANDLE                                mTimerDeadlineHandle = NULL;
 
 //
 // DXE Core globals for Architecture Protocols
@@ -423,6 +424,16 @@ DxeMain (
              );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Publish the Timer Deadline protocol for the platform timer driver
+  //
+  Status = CoreInstallMultipleProtocolInterfaces (
+             &mTimerDeadlineHandle,
+             &gEdkiiTimerDeadlineProtocolGuid,      &gTimerDeadline,
+             NULL
+             );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Register for the GUIDs of the Architectural Protocols, so the rest of the
   // EFI Boot Services and EFI Runtime Services tables can be filled in.
@@ -725,6 +736,11 @@ CoreExitBootServices (
   //
   gTimer->SetTimerPeriod (gTimer, 0);
 
+  DEBUG_CODE_BEGIN ();
+    CoreDumpPoolStatistics ();
+    CoreDumpEventGroupStatistics ();
+  DEBUG_CODE_END ();
+
   //
   // Terminate memory services if the MapKey matches
   //
@@ -37,9 +37,16 @@ LIST_ENTRY      gEventQueue[TPL_HIGH_LEVEL + 1];
 UINTN           gEventPending = 0;
 
 ///
-/// gEventSignalQueue - A list of events to signal based on EventGroup type
+/// mEventGroupHashTable - The event groups, bucketed by GUID hash. Each
+/// EVT_NOTIFY_SIGNAL event is a member of the group of its EventGroup GUID,
+/// or of the group of the zero GUID if it was created without one.
 ///
-LIST_ENTRY      gEventSignalQueue = INITIALIZE_LIST_HEAD_VARIABLE (gEventSignalQueue);
+LIST_ENTRY      mEventGroupHashTable[EVENT_GROUP_HASH_TABLE_SIZE];
+
+///
+/// mEventGroupCount - The number of event groups created so far
+///
+UINTN           mEventGroupCount = 0;
 
 ///
 /// Enumerate the valid types
@@ -137,6 +144,10 @@ CoreInitializeEventServices (
     InitializeListHead (&gEventQueue[Index]);
   }
 
+  for (Index = 0; Index < EVENT_GROUP_HASH_TABLE_SIZE; Index++) {
+    InitializeListHead (&mEventGroupHashTable[Index]);
+  }
+
   CoreInitializeTimer ();
 
   CoreCreateEventEx (
@@ -167,7 +178,11 @@ CoreDispatchEventNotifies (
 {
   IEVENT          *Event;
   LIST_ENTRY      *Head;
+  EVENT_GROUP     *Group;
+  VOID            *NotifyFunction;
+  UINT64          Tick;
 
+  Tick = 0;
   CoreAcquireEventLock ();
   ASSERT (gEventQueueLock.OwnerTpl == Priority);
   Head = &gEventQueue[Priority];
@@ -190,18 +205,41 @@ CoreDispatchEventNotifies (
       Event->SignalCount = 0;
     }
 
+    //
+    // Keep the group, the notification function may close the event
+    //
+    Group          = NULL;
+    NotifyFunction = (VOID *) (UINTN) Event->NotifyFunction;
+    if (Event->ExFlag) {
+      Group = Event->Group;
+    }
+
     CoreReleaseEventLock ();
 
+    PERF_CODE (
+      if (Group != NULL && Group->Measured) {
+        Tick = GetPerformanceCounter ();
+      }
+    );
+
     //
     // Notify this event
     //
     ASSERT (Event->NotifyFunction != NULL);
     Event->NotifyFunction (Event, Event->NotifyContext);
 
+    if (Group != NULL && Group->Measured) {
+      PERF_START (NotifyFunction, "EventGroup:", Group->PerfModule, Tick);
+      PERF_END (NotifyFunction, "EventGroup:", Group->PerfModule, 0);
+    }
+
     //
     // Check for next pending event
     //
     CoreAcquireEventLock ();
+    if (Group != NULL) {
+      Group->NotifyCount++;
+    }
   }
 
   gEventPending &= ~(1 << Priority);
@@ -247,6 +285,175 @@ CoreNotifyEvent (
 
 
 
+/**
+  Returns the mEventGroupHashTable bucket that holds the event group of a GUID.
+
+  @param  EventGroup             The GUID of the event group
+
+  @return The bucket list head
+
+**/
+LIST_ENTRY *
+CoreGetEventGroupHashBucket (
+  IN CONST EFI_GUID   *EventGroup
+  )
+{
+  UINT32              Hash;
+
+  Hash  = ReadUnaligned32 ((UINT32 *)EventGroup);
+  Hash ^= ReadUnaligned32 ((UINT32 *)EventGroup + 1);
+  Hash ^= ReadUnaligned32 ((UINT32 *)EventGroup + 2);
+  Hash ^= ReadUnaligned32 ((UINT32 *)EventGroup + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return &mEventGroupHashTable[Hash & (EVENT_GROUP_HASH_TABLE_SIZE - 1)];
+}
+
+
+/**
+  Finds the event group of a GUID. The event database must be locked.
+
+  @param  EventGroup             The GUID of the event group
+
+  @return The event group, or NULL if no event was ever created in the group
+
+**/
+EVENT_GROUP *
+CoreFindEventGroup (
+  IN CONST EFI_GUID   *EventGroup
+  )
+{
+  LIST_ENTRY          *Head;
+  LIST_ENTRY          *Link;
+  EVENT_GROUP         *Group;
+
+  ASSERT_LOCKED (&gEventQueueLock);
+
+  Head = CoreGetEventGroupHashBucket (EventGroup);
+  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+    Group = CR (Link, EVENT_GROUP, HashLink, EVENT_GROUP_SIGNATURE);
+    if (CompareGuid (&Group->Guid, EventGroup)) {
+      return Group;
+    }
+  }
+
+  return NULL;
+}
+
+
+/**
+  Finds the event group of a GUID, and creates it if it doesn't exist yet.
+  The event database must not be locked, so that memory can be allocated.
+
+  @param  EventGroup             The GUID of the event group
+
+  @return The event group, or NULL if it could not be allocated
+
+**/
+EVENT_GROUP *
+CoreCreateEventGroup (
+  IN CONST EFI_GUID   *EventGroup
+  )
+{
+  EVENT_GROUP         *Group;
+  EVENT_GROUP         *NewGroup;
+
+  CoreAcquireEventLock ();
+  Group = CoreFindEventGroup (EventGroup);
+  CoreReleaseEventLock ();
+  if (Group != NULL) {
+    return Group;
+  }
+
+  NewGroup = AllocateZeroPool (sizeof (EVENT_GROUP));
+  if (NewGroup == NULL) {
+    return NULL;
+  }
+  NewGroup->Signature = EVENT_GROUP_SIGNATURE;
+  CopyGuid (&NewGroup->Guid, EventGroup);
+  InitializeListHead (&NewGroup->EventList);
+
+  //
+  // The group may have been created by someone else in the meantime
+  //
+  CoreAcquireEventLock ();
+  Group = CoreFindEventGroup (EventGroup);
+  if (Group == NULL) {
+    NewGroup->Sequence = mEventGroupCount++;
+
+    //
+    // The idle loop event is signaled all the time, don't flood the
+    // performance records with it. The ExitBootServices and virtual address
+    // change groups are signaled after the memory map is handed to the OS,
+    // when the performance library must not allocate memory any more.
+    //
+    PERF_CODE (
+      NewGroup->Measured = (BOOLEAN) (!CompareGuid (EventGroup, &gIdleLoopEventGuid) &&
+                                      !CompareGuid (EventGroup, &gEfiEventExitBootServicesGuid) &&
+                                      !CompareGuid (EventGroup, &gEfiEventVirtualAddressChangeGuid));
+      AsciiSPrint (
+        NewGroup->PerfModule,
+        sizeof (NewGroup->PerfModule),
+        "%08x-%04x-%04x#%d",
+        EventGroup->Data1,
+        EventGroup->Data2,
+        EventGroup->Data3,
+        (UINT32) NewGroup->Sequence
+        );
+    );
+
+    InsertTailList (CoreGetEventGroupHashBucket (EventGroup), &NewGroup->HashLink);
+    Group    = NewGroup;
+    NewGroup = NULL;
+  }
+  CoreReleaseEventLock ();
+
+  if (NewGroup != NULL) {
+    CoreFreePool (NewGroup);
+  }
+
+  return Group;
+}
+
+
+/**
+  Dump the statistics of every event group: the number of member events, the
+  number of times the group was signaled and the number of member notification
+  functions dispatched. The sequence number of a group is the one found in the
+  module name of its performance records.
+
+**/
+VOID
+CoreDumpEventGroupStatistics (
+  VOID
+  )
+{
+  UINTN                   Index;
+  LIST_ENTRY              *Link;
+  EVENT_GROUP             *Group;
+
+  DEBUG ((DEBUG_EVENT, "Event group statistics: Sequence Guid Events Signaled Notified\n"));
+
+  CoreAcquireEventLock ();
+  for (Index = 0; Index < EVENT_GROUP_HASH_TABLE_SIZE; Index++) {
+    for (Link = mEventGroupHashTable[Index].ForwardLink; Link != &mEventGroupHashTable[Index]; Link = Link->ForwardLink) {
+      Group = CR (Link, EVENT_GROUP, HashLink, EVENT_GROUP_SIGNATURE);
+      DEBUG ((
+        DEBUG_EVENT,
+        "  %d %g %,ld %,ld %,ld\n",
+        (UINT32) Group->Sequence,
+        &Group->Guid,
+        (UINT64) Group->EventCount,
+        (UINT64) Group->SignalCount,
+        (UINT64) Group->NotifyCount
+        ));
+    }
+  }
+  CoreReleaseEventLock ();
+}
+
+
 /**
   Signals all events in the EventGroup.
 
@@ -261,13 +468,17 @@ CoreNotifySignalList (
   LIST_ENTRY              *Link;
   LIST_ENTRY              *Head;
   IEVENT                  *Event;
+  EVENT_GROUP             *Group;
 
   CoreAcquireEventLock ();
 
-  Head = &gEventSignalQueue;
-  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
-    Event = CR (Link, IEVENT, SignalLink, EVENT_SIGNATURE);
-    if (CompareGuid (&Event->EventGroup, EventGroup)) {
+  Group = CoreFindEventGroup (EventGroup);
+  if (Group != NULL) {
+    Group->SignalCount++;
+
+    Head = &Group->EventList;
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      Event = CR (Link, IEVENT, SignalLink, EVENT_SIGNATURE);
       CoreNotifyEvent (Event);
     }
   }
@@ -388,6 +599,8 @@ CoreCreateEventInternal (
   EFI_STATUS      Status;
   IEVENT          *IEvent;
   INTN            Index;
+  EVENT_GROUP     *Group;
+  EFI_GUID        ZeroGuid;
 
 
   if (Event == NULL) {
@@ -469,6 +682,34 @@ CoreCreateEventInternal (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Find the group the event is signaled with
+  //
+  Group = NULL;
+  if ((Type & EVT_NOTIFY_SIGNAL) != 0) {
+    if (EventGroup != NULL) {
+      Group = CoreCreateEventGroup (EventGroup);
+    } else {
+      ZeroMem (&ZeroGuid, sizeof (ZeroGuid));
+      Group = CoreCreateEventGroup (&ZeroGuid);
+    }
+    if (Group == NULL) {
+      CoreFreePool (IEvent);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  //
+  // Reserve room in the timer database, so the timer can be armed at any TPL
+  //
+  if ((Type & EVT_TIMER) != 0) {
+    Status = CoreReserveEventTimer ();
+    if (EFI_ERROR (Status)) {
+      CoreFreePool (IEvent);
+      return Status;
+    }
+  }
+
   IEvent->Signature = EVENT_SIGNATURE;
   IEvent->Type = Type;
 
@@ -500,7 +741,9 @@ CoreCreateEventInternal (
     //
     // The Event's NotifyFunction must be queued whenever the event is signaled
     //
-    InsertHeadList (&gEventSignalQueue, &IEvent->SignalLink);
+    IEvent->Group = Group;
+    InsertHeadList (&Group->EventList, &IEvent->SignalLink);
+    Group->EventCount++;
   }
 
   CoreReleaseEventLock ();
@@ -739,6 +982,7 @@ CoreCloseEvent (
   //
   if ((Event->Type & EVT_TIMER) != 0) {
     CoreSetTimer (Event, TimerCancel, 0);
+    CoreReleaseEventTimer ();
   }
 
   CoreAcquireEventLock ();
@@ -757,6 +1001,8 @@ CoreCloseEvent (
 
   if (Event->SignalLink.ForwardLink != NULL) {
     RemoveEntryList (&Event->SignalLink);
+    ASSERT (Event->Group->EventCount > 0);
+    Event->Group->EventCount--;
   }
 
   CoreReleaseEventLock ();
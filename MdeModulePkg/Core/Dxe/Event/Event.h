@@ -1,7 +1,7 @@
 /** @file
   UEFI Event support functions and structure.
 
-Copyright (c) 2006 - 2010, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2014, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -28,11 +28,60 @@ extern  UINTN                   gEventPending;
 /// Timer event information
 ///
 typedef struct {
-  LIST_ENTRY      Link;
+  ///
+  /// Position in the timer database, 0 if the timer is not armed
+  ///
+  UINTN           HeapIndex;
   UINT64          TriggerTime;
   UINT64          Period;
+  ///
+  /// Order in which timers with the same trigger time were armed
+  ///
+  UINT64          Sequence;
 } TIMER_EVENT_INFO;
 
+///
+/// Number of buckets of the event group hash table, must be a power of 2
+///
+#define EVENT_GROUP_HASH_TABLE_SIZE  64
+
+#define EVENT_GROUP_SIGNATURE   SIGNATURE_32('e','v','g','p')
+///
+/// Event group: the EVT_NOTIFY_SIGNAL events which are signaled together.
+/// Event groups are never freed, so they can be referenced without a lock.
+///
+typedef struct {
+  UINTN                   Signature;
+  ///
+  /// Link Entry inserted to the mEventGroupHashTable bucket of Guid
+  ///
+  LIST_ENTRY              HashLink;
+  EFI_GUID                Guid;
+  ///
+  /// Creation order of the group, which makes the performance record key unique
+  ///
+  UINTN                   Sequence;
+  ///
+  /// All the events of the group, linked through their SignalLink
+  ///
+  LIST_ENTRY              EventList;
+  UINTN                   EventCount;
+  ///
+  /// Statistics: number of times the group was signaled, and number of
+  /// notification functions of group members dispatched
+  ///
+  UINTN                   SignalCount;
+  UINTN                   NotifyCount;
+  ///
+  /// TRUE if the notification functions of the group are timed through
+  /// PerformanceLib, and the module name of the performance records: the
+  /// first three fields of the group GUID and the group Sequence, which
+  /// fit the performance record strings
+  ///
+  BOOLEAN                 Measured;
+  CHAR8                   PerfModule[sizeof ("00000000-0000-0000#4294967295")];
+} EVENT_GROUP;
+
 #define EVENT_SIGNATURE         SIGNATURE_32('e','v','n','t')
 typedef struct {
   UINTN                   Signature;
@@ -42,6 +91,7 @@ typedef struct {
   /// Entry if the event is registered to be signalled
   ///
   LIST_ENTRY              SignalLink;
+  EVENT_GROUP             *Group;
   ///
   /// Notification information for this event
   ///
@@ -85,4 +135,29 @@ CoreInitializeTimer (
   VOID
   );
 
+
+/**
+  Makes room in the timer database for a new timer event. It's called when a
+  timer event is created, at a TPL where memory can be allocated.
+
+  @retval EFI_SUCCESS            An entry of the timer database is reserved
+  @retval EFI_OUT_OF_RESOURCES   The timer database could not be grown
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  );
+
+
+/**
+  Gives back the entry of the timer database reserved for a timer event
+  which is closed.
+
+**/
+VOID
+CoreReleaseEventTimer (
+  VOID
+  );
+
 #endif
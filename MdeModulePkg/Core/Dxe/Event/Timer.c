@@ -1,7 +1,7 @@
 /** @file
   Core Timer Services
 
-Copyright (c) 2006 - 2013, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2014, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -16,20 +16,128 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "DxeMain.h"
 #include "Event.h"
 
+//
+// Number of entries the timer database is first allocated with
+//
+#define TIMER_HEAP_INITIAL_CAPACITY  64
+
 //
 // Internal data
 //
 
-LIST_ENTRY       mEfiTimerList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+//
+// The timer database is a binary min-heap of the armed timer events, ordered by
+// trigger time. mEfiTimerHeap[1] is the next timer to expire, and the children
+// of entry N are entries 2N and 2N + 1. Entry 0 is not used. Room for every timer
+// event is reserved when the event is created, so arming a timer never allocates
+// memory.
+//
+IEVENT           **mEfiTimerHeap = NULL;
+UINTN            mEfiTimerHeapSize = 0;
+UINTN            mEfiTimerHeapCapacity = 0;
+UINTN            mEfiTimerEventCount = 0;
+UINT64           mEfiTimerSequence = 0;
 EFI_LOCK         mEfiTimerLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT        mEfiCheckTimerEvent = NULL;
 
 EFI_LOCK         mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64           mEfiSystemTime = 0;
 
+EDKII_TIMER_DEADLINE_PROTOCOL gTimerDeadline = {
+  CoreGetNextTimerDeadline
+};
+
 //
 // Timer functions
 //
+/**
+  Checks if a timer event expires before another one. Timers with the same
+  trigger time expire in the order they were armed.
+
+  @param  Event                  Points to the internal structure of timer event
+  @param  Event2                 Points to the internal structure of timer event
+                                 to compare with
+
+  @retval TRUE                   Event expires before Event2
+  @retval FALSE                  Event expires after Event2
+
+**/
+BOOLEAN
+CoreTimerExpiresBefore (
+  IN IEVENT   *Event,
+  IN IEVENT   *Event2
+  )
+{
+  if (Event->Timer.TriggerTime != Event2->Timer.TriggerTime) {
+    return (BOOLEAN) (Event->Timer.TriggerTime < Event2->Timer.TriggerTime);
+  }
+  return (BOOLEAN) (Event->Timer.Sequence < Event2->Timer.Sequence);
+}
+
+/**
+  Moves a timer event towards the top of the timer database until its parent
+  expires before it.
+
+  @param  Index                  Position of the timer event in the timer database
+
+**/
+VOID
+CoreSiftUpEventTimer (
+  IN UINTN    Index
+  )
+{
+  IEVENT          *Event;
+  IEVENT          *Parent;
+
+  Event = mEfiTimerHeap[Index];
+  while (Index > 1) {
+    Parent = mEfiTimerHeap[Index / 2];
+    if (!CoreTimerExpiresBefore (Event, Parent)) {
+      break;
+    }
+    mEfiTimerHeap[Index] = Parent;
+    Parent->Timer.HeapIndex = Index;
+    Index = Index / 2;
+  }
+  mEfiTimerHeap[Index] = Event;
+  Event->Timer.HeapIndex = Index;
+}
+
+/**
+  Moves a timer event towards the bottom of the timer database until it
+  expires before its children.
+
+  @param  Index                  Position of the timer event in the timer database
+
+**/
+VOID
+CoreSiftDownEventTimer (
+  IN UINTN    Index
+  )
+{
+  IEVENT          *Event;
+  IEVENT          *Child;
+  UINTN           ChildIndex;
+
+  Event = mEfiTimerHeap[Index];
+  while (Index <= mEfiTimerHeapSize / 2) {
+    ChildIndex = Index * 2;
+    if (ChildIndex < mEfiTimerHeapSize &&
+        CoreTimerExpiresBefore (mEfiTimerHeap[ChildIndex + 1], mEfiTimerHeap[ChildIndex])) {
+      ChildIndex++;
+    }
+    Child = mEfiTimerHeap[ChildIndex];
+    if (!CoreTimerExpiresBefore (Child, Event)) {
+      break;
+    }
+    mEfiTimerHeap[Index] = Child;
+    Child->Timer.HeapIndex = Index;
+    Index = ChildIndex;
+  }
+  mEfiTimerHeap[Index] = Event;
+  Event->Timer.HeapIndex = Index;
+}
+
 /**
   Inserts the timer event.
 
@@ -42,29 +150,154 @@ CoreInsertEventTimer (
   IN IEVENT   *Event
   )
 {
-  UINT64          TriggerTime;
-  LIST_ENTRY      *Link;
-  IEVENT          *Event2;
+  ASSERT_LOCKED (&mEfiTimerLock);
+  ASSERT (Event->Timer.HeapIndex == 0);
+  ASSERT (mEfiTimerHeapSize < mEfiTimerHeapCapacity);
+
+  Event->Timer.Sequence = mEfiTimerSequence++;
+
+  //
+  // Add the timer at the bottom of the timer database and move it up to
+  // its place in the trigger time order
+  //
+  mEfiTimerHeap[mEfiTimerHeapSize + 1] = Event;
+  mEfiTimerHeapSize++;
+  CoreSiftUpEventTimer (mEfiTimerHeapSize);
+}
+
+/**
+  Removes the timer event from the timer database.
+
+  @param  Event                  Points to the internal structure of timer event
+                                 to be removed
+
+**/
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT   *Event
+  )
+{
+  UINTN           Index;
+  IEVENT          *Last;
 
   ASSERT_LOCKED (&mEfiTimerLock);
 
+  Index = Event->Timer.HeapIndex;
+  ASSERT (Index != 0 && Index <= mEfiTimerHeapSize);
+  ASSERT (mEfiTimerHeap[Index] == Event);
+
+  Event->Timer.HeapIndex = 0;
+  Last = mEfiTimerHeap[mEfiTimerHeapSize];
+  mEfiTimerHeapSize--;
+
   //
-  // Get the timer's trigger time
+  // Fill the hole with the last timer of the timer database, and move that
+  // one to its place in the trigger time order
   //
-  TriggerTime = Event->Timer.TriggerTime;
+  if (Last != Event) {
+    mEfiTimerHeap[Index] = Last;
+    Last->Timer.HeapIndex = Index;
+    if (Index > 1 && CoreTimerExpiresBefore (Last, mEfiTimerHeap[Index / 2])) {
+      CoreSiftUpEventTimer (Index);
+    } else {
+      CoreSiftDownEventTimer (Index);
+    }
+  }
+}
 
+/**
+  Returns the timer event which expires first, without taking the timer lock.
+  The caller must be running at TPL_HIGH_LEVEL.
+
+  @return The timer event which expires first, or NULL if no timer is armed
+
+**/
+IEVENT *
+CoreGetFirstEventTimer (
+  VOID
+  )
+{
   //
-  // Insert the timer into the timer database in assending sorted order
+  // The timer database is only changed below TPL_HIGH_LEVEL, and the first
+  // entry always points to an armed, or just disarmed, timer event.
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  if (mEfiTimerHeapSize == 0) {
+    return NULL;
+  }
+  return mEfiTimerHeap[1];
+}
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
+/**
+  Makes room in the timer database for a new timer event. It's called when a
+  timer event is created, at a TPL where memory can be allocated.
+
+  @retval EFI_SUCCESS            An entry of the timer database is reserved
+  @retval EFI_OUT_OF_RESOURCES   The timer database could not be grown
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  )
+{
+  IEVENT          **NewHeap;
+  IEVENT          **OldHeap;
+  UINTN           NewCapacity;
+
+  while (TRUE) {
+    CoreAcquireLock (&mEfiTimerLock);
+    if (mEfiTimerEventCount < mEfiTimerHeapCapacity) {
+      mEfiTimerEventCount++;
+      CoreReleaseLock (&mEfiTimerLock);
+      return EFI_SUCCESS;
+    }
+    NewCapacity = MAX (mEfiTimerHeapCapacity * 2, TIMER_HEAP_INITIAL_CAPACITY);
+    CoreReleaseLock (&mEfiTimerLock);
+
+    //
+    // Grow the timer database. Memory can't be allocated with the timer lock held.
+    //
+    NewHeap = AllocatePool ((NewCapacity + 1) * sizeof (IEVENT *));
+    if (NewHeap == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    CoreAcquireLock (&mEfiTimerLock);
+    if (NewCapacity > mEfiTimerHeapCapacity) {
+      if (mEfiTimerHeap != NULL) {
+        CopyMem (NewHeap, mEfiTimerHeap, (mEfiTimerHeapSize + 1) * sizeof (IEVENT *));
+      }
+      OldHeap               = mEfiTimerHeap;
+      mEfiTimerHeap         = NewHeap;
+      mEfiTimerHeapCapacity = NewCapacity;
+    } else {
+      //
+      // The timer database has been grown by someone else in the meantime
+      //
+      OldHeap = NewHeap;
+    }
+    CoreReleaseLock (&mEfiTimerLock);
+
+    if (OldHeap != NULL) {
+      CoreFreePool (OldHeap);
     }
   }
+}
+
+/**
+  Gives back the entry of the timer database reserved for a timer event
+  which is closed.
 
-  InsertTailList (Link, &Event->Timer.Link);
+**/
+VOID
+CoreReleaseEventTimer (
+  VOID
+  )
+{
+  CoreAcquireLock (&mEfiTimerLock);
+  ASSERT (mEfiTimerEventCount > mEfiTimerHeapSize);
+  mEfiTimerEventCount--;
+  CoreReleaseLock (&mEfiTimerLock);
 }
 
 /**
@@ -111,8 +344,8 @@ CoreCheckTimers (
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  while (mEfiTimerHeapSize != 0) {
+    Event = mEfiTimerHeap[1];
 
     //
     // If this timer is not expired, then we're done
@@ -125,8 +358,7 @@ CoreCheckTimers (
     // Remove this timer from the timer queue
     //
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);
 
     //
     // Signal it
@@ -213,9 +445,8 @@ CoreTimerTick (
   // If the head of the list is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
+  Event = CoreGetFirstEventTimer ();
+  if (Event != NULL) {
     if (Event->Timer.TriggerTime <= mEfiSystemTime) {
       CoreSignalEvent (mEfiCheckTimerEvent);
     }
@@ -225,6 +456,55 @@ CoreTimerTick (
 }
 
 
+/**
+  Returns the time left before the earliest armed timer event expires.
+
+  @param  This                   The EDKII_TIMER_DEADLINE_PROTOCOL instance
+  @param  TimeToExpire           The number of 100ns units until the earliest
+                                 timer event expires, 0 if it's already due
+
+  @retval EFI_SUCCESS            TimeToExpire is returned
+  @retval EFI_INVALID_PARAMETER  TimeToExpire is NULL
+  @retval EFI_NOT_FOUND          No timer event is armed
+
+**/
+EFI_STATUS
+EFIAPI
+CoreGetNextTimerDeadline (
+  IN  CONST EDKII_TIMER_DEADLINE_PROTOCOL *This,
+  OUT       UINT64                        *TimeToExpire
+  )
+{
+  IEVENT          *Event;
+  EFI_STATUS      Status;
+
+  if (TimeToExpire == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Only the system time lock is taken, so that the timer driver can call
+  // this from its interrupt handler
+  //
+  CoreAcquireLock (&mEfiSystemTimeLock);
+
+  Status = EFI_NOT_FOUND;
+  Event  = CoreGetFirstEventTimer ();
+  if (Event != NULL) {
+    if (Event->Timer.TriggerTime > mEfiSystemTime) {
+      *TimeToExpire = Event->Timer.TriggerTime - mEfiSystemTime;
+    } else {
+      *TimeToExpire = 0;
+    }
+    Status = EFI_SUCCESS;
+  }
+
+  CoreReleaseLock (&mEfiSystemTimeLock);
+
+  return Status;
+}
+
+
 
 /**
   Sets the type of timer and the trigger time for a timer event.
@@ -270,9 +550,8 @@ CoreSetTimer (
   //
   // If the timer is queued to the timer database, remove it
   //
-  if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+  if (Event->Timer.HeapIndex != 0) {
+    CoreRemoveEventTimer (Event);
   }
 
   Event->Timer.TriggerTime = 0;
@@ -17,12 +17,15 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 
 //
-// mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// mProtocolDatabase     - A list of all protocols in the system, in creation order
+// mProtocolHashTable    - The protocols in mProtocolDatabase, bucketed by GUID hash
 // gHandleList           - A list of all the handles in the system
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_TABLE_SIZE];
+BOOLEAN         mProtocolHashTableInitialized = FALSE;
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
@@ -85,6 +88,115 @@ CoreValidateHandle (
 
 
 
+/**
+  Returns the mProtocolHashTable bucket that holds the protocol entry for a GUID.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Protocol               The ID of the protocol
+
+  @return The head of the hash bucket list for Protocol
+
+**/
+LIST_ENTRY *
+CoreGetProtocolHashBucket (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINTN               Index;
+  UINT32              Hash;
+
+  if (!mProtocolHashTableInitialized) {
+    for (Index = 0; Index < PROTOCOL_HASH_TABLE_SIZE; Index++) {
+      InitializeListHead (&mProtocolHashTable[Index]);
+    }
+    mProtocolHashTableInitialized = TRUE;
+  }
+
+  //
+  // GUIDs are already well distributed, so folding the four DWORDs is enough
+  //
+  Hash  = ReadUnaligned32 ((UINT32 *)Protocol);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 1);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 2);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return &mProtocolHashTable[Hash & (PROTOCOL_HASH_TABLE_SIZE - 1)];
+}
+
+
+
+/**
+  Flag every dispatcher driver whose DEPEX references the protocol entry
+  for re-evaluation. The gProtocolDatabaseLock must be owned.
+
+  @param  ProtEntry              Protocol entry that gained an interface
+
+**/
+VOID
+CoreMarkProtocolDepexDirty (
+  IN PROTOCOL_ENTRY   *ProtEntry
+  )
+{
+  LIST_ENTRY          *Link;
+  PROTOCOL_DEPEX_REF  *DepexRef;
+
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  for (Link = ProtEntry->DepexRefs.ForwardLink;
+       Link != &ProtEntry->DepexRefs;
+       Link = Link->ForwardLink) {
+    DepexRef = CR(Link, PROTOCOL_DEPEX_REF, Link, PROTOCOL_DEPEX_REF_SIGNATURE);
+    *DepexRef->DepexDirty = TRUE;
+  }
+}
+
+
+
+/**
+  Record that a dispatcher driver's DEPEX references a protocol, so that
+  DepexDirty is set each time an interface of the protocol is installed.
+
+  @param  Protocol               The ID of the protocol referenced by the DEPEX
+  @param  DepexDirty             Flag of the driver to set on install
+
+  @retval EFI_SUCCESS            The reference was recorded
+  @retval EFI_OUT_OF_RESOURCES   There is not enough memory to record it
+
+**/
+EFI_STATUS
+CoreRegisterProtocolDepexReference (
+  IN EFI_GUID   *Protocol,
+  IN BOOLEAN    *DepexDirty
+  )
+{
+  PROTOCOL_ENTRY      *ProtEntry;
+  PROTOCOL_DEPEX_REF  *DepexRef;
+  EFI_STATUS          Status;
+
+  Status = EFI_OUT_OF_RESOURCES;
+
+  CoreAcquireProtocolLock ();
+
+  ProtEntry = CoreFindProtocolEntry (Protocol, TRUE);
+  if (ProtEntry != NULL) {
+    DepexRef = AllocatePool (sizeof (PROTOCOL_DEPEX_REF));
+    if (DepexRef != NULL) {
+      DepexRef->Signature  = PROTOCOL_DEPEX_REF_SIGNATURE;
+      DepexRef->DepexDirty = DepexDirty;
+      InsertTailList (&ProtEntry->DepexRefs, &DepexRef->Link);
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  CoreReleaseProtocolLock ();
+
+  return Status;
+}
+
+
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
@@ -101,6 +213,7 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
@@ -108,15 +221,16 @@ CoreFindProtocolEntry (
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the database for the matching GUID
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  Bucket    = CoreGetProtocolHashBucket (Protocol);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -143,11 +257,13 @@ CoreFindProtocolEntry (
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
+      InitializeListHead (&ProtEntry->DepexRefs);
 
       //
-      // Add it to protocol database
+      // Add it to protocol database and to the hash index of the database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -466,6 +582,11 @@ CoreInstallProtocolInterfaceNotify (
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
 
+  //
+  // Drivers whose DEPEX pushes this protocol need to be re-evaluated
+  //
+  CoreMarkProtocolDepexDirty (ProtEntry);
+
   //
   // Notify the notification list for this protocol
   //
@@ -904,13 +1025,21 @@ CoreGetProtocolInterface (
 
   Handle = (IHANDLE *)UserHandle;
 
+  //
+  // Resolve the GUID once through the protocol database index, so that
+  // each protocol interface on the handle only needs a pointer compare
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
   //
   // Look at each protocol interface for a match
   //
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
     Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    if (Prot->Protocol == ProtEntry) {
       return Prot;
     }
   }
@@ -36,6 +36,11 @@ typedef struct {
 
 #define PROTOCOL_ENTRY_SIGNATURE        SIGNATURE_32('p','r','t','e')
 
+///
+/// Number of buckets in the GUID-keyed protocol entry index. Must be a power of 2.
+///
+#define PROTOCOL_HASH_TABLE_SIZE        64
+
 ///
 /// PROTOCOL_ENTRY - each different protocol has 1 entry in the protocol
 /// database.  Each handler that supports this protocol is listed, along
@@ -45,12 +50,16 @@ typedef struct {
   UINTN               Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY          AllEntries;  
+  /// Link Entry inserted to the mProtocolHashTable bucket of ProtocolID
+  LIST_ENTRY          HashLink;
   /// ID of the protocol
   EFI_GUID            ProtocolID;  
   /// All protocol interfaces
   LIST_ENTRY          Protocols;     
   /// Registerd notification handlers
   LIST_ENTRY          Notify;                 
+  /// Dispatcher drivers whose DEPEX references this protocol
+  LIST_ENTRY          DepexRefs;
 } PROTOCOL_ENTRY;
 
 
@@ -109,6 +118,22 @@ typedef struct {
 } PROTOCOL_NOTIFY;
 
 
+#define PROTOCOL_DEPEX_REF_SIGNATURE    SIGNATURE_32('p','r','t','d')
+
+///
+/// PROTOCOL_DEPEX_REF - links a protocol to a dispatcher driver whose DEPEX
+/// pushes that protocol GUID, so installing the protocol only flags the
+/// drivers that may have become schedulable.
+///
+typedef struct {
+  UINTN               Signature;
+  /// Link on PROTOCOL_ENTRY.DepexRefs
+  LIST_ENTRY          Link;
+  /// Flag set when the protocol is installed
+  BOOLEAN             *DepexDirty;
+} PROTOCOL_DEPEX_REF;
+
+
 
 /**
   Finds the protocol entry for the requested protocol.
@@ -127,6 +152,19 @@ CoreFindProtocolEntry (
   );
 
 
+/**
+  Flag every dispatcher driver whose DEPEX references the protocol entry
+  for re-evaluation. The gProtocolDatabaseLock must be owned.
+
+  @param  ProtEntry              Protocol entry that gained an interface
+
+**/
+VOID
+CoreMarkProtocolDepexDirty (
+  IN PROTOCOL_ENTRY   *ProtEntry
+  );
+
+
 /**
   Signal event for every protocol in protocol entry.
 
@@ -37,7 +37,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP MEMORY_MAP;
+struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -48,7 +49,17 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
-} MEMORY_MAP;
+
+  //
+  // Node of the AVL tree which indexes the memory map by Start. MaxFreeSize is the
+  // size of the largest EfiConventionalMemory range in the subtree.
+  //
+  MEMORY_MAP      *Parent;
+  MEMORY_MAP      *Left;
+  MEMORY_MAP      *Right;
+  UINTN           Height;
+  UINT64          MaxFreeSize;
+};
 
 //
 // Internal prototypes
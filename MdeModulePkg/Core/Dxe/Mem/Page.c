@@ -17,6 +17,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define EFI_DEFAULT_PAGE_ALLOCATION_ALIGNMENT  (EFI_PAGE_SIZE)
 
+#define PREVIOUS_MEMORY_DESCRIPTOR(MemoryDescriptor, Size) \
+  ((EFI_MEMORY_DESCRIPTOR *)((UINT8 *)(MemoryDescriptor) - (Size)))
+
 //
 // Entry for tracking the memory regions for each memory type to coalesce similar memory types
 //
@@ -50,6 +53,11 @@ UINTN         mFreeMapStack = 0;
 /// This list maintain the free memory map list
 ///
 LIST_ENTRY   mFreeMemoryMapEntryList = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
+///
+/// Root of the AVL tree indexing gMemoryMap by start address. gMemoryMap itself
+/// is kept sorted by start address too.
+///
+MEMORY_MAP   *mMemoryMapRoot = NULL;
 BOOLEAN      mMemoryTypeInformationInitialized = FALSE;
 
 EFI_MEMORY_TYPE_STATISTICS mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
@@ -126,6 +134,298 @@ CoreReleaseMemoryLock (
 
 
 
+#define MEMORY_MAP_HEIGHT(a)        (((a) == NULL) ? 0 : (a)->Height)
+#define MEMORY_MAP_MAX_FREE_SIZE(a) (((a) == NULL) ? 0 : (a)->MaxFreeSize)
+
+/**
+  Internal function.  Recomputes the height and the largest free range of a
+  memory map tree node from its own range and its children.
+
+  @param  Node                   The tree node to update
+
+**/
+VOID
+MemoryMapTreeUpdateNode (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  UINT64  FreeSize;
+
+  Node->Height = MAX (MEMORY_MAP_HEIGHT (Node->Left), MEMORY_MAP_HEIGHT (Node->Right)) + 1;
+
+  FreeSize = 0;
+  if (Node->Type == EfiConventionalMemory) {
+    FreeSize = Node->End - Node->Start + 1;
+  }
+  FreeSize = MAX (FreeSize, MEMORY_MAP_MAX_FREE_SIZE (Node->Left));
+  FreeSize = MAX (FreeSize, MEMORY_MAP_MAX_FREE_SIZE (Node->Right));
+  Node->MaxFreeSize = FreeSize;
+}
+
+/**
+  Internal function.  Makes NewChild take the place of Child under Parent.
+
+  @param  Parent                 The parent node, or NULL if Child is the root
+  @param  Child                  The current child node
+  @param  NewChild               The node replacing Child, may be NULL
+
+**/
+VOID
+MemoryMapTreeReplaceChild (
+  IN OUT MEMORY_MAP      *Parent,
+  IN     MEMORY_MAP      *Child,
+  IN     MEMORY_MAP      *NewChild
+  )
+{
+  if (Parent == NULL) {
+    mMemoryMapRoot = NewChild;
+  } else if (Parent->Left == Child) {
+    Parent->Left = NewChild;
+  } else {
+    ASSERT (Parent->Right == Child);
+    Parent->Right = NewChild;
+  }
+}
+
+/**
+  Internal function.  Rotates a memory map tree node to the left or to the right.
+
+  @param  Node                   The tree node to rotate
+  @param  Left                   TRUE to rotate left, FALSE to rotate right
+
+**/
+VOID
+MemoryMapTreeRotate (
+  IN OUT MEMORY_MAP      *Node,
+  IN     BOOLEAN         Left
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  if (Left) {
+    Pivot       = Node->Right;
+    Node->Right = Pivot->Left;
+    if (Pivot->Left != NULL) {
+      Pivot->Left->Parent = Node;
+    }
+    Pivot->Left = Node;
+  } else {
+    Pivot       = Node->Left;
+    Node->Left  = Pivot->Right;
+    if (Pivot->Right != NULL) {
+      Pivot->Right->Parent = Node;
+    }
+    Pivot->Right = Node;
+  }
+
+  Pivot->Parent = Node->Parent;
+  MemoryMapTreeReplaceChild (Node->Parent, Node, Pivot);
+  Node->Parent  = Pivot;
+
+  MemoryMapTreeUpdateNode (Node);
+  MemoryMapTreeUpdateNode (Pivot);
+}
+
+/**
+  Internal function.  Updates the memory map tree nodes from Node up to the root,
+  and rotates the unbalanced ones.  Must be called after a node's range or type
+  changed, and after a node was linked into or removed from the tree.
+
+  @param  Node                   The lowest tree node to update, may be NULL
+
+**/
+VOID
+MemoryMapTreeRebalance (
+  IN MEMORY_MAP          *Node
+  )
+{
+  INTN  Balance;
+
+  while (Node != NULL) {
+    MemoryMapTreeUpdateNode (Node);
+
+    Balance = (INTN) MEMORY_MAP_HEIGHT (Node->Left) - (INTN) MEMORY_MAP_HEIGHT (Node->Right);
+    if (Balance > 1) {
+      if (MEMORY_MAP_HEIGHT (Node->Left->Left) < MEMORY_MAP_HEIGHT (Node->Left->Right)) {
+        MemoryMapTreeRotate (Node->Left, TRUE);
+      }
+      MemoryMapTreeRotate (Node, FALSE);
+      Node = Node->Parent;
+    } else if (Balance < -1) {
+      if (MEMORY_MAP_HEIGHT (Node->Right->Right) < MEMORY_MAP_HEIGHT (Node->Right->Left)) {
+        MemoryMapTreeRotate (Node->Right, FALSE);
+      }
+      MemoryMapTreeRotate (Node, TRUE);
+      Node = Node->Parent;
+    }
+
+    Node = Node->Parent;
+  }
+}
+
+/**
+  Internal function.  Finds the memory map descriptor with the highest start
+  address not above Address.
+
+  @param  Address                The address to look up
+
+  @return The descriptor, or NULL if all descriptors start above Address
+
+**/
+MEMORY_MAP *
+CoreFindMemoryMapEntry (
+  IN UINT64              Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Found;
+
+  Found = NULL;
+  Node  = mMemoryMapRoot;
+  while (Node != NULL) {
+    if (Node->Start <= Address) {
+      Found = Node;
+      Node  = Node->Right;
+    } else {
+      Node  = Node->Left;
+    }
+  }
+
+  return Found;
+}
+
+/**
+  Internal function.  Inserts a descriptor into the memory map, keeping both
+  gMemoryMap and the tree ordered by start address.
+
+  @param  Entry                  The entry to insert
+
+**/
+VOID
+InsertMemoryMapEntry (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Previous;
+
+  Previous = CoreFindMemoryMapEntry (Entry->Start);
+  ASSERT ((Previous == NULL) || (Previous->End < Entry->Start));
+  if (Previous == NULL) {
+    InsertHeadList (&gMemoryMap, &Entry->Link);
+  } else {
+    InsertHeadList (&Previous->Link, &Entry->Link);
+  }
+
+  Parent = NULL;
+  Node   = mMemoryMapRoot;
+  while (Node != NULL) {
+    Parent = Node;
+    Node   = (Entry->Start < Node->Start) ? Node->Left : Node->Right;
+  }
+
+  Entry->Parent = Parent;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+  if (Parent == NULL) {
+    mMemoryMapRoot = Entry;
+  } else if (Entry->Start < Parent->Start) {
+    Parent->Left = Entry;
+  } else {
+    Parent->Right = Entry;
+  }
+
+  MemoryMapTreeRebalance (Entry);
+}
+
+/**
+  Internal function.  Unlinks a descriptor from the memory map tree.
+
+  @param  Entry                  The entry to unlink
+
+**/
+VOID
+MemoryMapTreeRemove (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Successor;
+  MEMORY_MAP  *Child;
+  MEMORY_MAP  *Fix;
+
+  if ((Entry->Left != NULL) && (Entry->Right != NULL)) {
+    //
+    // Move the in-order successor into the place of Entry
+    //
+    Successor = Entry->Right;
+    while (Successor->Left != NULL) {
+      Successor = Successor->Left;
+    }
+
+    if (Successor->Parent != Entry) {
+      Fix = Successor->Parent;
+      Fix->Left = Successor->Right;
+      if (Successor->Right != NULL) {
+        Successor->Right->Parent = Fix;
+      }
+      Successor->Right = Entry->Right;
+      Entry->Right->Parent = Successor;
+    } else {
+      Fix = Successor;
+    }
+
+    Successor->Left = Entry->Left;
+    Entry->Left->Parent = Successor;
+    Successor->Parent = Entry->Parent;
+    MemoryMapTreeReplaceChild (Entry->Parent, Entry, Successor);
+  } else {
+    Child = (Entry->Left != NULL) ? Entry->Left : Entry->Right;
+    if (Child != NULL) {
+      Child->Parent = Entry->Parent;
+    }
+    MemoryMapTreeReplaceChild (Entry->Parent, Entry, Child);
+    Fix = Entry->Parent;
+  }
+
+  Entry->Parent = NULL;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+
+  MemoryMapTreeRebalance (Fix);
+}
+
+/**
+  Internal function.  Moves a descriptor which is linked into the memory map to
+  another storage location.
+
+  @param  Entry                  The entry linked into the memory map
+  @param  NewEntry               The storage to move the entry to
+
+**/
+VOID
+MoveMemoryMapEntry (
+  IN OUT MEMORY_MAP      *Entry,
+  OUT    MEMORY_MAP      *NewEntry
+  )
+{
+  CopyMem (NewEntry, Entry, sizeof (MEMORY_MAP));
+
+  NewEntry->Link.ForwardLink->BackLink = &NewEntry->Link;
+  NewEntry->Link.BackLink->ForwardLink = &NewEntry->Link;
+
+  MemoryMapTreeReplaceChild (Entry->Parent, Entry, NewEntry);
+  if (NewEntry->Left != NULL) {
+    NewEntry->Left->Parent = NewEntry;
+  }
+  if (NewEntry->Right != NULL) {
+    NewEntry->Right->Parent = NewEntry;
+  }
+
+  Entry->Link.ForwardLink = NULL;
+}
+
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -139,6 +439,7 @@ RemoveMemoryMapEntry (
 {
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
+  MemoryMapTreeRemove (Entry);
 
   if (Entry->FromPages) {
     //
@@ -168,7 +469,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -212,28 +512,24 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute. As the descriptors don't overlap, only the ones
+  // right below and right above the range can adjoin it.
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
+  if (Start != 0) {
+    Entry = CoreFindMemoryMapEntry (Start - 1);
+    if ((Entry != NULL) && (Entry->End + 1 == Start) &&
+        (Entry->Type == Type) && (Entry->Attribute == Attribute)) {
 
       Start = Entry->Start;
       RemoveMemoryMapEntry (Entry);
+    }
+  }
 
-    } else if (Entry->Start == End + 1) {
+  if (End != MAX_UINT64) {
+    Entry = CoreFindMemoryMapEntry (End + 1);
+    if ((Entry != NULL) && (Entry->Start == End + 1) &&
+        (Entry->Type == Type) && (Entry->Attribute == Attribute)) {
 
       End = Entry->End;
       RemoveMemoryMapEntry (Entry);
@@ -251,7 +547,7 @@ CoreAddRange (
   mMapStack[mMapDepth].End           = End;
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
-  InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapEntry (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -319,8 +615,6 @@ CoreFreeMemoryMapStack (
   )
 {
   MEMORY_MAP      *Entry;
-  MEMORY_MAP      *Entry2;
-  LIST_ENTRY      *Link2;
 
   ASSERT_LOCKED (&gMemoryLock);
 
@@ -352,26 +646,12 @@ CoreFreeMemoryMapStack (
     if (mMapStack[mMapDepth].Link.ForwardLink != NULL) {
 
       //
-      // Move this entry to general memory
+      // Move this entry to general memory. It takes over the place of the stack
+      // entry in both gMemoryMap and the tree.
       //
-      RemoveEntryList (&mMapStack[mMapDepth].Link);
-      mMapStack[mMapDepth].Link.ForwardLink = NULL;
-
-      CopyMem (Entry , &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
+      MoveMemoryMapEntry (&mMapStack[mMapDepth], Entry);
       Entry->FromPages = TRUE;
 
-      //
-      // Find insertion location
-      //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && Entry2->Start > Entry->Start) {
-          break;
-        }
-      }
-
-      InsertTailList (Link2, &Entry->Link);
-
     } else {
       //
       // This item of mMapStack[mMapDepth] has already been dequeued from gMemoryMap list,
@@ -698,7 +978,6 @@ CoreConvertPages (
   UINT64          End;
   UINT64          RangeEnd;
   UINT64          Attribute;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -723,15 +1002,9 @@ CoreConvertPages (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    Entry = CoreFindMemoryMapEntry (Start);
 
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    if ((Entry == NULL) || (Entry->End <= Start)) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -790,6 +1063,7 @@ CoreConvertPages (
       // Clip start
       //
       Entry->Start = RangeEnd + 1;
+      MemoryMapTreeRebalance (Entry);
 
     } else if (Entry->End == RangeEnd) {
 
@@ -797,6 +1071,7 @@ CoreConvertPages (
       // Clip end
       //
       Entry->End = Start - 1;
+      MemoryMapTreeRebalance (Entry);
 
     } else {
 
@@ -820,9 +1095,10 @@ CoreConvertPages (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      MemoryMapTreeRebalance (Entry);
 
       Entry = &mMapStack[mMapDepth];
-      InsertTailList (&gMemoryMap, &Entry->Link);
+      InsertMemoryMapEntry (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -881,6 +1157,84 @@ CoreConvertPages (
 
 
 
+/**
+  Internal function.  Searches a memory map subtree for the free range with the
+  highest address which fits the requested allocation.
+
+  Subtrees without a large enough EfiConventionalMemory range are skipped, and as
+  the descriptors don't overlap, the first fit found walking down from the highest
+  start address is the highest one.
+
+  @param  Node                   The root of the subtree to search
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+
+  @return The base address of the range, or 0 if the range was not found
+
+**/
+UINT64
+CoreFindFreePagesInTree (
+  IN MEMORY_MAP       *Node,
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfBytes,
+  IN UINTN            Alignment
+  )
+{
+  UINT64          Target;
+  UINT64          DescStart;
+  UINT64          DescEnd;
+
+  while ((Node != NULL) && (Node->MaxFreeSize >= NumberOfBytes)) {
+    //
+    // If desc is past max allowed address, so is its right subtree
+    //
+    if (Node->Start < MaxAddress) {
+      Target = CoreFindFreePagesInTree (Node->Right, MaxAddress, MinAddress, NumberOfBytes, Alignment);
+      if (Target != 0) {
+        return Target;
+      }
+
+      //
+      // If desc is below min allowed address, so is its left subtree
+      //
+      if (Node->End < MinAddress) {
+        return 0;
+      }
+
+      if (Node->Type == EfiConventionalMemory) {
+        DescStart = Node->Start;
+        DescEnd   = Node->End;
+
+        //
+        // If desc ends past max allowed address, clip the end
+        //
+        if (DescEnd >= MaxAddress) {
+          DescEnd = MaxAddress;
+        }
+
+        DescEnd = ((DescEnd + 1) & (~((UINT64) Alignment - 1))) - 1;
+
+        //
+        // See if the descriptor is large enough to satisfy the request, and
+        // the start of the allocated range is not below the min address allowed
+        //
+        if ((DescEnd >= DescStart) && (DescEnd - DescStart + 1 >= NumberOfBytes) &&
+            ((DescEnd - NumberOfBytes + 1) >= MinAddress)) {
+          return DescEnd - NumberOfBytes + 1;
+        }
+      }
+    }
+
+    Node = Node->Left;
+  }
+
+  return 0;
+}
+
+
 /**
   Internal function. Finds a consecutive free page range below
   the requested address.
@@ -906,11 +1260,6 @@ CoreFindFreePagesI (
 {
   UINT64          NumberOfBytes;
   UINT64          Target;
-  UINT64          DescStart;
-  UINT64          DescEnd;
-  UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
-  MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
     return 0;
@@ -939,64 +1288,8 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target = 0;
-
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
 
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        Target = DescEnd;
-      }
-    }
-  }
-
-  //
-  // If this is a grow down, adjust target to be the allocation base
-  //
-  Target -= NumberOfBytes - 1;
+  Target = CoreFindFreePagesInTree (mMemoryMapRoot, MaxAddress, MinAddress, NumberOfBytes, Alignment);
 
   //
   // If we didn't find a match, return 0
@@ -1212,7 +1505,6 @@ CoreFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
 
@@ -1224,14 +1516,8 @@ CoreFreePages (
   //
   // Find the entry that the covers the range
   //
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = CoreFindMemoryMapEntry (Memory);
+  if ((Entry == NULL) || (Entry->End <= Memory)) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -1499,10 +1785,15 @@ CoreGetMemoryMap (
     }
 
     //
-    // Check to see if the new Memory Map Descriptor can be merged with an 
-    // existing descriptor if they are adjacent and have the same attributes
+    // Check to see if the new Memory Map Descriptor can be merged with the
+    // previous one if they are adjacent and have the same attributes. gMemoryMap
+    // is sorted by address, so no other descriptor can adjoin it.
     //
-    MemoryMap = MergeMemoryMapDescriptor (MemoryMapStart, MemoryMap, Size);
+    if (MemoryMap != MemoryMapStart) {
+      MemoryMap = MergeMemoryMapDescriptor (PREVIOUS_MEMORY_DESCRIPTOR (MemoryMap, Size), MemoryMap, Size);
+    } else {
+      MemoryMap = NEXT_MEMORY_DESCRIPTOR (MemoryMap, Size);
+    }
   }
 
   for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
@@ -41,19 +41,60 @@ typedef struct {
   UINTN       Size;
 } POOL_TAIL;
 
+//
+// Pool entries smaller than DEFAULT_PAGE_ALLOCATION are carved out of slabs. A slab
+// is a naturally aligned block of pool pages holding entries of a single size class,
+// so the slab owning an entry is found by rounding the entry address down to the
+// slab size of its class.
+//
+#define POOL_SLAB_SIGNATURE   SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32          Signature;
+  UINT32          Index;
+  UINTN           FreeCount;
+  LIST_ENTRY      Link;
+  LIST_ENTRY      FreeList;
+} POOL_SLAB;
 
-#define POOL_SHIFT  7
+#define SIZE_OF_POOL_SLAB ALIGN_VALUE (sizeof (POOL_SLAB), 8)
 
 #define POOL_OVERHEAD (SIZE_OF_POOL_HEAD + sizeof(POOL_TAIL))
 
 #define HEAD_TO_TAIL(a)   \
   ((POOL_TAIL *) (((CHAR8 *) (a)) + (a)->Size - sizeof(POOL_TAIL)));
 
+//
+// Size classes of the slab entries, in bytes including the pool head & tail. Each
+// class is the largest multiple of 8 bytes which still fits the same number of
+// entries into a slab, so the slabs are used up to the last few bytes. The classes
+// up to MAX_SMALL_ENTRY_SIZE live in DEFAULT_PAGE_ALLOCATION slabs, the larger ones
+// in LARGE_SLAB_SIZE slabs. The last class covers every entry smaller than
+// DEFAULT_PAGE_ALLOCATION.
+//
+UINTN mPoolClassSize[] = {
+    48,   64,   80,   96,  112,  128,  160,  192,  224,  256,
+   320,  384,  448,  512,  576,  672,  808, 1008, 1344, 2024,
+  2336, 2720, 3272, 3632, DEFAULT_PAGE_ALLOCATION - 8
+};
+
+#define MAX_POOL_LIST         (sizeof (mPoolClassSize) / sizeof (mPoolClassSize[0]))
+#define MAX_SMALL_ENTRY_SIZE  2024
+#define MAX_SLAB_ENTRY_SIZE   (DEFAULT_PAGE_ALLOCATION - 8)
+
+#define LARGE_SLAB_SIZE       (DEFAULT_PAGE_ALLOCATION * 8)
 
-#define SIZE_TO_LIST(a)   ((a) >> POOL_SHIFT)
-#define LIST_TO_SIZE(a)   ((a+1) << POOL_SHIFT)
+#define SLAB_SIZE(a) \
+  ((mPoolClassSize[a] <= MAX_SMALL_ENTRY_SIZE) ? DEFAULT_PAGE_ALLOCATION : LARGE_SLAB_SIZE)
 
-#define MAX_POOL_LIST       SIZE_TO_LIST(DEFAULT_PAGE_ALLOCATION)
+#define SLAB_ENTRY_COUNT(a) \
+  ((SLAB_SIZE (a) - SIZE_OF_POOL_SLAB) / mPoolClassSize[a])
+
+//
+// Size class lookup table, indexed by the entry size in 8 byte units.
+//
+UINT8  mPoolSizeToList[MAX_SLAB_ENTRY_SIZE / 8];
+
+#define SIZE_TO_LIST(a)   ((UINTN) mPoolSizeToList[((a) - 1) >> 3])
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
@@ -66,8 +107,17 @@ typedef struct {
     INTN             Signature;
     UINTN            Used;
     EFI_MEMORY_TYPE  MemoryType;
+    //
+    // Slabs of each size class which have free entries
+    //
     LIST_ENTRY       FreeList[MAX_POOL_LIST];
     LIST_ENTRY       Link;
+    //
+    // Statistics
+    //
+    UINTN            PeakUsed;
+    UINTN            Pages;
+    UINTN            Allocations;
 } POOL;
 
 //
@@ -92,6 +142,22 @@ CoreInitializePool (
 {
   UINTN  Type;
   UINTN  Index;
+  UINTN  Class;
+
+  ASSERT (mPoolClassSize[MAX_POOL_LIST - 1] == MAX_SLAB_ENTRY_SIZE);
+  ASSERT (mPoolClassSize[0] >= sizeof (POOL_FREE));
+  ASSERT (SLAB_ENTRY_COUNT (MAX_POOL_LIST - 1) >= 2);
+
+  //
+  // Map every entry size to the smallest size class which fits it
+  //
+  Class = 0;
+  for (Index = 0; Index < MAX_SLAB_ENTRY_SIZE / 8; Index++) {
+    while (mPoolClassSize[Class] < (Index + 1) * 8) {
+      Class++;
+    }
+    mPoolSizeToList[Index] = (UINT8) Class;
+  }
 
   for (Type=0; Type < EfiMaxMemoryType; Type++) {
     mPoolHead[Type].Signature  = 0;
@@ -143,6 +209,7 @@ LookupPoolHead (
       return NULL;
     }
 
+    ZeroMem (Pool, sizeof (POOL));
     Pool->Signature = POOL_SIGNATURE;
     Pool->Used      = 0;
     Pool->MemoryType = MemoryType;
@@ -159,6 +226,54 @@ LookupPoolHead (
 }
 
 
+/**
+  Allocate a new slab for a size class and carve it up into free pool entries.
+
+  @param  Pool                   The pool head of the memory type
+  @param  Index                  The size class of the slab
+
+  @return The new slab, or NULL
+
+**/
+POOL_SLAB *
+CoreAllocatePoolSlab (
+  IN POOL             *Pool,
+  IN UINTN            Index
+  )
+{
+  POOL_SLAB   *Slab;
+  POOL_FREE   *Free;
+  CHAR8       *NewPage;
+  UINTN       FSize;
+  UINTN       Offset;
+
+  NewPage = CoreAllocatePoolPages (Pool->MemoryType, EFI_SIZE_TO_PAGES (SLAB_SIZE (Index)), SLAB_SIZE (Index));
+  if (NewPage == NULL) {
+    return NULL;
+  }
+  Pool->Pages += EFI_SIZE_TO_PAGES (SLAB_SIZE (Index));
+
+  Slab = (POOL_SLAB *) NewPage;
+  Slab->Signature = POOL_SLAB_SIGNATURE;
+  Slab->Index     = (UINT32)Index;
+  Slab->FreeCount = 0;
+  InitializeListHead (&Slab->FreeList);
+
+  FSize  = mPoolClassSize[Index];
+  for (Offset = SIZE_OF_POOL_SLAB; Offset + FSize <= SLAB_SIZE (Index); Offset += FSize) {
+    Free = (POOL_FREE *) &NewPage[Offset];
+    Free->Signature = POOL_FREE_SIGNATURE;
+    Free->Index     = (UINT32)Index;
+    InsertTailList (&Slab->FreeList, &Free->Link);
+    Slab->FreeCount++;
+  }
+
+  ASSERT (Slab->FreeCount == SLAB_ENTRY_COUNT (Index));
+  InsertHeadList (&Pool->FreeList[Index], &Slab->Link);
+
+  return Slab;
+}
+
 
 /**
   Allocate pool of a particular type.
@@ -237,14 +352,12 @@ CoreAllocatePoolI (
   )
 {
   POOL        *Pool;
+  POOL_SLAB   *Slab;
   POOL_FREE   *Free;
   POOL_HEAD   *Head;
   POOL_TAIL   *Tail;
-  CHAR8       *NewPage;
   VOID        *Buffer;
   UINTN       Index;
-  UINTN       FSize;
-  UINTN       Offset;
   UINTN       NoPages;
 
   ASSERT_LOCKED (&gMemoryLock);
@@ -261,7 +374,6 @@ CoreAllocatePoolI (
   Size = ALIGN_VARIABLE (Size);
 
   Size += POOL_OVERHEAD;
-  Index = SIZE_TO_LIST(Size);
   Pool = LookupPoolHead (PoolType);
   if (Pool== NULL) {
     return NULL;
@@ -272,54 +384,37 @@ CoreAllocatePoolI (
   // If allocation is over max size, just allocate pages for the request
   // (slow)
   //
-  if (Index >= MAX_POOL_LIST) {
+  if (Size > MAX_SLAB_ENTRY_SIZE) {
     NoPages = EFI_SIZE_TO_PAGES(Size) + EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION) - 1;
     NoPages &= ~(EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION) - 1);
     Head = CoreAllocatePoolPages (PoolType, NoPages, DEFAULT_PAGE_ALLOCATION);
+    if (Head != NULL) {
+      Pool->Pages += NoPages;
+    }
     goto Done;
   }
 
   //
-  // If there's no free pool in the proper list size, go get some more pages
+  // If no slab of the proper size class has a free entry, go get a new slab
   //
+  Index = SIZE_TO_LIST(Size);
   if (IsListEmpty (&Pool->FreeList[Index])) {
-
-    //
-    // Get another page
-    //
-    NewPage = CoreAllocatePoolPages(PoolType, EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION), DEFAULT_PAGE_ALLOCATION);
-    if (NewPage == NULL) {
+    if (CoreAllocatePoolSlab (Pool, Index) == NULL) {
       goto Done;
     }
-
-    //
-    // Carve up new page into free pool blocks
-    //
-    Offset = 0;
-    while (Offset < DEFAULT_PAGE_ALLOCATION) {
-      ASSERT (Index < MAX_POOL_LIST);
-      FSize = LIST_TO_SIZE(Index);
-
-      while (Offset + FSize <= DEFAULT_PAGE_ALLOCATION) {
-        Free = (POOL_FREE *) &NewPage[Offset];
-        Free->Signature = POOL_FREE_SIGNATURE;
-        Free->Index     = (UINT32)Index;
-        InsertHeadList (&Pool->FreeList[Index], &Free->Link);
-        Offset += FSize;
-      }
-
-      Index -= 1;
-    }
-
-    ASSERT (Offset == DEFAULT_PAGE_ALLOCATION);
-    Index = SIZE_TO_LIST(Size);
   }
 
   //
-  // Remove entry from free pool list
+  // Remove entry from the free list of the first slab. A slab which runs out of
+  // free entries leaves the list until one of its entries is freed.
   //
-  Free = CR (Pool->FreeList[Index].ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
+  Slab = CR (Pool->FreeList[Index].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  Free = CR (Slab->FreeList.ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
   RemoveEntryList (&Free->Link);
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    RemoveEntryList (&Slab->Link);
+  }
 
   Head = (POOL_HEAD *) Free;
 
@@ -352,6 +447,10 @@ Done:
     // Account the allocation
     //
     Pool->Used += Size;
+    Pool->Allocations++;
+    if (Pool->Used > Pool->PeakUsed) {
+      Pool->PeakUsed = Pool->Used;
+    }
 
   } else {
     DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate %ld bytes\n", (UINT64) Size));
@@ -410,13 +509,10 @@ CoreFreePoolI (
   POOL_HEAD   *Head;
   POOL_TAIL   *Tail;
   POOL_FREE   *Free;
+  POOL_SLAB   *Slab;
   UINTN       Index;
   UINTN       NoPages;
   UINTN       Size;
-  CHAR8       *NewPage;
-  UINTN       FSize;
-  UINTN       Offset;
-  BOOLEAN     AllFree;
 
   ASSERT(Buffer != NULL);
   //
@@ -458,16 +554,14 @@ CoreFreePoolI (
   Pool->Used -= Size;
   DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Head->Data, (UINT64)(Head->Size - POOL_OVERHEAD), (UINT64) Pool->Used));
 
-  //
-  // Determine the pool list
-  //
-  Index = SIZE_TO_LIST(Size);
+  Pool->Allocations--;
+
   DEBUG_CLEAR_MEMORY (Head, Size);
 
   //
-  // If it's not on the list, it must be pool pages
+  // If it's not from a slab, it must be pool pages
   //
-  if (Index >= MAX_POOL_LIST) {
+  if (Size > MAX_SLAB_ENTRY_SIZE) {
 
     //
     // Return the memory pages back to free memory
@@ -475,74 +569,39 @@ CoreFreePoolI (
     NoPages = EFI_SIZE_TO_PAGES(Size) + EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION) - 1;
     NoPages &= ~(EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION) - 1);
     CoreFreePoolPages ((EFI_PHYSICAL_ADDRESS) (UINTN) Head, NoPages);
+    Pool->Pages -= NoPages;
 
   } else {
 
     //
-    // Put the pool entry onto the free pool list
+    // Put the pool entry back onto the free list of its slab
     //
+    Index = SIZE_TO_LIST(Size);
+    Slab  = (POOL_SLAB *)((UINTN)Head & ~(SLAB_SIZE (Index) - 1));
+    ASSERT (Slab->Signature == POOL_SLAB_SIGNATURE);
+    ASSERT (Slab->Index == Index);
+
     Free = (POOL_FREE *) Head;
-    ASSERT(Free != NULL);
     Free->Signature = POOL_FREE_SIGNATURE;
     Free->Index     = (UINT32)Index;
-    InsertHeadList (&Pool->FreeList[Index], &Free->Link);
+    InsertHeadList (&Slab->FreeList, &Free->Link);
+    Slab->FreeCount++;
+
+    if (Slab->FreeCount == 1) {
+      InsertHeadList (&Pool->FreeList[Index], &Slab->Link);
+    }
 
     //
-    // See if all the pool entries in the same page as Free are freed pool
-    // entries
+    // Give the slab back to free memory once all its entries are freed. The last
+    // slab of a size class is kept for the standard memory types though, so that
+    // alternating allocate and free calls don't keep allocating pages.
     //
-    NewPage = (CHAR8 *)((UINTN)Free & ~((DEFAULT_PAGE_ALLOCATION) -1));
-    Free = (POOL_FREE *) &NewPage[0];
-    ASSERT(Free != NULL);
-
-    if (Free->Signature == POOL_FREE_SIGNATURE) {
-
-      Index = Free->Index;
-
-      AllFree = TRUE;
-      Offset = 0;
-
-      while ((Offset < DEFAULT_PAGE_ALLOCATION) && (AllFree)) {
-        FSize = LIST_TO_SIZE(Index);
-        while (Offset + FSize <= DEFAULT_PAGE_ALLOCATION) {
-          Free = (POOL_FREE *) &NewPage[Offset];
-          ASSERT(Free != NULL);
-          if (Free->Signature != POOL_FREE_SIGNATURE) {
-            AllFree = FALSE;
-          }
-          Offset += FSize;
-        }
-        Index -= 1;
-      }
-
-      if (AllFree) {
-
-        //
-        // All of the pool entries in the same page as Free are free pool
-        // entries
-        // Remove all of these pool entries from the free loop lists.
-        //
-        Free = (POOL_FREE *) &NewPage[0];
-        ASSERT(Free != NULL);
-        Index = Free->Index;
-        Offset = 0;
-
-        while (Offset < DEFAULT_PAGE_ALLOCATION) {
-          FSize = LIST_TO_SIZE(Index);
-          while (Offset + FSize <= DEFAULT_PAGE_ALLOCATION) {
-            Free = (POOL_FREE *) &NewPage[Offset];
-            ASSERT(Free != NULL);
-            RemoveEntryList (&Free->Link);
-            Offset += FSize;
-          }
-          Index -= 1;
-        }
-
-        //
-        // Free the page
-        //
-        CoreFreePoolPages ((EFI_PHYSICAL_ADDRESS) (UINTN)NewPage, EFI_SIZE_TO_PAGES (DEFAULT_PAGE_ALLOCATION));
-      }
+    if ((Slab->FreeCount == SLAB_ENTRY_COUNT (Index)) &&
+        (((INT32)Pool->MemoryType < 0) ||
+         (Pool->FreeList[Index].ForwardLink != Pool->FreeList[Index].BackLink))) {
+      RemoveEntryList (&Slab->Link);
+      CoreFreePoolPages ((EFI_PHYSICAL_ADDRESS) (UINTN) Slab, EFI_SIZE_TO_PAGES (SLAB_SIZE (Index)));
+      Pool->Pages -= EFI_SIZE_TO_PAGES (SLAB_SIZE (Index));
     }
   }
 
@@ -558,3 +617,47 @@ CoreFreePoolI (
 
   return EFI_SUCCESS;
 }
+
+
+/**
+  Dump the pool usage statistics of every memory type.
+
+**/
+VOID
+CoreDumpPoolStatistics (
+  VOID
+  )
+{
+  UINTN       Type;
+  LIST_ENTRY  *Link;
+  POOL        *Pool;
+
+  DEBUG ((DEBUG_POOL, "Pool statistics: Type Allocations Used (Peak) Pages\n"));
+  for (Type = 0; Type < EfiMaxMemoryType; Type++) {
+    Pool = &mPoolHead[Type];
+    if (Pool->Pages != 0) {
+      DEBUG ((
+        DEBUG_POOL,
+        "  %08x %,ld %,ld (%,ld) %,ld\n",
+        Pool->MemoryType,
+        (UINT64) Pool->Allocations,
+        (UINT64) Pool->Used,
+        (UINT64) Pool->PeakUsed,
+        (UINT64) Pool->Pages
+        ));
+    }
+  }
+
+  for (Link = mPoolHeadList.ForwardLink; Link != &mPoolHeadList; Link = Link->ForwardLink) {
+    Pool = CR(Link, POOL, Link, POOL_SIGNATURE);
+    DEBUG ((
+      DEBUG_POOL,
+      "  %08x %,ld %,ld (%,ld) %,ld\n",
+      Pool->MemoryType,
+      (UINT64) Pool->Allocations,
+      (UINT64) Pool->Used,
+      (UINT64) Pool->PeakUsed,
+      (UINT64) Pool->Pages
+      ));
+  }
+}
@@ -251,3 +251,48 @@ PeimDispatchReadiness (
     }
   }
 }
+
+/**
+
+  Compute the mask of PPI hash buckets referenced by the PUSH opcodes of a
+  dependency expression. The dispatcher only needs to evaluate the expression
+  again after a PPI in one of these buckets has been installed or reinstalled.
+
+  @param DependencyExpression   Pointer to a dependency expression.
+
+  @return The bucket mask, or 0 if the expression contains an unknown opcode.
+
+**/
+UINT32
+PeimDepexPpiBucketMask (
+  IN VOID               *DependencyExpression
+  )
+{
+  DEPENDENCY_EXPRESSION_OPERAND  *Iterator;
+  UINT32                         Mask;
+
+  Iterator = DependencyExpression;
+  Mask     = 0;
+
+  while (TRUE) {
+    switch (*(Iterator++)) {
+      case (EFI_DEP_PUSH):
+        Mask |= (UINT32) 1 << PeiPpiGuidHash ((EFI_GUID *) Iterator);
+        Iterator = Iterator + sizeof (EFI_GUID);
+        break;
+
+      case (EFI_DEP_AND):
+      case (EFI_DEP_OR):
+      case (EFI_DEP_NOT):
+      case (EFI_DEP_TRUE):
+      case (EFI_DEP_FALSE):
+        break;
+
+      case (EFI_DEP_END):
+        return Mask;
+
+      default:
+        return 0;
+    }
+  }
+}
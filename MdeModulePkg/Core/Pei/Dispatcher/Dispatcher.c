@@ -755,6 +755,8 @@ PeiDispatcher (
     if (!Private->PeimDispatcherReenter) {
       Private->PeimNeedingDispatch      = FALSE;
       Private->PeimDispatchOnThisPass   = FALSE;
+      Private->PpiHash.LastPassPpiBucketMask = Private->PpiHash.NewPpiBucketMask;
+      Private->PpiHash.NewPpiBucketMask      = 0;
     } else {
       Private->PeimDispatcherReenter    = FALSE;
     }
@@ -791,7 +793,16 @@ PeiDispatcher (
         PeimFileHandle = Private->CurrentFileHandle = Private->CurrentFvFileHandles[PeimCount];
 
         if (Private->Fv[FvCount].PeimState[PeimCount] == PEIM_STATE_NOT_DISPATCHED) {
-          if (!DepexSatisfied (Private, PeimFileHandle, PeimCount)) {
+          //
+          // A DEPEX that evaluated to FALSE can only change after a PPI it
+          // references is installed or reinstalled. Each PEIM is evaluated at
+          // most once per pass, so the PPIs changed since its last evaluation
+          // are covered by the buckets of this pass and the previous one.
+          //
+          if (((Private->PeimDepexPpiMask[FvCount][PeimCount] != 0) &&
+               ((Private->PeimDepexPpiMask[FvCount][PeimCount] &
+                 (Private->PpiHash.NewPpiBucketMask | Private->PpiHash.LastPassPpiBucketMask)) == 0)) ||
+              !DepexSatisfied (Private, PeimFileHandle, PeimCount)) {
             Private->PeimNeedingDispatch = TRUE;
           } else {
             Status = CoreFvHandle->FvPpi->GetFileInfo (CoreFvHandle->FvPpi, PeimFileHandle, &FvFileInfo);
@@ -1250,9 +1261,15 @@ DepexSatisfied (
   }
 
   //
-  // Evaluate a given DEPEX
+  // Evaluate a given DEPEX. If it is not satisfied, remember which PPI hash
+  // buckets it depends on so the dispatcher can skip it until one changes.
   //
-  return PeimDispatchReadiness (&Private->Ps, DepexData);
+  if (!PeimDispatchReadiness (&Private->Ps, DepexData)) {
+    Private->PeimDepexPpiMask[Private->CurrentPeimFvCount][PeimCount] = PeimDepexPpiBucketMask (DepexData);
+    return FALSE;
+  }
+
+  return TRUE;
 }
 
 /**
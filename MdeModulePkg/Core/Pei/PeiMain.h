@@ -94,6 +94,42 @@ typedef struct {
   PEI_PPI_LIST_POINTERS   PpiListPtrs[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
 } PEI_PPI_DATABASE;
 
+///
+/// Number of buckets in the GUID hash index of the PPI database. Must be a power
+/// of 2 and no larger than the bit width of PEI_PPI_HASH_INDEX.NewPpiBucketMask.
+///
+#define PEI_PPI_HASH_BUCKETS    32
+
+///
+/// Terminates a PPI hash chain.
+///
+#define PEI_PPI_HASH_END        0xFFFF
+
+///
+/// GUID hash index over the installed part of PEI_PPI_DATABASE.PpiListPtrs.
+/// The chains hold PpiList indexes rather than pointers, so the index survives
+/// the migration of the PEI Core data from temporary to permanent memory.
+///
+typedef struct {
+  ///
+  /// First PpiList index of each hash bucket.
+  ///
+  UINT16                  Head[PEI_PPI_HASH_BUCKETS];
+  ///
+  /// Next PpiList index in the same bucket. Chains are kept in ascending index
+  /// order so instances are found in installation order.
+  ///
+  UINT16                  Next[FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)];
+  ///
+  /// Buckets of the PPIs installed or reinstalled during the current dispatcher pass.
+  ///
+  UINT32                  NewPpiBucketMask;
+  ///
+  /// Buckets of the PPIs installed or reinstalled during the previous dispatcher pass.
+  ///
+  UINT32                  LastPassPpiBucketMask;
+} PEI_PPI_HASH_INDEX;
+
 
 //
 // PEI_CORE_FV_HANDE.PeimState
@@ -239,6 +275,16 @@ struct _PEI_CORE_INSTANCE {
   // Those Memory Range will be migrated into phisical memory. 
   //
   HOLE_MEMORY_DATA                  HoleData[HOLE_MAX_NUMBER];
+  //
+  // GUID hash index over PpiData. Kept at the end of the structure so that
+  // the offset of LoadModuleAtFixAddressTopAddress is not affected.
+  //
+  PEI_PPI_HASH_INDEX                PpiHash;
+  //
+  // For every PEIM whose DEPEX evaluated to FALSE, the mask of PPI hash buckets
+  // referenced by the DEPEX. Zero means the DEPEX must be evaluated on the next pass.
+  //
+  UINT32                            PeimDepexPpiMask[FixedPcdGet32 (PcdPeiCoreMaxFvSupported)][FixedPcdGet32 (PcdPeiCoreMaxPeimPerFv)];
 };
 
 ///
@@ -326,6 +372,21 @@ PeimDispatchReadiness (
   IN VOID               *DependencyExpression
   );
 
+/**
+
+  Compute the mask of PPI hash buckets referenced by the PUSH opcodes of a
+  dependency expression.
+
+  @param DependencyExpression   Pointer to a dependency expression.
+
+  @return The bucket mask, or 0 if the expression contains an unknown opcode.
+
+**/
+UINT32
+PeimDepexPpiBucketMask (
+  IN VOID               *DependencyExpression
+  );
+
 /**
   Conduct PEIM dispatch.
 
@@ -379,6 +440,20 @@ DepexSatisfied (
 //
 // PPI support functions
 //
+/**
+
+  Compute the bucket of a PPI GUID in the PPI database hash index.
+
+  @param Guid            The PPI GUID. It does not need to be aligned.
+
+  @return The bucket number, less than PEI_PPI_HASH_BUCKETS.
+
+**/
+UINTN
+PeiPpiGuidHash (
+  IN CONST EFI_GUID      *Guid
+  );
+
 /**
 
   Initialize PPI services.
@@ -14,6 +14,97 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "PeiMain.h"
 
+/**
+
+  Compute the bucket of a PPI GUID in the PPI database hash index.
+
+  @param Guid            The PPI GUID. It does not need to be aligned.
+
+  @return The bucket number, less than PEI_PPI_HASH_BUCKETS.
+
+**/
+UINTN
+PeiPpiGuidHash (
+  IN CONST EFI_GUID      *Guid
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *) Guid) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return (UINTN) (Hash & (PEI_PPI_HASH_BUCKETS - 1));
+}
+
+/**
+
+  Link an installed PPI into the hash index of the PPI database and record
+  its bucket as changed for the dispatcher.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Index           PpiList index of the installed PPI descriptor.
+
+**/
+VOID
+PpiHashInsert (
+  IN PEI_CORE_INSTANCE   *PrivateData,
+  IN INTN                Index
+  )
+{
+  UINTN   Bucket;
+  UINT16  *Link;
+
+  Bucket = PeiPpiGuidHash (PrivateData->PpiData.PpiListPtrs[Index].Ppi->Guid);
+
+  //
+  // Keep the chain in ascending index order. New installs always have the
+  // highest index, so they are appended.
+  //
+  Link = &PrivateData->PpiHash.Head[Bucket];
+  while (*Link != PEI_PPI_HASH_END && *Link < Index) {
+    Link = &PrivateData->PpiHash.Next[*Link];
+  }
+  PrivateData->PpiHash.Next[Index] = *Link;
+  *Link = (UINT16) Index;
+
+  PrivateData->PpiHash.NewPpiBucketMask |= (UINT32) 1 << Bucket;
+}
+
+/**
+
+  Unlink a PPI from the hash index of the PPI database and record its
+  bucket as changed for the dispatcher.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Index           PpiList index of the PPI descriptor.
+
+**/
+VOID
+PpiHashRemove (
+  IN PEI_CORE_INSTANCE   *PrivateData,
+  IN INTN                Index
+  )
+{
+  UINTN   Bucket;
+  UINT16  *Link;
+
+  Bucket = PeiPpiGuidHash (PrivateData->PpiData.PpiListPtrs[Index].Ppi->Guid);
+
+  Link = &PrivateData->PpiHash.Head[Bucket];
+  while (*Link != PEI_PPI_HASH_END) {
+    if (*Link == Index) {
+      *Link = PrivateData->PpiHash.Next[Index];
+      break;
+    }
+    Link = &PrivateData->PpiHash.Next[*Link];
+  }
+
+  PrivateData->PpiHash.NewPpiBucketMask |= (UINT32) 1 << Bucket;
+}
+
 /**
 
   Initialize PPI services.
@@ -33,6 +124,12 @@ InitializePpiServices (
     PrivateData->PpiData.NotifyListEnd = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
     PrivateData->PpiData.DispatchListEnd = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
     PrivateData->PpiData.LastDispatchedNotify = FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
+
+    //
+    // PpiList indexes must fit the UINT16 hash chains.
+    //
+    ASSERT (FixedPcdGet32 (PcdPeiCoreMaxPpiSupported) < PEI_PPI_HASH_END);
+    SetMem (PrivateData->PpiHash.Head, sizeof (PrivateData->PpiHash.Head), 0xFF);
   }
 }
 
@@ -220,13 +317,17 @@ PeiInstallPpi (
     // Try to indicate which item failed.
     //
     if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
-      PrivateData->PpiData.PpiListEnd = LastCallbackInstall;
+      while (PrivateData->PpiData.PpiListEnd > LastCallbackInstall) {
+        PrivateData->PpiData.PpiListEnd--;
+        PpiHashRemove (PrivateData, PrivateData->PpiData.PpiListEnd);
+      }
       DEBUG((EFI_D_ERROR, "ERROR -> InstallPpi: %g %p\n", PpiList->Guid, PpiList->Ppi));
       return  EFI_INVALID_PARAMETER;
     }
 
     DEBUG((EFI_D_INFO, "Install PPI: %g\n", PpiList->Guid));
     PrivateData->PpiData.PpiListPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR*) PpiList;
+    PpiHashInsert (PrivateData, Index);
     PrivateData->PpiData.PpiListEnd++;
 
     //
@@ -283,6 +384,7 @@ PeiReInstallPpi (
 {
   PEI_CORE_INSTANCE   *PrivateData;
   INTN                Index;
+  UINT16              HashIndex;
 
 
   if ((OldPpi == NULL) || (NewPpi == NULL)) {
@@ -296,24 +398,29 @@ PeiReInstallPpi (
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
 
   //
-  // Find the old PPI instance in the database.  If we can not find it,
-  // return the EFI_NOT_FOUND error.
+  // Find the old PPI instance in the hash bucket of its GUID.  If we can
+  // not find it, return the EFI_NOT_FOUND error.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
-    if (OldPpi == PrivateData->PpiData.PpiListPtrs[Index].Ppi) {
+  for (HashIndex = PrivateData->PpiHash.Head[PeiPpiGuidHash (OldPpi->Guid)];
+       HashIndex != PEI_PPI_HASH_END;
+       HashIndex = PrivateData->PpiHash.Next[HashIndex]) {
+    if (OldPpi == PrivateData->PpiData.PpiListPtrs[HashIndex].Ppi) {
       break;
     }
   }
-  if (Index == PrivateData->PpiData.PpiListEnd) {
+  if (HashIndex == PEI_PPI_HASH_END) {
     return EFI_NOT_FOUND;
   }
+  Index = HashIndex;
 
   //
   // Remove the old PPI from the database, add the new one.
   //
   DEBUG((EFI_D_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
   ASSERT (Index < (INTN)(FixedPcdGet32 (PcdPeiCoreMaxPpiSupported)));
+  PpiHashRemove (PrivateData, Index);
   PrivateData->PpiData.PpiListPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  PpiHashInsert (PrivateData, Index);
 
   //
   // Dispatch any callback level notifies for the newly installed PPI.
@@ -358,7 +465,7 @@ PeiLocatePpi (
   )
 {
   PEI_CORE_INSTANCE   *PrivateData;
-  INTN                Index;
+  UINT16              Index;
   EFI_GUID            *CheckGuid;
   EFI_PEI_PPI_DESCRIPTOR  *TempPtr;
 
@@ -366,9 +473,12 @@ PeiLocatePpi (
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
 
   //
-  // Search the data base for the matching instance of the GUIDed PPI.
+  // Search the hash bucket of the GUID for the matching instance of the
+  // GUIDed PPI. The bucket lists the PPIs in installation order.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
+  for (Index = PrivateData->PpiHash.Head[PeiPpiGuidHash (Guid)];
+       Index != PEI_PPI_HASH_END;
+       Index = PrivateData->PpiHash.Next[Index]) {
     TempPtr = PrivateData->PpiData.PpiListPtrs[Index].Ppi;
     CheckGuid = TempPtr->Guid;
 
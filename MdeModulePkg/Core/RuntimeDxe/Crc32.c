@@ -7,7 +7,11 @@
   EFI Runtime Services Table are converted from physical address to
   virtual addresses.  This requires that the 32-bit CRC be recomputed.
 
-Copyright (c) 2006 - 2008, Intel Corporation. All rights reserved.<BR>
+  The CRC is computed with CalculateCrc32() of BaseLib. On X64, large buffers
+  are folded with PCLMULQDQ instead while boot services are available, since
+  the fold uses XMM registers that belong to the OS at runtime.
+
+Copyright (c) 2006 - 2014, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -19,9 +23,41 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 **/
 
 
-#include <Uefi.h>
+#include "Runtime.h"
+
+//
+// Buffers shorter than this are not worth the CPUID to check for PCLMULQDQ.
+// CPUID may cause a VM exit when running in a virtual machine.
+//
+#define CRC32_PCLMUL_THRESHOLD  SIZE_4KB
+
+#if defined (MDE_CPU_X64)
+/**
+  Check whether RuntimeDriverCrc32Pclmul() can be used.
+
+  The fold is only used before ExitBootServices(), while the firmware owns the
+  XMM registers, with SSE enabled by CR4.OSFXSR, and if the processor reports
+  PCLMULQDQ.
+
+  @retval TRUE    RuntimeDriverCrc32Pclmul() can be used.
+  @retval FALSE   CalculateCrc32() must be used.
+
+**/
+BOOLEAN
+RuntimeDriverIsCrc32PclmulUsable (
+  VOID
+  )
+{
+  UINT32  RegEcx;
+
+  if (mRuntime.AtRuntime || (AsmReadCr4 () & BIT9) == 0) {
+    return FALSE;
+  }
 
-UINT32  mCrcTable[256];
+  AsmCpuid (1, NULL, NULL, &RegEcx, NULL);
+  return (BOOLEAN) ((RegEcx & BIT1) != 0);
+}
+#endif
 
 /**
   Calculate CRC32 for target data.
@@ -43,73 +79,36 @@ RuntimeDriverCalculateCrc32 (
   OUT UINT32  *CrcOut
   )
 {
+#if defined (MDE_CPU_X64)
   UINT32  Crc;
+  UINTN   Folded;
   UINTN   Index;
-  UINT8   *Ptr;
+  UINTN   Bit;
+#endif
 
   if (Data == NULL || DataSize == 0 || CrcOut == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Crc = 0xffffffff;
-  for (Index = 0, Ptr = Data; Index < DataSize; Index++, Ptr++) {
-    Crc = (Crc >> 8) ^ mCrcTable[(UINT8) Crc ^ *Ptr];
-  }
-
-  *CrcOut = Crc ^ 0xffffffff;
-  return EFI_SUCCESS;
-}
-
-
-/**
-  This internal function reverses bits for 32bit data.
-
-  @param  Value                 The data to be reversed.
-
-  @return                       Data reversed.
-
-**/
-UINT32
-ReverseBits (
-  UINT32  Value
-  )
-{
-  UINTN   Index;
-  UINT32  NewValue;
-
-  NewValue = 0;
-  for (Index = 0; Index < 32; Index++) {
-    if ((Value & (1 << Index)) != 0) {
-      NewValue = NewValue | (1 << (31 - Index));
-    }
-  }
-
-  return NewValue;
-}
-
-/**
-  Initialize CRC32 table.
-
-**/
-VOID
-RuntimeDriverInitializeCrc32Table (
-  VOID
-  )
-{
-  UINTN   TableEntry;
-  UINTN   Index;
-  UINT32  Value;
-
-  for (TableEntry = 0; TableEntry < 256; TableEntry++) {
-    Value = ReverseBits ((UINT32) TableEntry);
-    for (Index = 0; Index < 8; Index++) {
-      if ((Value & 0x80000000) != 0) {
-        Value = (Value << 1) ^ 0x04c11db7;
-      } else {
-        Value = Value << 1;
+#if defined (MDE_CPU_X64)
+  if (DataSize >= CRC32_PCLMUL_THRESHOLD && RuntimeDriverIsCrc32PclmulUsable ()) {
+    //
+    // Fold all of the whole 16-byte units, and add the last bytes bit by bit.
+    //
+    Folded = DataSize & ~((UINTN) 0x0f);
+    Crc    = RuntimeDriverCrc32Pclmul (Data, Folded, 0xffffffff);
+    for (Index = Folded; Index < DataSize; Index++) {
+      Crc ^= ((UINT8 *) Data)[Index];
+      for (Bit = 0; Bit < 8; Bit++) {
+        Crc = (Crc >> 1) ^ (((Crc & 1) != 0) ? 0xedb88320 : 0);
       }
     }
 
-    mCrcTable[TableEntry] = ReverseBits (Value);
+    *CrcOut = Crc ^ 0xffffffff;
+    return EFI_SUCCESS;
   }
+#endif
+
+  *CrcOut = CalculateCrc32 (Data, DataSize);
+  return EFI_SUCCESS;
 }
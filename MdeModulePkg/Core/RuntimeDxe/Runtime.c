@@ -400,11 +400,6 @@ RuntimeDriverInitialize (
   ASSERT_EFI_ERROR (Status);
   mMyImageBase = MyLoadedImage->ImageBase;
 
-  //
-  // Initialize the table used to compute 32-bit CRCs
-  //
-  RuntimeDriverInitializeCrc32Table ();
-
   //
   // Fill in the entries of the EFI Boot Services and EFI Runtime Services Tables
   //
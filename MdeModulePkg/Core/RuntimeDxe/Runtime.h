@@ -30,6 +30,10 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/CacheMaintenanceLib.h>
 #include <Library/PeCoffLib.h>
 
+//
+// The Runtime Architectural Protocol instance
+//
+extern EFI_RUNTIME_ARCH_PROTOCOL  mRuntime;
 
 //
 // Function Prototypes
@@ -54,6 +58,29 @@ RuntimeDriverCalculateCrc32 (
   OUT UINT32  *CrcOut
   );
 
+/**
+  Updates a CRC32 with a buffer using the PCLMULQDQ instruction.
+
+  This function is only available on x64, and only on processors that report
+  PCLMULQDQ support in CPUID. It uses XMM0 to XMM5. Crc is the running CRC
+  register, without the initial and final inversions.
+
+  @param  Buffer  The pointer to the data. It does not need to be aligned.
+  @param  Length  The number of bytes of data. It must be a multiple of 16,
+                  and at least 64.
+  @param  Crc     The CRC register before Buffer.
+
+  @return The CRC register after Buffer.
+
+**/
+UINT32
+EFIAPI
+RuntimeDriverCrc32Pclmul (
+  IN  CONST VOID  *Buffer,
+  IN  UINTN       Length,
+  IN  UINT32      Crc
+  );
+
 /**
   Determines the new virtual address that is to be used on subsequent memory accesses.
 
@@ -103,15 +130,6 @@ RuntimeDriverSetVirtualAddressMap (
   IN EFI_MEMORY_DESCRIPTOR  *VirtualMap
   );
 
-/**
-  Initialize CRC32 table.
-
-**/
-VOID
-RuntimeDriverInitializeCrc32Table (
-  VOID
-  );
-
 /**
   Install Runtime AP. This code includes the EfiRuntimeLib, but it only
   functions at RT in physical mode.
@@ -0,0 +1,163 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   Crc32Pclmul.asm
+;
+; Abstract:
+;
+;   RuntimeDriverCrc32Pclmul function
+;
+; Notes:
+;
+;   The buffer is folded into 4 128-bit accumulators by carry-less
+;   multiplication with x^(512+64) and x^512 mod P, then into 1 with x^(128+64)
+;   and x^128 mod P, and reduced to 32 bits with a Barrett reduction. All of
+;   the constants are bit-reflected, for the reflected CRC32 polynomial.
+;
+;------------------------------------------------------------------------------
+
+    .const
+
+ALIGN 16
+Crc32K1K2       DQ  00000000154442bd4h, 000000001c6e41596h
+Crc32K3K4       DQ  000000001751997d0h, 000000000ccaa009eh
+Crc32K5         DQ  00000000163cd6124h, 00000000000000000h
+Crc32Mask32     DQ  000000000ffffffffh, 00000000000000000h
+Crc32PolyMu     DQ  000000001db710641h, 000000001f7011641h
+
+    .code
+
+;------------------------------------------------------------------------------
+;  UINT32
+;  EFIAPI
+;  RuntimeDriverCrc32Pclmul (
+;    IN   CONST VOID  *Buffer,
+;    IN   UINTN       Length,
+;    IN   UINT32      Crc
+;    )
+;------------------------------------------------------------------------------
+RuntimeDriverCrc32Pclmul PROC
+    movdqu  xmm1, [rcx]
+    movdqu  xmm2, [rcx + 10h]
+    movdqu  xmm3, [rcx + 20h]
+    movdqu  xmm4, [rcx + 30h]
+    movd    xmm0, r8d
+    pxor    xmm1, xmm0                  ; xor Crc into the first 32 bits
+    add     rcx, 40h
+    sub     rdx, 40h
+    cmp     rdx, 40h
+    jb      Crc32Fold128
+
+    movdqa  xmm0, xmmword ptr [Crc32K1K2]
+Crc32Fold512:
+    movdqa  xmm5, xmm1
+    pclmulqdq xmm1, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm1, xmm5
+    movdqu  xmm5, [rcx]
+    pxor    xmm1, xmm5
+
+    movdqa  xmm5, xmm2
+    pclmulqdq xmm2, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm2, xmm5
+    movdqu  xmm5, [rcx + 10h]
+    pxor    xmm2, xmm5
+
+    movdqa  xmm5, xmm3
+    pclmulqdq xmm3, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm3, xmm5
+    movdqu  xmm5, [rcx + 20h]
+    pxor    xmm3, xmm5
+
+    movdqa  xmm5, xmm4
+    pclmulqdq xmm4, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm4, xmm5
+    movdqu  xmm5, [rcx + 30h]
+    pxor    xmm4, xmm5
+
+    add     rcx, 40h
+    sub     rdx, 40h
+    cmp     rdx, 40h
+    jae     Crc32Fold512
+
+Crc32Fold128:
+    movdqa  xmm0, xmmword ptr [Crc32K3K4]
+    movdqa  xmm5, xmm1
+    pclmulqdq xmm1, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm1, xmm5
+    pxor    xmm1, xmm2
+
+    movdqa  xmm5, xmm1
+    pclmulqdq xmm1, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm1, xmm5
+    pxor    xmm1, xmm3
+
+    movdqa  xmm5, xmm1
+    pclmulqdq xmm1, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm1, xmm5
+    pxor    xmm1, xmm4
+
+    test    rdx, rdx
+    jz      Crc32Reduce
+Crc32Fold16:
+    movdqa  xmm5, xmm1
+    pclmulqdq xmm1, xmm0, 00h
+    pclmulqdq xmm5, xmm0, 11h
+    pxor    xmm1, xmm5
+    movdqu  xmm5, [rcx]
+    pxor    xmm1, xmm5
+    add     rcx, 10h
+    sub     rdx, 10h
+    jnz     Crc32Fold16
+
+Crc32Reduce:
+    ;
+    ; Fold 128 bits to 64, which also appends 32 zero bits to the message
+    ;
+    pclmulqdq xmm0, xmm1, 01h
+    psrldq  xmm1, 8
+    pxor    xmm1, xmm0
+
+    ;
+    ; Fold 64 bits to 32
+    ;
+    movdqa  xmm2, xmm1
+    movdqa  xmm0, xmmword ptr [Crc32K5]
+    movdqa  xmm3, xmmword ptr [Crc32Mask32]
+    psrldq  xmm2, 4
+    pand    xmm1, xmm3
+    pclmulqdq xmm1, xmm0, 00h
+    pxor    xmm1, xmm2
+
+    ;
+    ; Barrett reduction to the 32-bit remainder
+    ;
+    movdqa  xmm0, xmmword ptr [Crc32PolyMu]
+    movdqa  xmm2, xmm1
+    pand    xmm1, xmm3
+    pclmulqdq xmm1, xmm0, 10h
+    pand    xmm1, xmm3
+    pclmulqdq xmm1, xmm0, 00h
+    pxor    xmm1, xmm2
+    psrldq  xmm1, 4
+    movd    eax, xmm1
+    ret
+RuntimeDriverCrc32Pclmul ENDP
+
+    END
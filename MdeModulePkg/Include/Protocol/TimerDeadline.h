@@ -0,0 +1,58 @@
+/** @file
+  Timer Deadline Protocol is produced by the EDK II DXE Core. It lets the platform
+  timer driver find out when the next armed timer event expires, so that it can
+  program a one-shot timer interrupt for that time instead of a fixed period.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __TIMER_DEADLINE_H__
+#define __TIMER_DEADLINE_H__
+
+#define EDKII_TIMER_DEADLINE_PROTOCOL_GUID \
+  { \
+    0xf54d19a7, 0xa2dc, 0x482d, { 0x9c, 0xdb, 0x4d, 0xc6, 0x84, 0x4e, 0x10, 0x48 } \
+  }
+
+typedef struct _EDKII_TIMER_DEADLINE_PROTOCOL  EDKII_TIMER_DEADLINE_PROTOCOL;
+
+/**
+  Return the time left before the earliest armed timer event expires.
+
+  This function may be called at any TPL, including from the timer interrupt
+  handler registered with EFI_TIMER_ARCH_PROTOCOL.RegisterHandler().
+
+  @param[in]  This          The EDKII_TIMER_DEADLINE_PROTOCOL instance.
+  @param[out] TimeToExpire  The number of 100ns units until the earliest timer
+                            event expires. 0 if it's already due.
+
+  @retval EFI_SUCCESS           TimeToExpire is returned.
+  @retval EFI_INVALID_PARAMETER TimeToExpire is NULL.
+  @retval EFI_NOT_FOUND         No timer event is armed.
+**/
+typedef
+EFI_STATUS
+(EFIAPI * EDKII_TIMER_DEADLINE_PROTOCOL_GET_NEXT_DEADLINE) (
+  IN  CONST EDKII_TIMER_DEADLINE_PROTOCOL *This,
+  OUT       UINT64                        *TimeToExpire
+  );
+
+///
+/// Timer Deadline Protocol lets the platform timer driver query when the next
+/// timer event of the DXE Core expires.
+///
+struct _EDKII_TIMER_DEADLINE_PROTOCOL {
+  EDKII_TIMER_DEADLINE_PROTOCOL_GET_NEXT_DEADLINE GetNextDeadline;
+};
+
+extern EFI_GUID gEdkiiTimerDeadlineProtocolGuid;
+
+#endif
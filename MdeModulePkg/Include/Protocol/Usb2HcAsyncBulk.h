@@ -0,0 +1,135 @@
+/** @file
+  The USB2 host controller asynchronous bulk protocol is an EDK II-specific
+  extension of EFI_USB2_HC_PROTOCOL. It lets a USB bus driver queue several
+  bulk transfers on an endpoint and be called back as each of them completes,
+  instead of waiting for one transfer at a time in BulkTransfer().
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __USB2_HC_ASYNC_BULK_H__
+#define __USB2_HC_ASYNC_BULK_H__
+
+#include <Protocol/Usb2HostController.h>
+
+#define EDKII_USB2_HC_ASYNC_BULK_PROTOCOL_GUID \
+  { \
+    0xe3219c0c, 0x0d07, 0x4c2d, { 0x97, 0xec, 0x22, 0xaf, 0x10, 0x16, 0x19, 0xe5 } \
+  }
+
+typedef struct _EDKII_USB2_HC_ASYNC_BULK_PROTOCOL  EDKII_USB2_HC_ASYNC_BULK_PROTOCOL;
+
+/**
+  Queue a bulk transfer to a bulk endpoint of a USB device and return without
+  waiting for it to complete.
+
+  Transfers queued on the same endpoint are executed in the order they were
+  queued, and their callbacks are invoked in the same order. The host
+  controller maintains the data toggle of the endpoint. The caller must not
+  touch Data until the callback of the transfer has been invoked or the
+  transfer has been cancelled.
+
+  @param[in]  This                The EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param[in]  DeviceAddress       Target device address.
+  @param[in]  EndPointAddress     Endpoint number and its direction in bit 7.
+  @param[in]  DeviceSpeed         Device speed, Low speed device doesn't support
+                                  bulk transfer.
+  @param[in]  MaximumPacketLength Maximum packet size the endpoint is capable of
+                                  sending or receiving.
+  @param[in]  Data                The data buffer of the transfer.
+  @param[in]  DataLength          The length of the data buffer in bytes.
+  @param[in]  Translator          A pointer to the transaction translator data.
+  @param[in]  CallBackFunction    The function called when the transfer completes,
+                                  with the length actually transferred and the
+                                  EFI_USB_ERR_x result of the transfer.
+  @param[in]  Context             The context passed to CallBackFunction.
+
+  @retval EFI_SUCCESS             The transfer is queued.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES    The queue of the endpoint is full, or the
+                                  request could not be allocated.
+  @retval EFI_DEVICE_ERROR        The host controller or the device is in a
+                                  bad state.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_ASYNC_BULK_TRANSFER)(
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress,
+  IN UINT8                               DeviceSpeed,
+  IN UINTN                               MaximumPacketLength,
+  IN VOID                                *Data,
+  IN UINTN                               DataLength,
+  IN EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK     CallBackFunction,
+  IN VOID                                *Context OPTIONAL
+  );
+
+/**
+  Cancel all the bulk transfers queued on an endpoint. The callbacks of the
+  cancelled transfers are not invoked, and their data buffers are returned
+  to the caller.
+
+  @param[in]  This                The EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+  @param[in]  DeviceAddress       Target device address.
+  @param[in]  EndPointAddress     Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS             The transfers of the endpoint are cancelled.
+  @retval EFI_NOT_FOUND           No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR        The endpoint could not be stopped.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_ASYNC_BULK_CANCEL)(
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This,
+  IN UINT8                               DeviceAddress,
+  IN UINT8                               EndPointAddress
+  );
+
+/**
+  Process the completion events the host controller has posted, and invoke
+  the callbacks of the bulk transfers that have completed.
+
+  Completions are also processed from a timer event of the host controller
+  driver. A caller waiting for its transfers may call Poll() to learn of them
+  without waiting for the next timer tick.
+
+  @param[in]  This                The EDKII_USB2_HC_ASYNC_BULK_PROTOCOL instance.
+
+  @retval EFI_SUCCESS             The completion events are processed.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_ASYNC_BULK_POLL)(
+  IN EDKII_USB2_HC_ASYNC_BULK_PROTOCOL   *This
+  );
+
+///
+/// The USB2 host controller asynchronous bulk protocol queues bulk transfers
+/// without waiting for their completion.
+///
+struct _EDKII_USB2_HC_ASYNC_BULK_PROTOCOL {
+  EDKII_USB2_HC_ASYNC_BULK_TRANSFER  AsyncBulkTransfer;
+  EDKII_USB2_HC_ASYNC_BULK_CANCEL    CancelAsyncBulkTransfer;
+  EDKII_USB2_HC_ASYNC_BULK_POLL      Poll;
+  ///
+  /// The maximum number of transfers that may be queued on one endpoint.
+  ///
+  UINTN                              MaxQueueDepth;
+};
+
+extern EFI_GUID gEdkiiUsb2HcAsyncBulkProtocolGuid;
+
+#endif
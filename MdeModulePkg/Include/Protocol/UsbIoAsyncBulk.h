@@ -0,0 +1,119 @@
+/** @file
+  The USB IO asynchronous bulk protocol is an EDK II-specific extension of
+  EFI_USB_IO_PROTOCOL. It is installed by the USB bus driver on the handle of
+  a USB interface whose host controller produces the
+  EDKII_USB2_HC_ASYNC_BULK_PROTOCOL, and lets a class driver keep several bulk
+  transfers outstanding on an endpoint of the interface.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __USB_IO_ASYNC_BULK_H__
+#define __USB_IO_ASYNC_BULK_H__
+
+#include <Protocol/UsbIo.h>
+
+#define EDKII_USB_IO_ASYNC_BULK_PROTOCOL_GUID \
+  { \
+    0x99215c35, 0xdf7b, 0x4a03, { 0xb3, 0x48, 0xae, 0x79, 0xcd, 0xfb, 0x48, 0x05 } \
+  }
+
+typedef struct _EDKII_USB_IO_ASYNC_BULK_PROTOCOL  EDKII_USB_IO_ASYNC_BULK_PROTOCOL;
+
+/**
+  Queue a bulk transfer to a bulk endpoint of the interface and return
+  without waiting for it to complete.
+
+  Transfers queued on the same endpoint are executed, and their callbacks
+  invoked, in the order they were queued. The caller must not touch Data
+  until the callback of the transfer has been invoked or the transfer has
+  been cancelled. A transfer that fails leaves the endpoint halted on the
+  device; the transfers queued behind it complete with EFI_USB_ERR_NOTEXECUTE.
+
+  @param[in]  This                The EDKII_USB_IO_ASYNC_BULK_PROTOCOL instance.
+  @param[in]  DeviceEndpoint      The destination USB device endpoint to which
+                                  the device request is being sent.
+  @param[in]  Data                The data buffer of the transfer.
+  @param[in]  DataLength          The length of the data buffer in bytes.
+  @param[in]  CallBackFunction    The function called when the transfer completes.
+  @param[in]  Context             The context passed to CallBackFunction.
+
+  @retval EFI_SUCCESS             The transfer is queued.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES    The queue of the endpoint is full, or the
+                                  request could not be allocated.
+  @retval EFI_DEVICE_ERROR        The transfer could not be queued.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_ASYNC_BULK_TRANSFER)(
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint,
+  IN VOID                              *Data,
+  IN UINTN                             DataLength,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK   CallBackFunction,
+  IN VOID                              *Context OPTIONAL
+  );
+
+/**
+  Cancel all the bulk transfers queued on an endpoint of the interface. The
+  callbacks of the cancelled transfers are not invoked.
+
+  @param[in]  This                The EDKII_USB_IO_ASYNC_BULK_PROTOCOL instance.
+  @param[in]  DeviceEndpoint      The USB device endpoint.
+
+  @retval EFI_SUCCESS             The transfers of the endpoint are cancelled.
+  @retval EFI_INVALID_PARAMETER   DeviceEndpoint is not a bulk endpoint of the
+                                  interface.
+  @retval EFI_NOT_FOUND           No transfer is queued on the endpoint.
+  @retval EFI_DEVICE_ERROR        The endpoint could not be stopped.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_ASYNC_BULK_CANCEL)(
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This,
+  IN UINT8                             DeviceEndpoint
+  );
+
+/**
+  Process the completions posted by the host controller and invoke the
+  callbacks of the bulk transfers that have completed.
+
+  @param[in]  This                The EDKII_USB_IO_ASYNC_BULK_PROTOCOL instance.
+
+  @retval EFI_SUCCESS             The completions are processed.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_ASYNC_BULK_POLL)(
+  IN EDKII_USB_IO_ASYNC_BULK_PROTOCOL  *This
+  );
+
+///
+/// The USB IO asynchronous bulk protocol queues bulk transfers on the
+/// endpoints of a USB interface without waiting for their completion.
+///
+struct _EDKII_USB_IO_ASYNC_BULK_PROTOCOL {
+  EDKII_USB_IO_ASYNC_BULK_TRANSFER  AsyncBulkTransfer;
+  EDKII_USB_IO_ASYNC_BULK_CANCEL    CancelAsyncBulkTransfer;
+  EDKII_USB_IO_ASYNC_BULK_POLL      Poll;
+  ///
+  /// The maximum number of transfers that may be queued on one endpoint.
+  ///
+  UINTN                             MaxQueueDepth;
+};
+
+extern EFI_GUID gEdkiiUsbIoAsyncBulkProtocolGuid;
+
+#endif
@@ -191,6 +191,11 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  Status = DiskIoCreateCache (Instance);
+  if (EFI_ERROR (Status)) {
+    goto ErrorExit;
+  }
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -219,6 +224,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoDestroyCache (Instance);
       FreePool (Instance);
     }
 
@@ -326,6 +332,7 @@ DiskIoDriverBindingStop (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
       );
+    DiskIoDestroyCache (Instance);
 
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -385,6 +392,28 @@ DiskIoDestroySubtask (
   return Link;
 }
 
+/**
+  Get the number of bytes transferred by the BlockIo request of the sub task.
+
+  It covers all the blocks touched by the sub task, and at least one block.
+
+  @param Subtask      Subtask.
+  @param BlockSize    The block size of the device.
+
+  @return The size in bytes of the BlockIo request.
+**/
+UINTN
+DiskIoSubtaskBlockIoSize (
+  IN DISK_IO_SUBTASK          *Subtask,
+  IN UINT32                   BlockSize
+  )
+{
+  UINTN                    Size;
+
+  Size = ((Subtask->Offset + Subtask->Length + BlockSize - 1) / BlockSize) * BlockSize;
+  return MAX (Size, BlockSize);
+}
+
 /**
   The callback for the BlockIo2 ReadBlocksEx/WriteBlocksEx.
   @param  Event                 Event whose notification function is being invoked.
@@ -418,6 +447,10 @@ DiskIo2OnReadWriteComplete (
     CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
   }
 
+  if (Subtask->Write) {
+    DiskIoCacheWriteComplete ();
+  }
+
   DiskIoDestroySubtask (Instance, Subtask);
 
   if (EFI_ERROR (TransactionStatus) || IsListEmpty (&Task->Subtasks)) {
@@ -569,6 +602,22 @@ DiskIoCreateSubtaskList (
     return TRUE;
   }
 
+  //
+  // A blocking read which is not block aligned, but fits in the shared working buffer,
+  // is done with one BlockIo request covering all its blocks instead of separate
+  // UnderRun, Middle and OverRun requests.
+  //
+  if (Blocking && !Write &&
+      ((UnderRun != 0) || (((UnderRun + BufferSize) % BlockSize) != 0) || (ALIGN_POINTER (BufferPtr, IoAlign) != BufferPtr)) &&
+      (BufferSize <= PcdGet32 (PcdDiskIoDataBufferBlockNum) * BlockSize - UnderRun)) {
+    Subtask = DiskIoCreateSubtask (Write, Lba, UnderRun, BufferSize, SharedWorkingBuffer, BufferPtr, Blocking);
+    if (Subtask == NULL) {
+      goto Done;
+    }
+    InsertTailList (Subtasks, &Subtask->Link);
+    return TRUE;
+  }
+
   if (UnderRun != 0) {
     Length = MIN (BlockSize - UnderRun, BufferSize);
     if (Blocking) {
@@ -865,18 +914,33 @@ DiskIo2ReadWriteDisk (
                             BlockIo,
                             MediaId,
                             Subtask->Lba,
-                            Subtask->Length < Media->BlockSize ? Media->BlockSize : Subtask->Length,
+                            DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize),
                             (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                             );
+        if (!EFI_ERROR (Status)) {
+          DiskIoCacheUpdate (
+            Instance,
+            Subtask->Lba,
+            DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize),
+            (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+            );
+        }
       } else {
+        //
+        // The data reaches the device later, so drop the cached copies now.
+        //
+        DiskIoCacheUpdate (Instance, Subtask->Lba, DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize), NULL);
         Status = BlockIo2->WriteBlocksEx (
                              BlockIo2,
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             Subtask->Length < Media->BlockSize ? Media->BlockSize : Subtask->Length,
+                             DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize),
                              (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                              );
+        if (EFI_ERROR (Status)) {
+          DiskIoCacheWriteComplete ();
+        }
       }
 
     } else {
@@ -884,13 +948,13 @@ DiskIo2ReadWriteDisk (
       // Read
       //
       if (Subtask->Blocking) {
-        Status = BlockIo->ReadBlocks (
-                            BlockIo,
-                            MediaId,
-                            Subtask->Lba,
-                            Subtask->Length < Media->BlockSize ? Media->BlockSize : Subtask->Length,
-                            (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
-                            );
+        Status = DiskIoCacheReadBlocks (
+                   Instance,
+                   MediaId,
+                   Subtask->Lba,
+                   DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize),
+                   (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                   );
         if (!EFI_ERROR (Status) && (Subtask->WorkingBuffer != NULL)) {
           CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
         }
@@ -900,7 +964,7 @@ DiskIo2ReadWriteDisk (
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             Subtask->Length < Media->BlockSize ? Media->BlockSize : Subtask->Length,
+                             DiskIoSubtaskBlockIoSize (Subtask, Media->BlockSize),
                              (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                              );
       }
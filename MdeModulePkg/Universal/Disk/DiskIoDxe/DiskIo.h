@@ -30,6 +30,31 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+#define DISK_IO_CACHE_HASH_SIZE         64
+#define DISK_IO_CACHE_HASH(Lba)         ((UINTN) (Lba) & (DISK_IO_CACHE_HASH_SIZE - 1))
+
+typedef struct {
+  LIST_ENTRY                      Link;     /// < link in the LRU list, most recently used first
+  LIST_ENTRY                      HashLink; /// < link in the hash bucket of Lba
+  EFI_LBA                         Lba;
+  BOOLEAN                         Valid;
+  UINT8                           *Data;
+} DISK_IO_CACHE_ENTRY;
+
+typedef struct {
+  UINT32                          BlockSize;
+  UINT32                          MediaId;    /// < the medium the cached blocks belong to
+  UINT32                          Generation; /// < mDiskIoCacheGeneration when the cache was last known coherent
+  UINTN                           EntryCount;
+  DISK_IO_CACHE_ENTRY             *Entries;
+  UINT8                           *Data;
+  UINTN                           ReadAheadBlockNum;
+  UINT8                           *ReadAheadBuffer;
+  EFI_LBA                         NextLba;    /// < the block following the last read, to detect sequential reads
+  LIST_ENTRY                      LruList;
+  LIST_ENTRY                      HashBuckets[DISK_IO_CACHE_HASH_SIZE];
+} DISK_IO_CACHE;
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                          Signature;
@@ -40,6 +65,7 @@ typedef struct {
   EFI_BLOCK_IO2_PROTOCOL          *BlockIo2;
 
   UINT8                           *SharedWorkingBuffer;
+  DISK_IO_CACHE                   *Cache;     /// < NULL when the block cache is disabled
 
   EFI_LOCK                        TaskQueueLock;
   LIST_ENTRY                      TaskQueue;
@@ -94,6 +120,95 @@ extern EFI_DRIVER_BINDING_PROTOCOL   gDiskIoDriverBinding;
 extern EFI_COMPONENT_NAME_PROTOCOL   gDiskIoComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL  gDiskIoComponentName2;
 
+//
+// Block cache
+//
+/**
+  Create the block cache of the DiskIo instance.
+
+  Nothing is created when PcdDiskIoCacheBlockNum is 0, or when the block size
+  does not keep consecutive blocks aligned to IoAlign.
+
+  @param Instance              Pointer to the DISK_IO_PRIVATE_DATA.
+
+  @retval EFI_SUCCESS          The cache is created, or the cache is disabled.
+  @retval EFI_OUT_OF_RESOURCES There is not enough memory for the cache.
+**/
+EFI_STATUS
+DiskIoCreateCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  );
+
+/**
+  Free the block cache of the DiskIo instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoDestroyCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  );
+
+/**
+  Read blocks from the device through the block cache.
+
+  Cached blocks are copied out, and each run of missing blocks is read with
+  one BlockIo request. When the request continues the previous one and its
+  tail is missing, up to PcdDiskIoReadAheadBlockNum blocks are read ahead.
+  Requests larger than half of the cache bypass it.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      The media ID that the read request is for.
+  @param Lba          The starting logical block address to read from on the device.
+  @param BufferSize   The size of the Buffer in bytes. This must be a multiple of
+                      the intrinsic block size of the device.
+  @param Buffer       A pointer to the destination buffer for the data. It meets
+                      the IoAlign requirement of the device.
+
+  @return The status returned by BlockIo ReadBlocks.
+**/
+EFI_STATUS
+DiskIoCacheReadBlocks (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT32                   MediaId,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  OUT UINT8                   *Buffer
+  );
+
+/**
+  Keep the block cache coherent with a write to the device.
+
+  The cached copies of the written blocks are refreshed from Buffer, or dropped
+  when Buffer is NULL, which is used for non-blocking writes whose data only
+  reaches the device later. Such a write must be followed by a call to
+  DiskIoCacheWriteComplete (). The caches of the other DiskIo instances are
+  dropped on their next use.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The starting logical block address written on the device.
+  @param BufferSize   The size in bytes written to the device.
+  @param Buffer       The data written to the device, or NULL.
+**/
+VOID
+DiskIoCacheUpdate (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  IN UINT8                    *Buffer       OPTIONAL
+  );
+
+/**
+  Note the completion of a non-blocking write announced to DiskIoCacheUpdate ().
+
+  The caches of all the DiskIo instances are dropped on their next use, as they
+  may have been filled with the blocks the write has just overwritten.
+**/
+VOID
+DiskIoCacheWriteComplete (
+  VOID
+  );
+
 //
 // Prototypes
 // Driver model protocol interface
@@ -0,0 +1,460 @@
+/** @file
+  Block cache of the DiskIo driver.
+
+  The cache keeps recently read blocks of a device so that the sectors which
+  are read again and again (partition tables, FAT and directory sectors) are
+  served without going to the device. It is write-through: every write still
+  goes to the device and only refreshes or drops the cached copies, so no
+  data is ever lost because of the cache.
+
+  The cache is coherent with the writes issued through any DiskIo instance of
+  this driver: a global generation counter is bumped on every write, and an
+  instance whose cache was built under an older generation drops it. No cache
+  is filled while a non-blocking write is in flight on any instance. Writes
+  which bypass DiskIo by going to BlockIo directly are not seen, so the cache
+  is disabled (PcdDiskIoCacheBlockNum = 0) unless the platform opts in.
+  Removable media are never cached, as a media change is only noticed by
+  BlockIo.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DiskIo.h"
+
+//
+// Bumped by every write issued through any DiskIo instance.
+//
+UINT32  mDiskIoCacheGeneration = 0;
+
+//
+// Number of non-blocking writes in flight on all DiskIo instances.
+//
+UINT32  mDiskIoCacheWriteCount = 0;
+
+/**
+  Create the block cache of the DiskIo instance.
+
+  Nothing is created when PcdDiskIoCacheBlockNum is 0, when the media is
+  removable, or when the block size does not keep consecutive blocks aligned
+  to IoAlign.
+
+  @param Instance              Pointer to the DISK_IO_PRIVATE_DATA.
+
+  @retval EFI_SUCCESS          The cache is created, or the cache is disabled.
+  @retval EFI_OUT_OF_RESOURCES There is not enough memory for the cache.
+**/
+EFI_STATUS
+DiskIoCreateCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  DISK_IO_CACHE               *Cache;
+  EFI_BLOCK_IO_MEDIA          *Media;
+  UINT32                      IoAlign;
+  UINTN                       Index;
+
+  Instance->Cache = NULL;
+
+  Media   = Instance->BlockIo->Media;
+  IoAlign = MAX (Media->IoAlign, 1);
+  if ((PcdGet32 (PcdDiskIoCacheBlockNum) == 0) || Media->RemovableMedia ||
+      (Media->BlockSize == 0) || ((Media->BlockSize % IoAlign) != 0)) {
+    return EFI_SUCCESS;
+  }
+
+  Cache = AllocateZeroPool (sizeof (DISK_IO_CACHE));
+  if (Cache == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Cache->BlockSize         = Media->BlockSize;
+  Cache->EntryCount        = PcdGet32 (PcdDiskIoCacheBlockNum);
+  Cache->ReadAheadBlockNum = MIN (PcdGet32 (PcdDiskIoReadAheadBlockNum), Cache->EntryCount / 2);
+  Cache->MediaId           = Media->MediaId;
+  Cache->Generation        = mDiskIoCacheGeneration;
+
+  Cache->Entries = AllocateZeroPool (Cache->EntryCount * sizeof (DISK_IO_CACHE_ENTRY));
+  Cache->Data    = AllocateAlignedPages (EFI_SIZE_TO_PAGES (Cache->EntryCount * Cache->BlockSize), IoAlign);
+  if (Cache->ReadAheadBlockNum > 1) {
+    Cache->ReadAheadBuffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (Cache->ReadAheadBlockNum * Cache->BlockSize), IoAlign);
+  }
+  if ((Cache->Entries == NULL) || (Cache->Data == NULL) ||
+      ((Cache->ReadAheadBlockNum > 1) && (Cache->ReadAheadBuffer == NULL))) {
+    Instance->Cache = Cache;
+    DiskIoDestroyCache (Instance);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  InitializeListHead (&Cache->LruList);
+  for (Index = 0; Index < DISK_IO_CACHE_HASH_SIZE; Index++) {
+    InitializeListHead (&Cache->HashBuckets[Index]);
+  }
+  for (Index = 0; Index < Cache->EntryCount; Index++) {
+    Cache->Entries[Index].Data = Cache->Data + Index * Cache->BlockSize;
+    InsertTailList (&Cache->LruList, &Cache->Entries[Index].Link);
+    InitializeListHead (&Cache->Entries[Index].HashLink);
+  }
+
+  Instance->Cache = Cache;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the block cache of the DiskIo instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoDestroyCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  DISK_IO_CACHE               *Cache;
+
+  Cache = Instance->Cache;
+  if (Cache == NULL) {
+    return;
+  }
+
+  if (Cache->ReadAheadBuffer != NULL) {
+    FreeAlignedPages (Cache->ReadAheadBuffer, EFI_SIZE_TO_PAGES (Cache->ReadAheadBlockNum * Cache->BlockSize));
+  }
+  if (Cache->Data != NULL) {
+    FreeAlignedPages (Cache->Data, EFI_SIZE_TO_PAGES (Cache->EntryCount * Cache->BlockSize));
+  }
+  if (Cache->Entries != NULL) {
+    FreePool (Cache->Entries);
+  }
+  FreePool (Cache);
+  Instance->Cache = NULL;
+}
+
+/**
+  Drop one cached block.
+
+  The entry is moved to the tail of the LRU list so that it is reused first.
+
+  @param Cache        Pointer to the DISK_IO_CACHE.
+  @param Entry        The entry to drop.
+**/
+VOID
+DiskIoCacheDropEntry (
+  IN DISK_IO_CACHE            *Cache,
+  IN DISK_IO_CACHE_ENTRY      *Entry
+  )
+{
+  if (Entry->Valid) {
+    Entry->Valid = FALSE;
+    RemoveEntryList (&Entry->HashLink);
+    InitializeListHead (&Entry->HashLink);
+  }
+  RemoveEntryList (&Entry->Link);
+  InsertTailList (&Cache->LruList, &Entry->Link);
+}
+
+/**
+  Drop all the cached blocks.
+
+  @param Cache        Pointer to the DISK_IO_CACHE.
+**/
+VOID
+DiskIoCacheFlush (
+  IN DISK_IO_CACHE            *Cache
+  )
+{
+  UINTN                       Index;
+
+  for (Index = 0; Index < Cache->EntryCount; Index++) {
+    DiskIoCacheDropEntry (Cache, &Cache->Entries[Index]);
+  }
+  Cache->NextLba = 0;
+}
+
+/**
+  Drop the cache when it may no longer describe the medium.
+
+  This happens when the medium is changed or removed, or when a write was
+  issued through another DiskIo instance since the cache was filled.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheValidate (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  DISK_IO_CACHE               *Cache;
+  EFI_BLOCK_IO_MEDIA          *Media;
+
+  Cache = Instance->Cache;
+  Media = Instance->BlockIo->Media;
+  if ((Cache->MediaId != Media->MediaId) || !Media->MediaPresent ||
+      (Cache->BlockSize != Media->BlockSize) || (Cache->Generation != mDiskIoCacheGeneration)) {
+    DiskIoCacheFlush (Cache);
+    Cache->MediaId    = Media->MediaId;
+    Cache->Generation = mDiskIoCacheGeneration;
+  }
+}
+
+/**
+  Find the cached copy of a block.
+
+  @param Cache        Pointer to the DISK_IO_CACHE.
+  @param Lba          The block to look up.
+
+  @return The cache entry of the block, or NULL if the block is not cached.
+**/
+DISK_IO_CACHE_ENTRY *
+DiskIoCacheLookup (
+  IN DISK_IO_CACHE            *Cache,
+  IN EFI_LBA                  Lba
+  )
+{
+  LIST_ENTRY                  *Bucket;
+  LIST_ENTRY                  *Link;
+  DISK_IO_CACHE_ENTRY         *Entry;
+
+  Bucket = &Cache->HashBuckets[DISK_IO_CACHE_HASH (Lba)];
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    Entry = BASE_CR (Link, DISK_IO_CACHE_ENTRY, HashLink);
+    if (Entry->Lba == Lba) {
+      return Entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Put the blocks of a buffer into the cache, reusing the least recently used
+  entries.
+
+  @param Cache        Pointer to the DISK_IO_CACHE.
+  @param Lba          The first block held by Buffer.
+  @param BlockNum     The number of blocks held by Buffer.
+  @param Buffer       The data of the blocks.
+**/
+VOID
+DiskIoCacheInsert (
+  IN DISK_IO_CACHE            *Cache,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BlockNum,
+  IN UINT8                    *Buffer
+  )
+{
+  UINTN                       Index;
+  DISK_IO_CACHE_ENTRY         *Entry;
+
+  for (Index = 0; Index < BlockNum; Index++) {
+    Entry = DiskIoCacheLookup (Cache, Lba + Index);
+    if (Entry == NULL) {
+      Entry = BASE_CR (GetPreviousNode (&Cache->LruList, &Cache->LruList), DISK_IO_CACHE_ENTRY, Link);
+      DiskIoCacheDropEntry (Cache, Entry);
+      Entry->Lba   = Lba + Index;
+      Entry->Valid = TRUE;
+      InsertTailList (&Cache->HashBuckets[DISK_IO_CACHE_HASH (Entry->Lba)], &Entry->HashLink);
+    }
+    CopyMem (Entry->Data, Buffer + Index * Cache->BlockSize, Cache->BlockSize);
+    RemoveEntryList (&Entry->Link);
+    InsertHeadList (&Cache->LruList, &Entry->Link);
+  }
+}
+
+/**
+  Read blocks from the device through the block cache.
+
+  Cached blocks are copied out, and each run of missing blocks is read with
+  one BlockIo request. When the request continues the previous one and its
+  tail is missing, up to PcdDiskIoReadAheadBlockNum blocks are read ahead.
+  Requests larger than half of the cache, and requests to removable media,
+  bypass it.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      The media ID that the read request is for.
+  @param Lba          The starting logical block address to read from on the device.
+  @param BufferSize   The size of the Buffer in bytes. This must be a multiple of
+                      the intrinsic block size of the device.
+  @param Buffer       A pointer to the destination buffer for the data. It meets
+                      the IoAlign requirement of the device.
+
+  @return The status returned by BlockIo ReadBlocks.
+**/
+EFI_STATUS
+DiskIoCacheReadBlocks (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT32                   MediaId,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  OUT UINT8                   *Buffer
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_BLOCK_IO_PROTOCOL       *BlockIo;
+  DISK_IO_CACHE               *Cache;
+  DISK_IO_CACHE_ENTRY         *Entry;
+  UINTN                       BlockNum;
+  UINTN                       Index;
+  UINTN                       Count;
+  UINTN                       ReadCount;
+  BOOLEAN                     Sequential;
+  BOOLEAN                     Fill;
+
+  BlockIo = Instance->BlockIo;
+  Cache   = Instance->Cache;
+  if ((Cache == NULL) || BlockIo->Media->RemovableMedia ||
+      (BufferSize == 0) || ((BufferSize % Cache->BlockSize) != 0)) {
+    return BlockIo->ReadBlocks (BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  DiskIoCacheValidate (Instance);
+
+  BlockNum = BufferSize / Cache->BlockSize;
+  if (BlockNum > Cache->EntryCount / 2) {
+    Cache->NextLba = Lba + BlockNum;
+    return BlockIo->ReadBlocks (BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  //
+  // Only fill the cache when no non-blocking write is in flight on any
+  // instance, otherwise the blocks read here may be overwritten after being
+  // cached.
+  //
+  Fill = (BOOLEAN) (mDiskIoCacheWriteCount == 0);
+
+  Sequential     = (BOOLEAN) (Lba == Cache->NextLba);
+  Cache->NextLba = Lba + BlockNum;
+
+  for (Index = 0; Index < BlockNum; Index += Count) {
+    Entry = DiskIoCacheLookup (Cache, Lba + Index);
+    if (Entry != NULL) {
+      CopyMem (Buffer + Index * Cache->BlockSize, Entry->Data, Cache->BlockSize);
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&Cache->LruList, &Entry->Link);
+      Count = 1;
+      continue;
+    }
+
+    //
+    // Read the whole run of missing blocks with one request.
+    //
+    for (Count = 1; Index + Count < BlockNum; Count++) {
+      if (DiskIoCacheLookup (Cache, Lba + Index + Count) != NULL) {
+        break;
+      }
+    }
+
+    ReadCount = 0;
+    if (Fill && Sequential && (Index + Count == BlockNum) && (Cache->ReadAheadBlockNum > Count) &&
+        (Lba + Index <= BlockIo->Media->LastBlock)) {
+      ReadCount = (UINTN) MIN (Cache->ReadAheadBlockNum, BlockIo->Media->LastBlock - (Lba + Index) + 1);
+    }
+
+    if (ReadCount > Count) {
+      Status = BlockIo->ReadBlocks (
+                          BlockIo,
+                          MediaId,
+                          Lba + Index,
+                          ReadCount * Cache->BlockSize,
+                          Cache->ReadAheadBuffer
+                          );
+      if (!EFI_ERROR (Status)) {
+        CopyMem (Buffer + Index * Cache->BlockSize, Cache->ReadAheadBuffer, Count * Cache->BlockSize);
+        DiskIoCacheInsert (Cache, Lba + Index, ReadCount, Cache->ReadAheadBuffer);
+        continue;
+      }
+    }
+
+    Status = BlockIo->ReadBlocks (
+                        BlockIo,
+                        MediaId,
+                        Lba + Index,
+                        Count * Cache->BlockSize,
+                        Buffer + Index * Cache->BlockSize
+                        );
+    if (EFI_ERROR (Status)) {
+      DiskIoCacheFlush (Cache);
+      return Status;
+    }
+    if (Fill) {
+      DiskIoCacheInsert (Cache, Lba + Index, Count, Buffer + Index * Cache->BlockSize);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Keep the block cache coherent with a write to the device.
+
+  The cached copies of the written blocks are refreshed from Buffer, or dropped
+  when Buffer is NULL, which is used for non-blocking writes whose data only
+  reaches the device later. The caches of the other DiskIo instances are
+  dropped on their next use.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The starting logical block address written on the device.
+  @param BufferSize   The size in bytes written to the device.
+  @param Buffer       The data written to the device, or NULL.
+**/
+VOID
+DiskIoCacheUpdate (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    BufferSize,
+  IN UINT8                    *Buffer       OPTIONAL
+  )
+{
+  DISK_IO_CACHE               *Cache;
+  DISK_IO_CACHE_ENTRY         *Entry;
+  UINT64                      BlockNum;
+  UINTN                       Index;
+
+  mDiskIoCacheGeneration++;
+  if (Buffer == NULL) {
+    mDiskIoCacheWriteCount++;
+  }
+
+  Cache = Instance->Cache;
+  if (Cache == NULL) {
+    return;
+  }
+
+  DiskIoCacheValidate (Instance);
+  Cache->Generation = mDiskIoCacheGeneration;
+
+  BlockNum = (BufferSize + Cache->BlockSize - 1) / Cache->BlockSize;
+  for (Index = 0; Index < Cache->EntryCount; Index++) {
+    Entry = &Cache->Entries[Index];
+    if (!Entry->Valid || (Entry->Lba < Lba) || (Entry->Lba - Lba >= BlockNum)) {
+      continue;
+    }
+    if ((Buffer != NULL) && ((Entry->Lba - Lba + 1) * Cache->BlockSize <= BufferSize)) {
+      CopyMem (Entry->Data, Buffer + (UINTN) (Entry->Lba - Lba) * Cache->BlockSize, Cache->BlockSize);
+    } else {
+      DiskIoCacheDropEntry (Cache, Entry);
+    }
+  }
+}
+
+/**
+  Note the completion of a non-blocking write announced to DiskIoCacheUpdate ().
+
+  The caches of all the DiskIo instances are dropped on their next use, as they
+  may have been filled with the blocks the write has just overwritten.
+**/
+VOID
+DiskIoCacheWriteComplete (
+  VOID
+  )
+{
+  ASSERT (mDiskIoCacheWriteCount != 0);
+  mDiskIoCacheWriteCount--;
+  mDiskIoCacheGeneration++;
+}
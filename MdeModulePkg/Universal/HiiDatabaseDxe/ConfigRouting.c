@@ -55,147 +55,258 @@ CalculateConfigStringLen (
 
 
 /**
-  Convert the hex UNICODE %02x encoding of a UEFI device path to binary
-  from <PathHdr> of <ConfigHdr>.
+  Converts the unicode character of the string from uppercase to lowercase.
+  This is a internal function.
+
+  @param ConfigString  String to be converted
+
+**/
+VOID
+EFIAPI
+HiiToLower (
+  IN EFI_STRING  ConfigString
+  )
+{
+  EFI_STRING  String;
+  BOOLEAN     Lower;
+
+  ASSERT (ConfigString != NULL);
+
+  //
+  // Convert all hex digits in range [A-F] in the configuration header to [a-f]
+  //
+  for (String = ConfigString, Lower = FALSE; *String != L'\0'; String++) {
+    if (*String == L'=') {
+      Lower = TRUE;
+    } else if (*String == L'&') {
+      Lower = FALSE;
+    } else if (Lower && *String >= L'A' && *String <= L'F') {
+      *String = (CHAR16) (*String - L'A' + L'a');
+    }
+  }
+
+  return;
+}
+
+/**
+  Convert hex digits to a byte buffer. Each two digits form one byte, in the
+  same order as the bytes reside in memory.
 
   This is a internal function.
 
-  @param  String                 UEFI configuration string
-  @param  DevicePathData         Binary of a UEFI device path.
+  @param  String                 Points to the first hex digit.
+  @param  Length                 Number of hex digits, an even number.
+  @param  Buffer                 The output buffer of Length / 2 bytes.
 
-  @retval EFI_NOT_FOUND          The device path is not invalid.
-  @retval EFI_INVALID_PARAMETER  Any incoming parameter is invalid.
-  @retval EFI_OUT_OF_RESOURCES   Lake of resources to store neccesary structures.
-  @retval EFI_SUCCESS            The device path is retrieved and translated to
-                                 binary format.
+  @retval EFI_INVALID_PARAMETER  A character is not a hex digit.
+  @retval EFI_SUCCESS            The hex digits are converted.
 
 **/
 EFI_STATUS
-GetDevicePath (
+HexStringToBuffer (
   IN  EFI_STRING                   String,
-  OUT UINT8                        **DevicePathData
+  IN  UINTN                        Length,
+  OUT UINT8                        *Buffer
   )
 {
-  UINTN                    Length;
-  EFI_STRING               PathHdr;
-  UINT8                    *DevicePathBuffer;
-  CHAR16                   TemStr[2];
   UINTN                    Index;
+  CHAR16                   Digit;
   UINT8                    DigitUint8;
+
+  for (Index = 0; Index < Length; Index ++) {
+    Digit = String[Index];
+    if (Digit >= L'0' && Digit <= L'9') {
+      DigitUint8 = (UINT8) (Digit - L'0');
+    } else if (Digit >= L'a' && Digit <= L'f') {
+      DigitUint8 = (UINT8) (Digit - L'a' + 10);
+    } else if (Digit >= L'A' && Digit <= L'F') {
+      DigitUint8 = (UINT8) (Digit - L'A' + 10);
+    } else {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if ((Index & 1) == 0) {
+      Buffer [Index/2] = (UINT8) (DigitUint8 << 4);
+    } else {
+      Buffer [Index/2] = (UINT8) (Buffer [Index/2] + DigitUint8);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the buffers of a parsed <ConfigHdr> and clear it.
+
+  This is a internal function.
+
+  @param  ConfigHdr              The parsed <ConfigHdr>.
+
+**/
+VOID
+FreeConfigHdr (
+  IN OUT HII_CONFIG_HDR            *ConfigHdr
+  )
+{
+  if (ConfigHdr->Header != NULL) {
+    FreePool (ConfigHdr->Header);
+  }
+
+  if (ConfigHdr->Name != NULL) {
+    FreePool (ConfigHdr->Name);
+  }
+
+  if (ConfigHdr->DevicePath != NULL) {
+    FreePool (ConfigHdr->DevicePath);
+  }
+
+  ZeroMem (ConfigHdr, sizeof (HII_CONFIG_HDR));
+}
+
+/**
+  Parse the <ConfigHdr> "GUID=...&NAME=...&PATH=..." at the beginning of a
+  <ConfigRequest> or <ConfigResp>. The GUID, NAME and PATH values are decoded
+  once, so that matching the string against the varstores and the device
+  paths in the database compares binary values.
+
+  This is a internal function.
+
+  @param  String                 String in <ConfigRequest> or <ConfigResp>
+                                 format.
+  @param  ConfigHdr              The parsed <ConfigHdr>. Caller takes the
+                                 responsibility to free it by FreeConfigHdr().
+
+  @retval EFI_INVALID_PARAMETER  The <ConfigHdr> is malformed.
+  @retval EFI_NOT_FOUND          The device path is invalid.
+  @retval EFI_OUT_OF_RESOURCES   Insufficient resources to store the result.
+  @retval EFI_SUCCESS            The <ConfigHdr> is parsed.
+
+**/
+EFI_STATUS
+ParseConfigHdr (
+  IN  EFI_STRING                   String,
+  OUT HII_CONFIG_HDR               *ConfigHdr
+  )
+{
+  EFI_STATUS               Status;
+  EFI_STRING               GuidHdr;
+  EFI_STRING               NameHdr;
+  EFI_STRING               PathHdr;
+  UINTN                    GuidLength;
+  UINTN                    NameLength;
+  UINTN                    PathLength;
+  UINTN                    Index;
+  UINT8                    NameChar[2];
   EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  UINTN                    RemainingSize;
 
+  ZeroMem (ConfigHdr, sizeof (HII_CONFIG_HDR));
 
-  if (String == NULL || DevicePathData == NULL) {
+  if (String == NULL || StrnCmp (String, L"GUID=", StrLen (L"GUID=")) != 0) {
     return EFI_INVALID_PARAMETER;
   }
 
   //
-  // Find the 'PATH=' of <PathHdr> and skip it.
+  // Locate the values of GUID, NAME and PATH, in that order.
   //
-  for (; (*String != 0 && StrnCmp (String, L"PATH=", StrLen (L"PATH=")) != 0); String++);
-  if (*String == 0) {
+  GuidHdr = String + StrLen (L"GUID=");
+  for (GuidLength = 0; GuidHdr[GuidLength] != L'\0' && GuidHdr[GuidLength] != L'&'; GuidLength++);
+  if (StrnCmp (GuidHdr + GuidLength, L"&NAME=", StrLen (L"&NAME=")) != 0) {
     return EFI_INVALID_PARAMETER;
   }
-  //
-  // Check whether path data does exist.
-  //
-  String += StrLen (L"PATH=");
-  if (*String == 0) {
+
+  NameHdr = GuidHdr + GuidLength + StrLen (L"&NAME=");
+  for (NameLength = 0; NameHdr[NameLength] != L'\0' && NameHdr[NameLength] != L'&'; NameLength++);
+  if (StrnCmp (NameHdr + NameLength, L"&PATH=", StrLen (L"&PATH=")) != 0) {
     return EFI_INVALID_PARAMETER;
   }
-  PathHdr = String;
+
+  PathHdr = NameHdr + NameLength + StrLen (L"&PATH=");
+  for (PathLength = 0; PathHdr[PathLength] != L'\0' && PathHdr[PathLength] != L'&'; PathLength++);
 
   //
-  // The content between 'PATH=' of <ConfigHdr> and '&' of next element
-  // or '\0' (end of configuration string) is the UNICODE %02x bytes encoding
-  // of UEFI device path.
-  //
-  for (Length = 0; *String != 0 && *String != L'&'; String++, Length++);
-  //
-  // Check DevicePath Length
+  // GUID is the hex bytes of the GUID, NAME has four hex digits per
+  // character and PATH is the hex bytes of the device path.
   //
-  if (((Length + 1) / 2) < sizeof (EFI_DEVICE_PATH_PROTOCOL)) {
-    return EFI_NOT_FOUND;
+  if ((GuidLength != sizeof (EFI_GUID) * 2) || ((NameLength % 4) != 0) ||
+      (PathLength == 0) || ((PathLength % 2) != 0)) {
+    return EFI_INVALID_PARAMETER;
   }
-  
-  //
-  // The data in <PathHdr> is encoded as hex UNICODE %02x bytes in the same order
-  // as the device path resides in RAM memory.
-  // Translate the data into binary.
-  //
-  DevicePathBuffer = (UINT8 *) AllocateZeroPool ((Length + 1) / 2);
-  if (DevicePathBuffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+
+  Status = HexStringToBuffer (GuidHdr, GuidLength, (UINT8 *) &ConfigHdr->Guid);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  
-  //
-  // Convert DevicePath
-  //
-  ZeroMem (TemStr, sizeof (TemStr));
-  for (Index = 0; Index < Length; Index ++) {
-    TemStr[0] = PathHdr[Index];
-    DigitUint8 = (UINT8) StrHexToUint64 (TemStr);
-    if ((Index & 1) == 0) {
-      DevicePathBuffer [Index/2] = DigitUint8;
-    } else {
-      DevicePathBuffer [Index/2] = (UINT8) ((DevicePathBuffer [Index/2] << 4) + DigitUint8);
+
+  ConfigHdr->Name = AllocateZeroPool ((NameLength / 4 + 1) * sizeof (CHAR16));
+  if (ConfigHdr->Name == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+  for (Index = 0; Index < NameLength / 4; Index++) {
+    Status = HexStringToBuffer (NameHdr + Index * 4, 4, NameChar);
+    if (EFI_ERROR (Status)) {
+      goto Done;
     }
+    ConfigHdr->Name[Index] = (CHAR16) ((NameChar[0] << 8) | NameChar[1]);
   }
-  
+
+  if ((PathLength / 2) < sizeof (EFI_DEVICE_PATH_PROTOCOL)) {
+    Status = EFI_NOT_FOUND;
+    goto Done;
+  }
+  ConfigHdr->DevicePath = AllocatePool (PathLength / 2);
+  if (ConfigHdr->DevicePath == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+  Status = HexStringToBuffer (PathHdr, PathLength, (UINT8 *) ConfigHdr->DevicePath);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
   //
-  // Validate DevicePath
+  // Validate the device path, no node may run past the decoded bytes.
   //
-  DevicePath  = (EFI_DEVICE_PATH_PROTOCOL *) DevicePathBuffer;
-  while (!IsDevicePathEnd (DevicePath)) {
-    if ((DevicePath->Type == 0) || (DevicePath->SubType == 0) || (DevicePathNodeLength (DevicePath) < sizeof (EFI_DEVICE_PATH_PROTOCOL))) {
-      //
-      // Invalid device path
-      //
-      FreePool (DevicePathBuffer);
-      return EFI_NOT_FOUND;
+  DevicePath    = ConfigHdr->DevicePath;
+  RemainingSize = PathLength / 2;
+  while (TRUE) {
+    if ((RemainingSize < sizeof (EFI_DEVICE_PATH_PROTOCOL)) ||
+        (DevicePathNodeLength (DevicePath) < sizeof (EFI_DEVICE_PATH_PROTOCOL)) ||
+        (DevicePathNodeLength (DevicePath) > RemainingSize)) {
+      Status = EFI_NOT_FOUND;
+      goto Done;
     }
-    DevicePath = NextDevicePathNode (DevicePath);
+    if (IsDevicePathEnd (DevicePath)) {
+      break;
+    }
+    if ((DevicePath->Type == 0) || (DevicePath->SubType == 0)) {
+      Status = EFI_NOT_FOUND;
+      goto Done;
+    }
+    RemainingSize -= DevicePathNodeLength (DevicePath);
+    DevicePath     = NextDevicePathNode (DevicePath);
   }
+  ConfigHdr->DevicePathSize = PathLength / 2 - RemainingSize + DevicePathNodeLength (DevicePath);
 
   //
-  // return the device path
+  // Keep a copy of the <ConfigHdr> in the lowercase form used in <AltResp>.
   //
-  *DevicePathData = DevicePathBuffer;
-  return EFI_SUCCESS;
-}
-
-/**
-  Converts the unicode character of the string from uppercase to lowercase.
-  This is a internal function.
-
-  @param ConfigString  String to be converted
-
-**/
-VOID
-EFIAPI
-HiiToLower (
-  IN EFI_STRING  ConfigString
-  )
-{
-  EFI_STRING  String;
-  BOOLEAN     Lower;
-
-  ASSERT (ConfigString != NULL);
+  ConfigHdr->Length = PathHdr + PathLength - String;
+  ConfigHdr->Header = AllocateCopyPool ((ConfigHdr->Length + 1) * sizeof (CHAR16), String);
+  if (ConfigHdr->Header == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+  ConfigHdr->Header[ConfigHdr->Length] = L'\0';
+  HiiToLower (ConfigHdr->Header);
 
-  //
-  // Convert all hex digits in range [A-F] in the configuration header to [a-f]
-  //
-  for (String = ConfigString, Lower = FALSE; *String != L'\0'; String++) {
-    if (*String == L'=') {
-      Lower = TRUE;
-    } else if (*String == L'&') {
-      Lower = FALSE;
-    } else if (Lower && *String >= L'A' && *String <= L'F') {
-      *String = (CHAR16) (*String - L'A' + L'a');
-    }
+Done:
+  if (EFI_ERROR (Status)) {
+    FreeConfigHdr (ConfigHdr);
   }
 
-  return;
+  return Status;
 }
 
 /**
@@ -376,8 +487,9 @@ OutputConfigBody (
   @param  MultiString            String in <MultiConfigRequest>,
                                  <MultiConfigAltResp>, or <MultiConfigResp>. On
                                  input, the buffer length of  this string is
-                                 MAX_STRING_LENGTH. On output, the  buffer length
-                                 might be updated.
+                                 MAX_STRING_LENGTH, or has been enlarged by this
+                                 function. On output, the  buffer length might be
+                                 doubled.
   @param  AppendString           NULL-terminated Unicode string.
 
   @retval EFI_INVALID_PARAMETER  Any incoming parameter is invalid.
@@ -392,6 +504,8 @@ AppendToMultiString (
 {
   UINTN AppendStringSize;
   UINTN MultiStringSize;
+  UINTN BufferSize;
+  UINTN NewBufferSize;
 
   if (MultiString == NULL || *MultiString == NULL || AppendString == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -401,13 +515,22 @@ AppendToMultiString (
   MultiStringSize  = StrSize (*MultiString);
 
   //
-  // Enlarge the buffer each time when length exceeds MAX_STRING_LENGTH.
+  // The buffer starts with MAX_STRING_LENGTH and is doubled each time when
+  // the length exceeds it, so the buffer size follows from the string size.
   //
-  if (MultiStringSize + AppendStringSize > MAX_STRING_LENGTH ||
-      MultiStringSize > MAX_STRING_LENGTH) {
+  BufferSize = MAX_STRING_LENGTH;
+  while (BufferSize < MultiStringSize) {
+    BufferSize *= 2;
+  }
+
+  if (MultiStringSize + AppendStringSize - sizeof (CHAR16) > BufferSize) {
+    NewBufferSize = BufferSize;
+    while (NewBufferSize < MultiStringSize + AppendStringSize - sizeof (CHAR16)) {
+      NewBufferSize *= 2;
+    }
     *MultiString = (EFI_STRING) ReallocatePool (
                                   MultiStringSize,
-                                  MultiStringSize + AppendStringSize,
+                                  NewBufferSize,
                                   (VOID *) (*MultiString)
                                   );
     ASSERT (*MultiString != NULL);
@@ -415,93 +538,220 @@ AppendToMultiString (
   //
   // Append the incoming string
   //
-  StrCat (*MultiString, AppendString);
+  CopyMem (
+    (UINT8 *) (*MultiString) + MultiStringSize - sizeof (CHAR16),
+    AppendString,
+    AppendStringSize
+    );
 
   return EFI_SUCCESS;
 }
 
 
 /**
-  Get the value of <Number> in <BlockConfig> format, i.e. the value of OFFSET
-  or WIDTH or VALUE.
-  <BlockConfig> ::= 'OFFSET='<Number>&'WIDTH='<Number>&'VALUE'=<Number>
+  Convert the hex digits of a <Number> in <BlockConfig> format to a byte
+  buffer. The last digit is the low nibble of the first byte, digits that
+  do not fit in the buffer are ignored and missing digits are zero.
+
+  This is a internal function.
+
+  @param  Number                 Points to the first character of <Number>.
+  @param  Length                 Length of the <Number>, in characters.
+  @param  Buffer                 The output buffer.
+  @param  BufferSize             The size of Buffer, in bytes.
+
+**/
+VOID
+NumberToBuffer (
+  IN  EFI_STRING                   Number,
+  IN  UINTN                        Length,
+  OUT UINT8                        *Buffer,
+  IN  UINTN                        BufferSize
+  )
+{
+  UINTN                    Index;
+  CHAR16                   Digit;
+  UINT8                    DigitUint8;
+
+  ZeroMem (Buffer, BufferSize);
+
+  for (Index = 0; Index < Length && Index / 2 < BufferSize; Index ++) {
+    Digit = Number[Length - Index - 1];
+    if (Digit >= L'0' && Digit <= L'9') {
+      DigitUint8 = (UINT8) (Digit - L'0');
+    } else if (Digit >= L'a' && Digit <= L'f') {
+      DigitUint8 = (UINT8) (Digit - L'a' + 10);
+    } else if (Digit >= L'A' && Digit <= L'F') {
+      DigitUint8 = (UINT8) (Digit - L'A' + 10);
+    } else {
+      DigitUint8 = 0;
+    }
+
+    if ((Index & 1) == 0) {
+      Buffer [Index/2] = DigitUint8;
+    } else {
+      Buffer [Index/2] = (UINT8) ((DigitUint8 << 4) + Buffer [Index/2]);
+    }
+  }
+}
+
+/**
+  Get the value of <Number> in <BlockConfig> format as an UINTN, i.e. the
+  value of OFFSET or WIDTH. Only the low order bytes that fit in an UINTN
+  are kept.
 
   This is a internal function.
 
   @param  StringPtr              String in <BlockConfig> format and points to the
                                  first character of <Number>.
-  @param  Number                 The output value. Caller takes the responsibility
-                                 to free memory.
+  @param  Number                 The output value.
   @param  Len                    Length of the <Number>, in characters.
 
-  @retval EFI_OUT_OF_RESOURCES   Insufficient resources to store neccessary
-                                 structures.
+  @retval EFI_INVALID_PARAMETER  StringPtr points to the end of the string.
   @retval EFI_SUCCESS            Value of <Number> is outputted in Number
                                  successfully.
 
 **/
 EFI_STATUS
-GetValueOfNumber (
+GetUintnOfNumber (
   IN EFI_STRING                    StringPtr,
-  OUT UINT8                        **Number,
+  OUT UINTN                        *Number,
   OUT UINTN                        *Len
   )
 {
   EFI_STRING               TmpPtr;
-  UINTN                    Length;
-  EFI_STRING               Str;
-  UINT8                    *Buf;
-  EFI_STATUS               Status;
-  UINT8                    DigitUint8;
-  UINTN                    Index;
-  CHAR16                   TemStr[2];
 
   if (StringPtr == NULL || *StringPtr == L'\0' || Number == NULL || Len == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Buf = NULL;
-
   TmpPtr = StringPtr;
   while (*StringPtr != L'\0' && *StringPtr != L'&') {
     StringPtr++;
   }
-  *Len   = StringPtr - TmpPtr;
-  Length = *Len + 1;
+  *Len = StringPtr - TmpPtr;
 
-  Str = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-  if (Str == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
+  *Number = 0;
+  NumberToBuffer (TmpPtr, *Len, (UINT8 *) Number, sizeof (UINTN));
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Parse the <BlockConfig> or <BlockName> elements of a configuration string
+  into an array, so that the string is scanned only once.
+  <BlockConfig> ::= '&OFFSET='<Number>&'WIDTH='<Number>&'VALUE='<Number>
+  <BlockName>   ::= '&OFFSET='<Number>&'WIDTH='<Number>
+
+  Parsing stops at the end of the string, at the first element that does
+  not start with "&OFFSET=" or at the first malformed element.
+
+  This is a internal function.
+
+  @param  StringPtr              Points to the '&' of the first element.
+  @param  HasValue               TRUE for <BlockConfig>, FALSE for <BlockName>.
+  @param  Elements               The parsed elements. Caller takes the
+                                 responsibility to free memory. NULL if no
+                                 element is parsed.
+  @param  ElementCount           The number of parsed elements.
+  @param  Progress               Points to the character where parsing stopped,
+                                 or to the '&' of the malformed element.
+
+  @retval EFI_OUT_OF_RESOURCES   Insufficient resources to store the elements.
+  @retval EFI_INVALID_PARAMETER  An element is malformed. The elements before
+                                 it are returned.
+  @retval EFI_SUCCESS            The elements are parsed successfully.
+
+**/
+EFI_STATUS
+ParseBlockConfig (
+  IN  EFI_STRING                   StringPtr,
+  IN  BOOLEAN                      HasValue,
+  OUT HII_BLOCK_CONFIG_ELEMENT     **Elements,
+  OUT UINTN                        *ElementCount,
+  OUT EFI_STRING                   *Progress
+  )
+{
+  EFI_STRING                 TmpPtr;
+  HII_BLOCK_CONFIG_ELEMENT   *Element;
+  UINTN                      MaxCount;
+  UINTN                      Length;
+  EFI_STATUS                 Status;
+
+  Element       = NULL;
+  *Elements     = NULL;
+  *ElementCount = 0;
+  *Progress     = StringPtr;
+
+  //
+  // Every element starts with "&OFFSET=", count them to size the array.
+  //
+  MaxCount = 0;
+  for (TmpPtr = StringPtr; *TmpPtr != L'\0'; TmpPtr++) {
+    if (*TmpPtr == L'&' && StrnCmp (TmpPtr, L"&OFFSET=", StrLen (L"&OFFSET=")) == 0) {
+      MaxCount++;
+    }
+  }
+  if (MaxCount == 0) {
+    return EFI_SUCCESS;
   }
-  CopyMem (Str, TmpPtr, *Len * sizeof (CHAR16));
-  *(Str + *Len) = L'\0';
 
-  Length = (Length + 1) / 2;
-  Buf = (UINT8 *) AllocateZeroPool (Length);
-  if (Buf == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
+  *Elements = AllocatePool (MaxCount * sizeof (HII_BLOCK_CONFIG_ELEMENT));
+  if (*Elements == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
-  
-  Length = *Len;
-  ZeroMem (TemStr, sizeof (TemStr));
-  for (Index = 0; Index < Length; Index ++) {
-    TemStr[0] = Str[Length - Index - 1];
-    DigitUint8 = (UINT8) StrHexToUint64 (TemStr);
-    if ((Index & 1) == 0) {
-      Buf [Index/2] = DigitUint8;
-    } else {
-      Buf [Index/2] = (UINT8) ((DigitUint8 << 4) + Buf [Index/2]);
+
+  Status = EFI_SUCCESS;
+  while (*ElementCount < MaxCount && StrnCmp (StringPtr, L"&OFFSET=", StrLen (L"&OFFSET=")) == 0) {
+    Element          = *Elements + *ElementCount;
+    Element->Element = StringPtr;
+    Element->Value   = NULL;
+    Element->ValueLength = 0;
+
+    Status = EFI_INVALID_PARAMETER;
+    StringPtr += StrLen (L"&OFFSET=");
+    if (EFI_ERROR (GetUintnOfNumber (StringPtr, &Element->Offset, &Length))) {
+      break;
+    }
+    StringPtr += Length;
+    if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
+      break;
+    }
+    StringPtr += StrLen (L"&WIDTH=");
+    if (EFI_ERROR (GetUintnOfNumber (StringPtr, &Element->Width, &Length))) {
+      break;
+    }
+    StringPtr += Length;
+
+    if (HasValue) {
+      if (StrnCmp (StringPtr, L"&VALUE=", StrLen (L"&VALUE=")) != 0) {
+        break;
+      }
+      StringPtr += StrLen (L"&VALUE=");
+      if (*StringPtr == L'\0') {
+        break;
+      }
+      Element->Value = StringPtr;
+      while (*StringPtr != L'\0' && *StringPtr != L'&') {
+        StringPtr++;
+      }
+      Element->ValueLength = StringPtr - Element->Value;
     }
+
+    Element->Length = StringPtr - Element->Element;
+    Status = EFI_SUCCESS;
+    (*ElementCount)++;
   }
 
-  *Number = Buf;
-  Status  = EFI_SUCCESS;
+  if (EFI_ERROR (Status)) {
+    *Progress = Element->Element;
+  } else {
+    *Progress = StringPtr;
+  }
 
-Exit:
-  if (Str != NULL) {
-    FreePool (Str);
+  if (*ElementCount == 0) {
+    FreePool (*Elements);
+    *Elements = NULL;
   }
 
   return Status;
@@ -514,6 +764,7 @@ Exit:
   @param  AltCfgResp             Pointer to a null-terminated Unicode string in
                                  <ConfigAltResp> format. The default value string 
                                  will be merged into it. 
+  @param  ConfigHdr              The parsed <ConfigHdr> of AltCfgResp.
   @param  DefaultAltCfgResp      Pointer to a null-terminated Unicode string in
                                  <MultiConfigAltResp> format. The default value 
                                  string may contain more than one ConfigAltResp
@@ -521,12 +772,14 @@ Exit:
 
   @retval EFI_SUCCESS            The merged string returns.
   @retval EFI_INVALID_PARAMETER  *AltCfgResp is to NULL.
+  @retval EFI_INVALID_PARAMETER  ConfigHdr is not parsed.
 **/
 EFI_STATUS
 EFIAPI
 MergeDefaultString (
-  IN OUT EFI_STRING  *AltCfgResp,
-  IN     EFI_STRING  DefaultAltCfgResp
+  IN OUT EFI_STRING      *AltCfgResp,
+  IN     HII_CONFIG_HDR  *ConfigHdr,
+  IN     EFI_STRING      DefaultAltCfgResp
   )
 {
   EFI_STRING   StringPtrDefault;
@@ -537,36 +790,12 @@ MergeDefaultString (
   UINTN        HeaderLength;
   UINTN        SizeAltCfgResp;
   
-  if (*AltCfgResp == NULL) {
+  if (*AltCfgResp == NULL || ConfigHdr->Header == NULL) {
     return EFI_INVALID_PARAMETER;
   }
   
-  //
-  // Get the requestr ConfigHdr
-  //
   SizeAltCfgResp  = 0;
-  StringPtr       = *AltCfgResp;
-  
-  //
-  // Find <ConfigHdr> GUID=...&NAME=...&PATH=...
-  //
-  if (StrnCmp (StringPtr, L"GUID=", StrLen (L"GUID=")) != 0) {
-    return EFI_INVALID_PARAMETER;
-  }
-  while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&NAME=", StrLen (L"&NAME=")) != 0) {
-    StringPtr++;
-  }
-  while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&PATH=", StrLen (L"&PATH=")) != 0) {
-    StringPtr++;
-  }
-  if (*StringPtr == L'\0') {
-    return EFI_INVALID_PARAMETER;
-  }
-  StringPtr += StrLen (L"&PATH=");
-  while (*StringPtr != L'\0' && *StringPtr != L'&') {
-    StringPtr ++;
-  }
-  HeaderLength = StringPtr - *AltCfgResp;
+  HeaderLength    = ConfigHdr->Length;
 
   //
   // Construct AltConfigHdr string  "&<ConfigHdr>&ALTCFG=XXXX\0"
@@ -577,7 +806,7 @@ MergeDefaultString (
     return EFI_OUT_OF_RESOURCES;
   }
   StrCpy (AltConfigHdr, L"&");
-  StrnCat (AltConfigHdr, *AltCfgResp, HeaderLength);
+  StrCat (AltConfigHdr, ConfigHdr->Header);
   StrCat (AltConfigHdr, L"&ALTCFG=");
   HeaderLength = StrLen (AltConfigHdr);
   
@@ -708,6 +937,18 @@ InsertBlockData (
     return;
   }
 
+  //
+  // Block data mostly comes in Offset order. The last block data has the
+  // largest Offset, so append directly when the new Offset is even larger.
+  //
+  if (!IsListEmpty (BlockLink)) {
+    BlockArray = BASE_CR (BlockLink->BackLink, IFR_BLOCK_DATA, Entry);
+    if (BlockArray->Name == NULL && BlockArray->Offset < BlockSingleData->Offset) {
+      InsertTailList (BlockLink, &BlockSingleData->Entry);
+      return;
+    }
+  }
+
   //
   // Insert block data in its Offset and Width order.
   //
@@ -1097,7 +1338,7 @@ GetFormPackageData (
   This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
 
   @param  DataBaseRecord        The DataBaseRecord instance contains the found Hii handle and package.
-  @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
+  @param  ConfigHdr             The parsed request ConfigHdr. If it is NULL,
                                 the first found varstore will be as ConfigHdr.
   @param  IsEfiVarstore         Whether the request storage type is efi varstore type.
   @param  EfiVarStore           The efi varstore info which will return.
@@ -1105,7 +1346,7 @@ GetFormPackageData (
 EFI_STATUS
 GetVarStoreType (
   IN     HII_DATABASE_RECORD        *DataBaseRecord,
-  IN     EFI_STRING                 ConfigHdr,
+  IN     HII_CONFIG_HDR             *ConfigHdr,
   OUT    BOOLEAN                    *IsEfiVarstore,
   OUT    EFI_IFR_VARSTORE_EFI       **EfiVarStore
   )
@@ -1115,21 +1356,13 @@ GetVarStoreType (
   UINTN                    PackageOffset;
   EFI_IFR_OP_HEADER        *IfrOpHdr;
   CHAR16                   *VarStoreName;
-  EFI_STRING               GuidStr;
-  EFI_STRING               NameStr;
-  EFI_STRING               TempStr;
-  UINTN                    LengthString;  
   UINT8                    *HiiFormPackage;
   UINTN                    PackageSize;
   EFI_IFR_VARSTORE_EFI     *IfrEfiVarStore;
   EFI_HII_PACKAGE_HEADER   *PackageHeader;
   
   HiiFormPackage = NULL;
-  LengthString     = 0;
   Status           = EFI_SUCCESS;
-  GuidStr          = NULL;
-  NameStr          = NULL;
-  TempStr          = NULL;
   *IsEfiVarstore   = FALSE;
 
   Status = GetFormPackageData(DataBaseRecord, &HiiFormPackage, &PackageSize);
@@ -1176,27 +1409,11 @@ GetVarStoreType (
       }
       AsciiStrToUnicodeStr ((CHAR8 *) IfrEfiVarStore->Name, VarStoreName);
 
-      GenerateSubStr (L"GUID=", sizeof (EFI_GUID), (VOID *) &IfrEfiVarStore->Guid, 1, &GuidStr);
-      GenerateSubStr (L"NAME=", StrLen (VarStoreName) * sizeof (CHAR16), (VOID *) VarStoreName, 2, &NameStr);
-      LengthString = StrLen (GuidStr);
-      LengthString = LengthString + StrLen (NameStr) + 1;
-      TempStr = AllocateZeroPool (LengthString * sizeof (CHAR16));
-      if (TempStr == NULL) {
-        FreePool (GuidStr);
-        FreePool (NameStr);
-        FreePool (VarStoreName);
-        Status = EFI_OUT_OF_RESOURCES;
-        goto Done;
-      }
-      StrCpy (TempStr, GuidStr);
-      StrCat (TempStr, NameStr);
-      if (ConfigHdr == NULL || StrnCmp (ConfigHdr, TempStr, StrLen (TempStr)) == 0) {
+      if (ConfigHdr == NULL ||
+          (CompareGuid (&IfrEfiVarStore->Guid, &ConfigHdr->Guid) && StrCmp (VarStoreName, ConfigHdr->Name) == 0)) {
         *EfiVarStore = (EFI_IFR_VARSTORE_EFI *) AllocateZeroPool (IfrOpHdr->Length);
         if (*EfiVarStore == NULL) {
           FreePool (VarStoreName);
-          FreePool (GuidStr);
-          FreePool (NameStr);
-          FreePool (TempStr);
           Status = EFI_OUT_OF_RESOURCES;
           goto Done;
         }
@@ -1208,9 +1425,6 @@ GetVarStoreType (
       // Free alllocated temp string.
       //
       FreePool (VarStoreName);
-      FreePool (GuidStr);
-      FreePool (NameStr);
-      FreePool (TempStr);
 
       //
       // Already found the varstore, break;
@@ -1260,8 +1474,9 @@ GetElementsFromRequest (
   Check whether the this varstore is the request varstore.
 
   @param  VarstoreGuid      Varstore guid.
-  @param  Name              Varstore name.
-  @param  ConfigHdr         Current configRequest info.
+  @param  Name              Varstore name, NULL if the varstore has no name.
+  @param  ConfigHdr         The parsed ConfigHdr of current configRequest.
+                            If it is NULL, any varstore is the request one.
 
   @retval  TRUE              This varstore is the requst one.
   @retval  FALSE             This varstore is not the requst one.
@@ -1269,69 +1484,34 @@ GetElementsFromRequest (
 **/
 BOOLEAN
 IsThisVarstore (
-  IN EFI_GUID    *VarstoreGuid,
-  IN CHAR16      *Name,
-  IN CHAR16      *ConfigHdr
+  IN EFI_GUID        *VarstoreGuid,
+  IN CHAR16          *Name,
+  IN HII_CONFIG_HDR  *ConfigHdr
   )
 {
-  EFI_STRING               GuidStr;
-  EFI_STRING               NameStr;
-  EFI_STRING               TempStr;
-  UINTN                    LengthString;
-  BOOLEAN                  RetVal;
+  if (ConfigHdr == NULL) {
+    return TRUE;
+  }
 
-  RetVal       = FALSE;
-  GuidStr      = NULL;
-  TempStr      = NULL;
+  if (!CompareGuid (VarstoreGuid, &ConfigHdr->Guid)) {
+    return FALSE;
+  }
 
   //
   // If ConfigHdr has name field and varstore not has name, return FALSE.
   //
-  if (Name == NULL && ConfigHdr != NULL && StrStr (ConfigHdr, L"NAME=&") == NULL) {
-    return FALSE;
-  }
-
-  GenerateSubStr (L"GUID=", sizeof (EFI_GUID), (VOID *)VarstoreGuid, 1, &GuidStr);
-  if (Name != NULL) {
-    GenerateSubStr (L"NAME=", StrLen (Name) * sizeof (CHAR16), (VOID *) Name, 2, &NameStr);
-  } else {
-    GenerateSubStr (L"NAME=", 0, NULL, 2, &NameStr);
-  }
-  LengthString = StrLen (GuidStr);
-  LengthString = LengthString + StrLen (NameStr) + 1;
-  TempStr = AllocateZeroPool (LengthString * sizeof (CHAR16));
-  if (TempStr == NULL) {
-    goto Done;
-  }
-
-  StrCpy (TempStr, GuidStr);
-  StrCat (TempStr, NameStr);
-
-  if (ConfigHdr == NULL || StrnCmp (ConfigHdr, TempStr, StrLen (TempStr)) == 0) {
-    RetVal = TRUE;
-  }
-
-Done:
-  if (GuidStr != NULL) {
-    FreePool (GuidStr); 
-  }
-
-  if (NameStr != NULL) {
-    FreePool (NameStr);
-  }
-
-  if (TempStr != NULL) {
-    FreePool (TempStr);
+  if (Name == NULL) {
+    return (BOOLEAN) (*ConfigHdr->Name == L'\0');
   }
 
-  return RetVal;
+  return (BOOLEAN) (StrCmp (Name, ConfigHdr->Name) == 0);
 }
 
 /**
   This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
 
   @param  DataBaseRecord        The DataBaseRecord instance contains the found Hii handle and package.
-  @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
+  @param  ConfigHdr             The parsed request ConfigHdr. If it is NULL,
                                 the first found varstore will be as ConfigHdr.
   @retval  TRUE                 This hii package is the reqeust one.
   @retval  FALSE                This hii package is not the reqeust one.
@@ -1339,7 +1519,7 @@ Done:
 BOOLEAN
 IsThisPackageList (
   IN     HII_DATABASE_RECORD        *DataBaseRecord,
-  IN     EFI_STRING                 ConfigHdr
+  IN     HII_CONFIG_HDR             *ConfigHdr
   )
 {
   EFI_STATUS               Status;
@@ -1547,7 +1727,7 @@ IsThisOpcodeRequired (
   @param  HiiHandle             Hii Handle for this hii package.
   @param  Package               Pointer to the form package data.
   @param  PackageLength         Length of the pacakge.
-  @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
+  @param  ConfigHdr             The parsed request ConfigHdr. If it is NULL,
                                 the first found varstore will be as ConfigHdr.
   @param  RequestBlockArray     The block array is retrieved from the request string.
   @param  VarStorageData        VarStorage structure contains the got block and default value.
@@ -1564,7 +1744,7 @@ ParseIfrData (
   IN     EFI_HII_HANDLE      HiiHandle,
   IN     UINT8               *Package,
   IN     UINT32              PackageLength,
-  IN     EFI_STRING          ConfigHdr,
+  IN     HII_CONFIG_HDR      *ConfigHdr,
   IN     IFR_BLOCK_DATA      *RequestBlockArray,
   IN OUT IFR_VARSTORAGE_DATA *VarStorageData,
   OUT    IFR_DEFAULT_DATA    *DefaultIdArray
@@ -2322,15 +2502,12 @@ GetBlockElement (
   IFR_BLOCK_DATA       *BlockData;
   IFR_BLOCK_DATA       *RequestBlockArray;
   EFI_STATUS           Status;
-  UINT8                *TmpBuffer;
-  UINT16               Offset;
-  UINT16               Width;
+  UINTN                Offset;
+  UINTN                Width;
   LIST_ENTRY           *Link;
   IFR_BLOCK_DATA       *NextBlockData;
   UINTN                Length;
 
-  TmpBuffer = NULL;
-
   //
   // Init RequestBlockArray
   //
@@ -2360,17 +2537,10 @@ GetBlockElement (
     //
     // Get Offset
     //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
+    Status = GetUintnOfNumber (StringPtr, &Offset, &Length);
     if (EFI_ERROR (Status)) {
       goto Done;
     }
-    Offset = 0;
-    CopyMem (
-      &Offset,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINT16)) ? ((Length + 1) / 2) : sizeof (UINT16)
-      );
-    FreePool (TmpBuffer);
 
     StringPtr += Length;
     if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
@@ -2381,17 +2551,10 @@ GetBlockElement (
     //
     // Get Width
     //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
+    Status = GetUintnOfNumber (StringPtr, &Width, &Length);
     if (EFI_ERROR (Status)) {
       goto Done;
     }
-    Width = 0;
-    CopyMem (
-      &Width,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINT16)) ? ((Length + 1) / 2) : sizeof (UINT16)
-      );
-    FreePool (TmpBuffer);
 
     StringPtr += Length;
     if (*StringPtr != 0 && *StringPtr != L'&') {
@@ -2405,8 +2568,8 @@ GetBlockElement (
     if (BlockData == NULL) {
       goto Done;
     }
-    BlockData->Offset = Offset;
-    BlockData->Width  = Width;
+    BlockData->Offset = (UINT16) Offset;
+    BlockData->Width  = (UINT16) Width;
     InsertBlockData (&RequestBlockArray->Entry, &BlockData);
 
     //
@@ -2416,16 +2579,13 @@ GetBlockElement (
       StringPtr += StrLen (L"&VALUE=");
 
       //
-      // Get Value
+      // Skip Value
       //
-      Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
-      if (EFI_ERROR (Status)) {
+      if (*StringPtr == 0) {
         goto Done;
       }
-
-      StringPtr += Length;
-      if (*StringPtr != 0 && *StringPtr != L'&') {
-        goto Done;
+      while (*StringPtr != 0 && *StringPtr != L'&') {
+        StringPtr++;
       }
     }
     //
@@ -3009,6 +3169,8 @@ GenerateAltConfigResp (
 
   @param  DataBaseRecord         The DataBaseRecord instance contains the found Hii handle and package.
   @param  DevicePath             Device Path which Hii Config Access Protocol is registered.
+  @param  RequestHdr             The parsed <ConfigHdr> of *Request. It must be
+                                 NULL if and only if *Request is NULL.
   @param  Request                Pointer to a null-terminated Unicode string in
                                  <ConfigRequest> format. When it doesn't contain
                                  any RequestElement, it will be updated to return 
@@ -3048,6 +3210,7 @@ EFIAPI
 GetFullStringFromHiiFormPackages (
   IN     HII_DATABASE_RECORD        *DataBaseRecord,
   IN     EFI_DEVICE_PATH_PROTOCOL   *DevicePath,
+  IN     HII_CONFIG_HDR             *RequestHdr OPTIONAL,
   IN OUT EFI_STRING                 *Request,
   IN OUT EFI_STRING                 *AltCfgResp,
   OUT    EFI_STRING                 *PointerProgress OPTIONAL
@@ -3066,11 +3229,16 @@ GetFullStringFromHiiFormPackages (
   EFI_STRING                   ConfigHdr;
   EFI_STRING                   StringPtr;
   EFI_STRING                   Progress;
+  HII_CONFIG_HDR               AltCfgHdr;
 
   if (DataBaseRecord == NULL || DevicePath == NULL || Request == NULL || AltCfgResp == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
+  if ((*Request == NULL) != (RequestHdr == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
   //
   // Initialize the local variables.
   //
@@ -3093,34 +3261,10 @@ GetFullStringFromHiiFormPackages (
   //
   StringPtr = NULL;
   if (*Request != NULL) {
-    StringPtr = *Request;
     //
     // Jump <ConfigHdr>
     //
-    if (StrnCmp (StringPtr, L"GUID=", StrLen (L"GUID=")) != 0) {
-      Status   = EFI_INVALID_PARAMETER;
-      goto Done;
-    }
-    StringPtr += StrLen (L"GUID=");
-    while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&NAME=", StrLen (L"&NAME=")) != 0) {
-      StringPtr++;
-    }
-    if (*StringPtr == L'\0') {
-      Status = EFI_INVALID_PARAMETER;
-      goto Done;
-    }
-    StringPtr += StrLen (L"&NAME=");
-    while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&PATH=", StrLen (L"&PATH=")) != 0) {
-      StringPtr++;
-    }
-    if (*StringPtr == L'\0') {
-      Status = EFI_INVALID_PARAMETER;
-      goto Done;
-    }
-    StringPtr += StrLen (L"&PATH=");
-    while (*StringPtr != L'\0' && *StringPtr != L'&') {
-      StringPtr ++;
-    }
+    StringPtr = *Request + RequestHdr->Length;
 
     if (*StringPtr == L'\0') {
       //
@@ -3177,7 +3321,7 @@ GetFullStringFromHiiFormPackages (
   Status = ParseIfrData (DataBaseRecord->Handle,
                          HiiFormPackage,
                          (UINT32) PackageSize,
-                         *Request,
+                         RequestHdr,
                          RequestBlockArray,
                          VarStorageData,
                          DefaultIdArray);
@@ -3221,7 +3365,11 @@ GetFullStringFromHiiFormPackages (
   // 5. Merge string into the input AltCfgResp if the iput *AltCfgResp is not NULL.
   //
   if (*AltCfgResp != NULL && DefaultAltCfgResp != NULL) {
-    Status = MergeDefaultString (AltCfgResp, DefaultAltCfgResp);
+    Status = ParseConfigHdr (*AltCfgResp, &AltCfgHdr);
+    if (!EFI_ERROR (Status)) {
+      Status = MergeDefaultString (AltCfgResp, &AltCfgHdr, DefaultAltCfgResp);
+      FreeConfigHdr (&AltCfgHdr);
+    }
     FreePool (DefaultAltCfgResp);
   } else if (*AltCfgResp == NULL) {
     *AltCfgResp = DefaultAltCfgResp;
@@ -3551,6 +3699,7 @@ NameValueValidate (
   Validate the config request string.
 
   @param  ConfigRequest                A null-terminated Unicode string in <ConfigRequest> format.
+  @param  ConfigHdr                    The parsed <ConfigHdr> of ConfigRequest.
 
   @retval     CHAR16 *    THE first element not correct.
   @retval     NULL        Success parse the name/value pair
@@ -3558,48 +3707,22 @@ NameValueValidate (
 **/
 CHAR16 *
 ConfigRequestValidate (
-  CHAR16          *ConfigRequest
+  CHAR16          *ConfigRequest,
+  HII_CONFIG_HDR  *ConfigHdr
   )
 {
-  BOOLEAN            HasNameField;
   CHAR16             *StringPtr;
 
-  HasNameField = TRUE;
-  StringPtr    = ConfigRequest;
-
   //
-  // Check <ConfigHdr>
+  // Skip <ConfigHdr>
   //
-  if (StrnCmp (StringPtr, L"GUID=", StrLen (L"GUID=")) != 0) {
-    return ConfigRequest;
-  }
-  StringPtr += StrLen (L"GUID=");
-  while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&NAME=", StrLen (L"&NAME=")) != 0) {
-    StringPtr++;
-  }
-  if (*StringPtr == L'\0') {
-    return ConfigRequest;
-  }
-  StringPtr += StrLen (L"&NAME=");
-  if (*StringPtr == L'&') {
-    HasNameField = FALSE;
-  }
-  while (*StringPtr != L'\0' && StrnCmp (StringPtr, L"&PATH=", StrLen (L"&PATH=")) != 0) {
-    StringPtr++;
-  }
-  if (*StringPtr == L'\0') {
-    return ConfigRequest;
-  }
-  StringPtr += StrLen (L"&PATH=");
-  while (*StringPtr != L'\0' && *StringPtr != L'&') {
-    StringPtr ++;
-  }
+  StringPtr = ConfigRequest + ConfigHdr->Length;
 
   if (*StringPtr == L'\0') {
     return NULL;
   }
 
-  if (HasNameField) {
+  if (*ConfigHdr->Name != L'\0') {
     //
     // Should be Buffer varstore, config request should be "OFFSET/Width" pairs.
     //
@@ -3666,7 +3789,7 @@ HiiConfigRoutingExtractConfig (
   EFI_STRING                          StringPtr;
   EFI_STRING                          ConfigRequest;
   UINTN                               Length;
-  EFI_DEVICE_PATH_PROTOCOL            *DevicePath;
+  HII_CONFIG_HDR                      ConfigHdr;
   EFI_DEVICE_PATH_PROTOCOL            *TempDevicePath;
   EFI_STATUS                          Status;
   LIST_ENTRY                          *Link;
@@ -3703,11 +3826,12 @@ HiiConfigRoutingExtractConfig (
   Status         = EFI_SUCCESS;
   AccessResults  = NULL;
   AccessProgress = NULL;
-  DevicePath     = NULL;
   IfrDataParsedFlag = FALSE;
   IsEfiVarStore     = FALSE;
   EfiVarStoreInfo   = NULL;
 
+  ZeroMem (&ConfigHdr, sizeof (ConfigHdr));
+
   //
   // The first element of <MultiConfigRequest> should be
   // <GuidHdr>, which is in 'GUID='<Guid> syntax.
@@ -3750,9 +3874,10 @@ HiiConfigRoutingExtractConfig (
     *(ConfigRequest + Length) = 0;
 
     //
-    // Get the UEFI device path
+    // Parse the <ConfigHdr> once, the GUID, NAME and UEFI device path in it
+    // are shared by all the following steps on this <ConfigRequest>.
     //
-    Status = GetDevicePath (ConfigRequest, (UINT8 **) &DevicePath);
+    Status = ParseConfigHdr (ConfigRequest, &ConfigHdr);
     if (EFI_ERROR (Status)) {
       goto Done;
     }
@@ -3771,7 +3896,9 @@ HiiConfigRoutingExtractConfig (
       if ((DevicePathPkg = Database->PackageList->DevicePathPkg) != NULL) {
         CurrentDevicePath = DevicePathPkg + sizeof (EFI_HII_PACKAGE_HEADER);
         DevicePathSize    = GetDevicePathSize ((EFI_DEVICE_PATH_PROTOCOL *) CurrentDevicePath);
-        if ((CompareMem (DevicePath,CurrentDevicePath,DevicePathSize) == 0) && IsThisPackageList(Database, ConfigRequest)) {
+        if ((DevicePathSize == ConfigHdr.DevicePathSize) &&
+            (CompareMem (ConfigHdr.DevicePath, CurrentDevicePath, DevicePathSize) == 0) &&
+            IsThisPackageList (Database, &ConfigHdr)) {
           DriverHandle = Database->DriverHandle;
           HiiHandle    = Database->Handle;
           break;
@@ -3783,7 +3910,7 @@ HiiConfigRoutingExtractConfig (
     // Try to find driver handle by device path.
     //
     if (DriverHandle == NULL) {
-      TempDevicePath = DevicePath;
+      TempDevicePath = ConfigHdr.DevicePath;
       Status = gBS->LocateDevicePath (
                       &gEfiDevicePathProtocolGuid,
                       &TempDevicePath,
@@ -3803,7 +3930,7 @@ HiiConfigRoutingExtractConfig (
     //
     // Validate ConfigRequest String.
     //
-    ErrorPtr = ConfigRequestValidate(ConfigRequest);
+    ErrorPtr = ConfigRequestValidate(ConfigRequest, &ConfigHdr);
     if (ErrorPtr != NULL) {
       *Progress = StrStr (StringPtr, ErrorPtr);
       Status = EFI_INVALID_PARAMETER;
@@ -3819,7 +3946,7 @@ HiiConfigRoutingExtractConfig (
       // Get the full request string from IFR when HiiPackage is registered to HiiHandle 
       //
       IfrDataParsedFlag = TRUE;
-      Status = GetFullStringFromHiiFormPackages (Database, DevicePath, &ConfigRequest, &DefaultResults, &AccessProgress);
+      Status = GetFullStringFromHiiFormPackages (Database, ConfigHdr.DevicePath, &ConfigHdr, &ConfigRequest, &DefaultResults, &AccessProgress);
       if (EFI_ERROR (Status)) {
         //
         // AccessProgress indicates the parsing progress on <ConfigRequest>.
@@ -3841,7 +3968,7 @@ HiiConfigRoutingExtractConfig (
     //
     // Check whether this ConfigRequest is search from Efi varstore type storage.
     //
-    Status = GetVarStoreType(Database, ConfigRequest, &IsEfiVarStore, &EfiVarStoreInfo);
+    Status = GetVarStoreType(Database, &ConfigHdr, &IsEfiVarStore, &EfiVarStoreInfo);
     if (EFI_ERROR (Status)) {
       goto Done;
     }
@@ -3889,15 +4016,12 @@ HiiConfigRoutingExtractConfig (
     // Update AccessResults by getting default setting from IFR when HiiPackage is registered to HiiHandle 
     //
     if (!IfrDataParsedFlag && HiiHandle != NULL) {
-      Status = GetFullStringFromHiiFormPackages (Database, DevicePath, &ConfigRequest, &DefaultResults, NULL);
+      Status = GetFullStringFromHiiFormPackages (Database, ConfigHdr.DevicePath, &ConfigHdr, &ConfigRequest, &DefaultResults, NULL);
       ASSERT_EFI_ERROR (Status);
     }
 
-    FreePool (DevicePath);
-    DevicePath = NULL;
-
     if (DefaultResults != NULL) {
-      Status = MergeDefaultString (&AccessResults, DefaultResults);
+      Status = MergeDefaultString (&AccessResults, &ConfigHdr, DefaultResults);
       ASSERT_EFI_ERROR (Status);
       FreePool (DefaultResults);
       DefaultResults = NULL;
@@ -3918,6 +4042,7 @@ NextConfigString:
     AccessResults = NULL;
     FreePool (ConfigRequest);
     ConfigRequest = NULL;
+    FreeConfigHdr (&ConfigHdr);
 
     //
     // Go to next <ConfigRequest> (skip '&').
@@ -3949,9 +4074,7 @@ Done:
     FreePool (DefaultResults);
   }
   
-  if (DevicePath != NULL) {
-    FreePool (DevicePath);
-  }  
+  FreeConfigHdr (&ConfigHdr);
 
   return Status;
 }
@@ -4005,6 +4128,7 @@ HiiConfigRoutingExportConfig (
   UINT8                               *DevicePathPkg;
   UINT8                               *CurrentDevicePath;
   BOOLEAN                             IfrDataParsedFlag;
+  HII_CONFIG_HDR                      ConfigHdr;
 
   if (This == NULL || Results == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -4087,7 +4211,7 @@ HiiConfigRoutingExportConfig (
       //
       if (HiiHandle != NULL && DevicePath != NULL) {
         IfrDataParsedFlag = TRUE;
-        Status = GetFullStringFromHiiFormPackages (Database, DevicePath, &ConfigRequest, &DefaultResults, NULL);
+        Status = GetFullStringFromHiiFormPackages (Database, DevicePath, NULL, &ConfigRequest, &DefaultResults, NULL);
         //
         // Get the full request string to get the Current setting again.
         //
@@ -4106,16 +4230,26 @@ HiiConfigRoutingExportConfig (
     }
 
     if (!EFI_ERROR (Status)) {
+      //
+      // Parse the <ConfigHdr> of the got setting once for getting and merging
+      // the default setting.
+      //
+      ZeroMem (&ConfigHdr, sizeof (ConfigHdr));
+      if (HiiHandle != NULL && DevicePath != NULL) {
+        Status = ParseConfigHdr (AccessResults, &ConfigHdr);
+        ASSERT_EFI_ERROR (Status);
+      }
+
       //
       // Update AccessResults by getting default setting from IFR when HiiPackage is registered to HiiHandle 
       //
-      if (!IfrDataParsedFlag && HiiHandle != NULL && DevicePath != NULL) {
+      if (!IfrDataParsedFlag && ConfigHdr.Header != NULL) {
         StringPtr = StrStr (AccessResults, L"&GUID=");
         if (StringPtr != NULL) {
           *StringPtr = 0;
         }
         if (GetElementsFromRequest (AccessResults)) {
-          Status = GetFullStringFromHiiFormPackages (Database, DevicePath, &AccessResults, &DefaultResults, NULL);
+          Status = GetFullStringFromHiiFormPackages (Database, DevicePath, &ConfigHdr, &AccessResults, &DefaultResults, NULL);
           ASSERT_EFI_ERROR (Status);
         }
         if (StringPtr != NULL) {
@@ -4126,11 +4260,12 @@ HiiConfigRoutingExportConfig (
       // Merge the default sting from IFR code into the got setting from driver.
       //
       if (DefaultResults != NULL) {
-        Status = MergeDefaultString (&AccessResults, DefaultResults);
+        Status = MergeDefaultString (&AccessResults, &ConfigHdr, DefaultResults);
         ASSERT_EFI_ERROR (Status);
         FreePool (DefaultResults);
         DefaultResults = NULL;
       }
+      FreeConfigHdr (&ConfigHdr);
       
       //
       // Attach this <ConfigAltResp> to a <MultiConfigAltResp>. There is a '&'
@@ -4194,7 +4329,7 @@ HiiConfigRoutingRouteConfig (
   EFI_STRING                          ConfigResp;
   UINTN                               Length;
   EFI_STATUS                          Status;
-  EFI_DEVICE_PATH_PROTOCOL            *DevicePath;
+  HII_CONFIG_HDR                      ConfigHdr;
   EFI_DEVICE_PATH_PROTOCOL            *TempDevicePath;
   LIST_ENTRY                          *Link;
   HII_DATABASE_RECORD                 *Database;
@@ -4257,9 +4392,10 @@ HiiConfigRoutingRouteConfig (
     *(ConfigResp + Length) = 0;
 
     //
-    // Get the UEFI device path
+    // Parse the <ConfigHdr> once, the GUID, NAME and UEFI device path in it
+    // are shared by all the following steps on this <ConfigResp>.
     //
-    Status = GetDevicePath (ConfigResp, (UINT8 **) &DevicePath);
+    Status = ParseConfigHdr (ConfigResp, &ConfigHdr);
     if (EFI_ERROR (Status)) {
       FreePool (ConfigResp);
       return Status;
@@ -4278,7 +4414,9 @@ HiiConfigRoutingRouteConfig (
       if ((DevicePathPkg = Database->PackageList->DevicePathPkg) != NULL) {
         CurrentDevicePath = DevicePathPkg + sizeof (EFI_HII_PACKAGE_HEADER);
         DevicePathSize    = GetDevicePathSize ((EFI_DEVICE_PATH_PROTOCOL *) CurrentDevicePath);
-        if ((CompareMem (DevicePath,CurrentDevicePath,DevicePathSize) == 0) && IsThisPackageList(Database, ConfigResp)) {
+        if ((DevicePathSize == ConfigHdr.DevicePathSize) &&
+            (CompareMem (ConfigHdr.DevicePath, CurrentDevicePath, DevicePathSize) == 0) &&
+            IsThisPackageList (Database, &ConfigHdr)) {
           DriverHandle = Database->DriverHandle;
           break;
         }
@@ -4289,7 +4427,7 @@ HiiConfigRoutingRouteConfig (
     // Try to find driver handle by device path.
     //
     if (DriverHandle == NULL) {
-      TempDevicePath = DevicePath;
+      TempDevicePath = ConfigHdr.DevicePath;
       Status = gBS->LocateDevicePath (
                       &gEfiDevicePathProtocolGuid,
                       &TempDevicePath,
@@ -4300,20 +4438,20 @@ HiiConfigRoutingRouteConfig (
         // Routing data does not match any known driver.
         // Set Progress to the 'G' in "GUID" of the routing header.
         //
-        FreePool (DevicePath);
+        FreeConfigHdr (&ConfigHdr);
         *Progress = StringPtr;
         FreePool (ConfigResp);
         return EFI_NOT_FOUND;
       }
     }
 
-    FreePool (DevicePath);
-
     //
     // Check whether this ConfigRequest is search from Efi varstore type storage.
     //
-    Status = GetVarStoreType(Database, ConfigResp, &IsEfiVarstore, &EfiVarStoreInfo);
+    Status = GetVarStoreType(Database, &ConfigHdr, &IsEfiVarstore, &EfiVarStoreInfo);
+    FreeConfigHdr (&ConfigHdr);
     if (EFI_ERROR (Status)) {
+      FreePool (ConfigResp);
       return Status;
     }
 
@@ -4423,18 +4561,13 @@ HiiBlockToConfig (
   UINTN                               Length;
   EFI_STATUS                          Status;
   EFI_STRING                          TmpPtr;
-  UINT8                               *TmpBuffer;
-  UINTN                               Offset;
-  UINTN                               Width;
-  UINT8                               *Value;
-  EFI_STRING                          ValueStr;
-  EFI_STRING                          ConfigElement;
+  EFI_STRING                          ParseProgress;
+  HII_BLOCK_CONFIG_ELEMENT            *Elements;
+  UINTN                               ElementCount;
   UINTN                               Index;
+  UINTN                               Width;
   UINT8                               *TemBuffer;
-  CHAR16                              *TemString;
-  CHAR16                              TemChar;
-
-  TmpBuffer = NULL;
+  BOOLEAN                             TrailingAnd;
 
   if (This == NULL || Progress == NULL || Config == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -4449,35 +4582,23 @@ HiiBlockToConfig (
   Private = CONFIG_ROUTING_DATABASE_PRIVATE_DATA_FROM_THIS (This);
   ASSERT (Private != NULL);
 
-  StringPtr     = ConfigRequest;
-  ValueStr      = NULL;
-  Value         = NULL;
-  ConfigElement = NULL;
-
-  //
-  // Allocate a fix length of memory to store Results. Reallocate memory for
-  // Results if this fix length is insufficient.
-  //
-  *Config = (EFI_STRING) AllocateZeroPool (MAX_STRING_LENGTH);
-  if (*Config == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
+  StringPtr = ConfigRequest;
+  Elements  = NULL;
+  *Config   = NULL;
 
   //
   // Jump <ConfigHdr>
   //
   if (StrnCmp (StringPtr, L"GUID=", StrLen (L"GUID=")) != 0) {
     *Progress = StringPtr;
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
   while (*StringPtr != 0 && StrnCmp (StringPtr, L"PATH=", StrLen (L"PATH=")) != 0) {
     StringPtr++;
   }
   if (*StringPtr == 0) {
     *Progress = StringPtr - 1;
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+    return EFI_INVALID_PARAMETER;
   }
 
   while (*StringPtr != L'&' && *StringPtr != 0) {
@@ -4486,180 +4607,101 @@ HiiBlockToConfig (
   if (*StringPtr == 0) {
     *Progress = StringPtr;
 
-    AppendToMultiString(Config, ConfigRequest);
+    *Config = AllocateCopyPool (StrSize (ConfigRequest), ConfigRequest);
+    if (*Config == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
     HiiToLower (*Config);
 
     return EFI_SUCCESS;
   }
-  //
-  // Skip '&'
-  //
-  StringPtr++;
 
   //
-  // Copy <ConfigHdr> and an additional '&' to <ConfigResp>
-  //
-  TemChar = *StringPtr;
-  *StringPtr = '\0';
-  AppendToMultiString(Config, ConfigRequest);
-  *StringPtr = TemChar;
-
-  //
-  // Parse each <RequestElement> if exists
+  // Parse all <RequestElement> at once.
   // Only <BlockName> format is supported by this help function.
   // <BlockName> ::= 'OFFSET='<Number>&'WIDTH='<Number>
   //
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"OFFSET=", StrLen (L"OFFSET=")) == 0) {
-    //
-    // Back up the header of one <BlockName>
-    //
-    TmpPtr = StringPtr;
-
-    StringPtr += StrLen (L"OFFSET=");
-    //
-    // Get Offset
-    //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
-    if (EFI_ERROR (Status)) {
-      *Progress = TmpPtr - 1;
-      goto Exit;
-    }
-    Offset = 0;
-    CopyMem (
-      &Offset,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINTN)) ? ((Length + 1) / 2) : sizeof (UINTN)
-      );
-    FreePool (TmpBuffer);
-
-    StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
-      *Progress = TmpPtr - 1;
-      Status = EFI_INVALID_PARAMETER;
-      goto Exit;
-    }
-    StringPtr += StrLen (L"&WIDTH=");
-
-    //
-    // Get Width
-    //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
-    if (EFI_ERROR (Status)) {
-      *Progress =  TmpPtr - 1;
-      goto Exit;
-    }
-    Width = 0;
-    CopyMem (
-      &Width,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINTN)) ? ((Length + 1) / 2) : sizeof (UINTN)
-      );
-    FreePool (TmpBuffer);
-
-    StringPtr += Length;
-    if (*StringPtr != 0 && *StringPtr != L'&') {
-      *Progress =  TmpPtr - 1;
-      Status = EFI_INVALID_PARAMETER;
-      goto Exit;
-    }
+  Status = ParseBlockConfig (StringPtr, FALSE, &Elements, &ElementCount, &ParseProgress);
 
-    //
-    // Calculate Value and convert it to hex string.
-    //
-    if (Offset + Width > BlockSize) {
-      *Progress = StringPtr;
+  //
+  // Add length for <ConfigHdr> and the Null-terminator, then for each
+  // "&OFFSET=XXXX&WIDTH=YYYY&VALUE=zzzz" in the order of the request.
+  //
+  Length = (StringPtr - ConfigRequest) + 1;
+  for (Index = 0; Index < ElementCount; Index++) {
+    if (Elements[Index].Offset + Elements[Index].Width > BlockSize) {
+      *Progress = Elements[Index].Element + Elements[Index].Length;
       Status = EFI_DEVICE_ERROR;
       goto Exit;
     }
+    Length += Elements[Index].Length + StrLen (L"&VALUE=") + Elements[Index].Width * 2;
+  }
 
-    Value = (UINT8 *) AllocateZeroPool (Width);
-    if (Value == NULL) {
-      *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-
-    CopyMem (Value, (UINT8 *) Block + Offset, Width);
-
-    Length = Width * 2 + 1;
-    ValueStr = (EFI_STRING) AllocateZeroPool (Length  * sizeof (CHAR16));
-    if (ValueStr == NULL) {
-      *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-    
-    TemString = ValueStr;
-    TemBuffer = Value + Width - 1;
-    for (Index = 0; Index < Width; Index ++, TemBuffer --) {
-      TemString += UnicodeValueToString (TemString, PREFIX_ZERO | RADIX_HEX, *TemBuffer, 2);
-    }
+  if (EFI_ERROR (Status)) {
+    *Progress = (Status == EFI_OUT_OF_RESOURCES) ? ConfigRequest : ParseProgress;
+    goto Exit;
+  }
 
-    FreePool (Value);
-    Value = NULL;
+  //
+  // A single '&' may end the request, it is kept in <ConfigResp>.
+  //
+  TrailingAnd = (BOOLEAN) (*ParseProgress == L'&' && *(ParseProgress + 1) == 0);
+  if (*ParseProgress != 0 && !TrailingAnd) {
+    *Progress = ParseProgress;
+    Status = EFI_INVALID_PARAMETER;
+    goto Exit;
+  }
+  if (TrailingAnd) {
+    Length++;
+  }
 
-    //
-    // Build a ConfigElement
-    //
-    Length += StringPtr - TmpPtr + 1 + StrLen (L"VALUE=");
-    ConfigElement = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-    if (ConfigElement == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-    CopyMem (ConfigElement, TmpPtr, (StringPtr - TmpPtr + 1) * sizeof (CHAR16));
-    if (*StringPtr == 0) {
-      *(ConfigElement + (StringPtr - TmpPtr)) = L'&';
-    }
-    *(ConfigElement + (StringPtr - TmpPtr) + 1) = 0;
-    StrCat (ConfigElement, L"VALUE=");
-    StrCat (ConfigElement, ValueStr);
+  *Config = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
+  if (*Config == NULL) {
+    *Progress = ConfigRequest;
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
 
-    AppendToMultiString (Config, ConfigElement);
+  //
+  // Copy <ConfigHdr>, then each <BlockName> followed by its value read from
+  // Block and converted to hex string.
+  //
+  TmpPtr = *Config;
+  CopyMem (TmpPtr, ConfigRequest, (StringPtr - ConfigRequest) * sizeof (CHAR16));
+  TmpPtr += StringPtr - ConfigRequest;
 
-    FreePool (ConfigElement);
-    FreePool (ValueStr);
-    ConfigElement = NULL;
-    ValueStr = NULL;
+  for (Index = 0; Index < ElementCount; Index++) {
+    CopyMem (TmpPtr, Elements[Index].Element, Elements[Index].Length * sizeof (CHAR16));
+    TmpPtr += Elements[Index].Length;
+    CopyMem (TmpPtr, L"&VALUE=", StrLen (L"&VALUE=") * sizeof (CHAR16));
+    TmpPtr += StrLen (L"&VALUE=");
 
-    //
-    // If '\0', parsing is finished. Otherwise skip '&' to continue
-    //
-    if (*StringPtr == 0) {
-      break;
+    Width     = Elements[Index].Width;
+    TemBuffer = (UINT8 *) Block + Elements[Index].Offset + Width - 1;
+    for (; Width > 0; Width--, TemBuffer--) {
+      TmpPtr += UnicodeValueToString (TmpPtr, PREFIX_ZERO | RADIX_HEX, *TemBuffer, 2);
     }
-    AppendToMultiString (Config, L"&");
-    StringPtr++;
+  }
 
+  if (TrailingAnd) {
+    *TmpPtr = L'&';
+    ParseProgress++;
   }
 
-  if (*StringPtr != 0) {
-    *Progress = StringPtr - 1;
-    Status = EFI_INVALID_PARAMETER;
-    goto Exit;
+  if (Elements != NULL) {
+    FreePool (Elements);
   }
-  
+
   HiiToLower (*Config);
-  *Progress = StringPtr;
+  *Progress = ParseProgress;
   return EFI_SUCCESS;
 
 Exit:
-  if (*Config != NULL) {
-  FreePool (*Config);
-  *Config = NULL;
-  }
-  if (ValueStr != NULL) {
-    FreePool (ValueStr);
-  }
-  if (Value != NULL) {
-    FreePool (Value);
-  }
-  if (ConfigElement != NULL) {
-    FreePool (ConfigElement);
+  if (Elements != NULL) {
+    FreePool (Elements);
   }
 
   return Status;
-
 }
 
 
@@ -4722,18 +4764,16 @@ HiiConfigToBlock (
 {
   HII_DATABASE_PRIVATE_DATA           *Private;
   EFI_STRING                          StringPtr;
-  EFI_STRING                          TmpPtr;
-  UINTN                               Length;
+  EFI_STRING                          ParseProgress;
   EFI_STATUS                          Status;
-  UINT8                               *TmpBuffer;
+  HII_BLOCK_CONFIG_ELEMENT            *Elements;
+  UINTN                               ElementCount;
+  UINTN                               Index;
   UINTN                               Offset;
   UINTN                               Width;
-  UINT8                               *Value;
   UINTN                               BufferSize;
   UINTN                               MaxBlockSize;
 
-  TmpBuffer = NULL;
-
   if (This == NULL || BlockSize == NULL || Progress == NULL) {
     return EFI_INVALID_PARAMETER;
   }
@@ -4748,7 +4788,6 @@ HiiConfigToBlock (
 
   StringPtr  = ConfigResp;
   BufferSize = *BlockSize;
-  Value      = NULL;
   MaxBlockSize = 0;
 
   //
@@ -4778,101 +4817,40 @@ HiiConfigToBlock (
   }
 
   //
-  // Parse each <ConfigElement> if exists
+  // Parse all <ConfigElement> at once.
   // Only '&'<BlockConfig> format is supported by this help function.
   // <BlockConfig> ::= 'OFFSET='<Number>&'WIDTH='<Number>&'VALUE='<Number>
   //
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"&OFFSET=", StrLen (L"&OFFSET=")) == 0) {
-    TmpPtr     = StringPtr;
-    StringPtr += StrLen (L"&OFFSET=");
-    //
-    // Get Offset
-    //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
-    if (EFI_ERROR (Status)) {
-      *Progress = TmpPtr;
-      goto Exit;
-    }
-    Offset = 0;
-    CopyMem (
-      &Offset,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINTN)) ? ((Length + 1) / 2) : sizeof (UINTN)
-      );
-    FreePool (TmpBuffer);
-
-    StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
-      *Progress = TmpPtr;
-      Status = EFI_INVALID_PARAMETER;
-      goto Exit;
-    }
-    StringPtr += StrLen (L"&WIDTH=");
-
-    //
-    // Get Width
-    //
-    Status = GetValueOfNumber (StringPtr, &TmpBuffer, &Length);
-    if (EFI_ERROR (Status)) {
-      *Progress = TmpPtr;
-      goto Exit;
-    }
-    Width = 0;
-    CopyMem (
-      &Width,
-      TmpBuffer,
-      (((Length + 1) / 2) < sizeof (UINTN)) ? ((Length + 1) / 2) : sizeof (UINTN)
-      );
-    FreePool (TmpBuffer);
-
-    StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&VALUE=", StrLen (L"&VALUE=")) != 0) {
-      *Progress = TmpPtr;
-      Status = EFI_INVALID_PARAMETER;
-      goto Exit;
-    }
-    StringPtr += StrLen (L"&VALUE=");
-
-    //
-    // Get Value
-    //
-    Status = GetValueOfNumber (StringPtr, &Value, &Length);
-    if (EFI_ERROR (Status)) {
-      *Progress = TmpPtr;
-      goto Exit;
-    }
+  Status = ParseBlockConfig (StringPtr, TRUE, &Elements, &ElementCount, &ParseProgress);
 
-    StringPtr += Length;
-    if (*StringPtr != 0 && *StringPtr != L'&') {
-      *Progress = TmpPtr;
-      Status = EFI_INVALID_PARAMETER;
-      goto Exit;
-    }
+  for (Index = 0; Index < ElementCount; Index++) {
+    Offset = Elements[Index].Offset;
+    Width  = Elements[Index].Width;
 
     //
     // Update the Block with configuration info
     //
     if ((Block != NULL) && (Offset + Width <= BufferSize)) {
-      CopyMem (Block + Offset, Value, Width);
+      NumberToBuffer (Elements[Index].Value, Elements[Index].ValueLength, Block + Offset, Width);
     }
     if (Offset + Width > MaxBlockSize) {
       MaxBlockSize = Offset + Width;
     }
+  }
 
-    FreePool (Value);
-    Value = NULL;
+  if (Elements != NULL) {
+    FreePool (Elements);
+  }
 
-    //
-    // If '\0', parsing is finished.
-    //
-    if (*StringPtr == 0) {
-      break;
-    }
+  if (EFI_ERROR (Status)) {
+    *Progress = ParseProgress;
+    goto Exit;
   }
-  
+
   //
   // The input string is not ConfigResp format, return error.
   //
+  StringPtr = ParseProgress;
   if (*StringPtr != 0) {
     *Progress = StringPtr;
     Status = EFI_INVALID_PARAMETER;
@@ -4898,9 +4876,6 @@ HiiConfigToBlock (
 
 Exit:
 
-  if (Value != NULL) {
-    FreePool (Value);
-  }
   return Status;
 }
 
@@ -949,6 +949,7 @@ AdjustStringPackage (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
@@ -1090,6 +1091,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    InvalidateStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -1403,6 +1405,9 @@ RemoveFontPackages (
     if (Package->GlyphBlock != NULL) {
       FreePool (Package->GlyphBlock);
     }
+    if (Package->GlyphIndex != NULL) {
+      FreePool (Package->GlyphIndex);
+    }
     FreePool (Package->FontPkgHdr);
     //
     // Delete default character cell information
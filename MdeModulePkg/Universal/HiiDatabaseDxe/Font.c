@@ -638,8 +638,269 @@ WriteOutputParam (
 }
 
 
+/**
+  Parse all glyph blocks once and record each run of glyphs in the glyph index
+  of the font package, in increasing character order.
+
+  This is a internal function.
+
+  @param  FontPackage             Hii font package instance.
+
+  @retval EFI_SUCCESS             The glyph index is built.
+  @retval EFI_UNSUPPORTED         The glyph blocks can not be indexed.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+BuildGlyphIndex (
+  IN OUT HII_FONT_PACKAGE_INSTANCE   *FontPackage
+  )
+{
+  EFI_STATUS                          Status;
+  HII_GLYPH_INDEX_ENTRY               *GlyphIndex;
+  HII_GLYPH_INDEX_ENTRY               Run;
+  UINTN                               Count;
+  UINTN                               Pass;
+  UINT8                               *BlockPtr;
+  UINTN                               CharCurrent;
+  UINT16                              Length16;
+  UINT32                              Length32;
+
+  ASSERT (FontPackage->GlyphIndex == NULL);
+
+  //
+  // The first pass counts the runs, the second one records them.
+  //
+  GlyphIndex = NULL;
+  Count      = 0;
+  for (Pass = 0; Pass < 2; Pass++) {
+    if (Pass == 1) {
+      if (Count == 0) {
+        return EFI_UNSUPPORTED;
+      }
+      GlyphIndex = AllocatePool (Count * sizeof (HII_GLYPH_INDEX_ENTRY));
+      if (GlyphIndex == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      Count = 0;
+    }
+
+    BlockPtr    = FontPackage->GlyphBlock;
+    CharCurrent = 1;
+    while (*BlockPtr != EFI_HII_GIBT_END) {
+      ZeroMem (&Run, sizeof (Run));
+      Run.CharStart = (CHAR16) CharCurrent;
+
+      switch (*BlockPtr) {
+      case EFI_HII_GIBT_DEFAULTS:
+        BlockPtr += sizeof (EFI_HII_GIBT_DEFAULTS_BLOCK);
+        break;
+
+      case EFI_HII_GIBT_DUPLICATE:
+        Run.Count     = 1;
+        Run.Duplicate = TRUE;
+        CopyMem (&Run.DuplicateOf, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (CHAR16));
+        BlockPtr += sizeof (EFI_HII_GIBT_DUPLICATE_BLOCK);
+        break;
+
+      case EFI_HII_GIBT_EXT1:
+        BlockPtr += *(BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8));
+        break;
+
+      case EFI_HII_GIBT_EXT2:
+        CopyMem (&Length16, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+        BlockPtr += Length16;
+        break;
+
+      case EFI_HII_GIBT_EXT4:
+        CopyMem (&Length32, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+        BlockPtr += Length32;
+        break;
+
+      case EFI_HII_GIBT_GLYPH:
+        CopyMem (&Run.Cell, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (EFI_HII_GLYPH_INFO));
+        Run.Count      = 1;
+        Run.BitmapSize = BITMAP_LEN_1_BIT (Run.Cell.Width, Run.Cell.Height);
+        BlockPtr      += sizeof (EFI_HII_GIBT_GLYPH_BLOCK) - sizeof (UINT8);
+        break;
+
+      case EFI_HII_GIBT_GLYPHS:
+        CopyMem (&Run.Cell, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (EFI_HII_GLYPH_INFO));
+        CopyMem (
+          &Run.Count,
+          BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (EFI_HII_GLYPH_INFO),
+          sizeof (UINT16)
+          );
+        Run.BitmapSize = BITMAP_LEN_1_BIT (Run.Cell.Width, Run.Cell.Height);
+        BlockPtr      += sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (EFI_HII_GLYPH_INFO) + sizeof (UINT16);
+        break;
+
+      case EFI_HII_GIBT_GLYPH_DEFAULT:
+      case EFI_HII_GIBT_GLYPHS_DEFAULT:
+        Status = GetCell ((UINT16) CharCurrent, &FontPackage->GlyphInfoList, &Run.Cell);
+        if (EFI_ERROR (Status)) {
+          goto Error;
+        }
+        if (*BlockPtr == EFI_HII_GIBT_GLYPH_DEFAULT) {
+          Run.Count = 1;
+          BlockPtr += sizeof (EFI_HII_GLYPH_BLOCK);
+        } else {
+          CopyMem (&Run.Count, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (UINT16));
+          BlockPtr += sizeof (EFI_HII_GIBT_GLYPHS_DEFAULT_BLOCK) - sizeof (UINT8);
+        }
+        Run.BitmapSize = BITMAP_LEN_1_BIT (Run.Cell.Width, Run.Cell.Height);
+        break;
+
+      case EFI_HII_GIBT_SKIP1:
+        CharCurrent += *(BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK));
+        BlockPtr    += sizeof (EFI_HII_GIBT_SKIP1_BLOCK);
+        break;
+
+      case EFI_HII_GIBT_SKIP2:
+        CopyMem (&Length16, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (UINT16));
+        CharCurrent += Length16;
+        BlockPtr    += sizeof (EFI_HII_GIBT_SKIP2_BLOCK);
+        break;
+
+      default:
+        Status = EFI_UNSUPPORTED;
+        goto Error;
+      }
+
+      if (Run.Count != 0) {
+        if (!Run.Duplicate) {
+          //
+          // The bitmaps of the run follow the block header.
+          //
+          Run.BitmapOffset = (UINT32) (BlockPtr - FontPackage->GlyphBlock);
+          BlockPtr        += Run.Count * Run.BitmapSize;
+        }
+        if (GlyphIndex != NULL) {
+          CopyMem (&GlyphIndex[Count], &Run, sizeof (Run));
+        }
+        Count++;
+        CharCurrent += Run.Count;
+      }
+
+      //
+      // Character values are 16 bits, do not index a font that wraps around.
+      //
+      if (CharCurrent > MAX_UINT16 + 1) {
+        Status = EFI_UNSUPPORTED;
+        goto Error;
+      }
+    }
+  }
+
+  FontPackage->GlyphIndex      = GlyphIndex;
+  FontPackage->GlyphIndexCount = Count;
+  return EFI_SUCCESS;
+
+Error:
+  if (GlyphIndex != NULL) {
+    FreePool (GlyphIndex);
+  }
+  return Status;
+}
+
+
+/**
+  Find the glyph of a character with the glyph index of the font package,
+  building the index first if needed.
+
+  This is a internal function.
+
+  @param  FontPackage             Hii font package instance.
+  @param  CharValue               Unicode character value, which identifies a glyph
+                                  block.
+  @param  GlyphBuffer             Output the corresponding bitmap data of the found
+                                  block. It is the caller's responsiblity to free
+                                  this buffer.
+  @param  Cell                    Output cell information of the encoded bitmap.
+  @param  GlyphBufferLen          If not NULL, output the length of GlyphBuffer.
+
+  @retval EFI_SUCCESS             The bitmap data is retrieved successfully.
+  @retval EFI_NOT_FOUND           The specified CharValue does not exist in current
+                                  database.
+  @retval EFI_UNSUPPORTED         The index can not be built. The caller must parse
+                                  the glyph blocks instead.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+FindGlyphBlockByIndex (
+  IN  HII_FONT_PACKAGE_INSTANCE      *FontPackage,
+  IN  CHAR16                         CharValue,
+  OUT UINT8                          **GlyphBuffer, OPTIONAL
+  OUT EFI_HII_GLYPH_INFO             *Cell, OPTIONAL
+  OUT UINTN                          *GlyphBufferLen OPTIONAL
+  )
+{
+  HII_GLYPH_INDEX_ENTRY               *Run;
+  UINTN                               Low;
+  UINTN                               High;
+  UINTN                               Middle;
+  UINTN                               Duplicates;
+
+  if (FontPackage->GlyphIndex == NULL) {
+    BuildGlyphIndex (FontPackage);
+    if (FontPackage->GlyphIndex == NULL) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  //
+  // Follow duplicate glyphs to the original glyph. A chain longer than the
+  // number of runs is a loop.
+  //
+  for (Duplicates = 0; Duplicates <= FontPackage->GlyphIndexCount; Duplicates++) {
+    //
+    // Find the last run that starts at or before CharValue.
+    //
+    Low  = 0;
+    High = FontPackage->GlyphIndexCount;
+    while (Low < High) {
+      Middle = (Low + High) / 2;
+      if (FontPackage->GlyphIndex[Middle].CharStart <= CharValue) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+    if (Low == 0) {
+      return EFI_NOT_FOUND;
+    }
+
+    Run = &FontPackage->GlyphIndex[Low - 1];
+    if ((UINTN) CharValue >= (UINTN) Run->CharStart + Run->Count) {
+      return EFI_NOT_FOUND;
+    }
+
+    if (Run->Duplicate) {
+      CharValue = Run->DuplicateOf;
+      continue;
+    }
+
+    return WriteOutputParam (
+             FontPackage->GlyphBlock + Run->BitmapOffset + (CharValue - Run->CharStart) * Run->BitmapSize,
+             Run->BitmapSize,
+             &Run->Cell,
+             GlyphBuffer,
+             Cell,
+             GlyphBufferLen
+             );
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
+  A specific CharValue is looked up in the glyph index of the font package,
+  which is built by the first such lookup.
   If CharValue = (CHAR16) (-1), collect all default character cell information
   within this font package and backup its information.
 
@@ -685,7 +946,14 @@ FindGlyphBlock (
   ASSERT (FontPackage->Signature == HII_FONT_PACKAGE_SIGNATURE);
   BaseLine  = 0;
   MinOffsetY = 0;
-  
+
+  if (CharValue != (CHAR16) (-1)) {
+    Status = FindGlyphBlockByIndex (FontPackage, CharValue, GlyphBuffer, Cell, GlyphBufferLen);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
   if (CharValue == (CHAR16) (-1)) {
     //
     // Collect the cell information specified in font package fixed header.
@@ -100,6 +100,31 @@ typedef struct {
   EFI_IFR_TYPE_VALUE  Value;
 } IFR_DEFAULT_DATA;
 
+//
+// One <BlockConfig> or <BlockName> element parsed from a configuration string.
+//
+typedef struct {
+  EFI_STRING          Element;           // Points to the '&' before OFFSET
+  UINTN               Length;            // Characters of the element
+  UINTN               Offset;
+  UINTN               Width;
+  EFI_STRING          Value;             // Points to the <Number> of VALUE, NULL for <BlockName>
+  UINTN               ValueLength;       // Characters of the <Number> of VALUE
+} HII_BLOCK_CONFIG_ELEMENT;
+
+//
+// The <ConfigHdr> of a <ConfigRequest> or <ConfigResp>, parsed once and
+// shared by the routing steps of that string.
+//
+typedef struct {
+  EFI_STRING                Header;         // Copy of the <ConfigHdr> with hex digits in lowercase
+  UINTN                     Length;         // Characters of the <ConfigHdr>
+  EFI_GUID                  Guid;
+  CHAR16                    *Name;          // Empty string if NAME has no value
+  EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
+  UINTN                     DevicePathSize;
+} HII_CONFIG_HDR;
+
 //
 // Storage types
 //
@@ -126,6 +151,17 @@ typedef struct {
 //
 // String Package definitions
 //
+
+//
+// Location of a StringId in the string blocks. StartStringId is 0 if no
+// block defines the StringId.
+//
+typedef struct {
+  UINT32                                BlockOffset;   // offset of the block in StringBlock
+  UINT32                                TextOffset;    // offset of the string text in the block
+  EFI_STRING_ID                         StartStringId; // first StringId of the block
+} HII_STRING_INDEX_ENTRY;
+
 #define HII_STRING_PACKAGE_SIGNATURE    SIGNATURE_32 ('h','i','s','p')
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                                 Signature;
@@ -135,6 +171,8 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                            FontInfoList;  // local font info list
   UINT8                                 FontId;
   EFI_STRING_ID                         MaxStringId;   // record StringId
+  HII_STRING_INDEX_ENTRY                *StringIndex;  // built on first lookup, indexed by StringId
+  UINTN                                 StringIndexCount;
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -161,6 +199,22 @@ typedef struct _HII_SIMPLE_FONT_PACKAGE_INSTANCE {
 //
 // Font Package definitions
 //
+
+//
+// A run of consecutive characters whose glyphs share one cell and bitmap size,
+// from a single glyph block. A duplicate block is a run of one character that
+// refers to DuplicateOf.
+//
+typedef struct {
+  CHAR16                                CharStart;
+  UINT16                                Count;
+  UINT32                                BitmapOffset;  // offset of the first bitmap in GlyphBlock
+  UINT32                                BitmapSize;
+  EFI_HII_GLYPH_INFO                    Cell;
+  BOOLEAN                               Duplicate;
+  CHAR16                                DuplicateOf;
+} HII_GLYPH_INDEX_ENTRY;
+
 #define HII_FONT_PACKAGE_SIGNATURE      SIGNATURE_32 ('h','i','f','p')
 typedef struct _HII_FONT_PACKAGE_INSTANCE {
   UINTN                                 Signature;
@@ -170,6 +224,8 @@ typedef struct _HII_FONT_PACKAGE_INSTANCE {
   UINT8                                 *GlyphBlock;
   LIST_ENTRY                            FontEntry;
   LIST_ENTRY                            GlyphInfoList;
+  HII_GLYPH_INDEX_ENTRY                 *GlyphIndex;   // built on first lookup, sorted by CharStart
+  UINTN                                 GlyphIndexCount;
 } HII_FONT_PACKAGE_INSTANCE;
 
 #define HII_GLYPH_INFO_SIGNATURE        SIGNATURE_32 ('h','g','i','s')
@@ -467,6 +523,18 @@ FindStringBlock (
   OUT EFI_STRING_ID                   *StartStringId OPTIONAL
   );
 
+/**
+  Free the StringId index of a string package. It must be called whenever the
+  string blocks of the package are changed, so that the next lookup rebuilds it.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN OUT HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  );
+
 
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
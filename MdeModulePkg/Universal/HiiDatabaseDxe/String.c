@@ -232,8 +232,297 @@ GetStringFontInfo (
 }
 
 
+/**
+  Free the StringId index of a string package. It must be called whenever the
+  string blocks of the package are changed, so that the next lookup rebuilds it.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN OUT HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex      = NULL;
+    StringPackage->StringIndexCount = 0;
+  }
+}
+
+
+/**
+  Record the location of a StringId in the StringId index.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+  @param  StringId                The string's id.
+  @param  BlockHdr                The string block which defines the StringId.
+  @param  TextOffset              Offset, relative to BlockHdr, of the string text.
+  @param  StartStringId           The first StringId of the string block.
+
+**/
+VOID
+SetStringIndexEntry (
+  IN OUT HII_STRING_PACKAGE_INSTANCE  *StringPackage,
+  IN     UINTN                        StringId,
+  IN     UINT8                        *BlockHdr,
+  IN     UINTN                        TextOffset,
+  IN     EFI_STRING_ID                StartStringId
+  )
+{
+  HII_STRING_INDEX_ENTRY               *Entry;
+
+  if (StringId >= StringPackage->StringIndexCount) {
+    return;
+  }
+
+  Entry                = &StringPackage->StringIndex[StringId];
+  Entry->BlockOffset   = (UINT32) (BlockHdr - StringPackage->StringBlock);
+  Entry->TextOffset    = (UINT32) TextOffset;
+  Entry->StartStringId = StartStringId;
+}
+
+
+/**
+  Parse all string blocks once and record, for each StringId, the block that
+  defines it and the offset of its string text.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+
+  @retval EFI_SUCCESS             The StringId index is built.
+  @retval EFI_UNSUPPORTED         The string blocks contain an unknown block type.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+BuildStringIndex (
+  IN OUT HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  )
+{
+  UINT8                                *BlockHdr;
+  UINT8                                *StringTextPtr;
+  UINTN                                CurrentStringId;
+  EFI_STRING_ID                        StartStringId;
+  UINTN                                Offset;
+  UINTN                                Index;
+  UINTN                                StringSize;
+  UINT16                               StringCount;
+  UINT16                               SkipCount;
+  UINT8                                Length8;
+  UINT16                               Length16;
+  UINT32                               Length32;
+
+  ASSERT (StringPackage->StringIndex == NULL);
+
+  //
+  // StringIds above MaxStringId are rejected before the index is used.
+  //
+  StringPackage->StringIndexCount = (UINTN) StringPackage->MaxStringId + 1;
+  StringPackage->StringIndex      = AllocateZeroPool (
+                                      StringPackage->StringIndexCount * sizeof (HII_STRING_INDEX_ENTRY)
+                                      );
+  if (StringPackage->StringIndex == NULL) {
+    StringPackage->StringIndexCount = 0;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  BlockHdr        = StringPackage->StringBlock;
+  CurrentStringId = 1;
+  while (*BlockHdr != EFI_HII_SIBT_END && CurrentStringId < StringPackage->StringIndexCount) {
+    StartStringId = (EFI_STRING_ID) CurrentStringId;
+
+    switch (*BlockHdr) {
+    case EFI_HII_SIBT_STRING_SCSU:
+    case EFI_HII_SIBT_STRING_SCSU_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRING_SCSU) {
+        Offset = sizeof (EFI_HII_STRING_BLOCK);
+      } else {
+        Offset = sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      }
+      SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, Offset, StartStringId);
+      BlockHdr += Offset + AsciiStrSize ((CHAR8 *) (BlockHdr + Offset));
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU:
+    case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRINGS_SCSU) {
+        CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+      } else {
+        CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      }
+      for (Index = 0; Index < StringCount; Index++) {
+        SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, StringTextPtr - BlockHdr, StartStringId);
+        StringTextPtr += AsciiStrSize ((CHAR8 *) StringTextPtr);
+      }
+      BlockHdr = StringTextPtr;
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2:
+    case EFI_HII_SIBT_STRING_UCS2_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRING_UCS2) {
+        Offset = sizeof (EFI_HII_STRING_BLOCK);
+      } else {
+        Offset = sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      }
+      SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, Offset, StartStringId);
+      GetUnicodeStringTextOrSize (NULL, BlockHdr + Offset, &StringSize);
+      BlockHdr += Offset + StringSize;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2:
+    case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRINGS_UCS2) {
+        CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+      } else {
+        CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      }
+      for (Index = 0; Index < StringCount; Index++) {
+        SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, StringTextPtr - BlockHdr, StartStringId);
+        GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+        StringTextPtr += StringSize;
+      }
+      BlockHdr = StringTextPtr;
+      break;
+
+    case EFI_HII_SIBT_DUPLICATE:
+      SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, 0, StartStringId);
+      BlockHdr += sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_SKIP1:
+    case EFI_HII_SIBT_SKIP2:
+      if (*BlockHdr == EFI_HII_SIBT_SKIP1) {
+        SkipCount = (UINT16) (*(BlockHdr + sizeof (EFI_HII_STRING_BLOCK)));
+      } else {
+        CopyMem (&SkipCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      }
+      for (Index = 0; Index < SkipCount; Index++) {
+        SetStringIndexEntry (StringPackage, CurrentStringId++, BlockHdr, 0, StartStringId);
+      }
+      if (*BlockHdr == EFI_HII_SIBT_SKIP1) {
+        BlockHdr += sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+      } else {
+        BlockHdr += sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+      }
+      break;
+
+    case EFI_HII_SIBT_EXT1:
+      CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+      BlockHdr += Length8;
+      break;
+
+    case EFI_HII_SIBT_EXT2:
+      CopyMem (&Length16, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      BlockHdr += Length16;
+      break;
+
+    case EFI_HII_SIBT_EXT4:
+      CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+      BlockHdr += Length32;
+      break;
+
+    default:
+      InvalidateStringIndex (StringPackage);
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Find the string block of a StringId with the StringId index, building the
+  index first if needed.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+  @param  StringId                The string's id, which is unique within
+                                  PackageList.
+  @param  BlockType               Output the block type of found string block.
+  @param  StringBlockAddr         Output the block address of found string block.
+  @param  StringTextOffset        Offset, relative to the found block address, of
+                                  the  string text information.
+  @param  StartStringId           The first id in the skip block which StringId in the block.
+
+  @retval EFI_SUCCESS             The string block is found.
+  @retval EFI_NOT_FOUND           StringId is in a skip block. The block is output.
+  @retval EFI_UNSUPPORTED         The index can not be used for StringId. The caller
+                                  must parse the string blocks instead.
+
+**/
+EFI_STATUS
+FindStringBlockByIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE     *StringPackage,
+  IN  EFI_STRING_ID                   StringId,
+  OUT UINT8                           *BlockType,
+  OUT UINT8                           **StringBlockAddr,
+  OUT UINTN                           *StringTextOffset,
+  OUT EFI_STRING_ID                   *StartStringId OPTIONAL
+  )
+{
+  HII_STRING_INDEX_ENTRY               *Entry;
+  UINT8                                *BlockHdr;
+  UINTN                                Duplicates;
+
+  if (StringPackage->StringIndex == NULL) {
+    BuildStringIndex (StringPackage);
+    if (StringPackage->StringIndex == NULL) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  //
+  // Follow duplicate blocks to the block of the original string. A chain
+  // longer than the number of StringIds is a loop.
+  //
+  for (Duplicates = 0; Duplicates < StringPackage->StringIndexCount; Duplicates++) {
+    if (StringId == 0 || StringId >= StringPackage->StringIndexCount) {
+      return EFI_UNSUPPORTED;
+    }
+    Entry = &StringPackage->StringIndex[StringId];
+    if (Entry->StartStringId == 0) {
+      return EFI_UNSUPPORTED;
+    }
+
+    BlockHdr = StringPackage->StringBlock + Entry->BlockOffset;
+    if (*BlockHdr == EFI_HII_SIBT_DUPLICATE) {
+      CopyMem (&StringId, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (EFI_STRING_ID));
+      continue;
+    }
+
+    *BlockType        = *BlockHdr;
+    *StringBlockAddr  = BlockHdr;
+    *StringTextOffset = Entry->TextOffset;
+    if (StartStringId != NULL) {
+      *StartStringId  = Entry->StartStringId;
+    }
+
+    if (*BlockHdr == EFI_HII_SIBT_SKIP1 || *BlockHdr == EFI_HII_SIBT_SKIP2) {
+      return EFI_NOT_FOUND;
+    }
+    return EFI_SUCCESS;
+  }
+
+  return EFI_UNSUPPORTED;
+}
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
+  A specific StringId is looked up in the StringId index of the string package,
+  which is built by the first such lookup.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
   within this string package and backup its information. If LastStringId is 
   specified, the string id of last string block will also be output.
@@ -290,6 +579,7 @@ FindStringBlock (
   UINT32                               Length32;
   UINTN                                StringSize;
   CHAR16                               Zero;
+  EFI_STATUS                           Status;
 
   ASSERT (StringPackage != NULL);
   ASSERT (StringPackage->Signature == HII_STRING_PACKAGE_SIGNATURE);
@@ -301,6 +591,18 @@ FindStringBlock (
     if (StringId > StringPackage->MaxStringId) {
       return EFI_NOT_FOUND;
     }
+
+    Status = FindStringBlockByIndex (
+               StringPackage,
+               StringId,
+               BlockType,
+               StringBlockAddr,
+               StringTextOffset,
+               StartStringId
+               );
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
   } else {
     ASSERT (Private != NULL && Private->Signature == HII_DATABASE_PRIVATE_DATA_SIGNATURE);
     if (StringId == 0 && LastStringId != NULL) {
@@ -843,6 +1145,7 @@ InsertLackStringBlock (
   } else {
     *BlockType = EFI_HII_SIBT_STRING_UCS2;
   }
+  InvalidateStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = StringBlock;
   StringPackage->StringPkgHdr->Header.Length += NewBlockSize - OldBlockSize;
@@ -1010,6 +1313,7 @@ SetStringWorker (
       TmpSize
       );
 
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1043,6 +1347,7 @@ SetStringWorker (
       OldBlockSize - (StringTextPtr - StringPackage->StringBlock) - StringSize
       );
 
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1094,6 +1399,7 @@ SetStringWorker (
 
   CopyMem (BlockPtr, StringPackage->StringBlock, OldBlockSize);
 
+  InvalidateStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = Block;
   StringPackage->StringPkgHdr->Header.Length += Ext2.Length;
@@ -1277,6 +1583,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1408,6 +1715,7 @@ HiiNewString (
     // Append a EFI_HII_SIBT_END block to the end.
     //
     *BlockPtr = EFI_HII_SIBT_END;
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = StringBlock;
     StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1450,6 +1758,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2FontBlockSize;
@@ -1511,6 +1820,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += FontBlockSize + Ucs2FontBlockSize;
@@ -1554,6 +1864,7 @@ Done:
     // Free the allocated new string Package when new string can't be added.
     //
     RemoveEntryList (&StringPackage->StringEntry);
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     FreePool (StringPackage->StringPkgHdr);
     FreePool (StringPackage);
@@ -92,12 +92,65 @@ GetLbaAndOffsetByAddress (
   return EFI_ABORTED;
 }
 
+/**
+  Gets the base address and the block size of the firmware volume which
+  contains the given address.
+
+  @param  Address        Address which should be contained
+                         by the firmware volume.
+  @param  FvbBaseAddress Pointer to the base address of the firmware volume for output.
+  @param  BlockSize      Pointer to the block size for output.
+
+  @retval EFI_SUCCESS    Base address and block size successfully returned.
+  @retval EFI_NOT_FOUND  Fail to find FVB handle by address.
+  @retval EFI_ABORTED    The firmware volume has no valid block map.
+
+**/
+EFI_STATUS
+GetBlockSizeByAddress (
+  IN  EFI_PHYSICAL_ADDRESS   Address,
+  OUT EFI_PHYSICAL_ADDRESS   *FvbBaseAddress,
+  OUT UINTN                  *BlockSize
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
+  EFI_FIRMWARE_VOLUME_HEADER          *FwVolHeader;
+
+  Fvb        = NULL;
+  *BlockSize = 0;
+
+  Status = GetFvbInfoByAddress (Address, NULL, &Fvb);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Fvb->GetPhysicalAddress (Fvb, FvbBaseAddress);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // BUGBUG: Assume one FV has one type of BlockLength.
+  //
+  FwVolHeader = (EFI_FIRMWARE_VOLUME_HEADER *) ((UINTN) *FvbBaseAddress);
+  if ((FwVolHeader->FvLength <= FwVolHeader->HeaderLength) || (FwVolHeader->BlockMap[0].Length == 0)) {
+    return EFI_ABORTED;
+  }
+
+  *BlockSize = FwVolHeader->BlockMap[0].Length;
+  return EFI_SUCCESS;
+}
+
 /**
   Writes a buffer to variable storage space, in the working block.
 
   This function writes a buffer to variable storage space into a firmware
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
+  Only the range which differs from the current content of the variable
+  storage space is written, so that the blocks a reclaim leaves untouched
+  are neither erased nor backed up.
 
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
@@ -118,6 +171,10 @@ FtwVariableSpace (
   EFI_LBA                            VarLba;
   UINTN                              VarOffset;
   UINTN                              FtwBufferSize;
+  UINTN                              WriteStart;
+  UINTN                              WriteEnd;
+  UINT8                              *OldBuffer;
+  UINT8                              *NewBuffer;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
 
   //
@@ -134,28 +191,42 @@ FtwVariableSpace (
   if (EFI_ERROR (Status)) {
     return Status;
   }
+
+  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
+  ASSERT (FtwBufferSize == VariableBuffer->Size);
+
+  //
+  // Find the range which differs from the current variable storage space.
+  //
+  OldBuffer = (UINT8 *) (UINTN) VariableBase;
+  NewBuffer = (UINT8 *) VariableBuffer;
+  for (WriteStart = 0; (WriteStart < FtwBufferSize) && (OldBuffer[WriteStart] == NewBuffer[WriteStart]); WriteStart++) {
+  }
+  if (WriteStart == FtwBufferSize) {
+    return EFI_SUCCESS;
+  }
+  for (WriteEnd = FtwBufferSize; OldBuffer[WriteEnd - 1] == NewBuffer[WriteEnd - 1]; WriteEnd--) {
+  }
+
   //
   // Get LBA and Offset by address.
   //
-  Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+  Status = GetLbaAndOffsetByAddress (VariableBase + WriteStart, &VarLba, &VarOffset);
   if (EFI_ERROR (Status)) {
     return EFI_ABORTED;
   }
 
-  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
-  ASSERT (FtwBufferSize == VariableBuffer->Size);
-
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,         // LBA
-                          VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
-                          NULL,           // PrivateData NULL
-                          FvbHandle,      // Fvb Handle
-                          (VOID *) VariableBuffer // write buffer
+                          VarLba,                   // LBA
+                          VarOffset,                // Offset
+                          WriteEnd - WriteStart,    // NumBytes
+                          NULL,                     // PrivateData NULL
+                          FvbHandle,                // Fvb Handle
+                          NewBuffer + WriteStart    // write buffer
                           );
 
   return Status;
@@ -23,6 +23,12 @@ VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 ///
 VARIABLE_STORE_HEADER  *mNvVariableCache      = NULL;
 
+///
+/// Hash indexes of the volatile and non-volatile variable stores which speed up
+/// looking a variable up by name. The HOB variable store is not indexed.
+///
+VARIABLE_INDEX         *mVariableIndex[VariableStoreTypeMax];
+
 ///
 /// The memory entry used for variable statistics data.
 ///
@@ -557,10 +563,354 @@ GetEndPointer (
 }
 
 
+/**
+  Gets the variable store which is covered by the variable store index of
+  the given type.
+
+  @param Type            The type of the variable store.
+
+  @return Pointer to the variable store header, or NULL if the store is not indexed.
+
+**/
+VARIABLE_STORE_HEADER *
+GetIndexedVariableStore (
+  IN VARIABLE_STORE_TYPE         Type
+  )
+{
+  if (Type == VariableStoreTypeVolatile) {
+    return (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  } else if (Type == VariableStoreTypeNv) {
+    return mNvVariableCache;
+  }
+
+  return NULL;
+}
+
+/**
+
+  Computes the variable store index bucket of a variable.
+
+  @param VariableName    Name of the variable, doesn't need to be NULL terminated.
+  @param NameSize        Size of VariableName in bytes.
+  @param VendorGuid      Guid of the variable.
+
+  @return The bucket number.
+
+**/
+UINT32
+GetVariableIndexBucket (
+  IN CHAR16                      *VariableName,
+  IN UINTN                       NameSize,
+  IN EFI_GUID                    *VendorGuid
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  Hash = VendorGuid->Data1;
+  for (Index = 0; (Index < NameSize / sizeof (CHAR16)) && (VariableName[Index] != 0); Index++) {
+    Hash = (Hash << 5) - Hash + VariableName[Index];
+  }
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return Hash & (VARIABLE_INDEX_BUCKET_COUNT - 1);
+}
+
+/**
+
+  Adds a variable to the tail of its bucket in a variable store index. If the
+  index is full, it is invalidated and lookups fall back to walking the store.
+
+  @param Index           Pointer to the variable store index.
+  @param VarStoreHeader  Pointer to the indexed variable store.
+  @param Variable        Pointer to the variable header.
+
+**/
+VOID
+AddVariableIndexEntry (
+  IN OUT VARIABLE_INDEX          *Index,
+  IN     VARIABLE_STORE_HEADER   *VarStoreHeader,
+  IN     VARIABLE_HEADER         *Variable
+  )
+{
+  UINT32  Bucket;
+  UINT32  Entry;
+
+  if (!Index->Valid) {
+    return;
+  }
+
+  if (Index->EntryCount == Index->MaxEntryCount) {
+    Index->Valid = FALSE;
+    return;
+  }
+
+  Bucket = GetVariableIndexBucket (GetVariableNamePtr (Variable), NameSizeOfVariable (Variable), &Variable->VendorGuid);
+  Entry  = Index->EntryCount++;
+
+  Index->Entry[Entry].Offset = (UINT32) ((UINTN) Variable - (UINTN) VarStoreHeader);
+  Index->Entry[Entry].Next   = VARIABLE_INDEX_END;
+  if (Index->Head[Bucket] == VARIABLE_INDEX_END) {
+    Index->Head[Bucket] = Entry;
+  } else {
+    Index->Entry[Index->Tail[Bucket]].Next = Entry;
+  }
+  Index->Tail[Bucket] = Entry;
+}
+
+/**
+
+  Rebuilds the variable store index of the given type from the variable store.
+  Must be called whenever the variable store is rewritten, e.g. by Reclaim().
+
+  @param Type            The type of the variable store.
+
+**/
+VOID
+RebuildVariableIndex (
+  IN VARIABLE_STORE_TYPE         Type
+  )
+{
+  VARIABLE_INDEX         *Index;
+  VARIABLE_STORE_HEADER  *VarStoreHeader;
+  VARIABLE_HEADER        *Variable;
+  VARIABLE_HEADER        *EndPtr;
+
+  Index          = mVariableIndex[Type];
+  VarStoreHeader = GetIndexedVariableStore (Type);
+  if ((Index == NULL) || (VarStoreHeader == NULL)) {
+    return;
+  }
+
+  SetMem (Index->Head, sizeof (Index->Head), 0xff);
+  SetMem (Index->Tail, sizeof (Index->Tail), 0xff);
+  Index->EntryCount = 0;
+  Index->Valid      = TRUE;
+
+  EndPtr = GetEndPointer (VarStoreHeader);
+  for ( Variable = GetStartPointer (VarStoreHeader)
+      ; (Variable < EndPtr) && IsValidVariableHeader (Variable)
+      ; Variable = GetNextVariablePtr (Variable)
+      ) {
+    if (Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      AddVariableIndexEntry (Index, VarStoreHeader, Variable);
+    }
+  }
+}
+
+/**
+
+  Adds a variable which was just appended to the variable store of the given
+  type to the variable store index.
+
+  @param Type            The type of the variable store.
+  @param Offset          Offset of the variable header from the variable store header.
+
+**/
+VOID
+UpdateVariableIndex (
+  IN VARIABLE_STORE_TYPE         Type,
+  IN UINTN                       Offset
+  )
+{
+  VARIABLE_STORE_HEADER  *VarStoreHeader;
+  VARIABLE_HEADER        *Variable;
+
+  VarStoreHeader = GetIndexedVariableStore (Type);
+  if ((mVariableIndex[Type] == NULL) || (VarStoreHeader == NULL)) {
+    return;
+  }
+
+  Variable = (VARIABLE_HEADER *) ((UINTN) VarStoreHeader + Offset);
+  if (Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+    AddVariableIndexEntry (mVariableIndex[Type], VarStoreHeader, Variable);
+  }
+}
+
+/**
+
+  Allocates and builds the variable store index of the given type. The index is
+  sized for a store filled with variables of the smallest possible size, so it
+  never needs to grow at runtime.
+
+  @param Type            The type of the variable store.
+
+  @retval EFI_SUCCESS            The index was built.
+  @retval EFI_OUT_OF_RESOURCES   There is not enough memory for the index.
+
+**/
+EFI_STATUS
+CreateVariableIndex (
+  IN VARIABLE_STORE_TYPE         Type
+  )
+{
+  VARIABLE_STORE_HEADER  *VarStoreHeader;
+  UINTN                  MaxEntryCount;
+
+  VarStoreHeader = GetIndexedVariableStore (Type);
+  ASSERT (VarStoreHeader != NULL);
+
+  MaxEntryCount = (VarStoreHeader->Size - sizeof (VARIABLE_STORE_HEADER)) / HEADER_ALIGN (sizeof (VARIABLE_HEADER) + sizeof (CHAR16));
+
+  mVariableIndex[Type] = AllocateRuntimePool (sizeof (VARIABLE_INDEX) + MaxEntryCount * sizeof (VARIABLE_INDEX_ENTRY));
+  if (mVariableIndex[Type] == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  mVariableIndex[Type]->MaxEntryCount = (UINT32) MaxEntryCount;
+
+  RebuildVariableIndex (Type);
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Chooses where the reclaim of the non-volatile variable store starts.
+
+  The variables in front of the returned variable are kept as they are, so the
+  flash blocks holding them are neither erased nor rewritten. Every block
+  boundary is a candidate start. The highest candidate is taken for which the
+  garbage behind it is enough to integrate the new variable, and to leave room
+  for another variable of the maximum size (and of the maximum hardware error
+  record size, if hardware error records are supported). If no candidate frees
+  enough space, the whole store is reclaimed.
+
+  @param VariableStoreHeader         Pointer to the variable store in flash.
+  @param UpdatingVariable            Pointer to the variable being updated, or NULL.
+  @param UpdatingInDeletedTransition Pointer to the IN_DELETED_TRANSITION copy of
+                                     the variable being updated, or NULL.
+  @param NewVariable                 Pointer to the new variable, or NULL.
+  @param NewVariableSize             New variable size.
+
+  @return Pointer to the first variable to reclaim.
+
+**/
+VARIABLE_HEADER *
+GetReclaimStartPointer (
+  IN VARIABLE_STORE_HEADER       *VariableStoreHeader,
+  IN VARIABLE_HEADER             *UpdatingVariable,
+  IN VARIABLE_HEADER             *UpdatingInDeletedTransition,
+  IN VARIABLE_HEADER             *NewVariable,
+  IN UINTN                       NewVariableSize
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  FvbBaseAddress;
+  UINTN                 BlockSize;
+  UINTN                 Block;
+  UINTN                 LastBlock;
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *NextVariable;
+  VARIABLE_HEADER       *StartPtr;
+  VARIABLE_HEADER       *LimitPtr;
+  VARIABLE_HEADER       *ReclaimStartPtr;
+  UINTN                 VariableSize;
+  BOOLEAN               IsHwErr;
+  BOOLEAN               IsLive;
+  UINTN                 LiveSize[2];
+  UINTN                 PrefixSize[2];
+  UINTN                 PrefixLiveSize[2];
+  UINTN                 NewSize[2];
+  UINTN                 SizeAfter[2];
+  UINTN                 CommonLimit;
+  UINTN                 HwErrLimit;
+  UINTN                 LastVariableOffset;
+
+  StartPtr = GetStartPointer (VariableStoreHeader);
+
+  Status = GetBlockSizeByAddress ((EFI_PHYSICAL_ADDRESS) (UINTN) VariableStoreHeader, &FvbBaseAddress, &BlockSize);
+  if (EFI_ERROR (Status)) {
+    return StartPtr;
+  }
+
+  //
+  // The variables being updated are dropped by the reclaim, so it must not
+  // start behind them.
+  //
+  LimitPtr = GetEndPointer (VariableStoreHeader);
+  if ((UpdatingVariable != NULL) && (UpdatingVariable < LimitPtr)) {
+    LimitPtr = UpdatingVariable;
+  }
+  if ((UpdatingInDeletedTransition != NULL) && (UpdatingInDeletedTransition < LimitPtr)) {
+    LimitPtr = UpdatingInDeletedTransition;
+  }
+
+  //
+  // Index 0 accounts common variables and index 1 hardware error records.
+  //
+  ZeroMem (LiveSize, sizeof (LiveSize));
+  ZeroMem (PrefixSize, sizeof (PrefixSize));
+  ZeroMem (PrefixLiveSize, sizeof (PrefixLiveSize));
+  ZeroMem (NewSize, sizeof (NewSize));
+  if (NewVariable != NULL) {
+    NewSize[((NewVariable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) ? 1 : 0] = NewVariableSize;
+  }
+
+  //
+  // Account the variables which survive the reclaim. IN_DELETED_TRANSITION
+  // variables are counted as surviving even if an ADDED one exists.
+  //
+  for (Variable = StartPtr; IsValidVariableHeader (Variable); Variable = NextVariable) {
+    NextVariable = GetNextVariablePtr (Variable);
+    if ((Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+        Variable != UpdatingVariable && Variable != UpdatingInDeletedTransition) {
+      IsHwErr = (BOOLEAN) ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD);
+      LiveSize[IsHwErr ? 1 : 0] += (UINTN) NextVariable - (UINTN) Variable;
+    }
+  }
+
+  HwErrLimit  = PcdGet32 (PcdHwErrStorageSize);
+  CommonLimit = VariableStoreHeader->Size - sizeof (VARIABLE_STORE_HEADER) - HwErrLimit;
+
+  ReclaimStartPtr = StartPtr;
+  LastBlock       = (UINTN) -1;
+  for (Variable = StartPtr; IsValidVariableHeader (Variable) && (Variable <= LimitPtr); Variable = NextVariable) {
+    NextVariable = GetNextVariablePtr (Variable);
+    VariableSize = (UINTN) NextVariable - (UINTN) Variable;
+    IsHwErr      = (BOOLEAN) ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD);
+    IsLive       = (BOOLEAN) ((Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+                              Variable != UpdatingVariable && Variable != UpdatingInDeletedTransition);
+
+    //
+    // The first variable starting in a block is a candidate.
+    //
+    Block = (UINTN) (((EFI_PHYSICAL_ADDRESS) (UINTN) Variable - FvbBaseAddress) / BlockSize);
+    if (Block != LastBlock) {
+      LastBlock = Block;
+
+      //
+      // The variables in front of the candidate keep their space, the ones
+      // behind it only keep it if they survive.
+      //
+      SizeAfter[0] = PrefixSize[0] + LiveSize[0] - PrefixLiveSize[0] + NewSize[0];
+      SizeAfter[1] = PrefixSize[1] + LiveSize[1] - PrefixLiveSize[1] + NewSize[1];
+      LastVariableOffset = (UINTN) Variable - (UINTN) VariableStoreHeader +
+                           LiveSize[0] + LiveSize[1] - PrefixLiveSize[0] - PrefixLiveSize[1] + NewVariableSize;
+
+      if ((LastVariableOffset <= VariableStoreHeader->Size) &&
+          (SizeAfter[0] + PcdGet32 (PcdMaxVariableSize) <= CommonLimit) &&
+          ((HwErrLimit == 0) || (SizeAfter[1] + PcdGet32 (PcdMaxHardwareErrorVariableSize) <= HwErrLimit))) {
+        ReclaimStartPtr = Variable;
+      }
+    }
+
+    PrefixSize[IsHwErr ? 1 : 0] += VariableSize;
+    if (IsLive) {
+      PrefixLiveSize[IsHwErr ? 1 : 0] += VariableSize;
+    }
+  }
+
+  return ReclaimStartPtr;
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
 
+  The volatile variable store is always reclaimed as a whole. The non-volatile
+  variable store is only reclaimed from the start chosen by GetReclaimStartPointer(),
+  and only the flash range which actually changes is written.
+
   @param VariableBase            Base address of variable store.
   @param LastVariableOffset      Offset of last variable.
   @param IsVolatile              The variable store is volatile or not;
@@ -602,6 +952,7 @@ Reclaim (
   UINTN                 HwErrVariableTotalSize;
   VARIABLE_HEADER       *UpdatingVariable;
   VARIABLE_HEADER       *UpdatingInDeletedTransition;
+  VARIABLE_HEADER       *ReclaimStartPtr;
 
   UpdatingVariable = NULL;
   UpdatingInDeletedTransition = NULL;
@@ -660,6 +1011,17 @@ Reclaim (
     ValidBuffer = (UINT8 *) mNvVariableCache;
   }
 
+  ReclaimStartPtr = GetStartPointer (VariableStoreHeader);
+  if (!IsVolatile) {
+    ReclaimStartPtr = GetReclaimStartPointer (
+                        VariableStoreHeader,
+                        UpdatingVariable,
+                        UpdatingInDeletedTransition,
+                        NewVariable,
+                        NewVariableSize
+                        );
+  }
+
   SetMem (ValidBuffer, MaximumBufferSize, 0xff);
 
   //
@@ -668,10 +1030,29 @@ Reclaim (
   CopyMem (ValidBuffer, VariableStoreHeader, sizeof (VARIABLE_STORE_HEADER));
   CurrPtr = (UINT8 *) GetStartPointer ((VARIABLE_STORE_HEADER *) ValidBuffer);
 
+  //
+  // Keep the variables in front of the reclaim start as they are.
+  //
+  if (ReclaimStartPtr != GetStartPointer (VariableStoreHeader)) {
+    VariableSize = (UINTN) ReclaimStartPtr - (UINTN) GetStartPointer (VariableStoreHeader);
+    CopyMem (CurrPtr, (UINT8 *) GetStartPointer (VariableStoreHeader), VariableSize);
+    CurrPtr += VariableSize;
+
+    for (Variable = GetStartPointer (VariableStoreHeader); Variable < ReclaimStartPtr; Variable = NextVariable) {
+      NextVariable = GetNextVariablePtr (Variable);
+      VariableSize = (UINTN) NextVariable - (UINTN) Variable;
+      if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+        HwErrVariableTotalSize += VariableSize;
+      } else {
+        CommonVariableTotalSize += VariableSize;
+      }
+    }
+  }
+
   //
   // Reinstall all ADDED variables as long as they are not identical to Updating Variable.
   // 
-  Variable = GetStartPointer (VariableStoreHeader);
+  Variable = ReclaimStartPtr;
   while (IsValidVariableHeader (Variable)) {
     NextVariable = GetNextVariablePtr (Variable);
     if (Variable != UpdatingVariable && Variable->State == VAR_ADDED) {
@@ -690,7 +1071,7 @@ Reclaim (
   //
   // Reinstall all in delete transition variables.
   // 
-  Variable = GetStartPointer (VariableStoreHeader);
+  Variable = ReclaimStartPtr;
   while (IsValidVariableHeader (Variable)) {
     NextVariable = GetNextVariablePtr (Variable);
     if (Variable != UpdatingVariable && Variable != UpdatingInDeletedTransition && Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
@@ -819,9 +1200,75 @@ Done:
     CopyMem (mNvVariableCache, (UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
   }
 
+  RebuildVariableIndex (IsVolatile ? VariableStoreTypeVolatile : VariableStoreTypeNv);
+
   return Status;
 }
 
+/**
+  Find the variable in the specified variable store through its variable store index.
+
+  Walks the variables with the same hash in store order and applies the same
+  matching rules as FindVariableEx().
+
+  @param  VariableName        Name of the variable to be found, must not be an empty string.
+  @param  VendorGuid          Vendor GUID to be found.
+  @param  IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                              check at runtime when searching variable.
+  @param  VarStoreHeader      Pointer to the variable store.
+  @param  Index               Pointer to the index of the variable store.
+  @param  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+
+  @retval  EFI_SUCCESS            Variable found successfully
+  @retval  EFI_NOT_FOUND          Variable not found
+**/
+EFI_STATUS
+FindVariableByIndex (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN     VARIABLE_STORE_HEADER   *VarStoreHeader,
+  IN     VARIABLE_INDEX          *Index,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_HEADER                *InDeletedVariable;
+  VARIABLE_HEADER                *Variable;
+  UINT32                         Entry;
+
+  InDeletedVariable = NULL;
+
+  for ( Entry = Index->Head[GetVariableIndexBucket (VariableName, StrSize (VariableName), VendorGuid)]
+      ; Entry != VARIABLE_INDEX_END
+      ; Entry = Index->Entry[Entry].Next
+      ) {
+    Variable = (VARIABLE_HEADER *) ((UINTN) VarStoreHeader + Index->Entry[Entry].Offset);
+    if (Variable->State != VAR_ADDED && Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      continue;
+    }
+    if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+      continue;
+    }
+    if (!CompareGuid (VendorGuid, &Variable->VendorGuid)) {
+      continue;
+    }
+
+    ASSERT (NameSizeOfVariable (Variable) != 0);
+    if (CompareMem (VariableName, GetVariableNamePtr (Variable), NameSizeOfVariable (Variable)) == 0) {
+      if (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+        InDeletedVariable = Variable;
+      } else {
+        PtrTrack->CurrPtr                = Variable;
+        PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  PtrTrack->CurrPtr = InDeletedVariable;
+  return (PtrTrack->CurrPtr  == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -844,9 +1291,24 @@ FindVariableEx (
 {
   VARIABLE_HEADER                *InDeletedVariable;
   VOID                           *Point;
+  VARIABLE_STORE_TYPE            Type;
+  VARIABLE_STORE_HEADER          *VarStoreHeader;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
+  //
+  // Look a named variable up through the store index if the store is indexed.
+  //
+  if (VariableName[0] != 0) {
+    for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+      VarStoreHeader = GetIndexedVariableStore (Type);
+      if ((mVariableIndex[Type] != NULL) && mVariableIndex[Type]->Valid &&
+          (VarStoreHeader != NULL) && (PtrTrack->StartPtr == GetStartPointer (VarStoreHeader))) {
+        return FindVariableByIndex (VariableName, VendorGuid, IgnoreRtCheck, VarStoreHeader, mVariableIndex[Type], PtrTrack);
+      }
+    }
+  }
+
   //
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
@@ -2002,6 +2464,7 @@ UpdateVariable (
     // update the memory copy of Flash region.
     //
     CopyMem ((UINT8 *)mNvVariableCache + CacheOffset, (UINT8 *)NextVariable, VarSize);
+    UpdateVariableIndex (VariableStoreTypeNv, CacheOffset);
   } else {
     //
     // Create a volatile variable.
@@ -2043,6 +2506,7 @@ UpdateVariable (
       goto Done;
     }
 
+    UpdateVariableIndex (VariableStoreTypeVolatile, mVariableModuleGlobal->VolatileLastVariableOffset);
     mVariableModuleGlobal->VolatileLastVariableOffset += HEADER_ALIGN (VarSize);
   }
 
@@ -2383,6 +2847,10 @@ VariableServiceGetNextVariableName (
 
   AcquireLockOnlyAtBootTime(&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
 
+  //
+  // The previous variable is looked up through the variable store indexes, so
+  // the walk resumes right after it instead of rescanning the stores.
+  //
   Status = FindVariable (VariableName, VendorGuid, &Variable, &mVariableModuleGlobal->VariableGlobal, FALSE);
   if (Variable.CurrPtr == NULL || EFI_ERROR (Status)) {
     goto Done;
@@ -2912,6 +3380,8 @@ VariableServiceQueryVariableInfo (
 
 /**
   This function reclaims variable storage if free size is below the threshold.
+  It is called on ReadyToBoot, so that runtime SetVariable () calls find enough
+  free space without a reclaim.
   
 **/
 VOID
@@ -3314,8 +3784,16 @@ VariableCommonInitialize (
     }
     FreePool (mVariableModuleGlobal);
     FreePool (VolatileVariableStore);
+    return Status;
   }
 
+  //
+  // Index the volatile and non-volatile variable stores. Without an index,
+  // variables are found by walking the store.
+  //
+  CreateVariableIndex (VariableStoreTypeVolatile);
+  CreateVariableIndex (VariableStoreTypeNv);
+
   return Status;
 }
 
@@ -98,6 +98,38 @@ typedef struct {
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
 } VARIABLE_MODULE_GLOBAL;
 
+///
+/// Number of hash buckets of a variable store index, must be a power of 2.
+///
+#define VARIABLE_INDEX_BUCKET_COUNT   256
+#define VARIABLE_INDEX_END            0xFFFFFFFF
+
+typedef struct {
+  ///
+  /// Offset of the variable header from the variable store header.
+  ///
+  UINT32      Offset;
+  ///
+  /// Next entry in the same bucket, or VARIABLE_INDEX_END.
+  ///
+  UINT32      Next;
+} VARIABLE_INDEX_ENTRY;
+
+///
+/// Hash index of the ADDED and IN_DELETED_TRANSITION variables in a variable
+/// store, keyed by (VendorGuid, Name). Each bucket lists its variables in the
+/// order they appear in the store. Only offsets are kept so that the index needs
+/// no fix up when the store is converted to virtual addresses.
+///
+typedef struct {
+  BOOLEAN               Valid;
+  UINT32                EntryCount;
+  UINT32                MaxEntryCount;
+  UINT32                Head[VARIABLE_INDEX_BUCKET_COUNT];
+  UINT32                Tail[VARIABLE_INDEX_BUCKET_COUNT];
+  VARIABLE_INDEX_ENTRY  Entry[1];
+} VARIABLE_INDEX;
+
 typedef struct {
   EFI_GUID    *Guid;
   CHAR16      *Name;
@@ -129,6 +161,7 @@ FlushHobVariableToFlash (
   This function writes a buffer to variable storage space into a firmware
   volume block device. The destination is specified by the parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
+  Only the range which differs from the current content is written.
 
   @param  VariableBase   Base address of the variable to write.
   @param  VariableBuffer Point to the variable data buffer.
@@ -349,6 +382,27 @@ GetFtwProtocol (
   OUT VOID                                **FtwProtocol
   );
 
+/**
+  Gets the base address and the block size of the firmware volume which
+  contains the given address.
+
+  @param  Address        Address which should be contained
+                         by the firmware volume.
+  @param  FvbBaseAddress Pointer to the base address of the firmware volume for output.
+  @param  BlockSize      Pointer to the block size for output.
+
+  @retval EFI_SUCCESS    Base address and block size successfully returned.
+  @retval EFI_NOT_FOUND  Fail to find FVB handle by address.
+  @retval EFI_ABORTED    The firmware volume has no valid block map.
+
+**/
+EFI_STATUS
+GetBlockSizeByAddress (
+  IN  EFI_PHYSICAL_ADDRESS   Address,
+  OUT EFI_PHYSICAL_ADDRESS   *FvbBaseAddress,
+  OUT UINTN                  *BlockSize
+  );
+
 /**
   Get the proper fvb handle and/or fvb protocol by the given Flash address.
 
@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "Variable.h"
 
 extern VARIABLE_STORE_HEADER   *mNvVariableCache;
+extern VARIABLE_INDEX          *mVariableIndex[VariableStoreTypeMax];
 extern VARIABLE_INFO_ENTRY     *gVariableInfo;
 EFI_HANDLE                     mHandle                    = NULL;
 EFI_EVENT                      mVirtualAddressChangeEvent = NULL;
@@ -242,6 +243,11 @@ VariableClassAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.HobVariableBase);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal);
   EfiConvertPointer (0x0, (VOID **) &mNvVariableCache);  
+  //
+  // The variable store indexes only hold offsets into the stores.
+  //
+  EfiConvertPointer (0x0, (VOID **) &mVariableIndex[VariableStoreTypeVolatile]);
+  EfiConvertPointer (0x0, (VOID **) &mVariableIndex[VariableStoreTypeNv]);
 
   //
   // in the list of locked variables, convert the name pointers first
@@ -3225,6 +3225,30 @@ CalculateCheckSum64 (
   );
 
 
+/**
+  Computes and returns the 32-bit CRC of a buffer.
+
+  This function computes the CRC32 defined by ITU-T V.42, which is the CRC
+  returned by the CalculateCrc32() boot service. If Length is 0, then 0 is
+  returned.
+
+  If Buffer is NULL, then ASSERT().
+  If Length is greater than (MAX_ADDRESS - Buffer + 1), then ASSERT().
+
+  @param  Buffer      The pointer to the buffer to carry out the CRC operation.
+  @param  Length      The size, in bytes, of Buffer.
+
+  @return Crc32       The 32-bit CRC of Buffer.
+
+**/
+UINT32
+EFIAPI
+CalculateCrc32 (
+  IN      CONST VOID               *Buffer,
+  IN      UINTN                     Length
+  );
+
+
 //
 // Base Library CPU Functions
 //
@@ -0,0 +1,377 @@
+/** @file
+  Measures the cost of the dbx lookups done by the image verification handler.
+  The application installs synthetic dbx variables holding thousands of SHA-256
+  hashes, then counts how many times its own image can be loaded and unloaded
+  over a fixed period with each of them, and prints the results as operations
+  per second.
+
+  The platform must be in user mode with Secure Boot enabled, and must allow
+  custom mode, since db and dbx are written without a signature. The SHA-256
+  hash of this image is appended to db so that its verification succeeds after
+  the dbx lookup. db, dbx and the custom mode are restored before exit.
+
+  Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Uefi.h>
+#include <Protocol/LoadedImage.h>
+#include <Guid/GlobalVariable.h>
+#include <Guid/ImageAuthentication.h>
+#include <Guid/AuthenticatedVariableFormat.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/PeImageDigestLib.h>
+
+#define SIGNATURE_DATABASE_PERF_SECONDS   2
+
+#define SIGNATURE_DATABASE_ATTRIBUTES     (EFI_VARIABLE_NON_VOLATILE | \
+                                           EFI_VARIABLE_BOOTSERVICE_ACCESS | \
+                                           EFI_VARIABLE_RUNTIME_ACCESS | \
+                                           EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS)
+
+//
+// Number of hashes in each synthetic dbx
+//
+UINTN     mDbxHashCount[] = { 16, 256, 1024, 4096, 16384 };
+
+EFI_GUID  mSignatureDatabasePerfOwner = { 0x8566fb5b, 0x55b3, 0x4cad, { 0x8d, 0x70, 0xf5, 0xb1, 0x7d, 0x39, 0xe0, 0xcb } };
+
+/**
+  Write a signature database in custom mode. The data is prefixed with an
+  EFI_VARIABLE_AUTHENTICATION_2 descriptor without certificate data.
+
+  @param[in]  VariableName   The database variable, db or dbx.
+  @param[in]  Attributes     Additional attributes, EFI_VARIABLE_APPEND_WRITE or 0.
+  @param[in]  Data           The signature lists, or NULL to delete the variable.
+  @param[in]  DataSize       The size of Data.
+
+  @retval EFI_SUCCESS             The variable was written.
+  @retval EFI_OUT_OF_RESOURCES    No enough memory for the payload.
+  @retval Others                  The status returned by SetVariable().
+
+**/
+EFI_STATUS
+SetSignatureDatabase (
+  IN CHAR16                         *VariableName,
+  IN UINT32                         Attributes,
+  IN VOID                           *Data,
+  IN UINTN                          DataSize
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_VARIABLE_AUTHENTICATION_2     *Descriptor;
+  UINTN                             DescriptorSize;
+
+  DescriptorSize = OFFSET_OF (EFI_VARIABLE_AUTHENTICATION_2, AuthInfo) + OFFSET_OF (WIN_CERTIFICATE_UEFI_GUID, CertData);
+  Descriptor     = AllocateZeroPool (DescriptorSize + DataSize);
+  if (Descriptor == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gRT->GetTime (&Descriptor->TimeStamp, NULL);
+  if (EFI_ERROR (Status)) {
+    FreePool (Descriptor);
+    return Status;
+  }
+  Descriptor->TimeStamp.Pad1       = 0;
+  Descriptor->TimeStamp.Nanosecond = 0;
+  Descriptor->TimeStamp.TimeZone   = 0;
+  Descriptor->TimeStamp.Daylight   = 0;
+  Descriptor->TimeStamp.Pad2       = 0;
+
+  Descriptor->AuthInfo.Hdr.dwLength         = OFFSET_OF (WIN_CERTIFICATE_UEFI_GUID, CertData);
+  Descriptor->AuthInfo.Hdr.wRevision        = 0x0200;
+  Descriptor->AuthInfo.Hdr.wCertificateType = WIN_CERT_TYPE_EFI_GUID;
+  CopyGuid (&Descriptor->AuthInfo.CertType, &gEfiCertPkcs7Guid);
+
+  if (Data != NULL) {
+    CopyMem ((UINT8 *) Descriptor + DescriptorSize, Data, DataSize);
+  }
+
+  Status = gRT->SetVariable (
+                  VariableName,
+                  &gEfiImageSecurityDatabaseGuid,
+                  SIGNATURE_DATABASE_ATTRIBUTES | Attributes,
+                  DescriptorSize + DataSize,
+                  Descriptor
+                  );
+  FreePool (Descriptor);
+  return Status;
+}
+
+/**
+  Create a signature list of SHA-256 hashes. The hashes are filled with a
+  pseudo random sequence, so that they are not sorted in the list.
+
+  @param[in]   HashCount      The number of hashes in the list.
+  @param[in]   Hash           The hash to put in the list, or NULL for random
+                              hashes only.
+  @param[out]  ListSize       The size of the signature list.
+
+  @return The signature list, or NULL if there is no enough memory.
+
+**/
+EFI_SIGNATURE_LIST *
+CreateSha256SignatureList (
+  IN  UINTN                         HashCount,
+  IN  UINT8                         *Hash,    OPTIONAL
+  OUT UINTN                         *ListSize
+  )
+{
+  EFI_SIGNATURE_LIST                *List;
+  EFI_SIGNATURE_DATA                *Cert;
+  UINTN                             SignatureSize;
+  UINT32                            Seed;
+  UINTN                             Index;
+  UINTN                             Byte;
+
+  SignatureSize = OFFSET_OF (EFI_SIGNATURE_DATA, SignatureData) + SHA256_DIGEST_SIZE;
+  *ListSize     = sizeof (EFI_SIGNATURE_LIST) + HashCount * SignatureSize;
+  List          = AllocateZeroPool (*ListSize);
+  if (List == NULL) {
+    return NULL;
+  }
+
+  CopyGuid (&List->SignatureType, &gEfiCertSha256Guid);
+  List->SignatureListSize   = (UINT32) *ListSize;
+  List->SignatureHeaderSize = 0;
+  List->SignatureSize       = (UINT32) SignatureSize;
+
+  Seed = 0x12345678;
+  Cert = (EFI_SIGNATURE_DATA *) (List + 1);
+  for (Index = 0; Index < HashCount; Index++) {
+    CopyGuid (&Cert->SignatureOwner, &mSignatureDatabasePerfOwner);
+    if (Hash != NULL) {
+      CopyMem (Cert->SignatureData, Hash, SHA256_DIGEST_SIZE);
+    } else {
+      for (Byte = 0; Byte < SHA256_DIGEST_SIZE; Byte++) {
+        Seed = Seed * 1103515245 + 12345;
+        Cert->SignatureData[Byte] = (UINT8) (Seed >> 16);
+      }
+    }
+    Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + SignatureSize);
+  }
+
+  return List;
+}
+
+/**
+  Counts how many times the image can be loaded and unloaded within
+  SIGNATURE_DATABASE_PERF_SECONDS and prints the rate.
+
+  @param[in] ParentImage        The image handle of this application.
+  @param[in] DevicePath         The device path of the image file.
+  @param[in] ImageBuffer        The image file.
+  @param[in] ImageSize          The size of the image file.
+  @param[in] HashCount          The number of hashes in dbx, printed with the rate.
+
+  @retval EFI_SUCCESS           The test ran.
+  @retval other                 The image could not be loaded.
+
+**/
+EFI_STATUS
+MeasureSignatureDatabasePerf (
+  IN EFI_HANDLE                 ParentImage,
+  IN EFI_DEVICE_PATH_PROTOCOL   *DevicePath,
+  IN VOID                       *ImageBuffer,
+  IN UINTN                      ImageSize,
+  IN UINTN                      HashCount
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  EFI_HANDLE  ImageHandle;
+  UINTN       Count;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The timer period is in 100ns units
+  //
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x32 (SIGNATURE_DATABASE_PERF_SECONDS, 10000000));
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (TimerEvent);
+    return Status;
+  }
+
+  for (Count = 0; gBS->CheckEvent (TimerEvent) == EFI_NOT_READY; Count++) {
+    Status = gBS->LoadImage (FALSE, ParentImage, DevicePath, ImageBuffer, ImageSize, &ImageHandle);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    gBS->UnloadImage (ImageHandle);
+  }
+
+  gBS->CloseEvent (TimerEvent);
+
+  if (EFI_ERROR (Status)) {
+    Print (L"LoadImage with %d hashes in dbx failed - %r\n", (UINT32) HashCount, Status);
+    return Status;
+  }
+
+  Print (L"LoadImage, %6d hashes in dbx     %10ld per second\n", (UINT32) HashCount, (UINT64) (Count / SIGNATURE_DATABASE_PERF_SECONDS));
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the image goes into a library that calls this
+  function.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
+  UINT8                       *SecureBoot;
+  UINT8                       *ImageBuffer;
+  UINTN                       ImageSize;
+  UINT32                      AuthenticationStatus;
+  PE_IMAGE_DIGEST             Digest;
+  UINT8                       *Db;
+  UINTN                       DbSize;
+  UINT8                       *Dbx;
+  UINTN                       DbxSize;
+  EFI_SIGNATURE_LIST          *List;
+  UINTN                       ListSize;
+  UINT8                       Mode;
+  UINTN                       Index;
+
+  GetEfiGlobalVariable2 (EFI_SECURE_BOOT_MODE_NAME, (VOID **) &SecureBoot, NULL);
+  if (SecureBoot == NULL || *SecureBoot != SECURE_BOOT_MODE_ENABLE) {
+    Print (L"Secure Boot is not enabled, images are not verified\n");
+    if (SecureBoot != NULL) {
+      FreePool (SecureBoot);
+    }
+    return EFI_UNSUPPORTED;
+  }
+  FreePool (SecureBoot);
+
+  //
+  // Read this image and compute its Authenticode hash.
+  //
+  Status = gBS->HandleProtocol (ImageHandle, &gEfiLoadedImageDevicePathProtocolGuid, (VOID **) &DevicePath);
+  if (EFI_ERROR (Status) || DevicePath == NULL) {
+    Print (L"No device path for this image\n");
+    return EFI_UNSUPPORTED;
+  }
+
+  ImageBuffer = GetFileBufferByFilePath (FALSE, DevicePath, &ImageSize, &AuthenticationStatus);
+  if (ImageBuffer == NULL) {
+    Print (L"Failed to read this image\n");
+    return EFI_NOT_FOUND;
+  }
+
+  Status = GetPeImageDigest (NULL, ImageBuffer, ImageSize, PE_IMAGE_DIGEST_SHA256, &Digest);
+  if (EFI_ERROR (Status)) {
+    Print (L"Failed to hash this image - %r\n", Status);
+    FreePool (ImageBuffer);
+    return Status;
+  }
+
+  GetVariable2 (EFI_IMAGE_SECURITY_DATABASE, &gEfiImageSecurityDatabaseGuid, (VOID **) &Db, &DbSize);
+  GetVariable2 (EFI_IMAGE_SECURITY_DATABASE1, &gEfiImageSecurityDatabaseGuid, (VOID **) &Dbx, &DbxSize);
+
+  Mode   = CUSTOM_SECURE_BOOT_MODE;
+  Status = gRT->SetVariable (
+                  EFI_CUSTOM_MODE_NAME,
+                  &gEfiCustomModeEnableGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (Mode),
+                  &Mode
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"Failed to enter custom mode - %r\n", Status);
+    goto Done;
+  }
+
+  //
+  // Allow this image through db, so each load looks it up in dbx and then db.
+  //
+  List = CreateSha256SignatureList (1, Digest.Sha256, &ListSize);
+  if (List == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Restore;
+  }
+  Status = SetSignatureDatabase (EFI_IMAGE_SECURITY_DATABASE, EFI_VARIABLE_APPEND_WRITE, List, ListSize);
+  FreePool (List);
+  if (EFI_ERROR (Status)) {
+    Print (L"Failed to append the image hash to db - %r\n", Status);
+    goto Restore;
+  }
+
+  Print (L"%d seconds per test\n", SIGNATURE_DATABASE_PERF_SECONDS);
+  for (Index = 0; Index < sizeof (mDbxHashCount) / sizeof (mDbxHashCount[0]); Index++) {
+    List = CreateSha256SignatureList (mDbxHashCount[Index], NULL, &ListSize);
+    if (List == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+    Status = SetSignatureDatabase (EFI_IMAGE_SECURITY_DATABASE1, 0, List, ListSize);
+    FreePool (List);
+    if (EFI_ERROR (Status)) {
+      //
+      // Larger databases than the variable services hold are skipped.
+      //
+      Print (L"Failed to write dbx with %d hashes - %r\n", (UINT32) mDbxHashCount[Index], Status);
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    Status = MeasureSignatureDatabasePerf (ImageHandle, DevicePath, ImageBuffer, ImageSize, mDbxHashCount[Index]);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+Restore:
+  SetSignatureDatabase (EFI_IMAGE_SECURITY_DATABASE, 0, Db, DbSize);
+  SetSignatureDatabase (EFI_IMAGE_SECURITY_DATABASE1, 0, Dbx, DbxSize);
+
+  Mode = STANDARD_SECURE_BOOT_MODE;
+  gRT->SetVariable (
+         EFI_CUSTOM_MODE_NAME,
+         &gEfiCustomModeEnableGuid,
+         EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+         sizeof (Mode),
+         &Mode
+         );
+
+Done:
+  if (Db != NULL) {
+    FreePool (Db);
+  }
+  if (Dbx != NULL) {
+    FreePool (Dbx);
+  }
+  FreePool (ImageBuffer);
+  return Status;
+}
@@ -0,0 +1,81 @@
+/** @file
+  This library computes the Authenticode digests of a PE/COFF image, as defined
+  in PE/COFF Specification 8.0 Appendix A, for the image verification and the
+  measured boot services.
+
+  All the digests needed for one image are computed in a single pass over the
+  image, and the result is kept for the next Security2 handler asking for the
+  same image, so an image is hashed once no matter how many services consume it.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _PE_IMAGE_DIGEST_LIB_H_
+#define _PE_IMAGE_DIGEST_LIB_H_
+
+#include <Protocol/DevicePath.h>
+#include <Library/BaseCryptLib.h>
+
+//
+// Digest algorithms which can be requested from GetPeImageDigest().
+//
+#define PE_IMAGE_DIGEST_SHA1      BIT0
+#define PE_IMAGE_DIGEST_SHA256    BIT1
+
+///
+/// Authenticode digests of one PE/COFF image. Only the digests whose bit is
+/// set in DigestMask are valid.
+///
+typedef struct {
+  UINT32   DigestMask;
+  UINT8    Sha1[SHA1_DIGEST_SIZE];
+  UINT8    Sha256[SHA256_DIGEST_SIZE];
+} PE_IMAGE_DIGEST;
+
+/**
+  Get the Authenticode digests of a PE/COFF image.
+
+  Within one run of the Security2 handlers, the digests are returned from the
+  cache when File, ImageBase and ImageSize identify the image hashed last.
+  Otherwise every digest requested so far by any caller is computed in a single
+  pass over the image, so that the other consumers of the same image can be
+  served from the cache.
+
+  Caution: This function may receive untrusted input.
+  The caller must have validated the PE/COFF image with PeCoffLoaderGetImageInfo()
+  before calling this function.
+
+  @param[in]  File          The file device path the Security2 handler received
+                            for the image, or NULL.
+  @param[in]  ImageBase     Pointer to the PE/COFF image buffer.
+  @param[in]  ImageSize     Size of the image buffer in bytes.
+  @param[in]  DigestMask    The digests needed by the caller, a combination of
+                            PE_IMAGE_DIGEST_SHA1 and PE_IMAGE_DIGEST_SHA256.
+  @param[out] Digest        Receives the digests. At least the requested ones are valid.
+
+  @retval EFI_SUCCESS             The requested digests were returned.
+  @retval EFI_INVALID_PARAMETER   ImageBase or Digest is NULL, or DigestMask is not supported.
+  @retval EFI_UNSUPPORTED         The image is not a well-formed PE/COFF image.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory to hash the image.
+  @retval EFI_ABORTED             The hash algorithm failed.
+
+**/
+EFI_STATUS
+EFIAPI
+GetPeImageDigest (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *File,  OPTIONAL
+  IN  VOID                            *ImageBase,
+  IN  UINTN                           ImageSize,
+  IN  UINT32                          DigestMask,
+  OUT PE_IMAGE_DIGEST                 *Digest
+  );
+
+#endif
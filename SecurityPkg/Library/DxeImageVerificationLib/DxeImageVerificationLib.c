@@ -38,6 +38,7 @@ EFI_GUID                            mCertType;
 //
 UINTN                               mImageSize;
 UINT8                               *mImageBase       = NULL;
+CONST EFI_DEVICE_PATH_PROTOCOL      *mImageFile       = NULL;
 UINT8                               mImageDigest[MAX_DIGEST_SIZE];
 UINTN                               mImageDigestSize;
 
@@ -71,6 +72,27 @@ HASH_TABLE mHash[] = {
   { L"SHA512", 64, &mHashOidValue[32], 9, NULL,                NULL,       NULL,          NULL       }
 };
 
+//
+// Signature databases read by image verification. The index of a database is
+// only built again when the content of its variable changes.
+//
+SIGNATURE_DATABASE_CACHE mSignatureDatabaseCache[] = {
+  { EFI_IMAGE_SECURITY_DATABASE,  NULL, 0, 0, 0, { 0 }, NULL, 0 },
+  { EFI_IMAGE_SECURITY_DATABASE1, NULL, 0, 0, 0, { 0 }, NULL, 0 }
+};
+
+//
+// Buffer the signature database variables are read into before they are
+// compared against the cached copy.
+//
+UINT8             *mSignatureDatabaseBuffer     = NULL;
+UINTN             mSignatureDatabaseBufferSize  = 0;
+
+//
+// SHA-256 context to digest the signature database variables.
+//
+VOID              *mSignatureDatabaseHashCtx    = NULL;
+
 /**
   SecureBoot Hook for processing image verification.
 
@@ -288,27 +310,8 @@ HashPeImage (
   IN  UINT32              HashAlg
   )
 {
-  BOOLEAN                   Status;
-  UINT16                    Magic;
-  EFI_IMAGE_SECTION_HEADER  *Section;
-  VOID                      *HashCtx;
-  UINTN                     CtxSize;
-  UINT8                     *HashBase;
-  UINTN                     HashSize;
-  UINTN                     SumOfBytesHashed;
-  EFI_IMAGE_SECTION_HEADER  *SectionHeader;
-  UINTN                     Index;
-  UINTN                     Pos;
-  UINT32                    CertSize;
-  UINT32                    NumberOfRvaAndSizes;
-
-  HashCtx       = NULL;
-  SectionHeader = NULL;
-  Status        = FALSE;
-
-  if ((HashAlg != HASHALG_SHA1) && (HashAlg != HASHALG_SHA256)) {
-    return FALSE;
-  }
+  EFI_STATUS                Status;
+  PE_IMAGE_DIGEST           Digest;
 
   //
   // Initialize context of hash.
@@ -325,272 +328,28 @@ HashPeImage (
     return FALSE;
   }
 
-  CtxSize   = mHash[HashAlg].GetContextSize();
-
-  HashCtx = AllocatePool (CtxSize);
-  if (HashCtx == NULL) {
-    return FALSE;
-  }
-
-  // 1.  Load the image header into memory.
-
-  // 2.  Initialize a SHA hash context.
-  Status = mHash[HashAlg].HashInit(HashCtx);
-
-  if (!Status) {
-    goto Done;
-  }
-
   //
-  // Measuring PE/COFF Image Header;
-  // But CheckSum field and SECURITY data directory (certificate) are excluded
+  // The digests are computed in one pass over the image and shared with the
+  // measured boot handler, which hashes the same image buffer.
   //
-  if (mNtHeader.Pe32->FileHeader.Machine == IMAGE_FILE_MACHINE_IA64 && mNtHeader.Pe32->OptionalHeader.Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-    //
-    // NOTE: Some versions of Linux ELILO for Itanium have an incorrect magic value 
-    //       in the PE/COFF Header. If the MachineType is Itanium(IA64) and the 
-    //       Magic value in the OptionalHeader is EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC
-    //       then override the magic value to EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC
-    //
-    Magic = EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC;
-  } else {
-    //
-    // Get the magic value from the PE/COFF Optional Header
-    //
-    Magic =  mNtHeader.Pe32->OptionalHeader.Magic;
-  }
-  
-  //
-  // 3.  Calculate the distance from the base of the image header to the image checksum address.
-  // 4.  Hash the image header from its base to beginning of the image checksum.
-  //
-  HashBase = mImageBase;
-  if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-    //
-    // Use PE32 offset.
-    //
-    HashSize = (UINTN) ((UINT8 *) (&mNtHeader.Pe32->OptionalHeader.CheckSum) - HashBase);
-    NumberOfRvaAndSizes = mNtHeader.Pe32->OptionalHeader.NumberOfRvaAndSizes;
-  } else if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC) {
-    //
-    // Use PE32+ offset.
-    //
-    HashSize = (UINTN) ((UINT8 *) (&mNtHeader.Pe32Plus->OptionalHeader.CheckSum) - HashBase);
-    NumberOfRvaAndSizes = mNtHeader.Pe32Plus->OptionalHeader.NumberOfRvaAndSizes;
-  } else {
-    //
-    // Invalid header magic number.
-    //
-    Status = FALSE;
-    goto Done;
-  }
-
-  Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-  if (!Status) {
-    goto Done;
-  }
-
-  //
-  // 5.  Skip over the image checksum (it occupies a single ULONG).
-  //
-  if (NumberOfRvaAndSizes <= EFI_IMAGE_DIRECTORY_ENTRY_SECURITY) {
-    //
-    // 6.  Since there is no Cert Directory in optional header, hash everything
-    //     from the end of the checksum to the end of image header.
-    //
-    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-      //
-      // Use PE32 offset.
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32->OptionalHeader.CheckSum + sizeof (UINT32);
-      HashSize = mNtHeader.Pe32->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - mImageBase);
-    } else {
-      //
-      // Use PE32+ offset.
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32Plus->OptionalHeader.CheckSum + sizeof (UINT32);
-      HashSize = mNtHeader.Pe32Plus->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - mImageBase);
-    }
-
-    if (HashSize != 0) {
-      Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-      if (!Status) {
-        goto Done;
-      }
-    }
-  } else {
-    //
-    // 7.  Hash everything from the end of the checksum to the start of the Cert Directory.
-    //
-    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-      //
-      // Use PE32 offset.
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32->OptionalHeader.CheckSum + sizeof (UINT32);
-      HashSize = (UINTN) ((UINT8 *) (&mNtHeader.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY]) - HashBase);
-    } else {
-      //
-      // Use PE32+ offset.
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32Plus->OptionalHeader.CheckSum + sizeof (UINT32);
-      HashSize = (UINTN) ((UINT8 *) (&mNtHeader.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY]) - HashBase);
-    }
-
-    if (HashSize != 0) {
-      Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-      if (!Status) {
-        goto Done;
-      }
-    }
-
-    //
-    // 8.  Skip over the Cert Directory. (It is sizeof(IMAGE_DATA_DIRECTORY) bytes.)
-    // 9.  Hash everything from the end of the Cert Directory to the end of image header.
-    //
-    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-      //
-      // Use PE32 offset
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY + 1];
-      HashSize = mNtHeader.Pe32->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - mImageBase);
-    } else {
-      //
-      // Use PE32+ offset.
-      //
-      HashBase = (UINT8 *) &mNtHeader.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY + 1];
-      HashSize = mNtHeader.Pe32Plus->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - mImageBase);
-    }
-
-    if (HashSize != 0) {
-      Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-      if (!Status) {
-        goto Done;
-      }
-    }    
+  Status = GetPeImageDigest (
+             mImageFile,
+             mImageBase,
+             mImageSize,
+             (HashAlg == HASHALG_SHA1) ? PE_IMAGE_DIGEST_SHA1 : PE_IMAGE_DIGEST_SHA256,
+             &Digest
+             );
+  if (EFI_ERROR (Status)) {
+    return FALSE;
   }
 
-  //
-  // 10. Set the SUM_OF_BYTES_HASHED to the size of the header.
-  //
-  if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-    //
-    // Use PE32 offset.
-    //
-    SumOfBytesHashed = mNtHeader.Pe32->OptionalHeader.SizeOfHeaders;
+  if (HashAlg == HASHALG_SHA1) {
+    CopyMem (mImageDigest, Digest.Sha1, SHA1_DIGEST_SIZE);
   } else {
-    //
-    // Use PE32+ offset
-    //
-    SumOfBytesHashed = mNtHeader.Pe32Plus->OptionalHeader.SizeOfHeaders;
-  }
-
-
-  Section = (EFI_IMAGE_SECTION_HEADER *) (
-               mImageBase +
-               mPeCoffHeaderOffset +
-               sizeof (UINT32) +
-               sizeof (EFI_IMAGE_FILE_HEADER) +
-               mNtHeader.Pe32->FileHeader.SizeOfOptionalHeader
-               );
-
-  //
-  // 11. Build a temporary table of pointers to all the IMAGE_SECTION_HEADER
-  //     structures in the image. The 'NumberOfSections' field of the image
-  //     header indicates how big the table should be. Do not include any
-  //     IMAGE_SECTION_HEADERs in the table whose 'SizeOfRawData' field is zero.
-  //
-  SectionHeader = (EFI_IMAGE_SECTION_HEADER *) AllocateZeroPool (sizeof (EFI_IMAGE_SECTION_HEADER) * mNtHeader.Pe32->FileHeader.NumberOfSections);
-  if (SectionHeader == NULL) {
-    Status = FALSE;
-    goto Done;
-  }
-  //
-  // 12.  Using the 'PointerToRawData' in the referenced section headers as
-  //      a key, arrange the elements in the table in ascending order. In other
-  //      words, sort the section headers according to the disk-file offset of
-  //      the section.
-  //
-  for (Index = 0; Index < mNtHeader.Pe32->FileHeader.NumberOfSections; Index++) {
-    Pos = Index;
-    while ((Pos > 0) && (Section->PointerToRawData < SectionHeader[Pos - 1].PointerToRawData)) {
-      CopyMem (&SectionHeader[Pos], &SectionHeader[Pos - 1], sizeof (EFI_IMAGE_SECTION_HEADER));
-      Pos--;
-    }
-    CopyMem (&SectionHeader[Pos], Section, sizeof (EFI_IMAGE_SECTION_HEADER));
-    Section += 1;
-  }
-
-  //
-  // 13.  Walk through the sorted table, bring the corresponding section
-  //      into memory, and hash the entire section (using the 'SizeOfRawData'
-  //      field in the section header to determine the amount of data to hash).
-  // 14.  Add the section's 'SizeOfRawData' to SUM_OF_BYTES_HASHED .
-  // 15.  Repeat steps 13 and 14 for all the sections in the sorted table.
-  //
-  for (Index = 0; Index < mNtHeader.Pe32->FileHeader.NumberOfSections; Index++) {
-    Section = &SectionHeader[Index];
-    if (Section->SizeOfRawData == 0) {
-      continue;
-    }
-    HashBase  = mImageBase + Section->PointerToRawData;
-    HashSize  = (UINTN) Section->SizeOfRawData;
-
-    Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-    if (!Status) {
-      goto Done;
-    }
-
-    SumOfBytesHashed += HashSize;
-  }
-
-  //
-  // 16.  If the file size is greater than SUM_OF_BYTES_HASHED, there is extra
-  //      data in the file that needs to be added to the hash. This data begins
-  //      at file offset SUM_OF_BYTES_HASHED and its length is:
-  //             FileSize  -  (CertDirectory->Size)
-  //
-  if (mImageSize > SumOfBytesHashed) {
-    HashBase = mImageBase + SumOfBytesHashed;
-
-    if (NumberOfRvaAndSizes <= EFI_IMAGE_DIRECTORY_ENTRY_SECURITY) {
-      CertSize = 0;
-    } else {
-      if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-        //
-        // Use PE32 offset.
-        //
-        CertSize = mNtHeader.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].Size;
-      } else {
-        //
-        // Use PE32+ offset.
-        //
-        CertSize = mNtHeader.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].Size;
-      }
-    }
-
-    if (mImageSize > CertSize + SumOfBytesHashed) {
-      HashSize = (UINTN) (mImageSize - CertSize - SumOfBytesHashed);
-
-      Status  = mHash[HashAlg].HashUpdate(HashCtx, HashBase, HashSize);
-      if (!Status) {
-        goto Done;
-      }
-    } else if (mImageSize < CertSize + SumOfBytesHashed) {
-      Status = FALSE;
-      goto Done;
-    }
+    CopyMem (mImageDigest, Digest.Sha256, SHA256_DIGEST_SIZE);
   }
 
-  Status  = mHash[HashAlg].HashFinal(HashCtx, mImageDigest);
-
-Done:
-  if (HashCtx != NULL) {
-    FreePool (HashCtx);
-  }
-  if (SectionHeader != NULL) {
-    FreePool (SectionHeader);
-  }
-  return Status;
+  return TRUE;
 }
 
 /**
@@ -803,6 +562,338 @@ AddImageExeInfo (
   }
 }
 
+/**
+  Compare a signature in the database index against a search key.
+
+  @param[in]  Entry           The index entry.
+  @param[in]  CertType        Signature type of the key.
+  @param[in]  SignatureSize   Size of the signature data of the key, owner GUID excluded.
+  @param[in]  Signature       Signature data of the key.
+
+  @retval 0           The entry matches the key.
+  @retval <0          The entry sorts before the key.
+  @retval >0          The entry sorts after the key.
+
+**/
+INTN
+CompareSignatureIndexEntryToKey (
+  IN SIGNATURE_INDEX_ENTRY  *Entry,
+  IN EFI_GUID               *CertType,
+  IN UINTN                  SignatureSize,
+  IN UINT8                  *Signature
+  )
+{
+  UINTN  EntrySize;
+  INTN   Result;
+
+  EntrySize = Entry->CertList->SignatureSize - sizeof (EFI_GUID);
+  if (EntrySize != SignatureSize) {
+    return (EntrySize < SignatureSize) ? -1 : 1;
+  }
+
+  Result = CompareMem (&Entry->CertList->SignatureType, CertType, sizeof (EFI_GUID));
+  if (Result != 0) {
+    return Result;
+  }
+
+  return CompareMem (Entry->Cert->SignatureData, Signature, SignatureSize);
+}
+
+/**
+  Compare two signatures in the database index. Equal signatures are ordered
+  by their position in the variable, so the first match of a lookup is the
+  one the linear search of the database would find.
+
+  @param[in]  Entry1      The first index entry.
+  @param[in]  Entry2      The second index entry.
+
+  @retval 0           The entries are the same.
+  @retval <0          Entry1 sorts before Entry2.
+  @retval >0          Entry1 sorts after Entry2.
+
+**/
+INTN
+CompareSignatureIndexEntry (
+  IN SIGNATURE_INDEX_ENTRY  *Entry1,
+  IN SIGNATURE_INDEX_ENTRY  *Entry2
+  )
+{
+  INTN  Result;
+
+  Result = CompareSignatureIndexEntryToKey (
+             Entry1,
+             &Entry2->CertList->SignatureType,
+             Entry2->CertList->SignatureSize - sizeof (EFI_GUID),
+             Entry2->Cert->SignatureData
+             );
+  if (Result != 0) {
+    return Result;
+  }
+
+  if (Entry1->Cert == Entry2->Cert) {
+    return 0;
+  }
+  return ((UINTN) Entry1->Cert < (UINTN) Entry2->Cert) ? -1 : 1;
+}
+
+/**
+  Move an entry of the signature index heap down to its place.
+
+  @param[in, out]  Index     The signature index.
+  @param[in]       Root      The entry to move down.
+  @param[in]       Count     Number of entries in the heap.
+
+**/
+VOID
+SiftDownSignatureIndex (
+  IN OUT SIGNATURE_INDEX_ENTRY  *Index,
+  IN     UINTN                  Root,
+  IN     UINTN                  Count
+  )
+{
+  UINTN                  Child;
+  SIGNATURE_INDEX_ENTRY  Entry;
+
+  while ((Child = 2 * Root + 1) < Count) {
+    if ((Child + 1 < Count) && (CompareSignatureIndexEntry (&Index[Child], &Index[Child + 1]) < 0)) {
+      Child++;
+    }
+    if (CompareSignatureIndexEntry (&Index[Root], &Index[Child]) >= 0) {
+      break;
+    }
+    CopyMem (&Entry, &Index[Root], sizeof (Entry));
+    CopyMem (&Index[Root], &Index[Child], sizeof (Entry));
+    CopyMem (&Index[Child], &Entry, sizeof (Entry));
+    Root = Child;
+  }
+}
+
+/**
+  Parse a signature database and build the sorted index of its signatures.
+
+  @param[in, out]  Database     The signature database read from the variable.
+
+  @retval EFI_SUCCESS           The index was built.
+  @retval EFI_OUT_OF_RESOURCES  No enough memory for the index.
+
+**/
+EFI_STATUS
+BuildSignatureDatabaseIndex (
+  IN OUT SIGNATURE_DATABASE_CACHE  *Database
+  )
+{
+  EFI_SIGNATURE_LIST     *CertList;
+  EFI_SIGNATURE_DATA     *Cert;
+  SIGNATURE_INDEX_ENTRY  *Index;
+  SIGNATURE_INDEX_ENTRY  Entry;
+  UINTN                  DataSize;
+  UINTN                  CertCount;
+  UINTN                  Count;
+  UINTN                  Pass;
+  UINTN                  Loop;
+
+  Index = NULL;
+  Count = 0;
+
+  //
+  // The first pass counts the signatures, the second one fills the index.
+  //
+  for (Pass = 0; Pass < 2; Pass++) {
+    Count    = 0;
+    DataSize = Database->DataSize;
+    CertList = (EFI_SIGNATURE_LIST *) Database->Data;
+    while ((DataSize >= sizeof (EFI_SIGNATURE_LIST)) && (DataSize >= CertList->SignatureListSize)) {
+      if ((CertList->SignatureSize <= sizeof (EFI_GUID)) ||
+          (CertList->SignatureListSize < sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize)) {
+        break;
+      }
+      CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+      Cert      = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
+      for (Loop = 0; Loop < CertCount; Loop++) {
+        if (Index != NULL) {
+          Index[Count].CertList = CertList;
+          Index[Count].Cert     = Cert;
+        }
+        Count++;
+        Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + CertList->SignatureSize);
+      }
+
+      DataSize -= CertList->SignatureListSize;
+      CertList = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+    }
+
+    if ((Pass == 0) && (Count != 0)) {
+      Index = AllocatePool (Count * sizeof (SIGNATURE_INDEX_ENTRY));
+      if (Index == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+  }
+
+  //
+  // Heap sort the index.
+  //
+  for (Loop = Count / 2; Loop > 0; Loop--) {
+    SiftDownSignatureIndex (Index, Loop - 1, Count);
+  }
+  for (Loop = Count; Loop > 1; Loop--) {
+    CopyMem (&Entry, &Index[0], sizeof (Entry));
+    CopyMem (&Index[0], &Index[Loop - 1], sizeof (Entry));
+    CopyMem (&Index[Loop - 1], &Entry, sizeof (Entry));
+    SiftDownSignatureIndex (Index, 0, Loop - 1);
+  }
+
+  Database->Index      = Index;
+  Database->IndexCount = Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Release the content and the index of a cached signature database.
+
+  @param[in, out]  Database     The signature database.
+
+**/
+VOID
+ReleaseSignatureDatabase (
+  IN OUT SIGNATURE_DATABASE_CACHE  *Database
+  )
+{
+  if (Database->Data != NULL) {
+    FreePool (Database->Data);
+  }
+  if (Database->Index != NULL) {
+    FreePool (Database->Index);
+  }
+  Database->Data       = NULL;
+  Database->DataSize   = 0;
+  Database->BufferSize = 0;
+  Database->Attributes = 0;
+  Database->Index      = NULL;
+  Database->IndexCount = 0;
+  ZeroMem (Database->Digest, sizeof (Database->Digest));
+}
+
+/**
+  Get a signature database. The variable is read on each call, and the cached
+  copy and its index are replaced when the size, attributes or SHA-256 digest
+  of the variable differ from the cached ones.
+
+  @param[in]  VariableName    Name of the database variable, db or dbx.
+  @param[out] Database        The signature database. Data is NULL if the
+                              variable does not exist.
+
+  @retval EFI_SUCCESS             The database was returned.
+  @retval EFI_NOT_FOUND           VariableName is not a cached database.
+  @retval EFI_OUT_OF_RESOURCES    No enough memory to read the database.
+  @retval EFI_ABORTED             The database could not be digested.
+  @retval Others                  The variable could not be read.
+
+**/
+EFI_STATUS
+GetSignatureDatabase (
+  IN  CHAR16                    *VariableName,
+  OUT SIGNATURE_DATABASE_CACHE  **Database
+  )
+{
+  EFI_STATUS                Status;
+  SIGNATURE_DATABASE_CACHE  *Cache;
+  UINT8                     *Data;
+  UINTN                     DataSize;
+  UINTN                     BufferSize;
+  UINT32                    Attributes;
+  UINT8                     Digest[SHA256_DIGEST_SIZE];
+  UINTN                     Index;
+
+  Cache = NULL;
+  for (Index = 0; Index < sizeof (mSignatureDatabaseCache) / sizeof (mSignatureDatabaseCache[0]); Index++) {
+    if (StrCmp (VariableName, mSignatureDatabaseCache[Index].VariableName) == 0) {
+      Cache = &mSignatureDatabaseCache[Index];
+      break;
+    }
+  }
+  if (Cache == NULL) {
+    return EFI_NOT_FOUND;
+  }
+  *Database = Cache;
+
+  //
+  // Read signature database variable. A database that can not be read is empty.
+  //
+  DataSize = 0;
+  Status   = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    ReleaseSignatureDatabase (Cache);
+    return EFI_SUCCESS;
+  }
+
+  if (mSignatureDatabaseBufferSize < DataSize) {
+    if (mSignatureDatabaseBuffer != NULL) {
+      FreePool (mSignatureDatabaseBuffer);
+    }
+    mSignatureDatabaseBufferSize = 0;
+    mSignatureDatabaseBuffer     = (UINT8 *) AllocatePool (DataSize);
+    if (mSignatureDatabaseBuffer == NULL) {
+      ReleaseSignatureDatabase (Cache);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    mSignatureDatabaseBufferSize = DataSize;
+  }
+
+  Status = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, &Attributes, &DataSize, mSignatureDatabaseBuffer);
+  if (EFI_ERROR (Status)) {
+    ReleaseSignatureDatabase (Cache);
+    return Status;
+  }
+
+  if (mSignatureDatabaseHashCtx == NULL) {
+    mSignatureDatabaseHashCtx = AllocatePool (Sha256GetContextSize ());
+    if (mSignatureDatabaseHashCtx == NULL) {
+      ReleaseSignatureDatabase (Cache);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+  if (!Sha256Init (mSignatureDatabaseHashCtx) ||
+      !Sha256Update (mSignatureDatabaseHashCtx, mSignatureDatabaseBuffer, DataSize) ||
+      !Sha256Final (mSignatureDatabaseHashCtx, Digest)) {
+    ReleaseSignatureDatabase (Cache);
+    return EFI_ABORTED;
+  }
+
+  if ((Cache->Data != NULL) &&
+      (Cache->DataSize == DataSize) &&
+      (Cache->Attributes == Attributes) &&
+      (CompareMem (Cache->Digest, Digest, sizeof (Digest)) == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The variable changed. The buffer it was read into becomes the cached copy,
+  // and the pool of the previous copy is kept to read the next variable.
+  //
+  if (Cache->Index != NULL) {
+    FreePool (Cache->Index);
+  }
+  Data                          = Cache->Data;
+  BufferSize                    = Cache->BufferSize;
+  Cache->Data                   = mSignatureDatabaseBuffer;
+  Cache->DataSize               = DataSize;
+  Cache->BufferSize             = mSignatureDatabaseBufferSize;
+  Cache->Attributes             = Attributes;
+  Cache->Index                  = NULL;
+  Cache->IndexCount             = 0;
+  CopyMem (Cache->Digest, Digest, sizeof (Digest));
+  mSignatureDatabaseBuffer      = Data;
+  mSignatureDatabaseBufferSize  = BufferSize;
+
+  //
+  // Without memory for the index, the database is searched linearly.
+  //
+  BuildSignatureDatabaseIndex (Cache);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Check whether signature is in specified database.
 
@@ -823,39 +914,54 @@ IsSignatureFoundInDatabase (
   IN UINTN              SignatureSize
   )
 {
-  EFI_STATUS          Status;
-  EFI_SIGNATURE_LIST  *CertList;
-  EFI_SIGNATURE_DATA  *Cert;
-  UINTN               DataSize;
-  UINT8               *Data;
-  UINTN               Index;
-  UINTN               CertCount;
-  BOOLEAN             IsFound;
-  //
-  // Read signature database variable.
-  //
-  IsFound   = FALSE;
-  Data      = NULL;
-  DataSize  = 0;
-  Status    = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
+  EFI_STATUS                Status;
+  SIGNATURE_DATABASE_CACHE  *Database;
+  EFI_SIGNATURE_LIST        *CertList;
+  EFI_SIGNATURE_DATA        *Cert;
+  UINTN                     DataSize;
+  UINTN                     Index;
+  UINTN                     CertCount;
+  UINTN                     Low;
+  UINTN                     High;
+
+  Status = GetSignatureDatabase (VariableName, &Database);
+  if (EFI_ERROR (Status)) {
     return FALSE;
   }
 
-  Data = (UINT8 *) AllocateZeroPool (DataSize);
-  if (Data == NULL) {
+  if (Database->Index != NULL) {
+    //
+    // Binary search for the first matching signature in the index.
+    //
+    Low  = 0;
+    High = Database->IndexCount;
+    while (Low < High) {
+      Index = Low + (High - Low) / 2;
+      if (CompareSignatureIndexEntryToKey (&Database->Index[Index], CertType, SignatureSize, Signature) < 0) {
+        Low = Index + 1;
+      } else {
+        High = Index;
+      }
+    }
+
+    if ((Low < Database->IndexCount) &&
+        (CompareSignatureIndexEntryToKey (&Database->Index[Low], CertType, SignatureSize, Signature) == 0)) {
+      SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, Database->Index[Low].CertList->SignatureSize, Database->Index[Low].Cert);
+      return TRUE;
+    }
     return FALSE;
   }
 
-  Status = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, Data);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
   //
   // Enumerate all signature data in SigDB to check if executable's signature exists.
   //
-  CertList = (EFI_SIGNATURE_LIST *) Data;
-  while ((DataSize > 0) && (DataSize >= CertList->SignatureListSize)) {
+  DataSize = Database->DataSize;
+  CertList = (EFI_SIGNATURE_LIST *) Database->Data;
+  while ((DataSize >= sizeof (EFI_SIGNATURE_LIST)) && (DataSize >= CertList->SignatureListSize)) {
+    if ((CertList->SignatureSize <= sizeof (EFI_GUID)) ||
+        (CertList->SignatureListSize < sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize)) {
+      break;
+    }
     CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
     Cert      = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
     if ((CertList->SignatureSize == sizeof(EFI_SIGNATURE_DATA) - 1 + SignatureSize) && (CompareGuid(&CertList->SignatureType, CertType))) {
@@ -864,29 +970,19 @@ IsSignatureFoundInDatabase (
           //
           // Find the signature in database.
           //
-          IsFound = TRUE;
           SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, CertList->SignatureSize, Cert);
-          break;
+          return TRUE;
         }
 
         Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + CertList->SignatureSize);
       }
-
-      if (IsFound) {
-        break;
-      }
     }
 
     DataSize -= CertList->SignatureListSize;
     CertList = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
   }
 
-Done:
-  if (Data != NULL) {
-    FreePool (Data);
-  }
-
-  return IsFound;
+  return FALSE;
 }
 
 /**
@@ -912,6 +1008,7 @@ IsPkcsSignedDataVerifiedBySignatureList (
 {
   EFI_STATUS                Status;
   BOOLEAN                   VerifyStatus;
+  SIGNATURE_DATABASE_CACHE  *Database;
   EFI_SIGNATURE_LIST        *CertList;
   EFI_SIGNATURE_DATA        *Cert;
   UINTN                     DataSize;
@@ -929,22 +1026,41 @@ IsPkcsSignedDataVerifiedBySignatureList (
   VerifyStatus = FALSE;
 
   DataSize = 0;
-  Status   = gRT->GetVariable (VariableName, VendorGuid, NULL, &DataSize, NULL);
-  if (Status == EFI_BUFFER_TOO_SMALL) {
-    Data = (UINT8 *) AllocateZeroPool (DataSize);
-    if (Data == NULL) {
-      return VerifyStatus;
+  Database = NULL;
+  if (CompareGuid (VendorGuid, &gEfiImageSecurityDatabaseGuid)) {
+    //
+    // db and dbx are served from the signature database cache.
+    //
+    Status = GetSignatureDatabase (VariableName, &Database);
+    if (EFI_ERROR (Status)) {
+      Database = NULL;
     }
+  }
 
-    Status = gRT->GetVariable (VariableName, VendorGuid, NULL, &DataSize, (VOID *) Data);
-    if (EFI_ERROR (Status)) {
-      goto Done;
+  if (Database != NULL) {
+    DataSize = Database->DataSize;
+    CertList = (EFI_SIGNATURE_LIST *) Database->Data;
+    Status   = (CertList != NULL) ? EFI_BUFFER_TOO_SMALL : EFI_NOT_FOUND;
+  } else {
+    Status   = gRT->GetVariable (VariableName, VendorGuid, NULL, &DataSize, NULL);
+  }
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    if (Database == NULL) {
+      Data = (UINT8 *) AllocateZeroPool (DataSize);
+      if (Data == NULL) {
+        return VerifyStatus;
+      }
+
+      Status = gRT->GetVariable (VariableName, VendorGuid, NULL, &DataSize, (VOID *) Data);
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+      CertList = (EFI_SIGNATURE_LIST *) Data;
     }
 
     //
     // Find X509 certificate in Signature List to verify the signature in pkcs7 signed data.
     //
-    CertList = (EFI_SIGNATURE_LIST *) Data;
     while ((DataSize > 0) && (DataSize >= CertList->SignatureListSize)) {
       if (CompareGuid (&CertList->SignatureType, &gEfiCertX509Guid)) {
         Cert          = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
@@ -1142,6 +1258,7 @@ DxeImageVerificationHandler (
 
   mImageBase  = (UINT8 *) FileBuffer;
   mImageSize  = FileSize;
+  mImageFile  = File;
 
   ZeroMem (&ImageContext, sizeof (ImageContext));
   ImageContext.Handle    = (VOID *) FileBuffer;
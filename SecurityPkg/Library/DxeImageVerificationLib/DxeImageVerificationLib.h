@@ -29,6 +29,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/DevicePathLib.h>
 #include <Library/SecurityManagementLib.h>
 #include <Library/PeCoffLib.h>
+#include <Library/PeImageDigestLib.h>
 #include <Protocol/FirmwareVolume2.h>
 #include <Protocol/DevicePath.h>
 #include <Protocol/BlockIo.h>
@@ -204,4 +205,41 @@ typedef struct {
   HASH_FINAL               HashFinal;
 } HASH_TABLE;
 
+//
+// Index entry of one signature in a signature database variable
+//
+typedef struct {
+  EFI_SIGNATURE_LIST       *CertList;
+  EFI_SIGNATURE_DATA       *Cert;
+} SIGNATURE_INDEX_ENTRY;
+
+//
+// Cached copy of a signature database variable (db or dbx)
+//
+typedef struct {
+  //
+  // Name of the variable, in gEfiImageSecurityDatabaseGuid namespace
+  //
+  CHAR16                   *VariableName;
+  //
+  // Content of the variable, NULL if the variable does not exist. BufferSize
+  // is the size of the pool holding Data.
+  //
+  UINT8                    *Data;
+  UINTN                    DataSize;
+  UINTN                    BufferSize;
+  //
+  // Attributes and SHA-256 digest of Data, compared on each use to detect an
+  // update of the variable
+  //
+  UINT32                   Attributes;
+  UINT8                    Digest[SHA256_DIGEST_SIZE];
+  //
+  // All signatures in Data sorted by size, type and value. NULL if the
+  // database is read without the index.
+  //
+  SIGNATURE_INDEX_ENTRY    *Index;
+  UINTN                    IndexCount;
+} SIGNATURE_DATABASE_CACHE;
+
 #endif
@@ -0,0 +1,654 @@
+/** @file
+  Compute the Authenticode digests of a PE/COFF image in a single pass and
+  share them between the image verification and measured boot services.
+
+  Caution: This file requires additional review when modified.
+  This library will have external input - PE/COFF image.
+  This external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+  GetPeImageDigest() will accept untrusted PE/COFF image and validate its data
+  structure within this image buffer before use.
+
+  The digests are only shared within one run of the Security2 handlers for an
+  image. This library registers a handler of its own which runs before the
+  handlers of its consumers and drops the digests of the previous image.
+
+Copyright (c) 2014, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <PiDxe.h>
+
+#include <IndustryStandard/PeImage.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/SecurityManagementLib.h>
+#include <Library/PeImageDigestLib.h>
+
+//
+// The image is fed to all the hash algorithms in pieces of this size, so that
+// each piece is read from memory once and then hashed from the cache.
+//
+#define PE_IMAGE_DIGEST_CHUNK_SIZE    SIZE_32KB
+
+typedef
+UINTN
+(EFIAPI *PE_IMAGE_HASH_GET_CONTEXT_SIZE) (
+  VOID
+  );
+
+typedef
+BOOLEAN
+(EFIAPI *PE_IMAGE_HASH_INIT) (
+  OUT  VOID  *HashContext
+  );
+
+typedef
+BOOLEAN
+(EFIAPI *PE_IMAGE_HASH_UPDATE) (
+  IN OUT  VOID        *HashContext,
+  IN      CONST VOID  *Data,
+  IN      UINTN       DataSize
+  );
+
+typedef
+BOOLEAN
+(EFIAPI *PE_IMAGE_HASH_FINAL) (
+  IN OUT  VOID   *HashContext,
+  OUT     UINT8  *HashValue
+  );
+
+typedef struct {
+  UINT32                          DigestMask;
+  UINTN                           DigestOffset;
+  PE_IMAGE_HASH_GET_CONTEXT_SIZE  GetContextSize;
+  PE_IMAGE_HASH_INIT              HashInit;
+  PE_IMAGE_HASH_UPDATE            HashUpdate;
+  PE_IMAGE_HASH_FINAL             HashFinal;
+} PE_IMAGE_DIGEST_ALGORITHM;
+
+PE_IMAGE_DIGEST_ALGORITHM mPeImageDigestAlgorithm[] = {
+  { PE_IMAGE_DIGEST_SHA1,   OFFSET_OF (PE_IMAGE_DIGEST, Sha1),   Sha1GetContextSize,   Sha1Init,   Sha1Update,   Sha1Final   },
+  { PE_IMAGE_DIGEST_SHA256, OFFSET_OF (PE_IMAGE_DIGEST, Sha256), Sha256GetContextSize, Sha256Init, Sha256Update, Sha256Final }
+};
+
+#define PE_IMAGE_DIGEST_ALGORITHM_COUNT   (sizeof (mPeImageDigestAlgorithm) / sizeof (mPeImageDigestAlgorithm[0]))
+#define PE_IMAGE_DIGEST_ALL               (PE_IMAGE_DIGEST_SHA1 | PE_IMAGE_DIGEST_SHA256)
+
+//
+// Union of the digests requested by all callers so far. A new image is hashed
+// with all of them, since every consumer is called for every image.
+//
+UINT32            mPeImageDigestWanted = 0;
+
+//
+// The image hashed last in the current run of the Security2 handlers, identified
+// by its file device path and image buffer. mCachedDigest is valid only while
+// mCachedImageBase is not NULL.
+//
+EFI_DEVICE_PATH_PROTOCOL  *mCachedFile         = NULL;
+VOID                      *mCachedImageBase    = NULL;
+UINTN                     mCachedImageSize     = 0;
+PE_IMAGE_DIGEST           mCachedDigest;
+
+/**
+  Drop the cached digests.
+
+**/
+VOID
+PeImageDigestClearCache (
+  VOID
+  )
+{
+  if (mCachedFile != NULL) {
+    FreePool (mCachedFile);
+    mCachedFile = NULL;
+  }
+  mCachedImageBase = NULL;
+  mCachedImageSize = 0;
+  ZeroMem (&mCachedDigest, sizeof (mCachedDigest));
+}
+
+/**
+  Check if a file device path is the one of the cached image.
+
+  @param[in]  File          The file device path, or NULL.
+
+  @retval TRUE   File matches the file device path of the cached image.
+  @retval FALSE  File doesn't match.
+
+**/
+BOOLEAN
+PeImageDigestIsCachedFile (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *File
+  )
+{
+  UINTN             Size;
+
+  if (File == NULL || mCachedFile == NULL) {
+    return (BOOLEAN) (File == NULL && mCachedFile == NULL);
+  }
+
+  Size = GetDevicePathSize (File);
+  return (BOOLEAN) (Size == GetDevicePathSize (mCachedFile) &&
+                    CompareMem (File, mCachedFile, Size) == 0);
+}
+
+/**
+  Feed a range of the image to every active hash context.
+
+  @param[in]  Contexts      Hash contexts, indexed like mPeImageDigestAlgorithm.
+  @param[in]  DigestMask    The active algorithms.
+  @param[in]  Data          Start of the range.
+  @param[in]  DataSize      Size of the range in bytes.
+
+  @retval TRUE   All the hash updates succeeded.
+  @retval FALSE  A hash update failed.
+
+**/
+BOOLEAN
+PeImageDigestUpdate (
+  IN VOID           **Contexts,
+  IN UINT32         DigestMask,
+  IN CONST UINT8    *Data,
+  IN UINTN          DataSize
+  )
+{
+  UINTN    Index;
+  UINTN    ChunkSize;
+
+  while (DataSize != 0) {
+    ChunkSize = MIN (DataSize, PE_IMAGE_DIGEST_CHUNK_SIZE);
+    for (Index = 0; Index < PE_IMAGE_DIGEST_ALGORITHM_COUNT; Index++) {
+      if ((mPeImageDigestAlgorithm[Index].DigestMask & DigestMask) == 0) {
+        continue;
+      }
+      if (!mPeImageDigestAlgorithm[Index].HashUpdate (Contexts[Index], Data, ChunkSize)) {
+        return FALSE;
+      }
+    }
+    Data     += ChunkSize;
+    DataSize -= ChunkSize;
+  }
+
+  return TRUE;
+}
+
+/**
+  Calculate the Authenticode digests of a Pe/Coff image based on the image
+  hashing in PE/COFF Specification 8.0 Appendix A, for all requested algorithms
+  in one pass over the image.
+
+  Caution: This function may receive untrusted input.
+  PE/COFF image is external input, so this function will validate its data structure
+  within this image buffer before use.
+
+  @param[in]  ImageBase     Pointer to the PE/COFF image buffer.
+  @param[in]  ImageSize     Size of the image buffer in bytes.
+  @param[in]  DigestMask    The digests to compute.
+  @param[out] Digest        Receives the digests.
+
+  @retval EFI_SUCCESS             The digests were computed.
+  @retval EFI_UNSUPPORTED         The image is not a well-formed PE/COFF image.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory to hash the image.
+  @retval EFI_ABORTED             The hash algorithm failed.
+
+**/
+EFI_STATUS
+HashPeImageMultiple (
+  IN  UINT8             *ImageBase,
+  IN  UINTN             ImageSize,
+  IN  UINT32            DigestMask,
+  OUT PE_IMAGE_DIGEST   *Digest
+  )
+{
+  EFI_STATUS                           Status;
+  VOID                                 *Contexts[PE_IMAGE_DIGEST_ALGORITHM_COUNT];
+  EFI_IMAGE_DOS_HEADER                 *DosHdr;
+  UINT32                               PeCoffHeaderOffset;
+  EFI_IMAGE_OPTIONAL_HEADER_PTR_UNION  Hdr;
+  UINT16                               Magic;
+  EFI_IMAGE_SECTION_HEADER             *Section;
+  EFI_IMAGE_SECTION_HEADER             *SectionHeader;
+  UINT8                                *HashBase;
+  UINTN                                HashSize;
+  UINTN                                SumOfBytesHashed;
+  UINTN                                Index;
+  UINTN                                Pos;
+  UINT32                               CertSize;
+  UINT32                               NumberOfRvaAndSizes;
+
+  ZeroMem (Contexts, sizeof (Contexts));
+  SectionHeader = NULL;
+  Status        = EFI_UNSUPPORTED;
+
+  //
+  // Check PE/COFF image
+  //
+  DosHdr = (EFI_IMAGE_DOS_HEADER *) ImageBase;
+  PeCoffHeaderOffset = 0;
+  if (DosHdr->e_magic == EFI_IMAGE_DOS_SIGNATURE) {
+    PeCoffHeaderOffset = DosHdr->e_lfanew;
+  }
+
+  Hdr.Pe32 = (EFI_IMAGE_NT_HEADERS32 *) (ImageBase + PeCoffHeaderOffset);
+  if (Hdr.Pe32->Signature != EFI_IMAGE_NT_SIGNATURE) {
+    return EFI_UNSUPPORTED;
+  }
+
+  // 1.  Load the image header into memory.
+
+  // 2.  Initialize a SHA hash context for every requested algorithm.
+  for (Index = 0; Index < PE_IMAGE_DIGEST_ALGORITHM_COUNT; Index++) {
+    if ((mPeImageDigestAlgorithm[Index].DigestMask & DigestMask) == 0) {
+      continue;
+    }
+    Contexts[Index] = AllocatePool (mPeImageDigestAlgorithm[Index].GetContextSize ());
+    if (Contexts[Index] == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Done;
+    }
+    if (!mPeImageDigestAlgorithm[Index].HashInit (Contexts[Index])) {
+      Status = EFI_ABORTED;
+      goto Done;
+    }
+  }
+
+  //
+  // Measuring PE/COFF Image Header;
+  // But CheckSum field and SECURITY data directory (certificate) are excluded
+  //
+  if (Hdr.Pe32->FileHeader.Machine == IMAGE_FILE_MACHINE_IA64 && Hdr.Pe32->OptionalHeader.Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+    //
+    // NOTE: Some versions of Linux ELILO for Itanium have an incorrect magic value 
+    //       in the PE/COFF Header. If the MachineType is Itanium(IA64) and the 
+    //       Magic value in the OptionalHeader is EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC
+    //       then override the magic value to EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC
+    //
+    Magic = EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+  } else {
+    //
+    // Get the magic value from the PE/COFF Optional Header
+    //
+    Magic = Hdr.Pe32->OptionalHeader.Magic;
+  }
+
+  //
+  // 3.  Calculate the distance from the base of the image header to the image checksum address.
+  // 4.  Hash the image header from its base to beginning of the image checksum.
+  //
+  HashBase = ImageBase;
+  if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+    //
+    // Use PE32 offset.
+    //
+    HashSize = (UINTN) ((UINT8 *) (&Hdr.Pe32->OptionalHeader.CheckSum) - HashBase);
+    NumberOfRvaAndSizes = Hdr.Pe32->OptionalHeader.NumberOfRvaAndSizes;
+  } else if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR64_MAGIC) {
+    //
+    // Use PE32+ offset.
+    //
+    HashSize = (UINTN) ((UINT8 *) (&Hdr.Pe32Plus->OptionalHeader.CheckSum) - HashBase);
+    NumberOfRvaAndSizes = Hdr.Pe32Plus->OptionalHeader.NumberOfRvaAndSizes;
+  } else {
+    //
+    // Invalid header magic number.
+    //
+    Status = EFI_UNSUPPORTED;
+    goto Done;
+  }
+
+  Status = EFI_ABORTED;
+  if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+    goto Done;
+  }
+
+  //
+  // 5.  Skip over the image checksum (it occupies a single ULONG).
+  //
+  if (NumberOfRvaAndSizes <= EFI_IMAGE_DIRECTORY_ENTRY_SECURITY) {
+    //
+    // 6.  Since there is no Cert Directory in optional header, hash everything
+    //     from the end of the checksum to the end of image header.
+    //
+    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+      //
+      // Use PE32 offset.
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32->OptionalHeader.CheckSum + sizeof (UINT32);
+      HashSize = Hdr.Pe32->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - ImageBase);
+    } else {
+      //
+      // Use PE32+ offset.
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32Plus->OptionalHeader.CheckSum + sizeof (UINT32);
+      HashSize = Hdr.Pe32Plus->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - ImageBase);
+    }
+
+    if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+      goto Done;
+    }
+  } else {
+    //
+    // 7.  Hash everything from the end of the checksum to the start of the Cert Directory.
+    //
+    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+      //
+      // Use PE32 offset.
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32->OptionalHeader.CheckSum + sizeof (UINT32);
+      HashSize = (UINTN) ((UINT8 *) (&Hdr.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY]) - HashBase);
+    } else {
+      //
+      // Use PE32+ offset.
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32Plus->OptionalHeader.CheckSum + sizeof (UINT32);
+      HashSize = (UINTN) ((UINT8 *) (&Hdr.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY]) - HashBase);
+    }
+
+    if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+      goto Done;
+    }
+
+    //
+    // 8.  Skip over the Cert Directory. (It is sizeof(IMAGE_DATA_DIRECTORY) bytes.)
+    // 9.  Hash everything from the end of the Cert Directory to the end of image header.
+    //
+    if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+      //
+      // Use PE32 offset
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY + 1];
+      HashSize = Hdr.Pe32->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - ImageBase);
+    } else {
+      //
+      // Use PE32+ offset.
+      //
+      HashBase = (UINT8 *) &Hdr.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY + 1];
+      HashSize = Hdr.Pe32Plus->OptionalHeader.SizeOfHeaders - (UINTN) (HashBase - ImageBase);
+    }
+
+    if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+      goto Done;
+    }
+  }
+
+  //
+  // 10. Set the SUM_OF_BYTES_HASHED to the size of the header.
+  //
+  if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+    //
+    // Use PE32 offset.
+    //
+    SumOfBytesHashed = Hdr.Pe32->OptionalHeader.SizeOfHeaders;
+  } else {
+    //
+    // Use PE32+ offset
+    //
+    SumOfBytesHashed = Hdr.Pe32Plus->OptionalHeader.SizeOfHeaders;
+  }
+
+  //
+  // 11. Build a temporary table of pointers to all the IMAGE_SECTION_HEADER
+  //     structures in the image. The 'NumberOfSections' field of the image
+  //     header indicates how big the table should be. Do not include any
+  //     IMAGE_SECTION_HEADERs in the table whose 'SizeOfRawData' field is zero.
+  //
+  SectionHeader = (EFI_IMAGE_SECTION_HEADER *) AllocateZeroPool (sizeof (EFI_IMAGE_SECTION_HEADER) * Hdr.Pe32->FileHeader.NumberOfSections);
+  if (SectionHeader == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  //
+  // 12.  Using the 'PointerToRawData' in the referenced section headers as
+  //      a key, arrange the elements in the table in ascending order. In other
+  //      words, sort the section headers according to the disk-file offset of
+  //      the section.
+  //
+  Section = (EFI_IMAGE_SECTION_HEADER *) (
+               ImageBase +
+               PeCoffHeaderOffset +
+               sizeof (UINT32) +
+               sizeof (EFI_IMAGE_FILE_HEADER) +
+               Hdr.Pe32->FileHeader.SizeOfOptionalHeader
+               );
+  for (Index = 0; Index < Hdr.Pe32->FileHeader.NumberOfSections; Index++) {
+    Pos = Index;
+    while ((Pos > 0) && (Section->PointerToRawData < SectionHeader[Pos - 1].PointerToRawData)) {
+      CopyMem (&SectionHeader[Pos], &SectionHeader[Pos - 1], sizeof (EFI_IMAGE_SECTION_HEADER));
+      Pos--;
+    }
+    CopyMem (&SectionHeader[Pos], Section, sizeof (EFI_IMAGE_SECTION_HEADER));
+    Section += 1;
+  }
+
+  //
+  // 13.  Walk through the sorted table, bring the corresponding section
+  //      into memory, and hash the entire section (using the 'SizeOfRawData'
+  //      field in the section header to determine the amount of data to hash).
+  // 14.  Add the section's 'SizeOfRawData' to SUM_OF_BYTES_HASHED .
+  // 15.  Repeat steps 13 and 14 for all the sections in the sorted table.
+  //
+  for (Index = 0; Index < Hdr.Pe32->FileHeader.NumberOfSections; Index++) {
+    Section = &SectionHeader[Index];
+    if (Section->SizeOfRawData == 0) {
+      continue;
+    }
+    HashBase = ImageBase + Section->PointerToRawData;
+    HashSize = (UINTN) Section->SizeOfRawData;
+
+    if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+      goto Done;
+    }
+
+    SumOfBytesHashed += HashSize;
+  }
+
+  //
+  // 16.  If the file size is greater than SUM_OF_BYTES_HASHED, there is extra
+  //      data in the file that needs to be added to the hash. This data begins
+  //      at file offset SUM_OF_BYTES_HASHED and its length is:
+  //             FileSize  -  (CertDirectory->Size)
+  //
+  if (ImageSize > SumOfBytesHashed) {
+    HashBase = ImageBase + SumOfBytesHashed;
+
+    if (NumberOfRvaAndSizes <= EFI_IMAGE_DIRECTORY_ENTRY_SECURITY) {
+      CertSize = 0;
+    } else {
+      if (Magic == EFI_IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
+        //
+        // Use PE32 offset.
+        //
+        CertSize = Hdr.Pe32->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].Size;
+      } else {
+        //
+        // Use PE32+ offset.
+        //
+        CertSize = Hdr.Pe32Plus->OptionalHeader.DataDirectory[EFI_IMAGE_DIRECTORY_ENTRY_SECURITY].Size;
+      }
+    }
+
+    if (ImageSize > CertSize + SumOfBytesHashed) {
+      HashSize = (UINTN) (ImageSize - CertSize - SumOfBytesHashed);
+
+      if (!PeImageDigestUpdate (Contexts, DigestMask, HashBase, HashSize)) {
+        goto Done;
+      }
+    } else if (ImageSize < CertSize + SumOfBytesHashed) {
+      Status = EFI_UNSUPPORTED;
+      goto Done;
+    }
+  }
+
+  //
+  // 17.  Finalize the SHA hashes.
+  //
+  for (Index = 0; Index < PE_IMAGE_DIGEST_ALGORITHM_COUNT; Index++) {
+    if (Contexts[Index] == NULL) {
+      continue;
+    }
+    if (!mPeImageDigestAlgorithm[Index].HashFinal (
+                                          Contexts[Index],
+                                          (UINT8 *) Digest + mPeImageDigestAlgorithm[Index].DigestOffset
+                                          )) {
+      goto Done;
+    }
+  }
+  Digest->DigestMask = DigestMask;
+  Status = EFI_SUCCESS;
+
+Done:
+  for (Index = 0; Index < PE_IMAGE_DIGEST_ALGORITHM_COUNT; Index++) {
+    if (Contexts[Index] != NULL) {
+      FreePool (Contexts[Index]);
+    }
+  }
+  if (SectionHeader != NULL) {
+    FreePool (SectionHeader);
+  }
+  return Status;
+}
+
+/**
+  Get the Authenticode digests of a PE/COFF image.
+
+  Within one run of the Security2 handlers, the digests are returned from the
+  cache when File, ImageBase and ImageSize identify the image hashed last.
+  Otherwise every digest requested so far by any caller is computed in a single
+  pass over the image, so that the other consumers of the same image can be
+  served from the cache.
+
+  Caution: This function may receive untrusted input.
+  The caller must have validated the PE/COFF image with PeCoffLoaderGetImageInfo()
+  before calling this function.
+
+  @param[in]  File          The file device path the Security2 handler received
+                            for the image, or NULL.
+  @param[in]  ImageBase     Pointer to the PE/COFF image buffer.
+  @param[in]  ImageSize     Size of the image buffer in bytes.
+  @param[in]  DigestMask    The digests needed by the caller, a combination of
+                            PE_IMAGE_DIGEST_SHA1 and PE_IMAGE_DIGEST_SHA256.
+  @param[out] Digest        Receives the digests. At least the requested ones are valid.
+
+  @retval EFI_SUCCESS             The requested digests were returned.
+  @retval EFI_INVALID_PARAMETER   ImageBase or Digest is NULL, or DigestMask is not supported.
+  @retval EFI_UNSUPPORTED         The image is not a well-formed PE/COFF image.
+  @retval EFI_OUT_OF_RESOURCES    There is not enough memory to hash the image.
+  @retval EFI_ABORTED             The hash algorithm failed.
+
+**/
+EFI_STATUS
+EFIAPI
+GetPeImageDigest (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *File,  OPTIONAL
+  IN  VOID                            *ImageBase,
+  IN  UINTN                           ImageSize,
+  IN  UINT32                          DigestMask,
+  OUT PE_IMAGE_DIGEST                 *Digest
+  )
+{
+  EFI_STATUS    Status;
+
+  if (ImageBase == NULL || ImageSize == 0 || Digest == NULL ||
+      DigestMask == 0 || (DigestMask & ~PE_IMAGE_DIGEST_ALL) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mCachedImageBase == ImageBase &&
+      mCachedImageSize == ImageSize &&
+      (mCachedDigest.DigestMask & DigestMask) == DigestMask &&
+      PeImageDigestIsCachedFile (File)) {
+    CopyMem (Digest, &mCachedDigest, sizeof (PE_IMAGE_DIGEST));
+    return EFI_SUCCESS;
+  }
+
+  PeImageDigestClearCache ();
+  mPeImageDigestWanted |= DigestMask;
+
+  Status = HashPeImageMultiple (ImageBase, ImageSize, mPeImageDigestWanted, &mCachedDigest);
+  if (EFI_ERROR (Status)) {
+    ZeroMem (&mCachedDigest, sizeof (mCachedDigest));
+    return Status;
+  }
+
+  //
+  // Without memory for the device path copy, return the digests uncached.
+  //
+  if (File != NULL) {
+    mCachedFile = DuplicateDevicePath (File);
+  }
+  if (File == NULL || mCachedFile != NULL) {
+    mCachedImageBase = ImageBase;
+    mCachedImageSize = ImageSize;
+  }
+  CopyMem (Digest, &mCachedDigest, sizeof (PE_IMAGE_DIGEST));
+  return EFI_SUCCESS;
+}
+
+/**
+  Security2 handler which starts every run of the Security2 handlers for an
+  image by dropping the digests cached for the previous image, so the digests
+  are never shared beyond the verification and measurement of one image.
+
+  @param[in]  AuthenticationStatus  The authentication status of the file.
+  @param[in]  File                  The device path of the file.
+  @param[in]  FileBuffer            The image buffer.
+  @param[in]  FileSize              The size of the image buffer.
+  @param[in]  BootPolicy            Whether the image is loaded by the boot manager.
+
+  @retval EFI_SUCCESS               The cache is cleared.
+
+**/
+EFI_STATUS
+EFIAPI
+PeImageDigestSecurityHandler (
+  IN  UINT32                           AuthenticationStatus,
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL   *File,
+  IN  VOID                             *FileBuffer,
+  IN  UINTN                            FileSize,
+  IN  BOOLEAN                          BootPolicy
+  )
+{
+  PeImageDigestClearCache ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Register the handler which clears the digest cache for each image.
+
+  The consumers of this library depend on it, so this constructor runs before
+  theirs and the handler is registered ahead of their handlers.
+
+  @param[in]  ImageHandle   ImageHandle of the loaded driver.
+  @param[in]  SystemTable   Pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The handler was registered.
+
+**/
+EFI_STATUS
+EFIAPI
+DxePeImageDigestLibConstructor (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  return RegisterSecurity2Handler (
+           PeImageDigestSecurityHandler,
+           EFI_AUTH_OPERATION_VERIFY_IMAGE
+           );
+}